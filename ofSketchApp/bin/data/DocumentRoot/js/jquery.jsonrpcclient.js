@@ -29,6 +29,8 @@
    *                onopen     A socket onopen handler. (Not used for custom getSocket.)
    *                onclose    A socket onclose handler. (Not used for custom getSocket.)
    *                onerror    A socket onerror handler. (Not used for custom getSocket.)
+   *                encoding   'json', or 'msgpack' to ask the server for MessagePack frames,
+   *                           which needs msgpack.js.  Calls are then sent as MessagePack too.
    *                getSocket  A function returning a WebSocket or null.
    *                           It must take an onmessage_cb and bind it to the onmessage event
    *                           (or chain it before/after some other onmessage handler).
@@ -47,6 +49,7 @@
       onopen      : noop, ///< Optional onopen-handler for WebSocket.
       onclose     : noop, ///< Optional onclose-handler for WebSocket.
       onerror     : noop, ///< Optional onerror-handler for WebSocket.
+      encoding    : 'json', ///< Optional websocket encoding, 'json' or 'msgpack'.
       /// Custom socket supplier for using an already existing socket
       getSocket   : function (onmessage_cb) { return self._getSocket(onmessage_cb); }
     }, options);
@@ -54,8 +57,9 @@
     // Declare an instance version of the onmessage callback to wrap 'this'.
     this.wsOnMessage = function(event) { self._wsOnMessage(event); };
 
-    //queue for ws request sent *before* ws is open.
+    //queue for ws requests not sent yet.
     this._ws_request_queue = [];
+    this._ws_flush_pending = false;
   };
 
   /// Holding the WebSocket on default getsocket.
@@ -232,6 +236,18 @@
 
       // Set up onerror handler.
       this._ws_socket.onerror = this.options.onerror;
+
+      // Binary frames hold MessagePack.
+      this._ws_socket.binaryType = 'arraybuffer';
+
+      // Ask for MessagePack before any other call, so their responses use it too.
+      if (this._isMessagePack()) {
+        this._ws_request_queue.unshift({
+          jsonrpc : '2.0',
+          method  : 'set-encoding',
+          params  : { encoding: 'msgpack' }
+        });
+      }
     }
 
     return this._ws_socket;
@@ -244,33 +260,28 @@
    * @memberof $.JsonRpcClient
    */
   $.JsonRpcClient.prototype._wsCall = function(socket, request, success_cb, error_cb) {
-    var request_json = $.toJSON(request);
+    var self = this; // In closures below, this is set to the WebSocket.  Use self instead.
 
-    if (socket.readyState < 1) {
-
-      //queue request
-      this._ws_request_queue.push(request_json);
+    // Requests made before the socket opens, or in the same turn of the event loop, are
+    // sent together as one batch.
+    this._ws_request_queue.push(request);
 
+    if (socket.readyState < 1) {
       if (!socket.onopen) {
         // The websocket is not open yet; we have to set sending of the message in onopen.
-        var self = this; // In closure below, this is set to the WebSocket.  Use self instead.
-
-        // Set up sending of message for when the socket is open.
         socket.onopen = function(event) {
           // Hook for extra onopen callback
           self.options.onopen(event);
 
           // Send queued requests.
-          for (var i=0; i<self._ws_request_queue.length; i++) {
-            socket.send(self._ws_request_queue[i]);
-          }
-          self._ws_request_queue = [];
+          self._wsFlush(socket);
         };
       }
     }
-    else {
+    else if (!this._ws_flush_pending) {
       // We have a socket and it should be ready to send on.
-      socket.send(request_json);
+      this._ws_flush_pending = true;
+      setTimeout(function() { self._wsFlush(socket); }, 0);
     }
 
     // Setup callbacks.  If there is an id, this is a call and not a notify.
@@ -279,10 +290,46 @@
     }
   };
 
+  /**
+   * Internal helper to send the queued requests, as a batch if there is more than one.
+   *
+   * @fn _wsFlush
+   * @memberof $.JsonRpcClient
+   */
+  $.JsonRpcClient.prototype._wsFlush = function(socket) {
+    var requests = this._ws_request_queue;
+
+    this._ws_request_queue = [];
+    this._ws_flush_pending = false;
+
+    if (requests.length === 0) {
+      return;
+    }
+
+    var payload = requests.length === 1 ? requests[0] : requests;
+
+    if (this._isMessagePack()) {
+      socket.send(MessagePack.encode(payload));
+    }
+    else {
+      socket.send($.toJSON(payload));
+    }
+  };
+
+  /**
+   * Internal helper to check if the websocket uses MessagePack.
+   *
+   * @fn _isMessagePack
+   * @memberof $.JsonRpcClient
+   */
+  $.JsonRpcClient.prototype._isMessagePack = function() {
+    return this.options.encoding === 'msgpack' && typeof MessagePack !== 'undefined';
+  };
+
   /**
    * Internal handler for the websocket messages.  It determines if the message is a JSON-RPC
    * response, and if so, tries to couple it with a given callback.  Otherwise, it falls back to
-   * given external onmessage-handler, if any.
+   * given external onmessage-handler, if any, along with the decoded message.
    *
    * @param event The websocket onmessage-event.
    */
@@ -291,14 +338,48 @@
     // Check if this could be a JSON RPC message.
     var response;
     try {
-      response = $.parseJSON(event.data);
+      if (event.data instanceof ArrayBuffer) {
+        response = MessagePack.decode(event.data);
+      }
+      else {
+        response = $.parseJSON(event.data);
+      }
     } catch (err){
       this.options.onmessage(event);
       return;
     }
 
+    // The responses to a batch come back together, in any order.
+    if ($.isArray(response)) {
+      var handled = response.length > 0;
+
+      for (var i = 0; i < response.length; i++) {
+        handled = this._wsHandleResponse(response[i]) && handled;
+      }
+
+      if (handled) {
+        return;
+      }
+    }
+    else if (this._wsHandleResponse(response)) {
+      return;
+    }
+
+    //If we get here its not a valid JSON-RPC response, pass it along to the fallback message handler.
+    this.options.onmessage(event, response);
+  };
+
+  /**
+   * Internal helper to couple a single JSON-RPC response with its callback.
+   *
+   * @param response The parsed response.
+   * @return {boolean} true if it was a response to one of our calls.
+   */
+  $.JsonRpcClient.prototype._wsHandleResponse = function(response) {
+
     /// @todo Make using the jsonrcp 2.0 check optional, to use this on JSON-RPC 1 backends.
-    if (typeof response === 'object'
+    if (response !== null
+        && typeof response === 'object'
         && response.jsonrpc === '2.0') {
 
       /// @todo Handle bad response (without id).
@@ -313,7 +394,7 @@
 
         // Run callback with result as parameter.
         success_cb(response.result);
-        return;
+        return true;
       }
 
       // If this is an object with error, it is an error response.
@@ -326,12 +407,11 @@
 
         // Run callback with the error object as parameter.
         error_cb(response.error);
-        return;
+        return true;
       }
     }
 
-    //If we get here its not a valid JSON-RPC response, pass it along to the fallback message handler.
-    this.options.onmessage(event);
+    return false;
   };
 
 
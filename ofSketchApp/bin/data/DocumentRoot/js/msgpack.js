@@ -0,0 +1,358 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+// Encodes and decodes MessagePack <http://msgpack.org>, which the server sends
+// instead of JSON once a connection asks for it with the set-encoding method.
+var MessagePack = (function() {
+
+    //--------------------------------------------------------------------------
+    var _encodeUTF8 = function(text)
+    {
+        var bytes = [];
+
+        for (var i = 0; i < text.length; i++)
+        {
+            var code = text.charCodeAt(i);
+
+            // Join surrogate pairs.
+            if (code >= 0xd800 && code < 0xdc00 && i + 1 < text.length)
+            {
+                var next = text.charCodeAt(i + 1);
+
+                if (next >= 0xdc00 && next < 0xe000)
+                {
+                    code = 0x10000 + ((code - 0xd800) << 10) + (next - 0xdc00);
+                    i++;
+                }
+            }
+
+            if (code < 0x80)
+            {
+                bytes.push(code);
+            }
+            else if (code < 0x800)
+            {
+                bytes.push(0xc0 | (code >> 6),
+                           0x80 | (code & 0x3f));
+            }
+            else if (code < 0x10000)
+            {
+                bytes.push(0xe0 | (code >> 12),
+                           0x80 | ((code >> 6) & 0x3f),
+                           0x80 | (code & 0x3f));
+            }
+            else
+            {
+                bytes.push(0xf0 | (code >> 18),
+                           0x80 | ((code >> 12) & 0x3f),
+                           0x80 | ((code >> 6) & 0x3f),
+                           0x80 | (code & 0x3f));
+            }
+        }
+
+        return bytes;
+    }
+
+    //--------------------------------------------------------------------------
+    var _decodeUTF8 = function(bytes, offset, length)
+    {
+        if (typeof TextDecoder !== 'undefined')
+        {
+            return new TextDecoder('utf-8').decode(bytes.subarray(offset, offset + length));
+        }
+
+        var end = offset + length;
+        var codes = [];
+        var text = '';
+
+        while (offset < end)
+        {
+            var code = bytes[offset++];
+
+            if (code >= 0xf0)
+            {
+                code = ((code & 0x07) << 18) | ((bytes[offset++] & 0x3f) << 12) | ((bytes[offset++] & 0x3f) << 6) | (bytes[offset++] & 0x3f);
+                code -= 0x10000;
+                codes.push(0xd800 + (code >> 10), 0xdc00 + (code & 0x3ff));
+            }
+            else if (code >= 0xe0)
+            {
+                codes.push(((code & 0x0f) << 12) | ((bytes[offset++] & 0x3f) << 6) | (bytes[offset++] & 0x3f));
+            }
+            else if (code >= 0xc0)
+            {
+                codes.push(((code & 0x1f) << 6) | (bytes[offset++] & 0x3f));
+            }
+            else
+            {
+                codes.push(code);
+            }
+
+            // Keep the argument list of fromCharCode short.
+            if (codes.length >= 4096)
+            {
+                text += String.fromCharCode.apply(null, codes);
+                codes = [];
+            }
+        }
+
+        return text + String.fromCharCode.apply(null, codes);
+    }
+
+    //--------------------------------------------------------------------------
+    var _writeHeader = function(bytes, fixed, fixedSizes, types, size)
+    {
+        if (size < fixedSizes)
+        {
+            bytes.push(fixed | size);
+        }
+        else if (types[0] && size <= 0xff)
+        {
+            bytes.push(types[0], size);
+        }
+        else if (size <= 0xffff)
+        {
+            bytes.push(types[1], size >>> 8, size & 0xff);
+        }
+        else
+        {
+            bytes.push(types[2], size >>> 24, (size >>> 16) & 0xff, (size >>> 8) & 0xff, size & 0xff);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    var _write = function(bytes, value)
+    {
+        if (value === null || typeof value === 'undefined')
+        {
+            bytes.push(0xc0);
+        }
+        else if (typeof value === 'boolean')
+        {
+            bytes.push(value ? 0xc3 : 0xc2);
+        }
+        else if (typeof value === 'number')
+        {
+            if (value === Math.floor(value) && value >= 0 && value <= 0xffffffff)
+            {
+                if (value < 0x80)
+                {
+                    bytes.push(value);
+                }
+                else
+                {
+                    bytes.push(0xce, value >>> 24, (value >>> 16) & 0xff, (value >>> 8) & 0xff, value & 0xff);
+                }
+            }
+            else if (value === Math.floor(value) && value < 0 && value >= -0x80000000)
+            {
+                if (value >= -32)
+                {
+                    bytes.push(value & 0xff);
+                }
+                else
+                {
+                    bytes.push(0xd2, (value >> 24) & 0xff, (value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff);
+                }
+            }
+            else
+            {
+                var view = new DataView(new ArrayBuffer(8));
+                view.setFloat64(0, value);
+                bytes.push(0xcb);
+
+                for (var i = 0; i < 8; i++)
+                {
+                    bytes.push(view.getUint8(i));
+                }
+            }
+        }
+        else if (typeof value === 'string')
+        {
+            var text = _encodeUTF8(value);
+            _writeHeader(bytes, 0xa0, 32, [ 0xd9, 0xda, 0xdb ], text.length);
+
+            for (var i = 0; i < text.length; i++)
+            {
+                bytes.push(text[i]);
+            }
+        }
+        else if ($.isArray(value))
+        {
+            _writeHeader(bytes, 0x90, 16, [ 0, 0xdc, 0xdd ], value.length);
+
+            for (var i = 0; i < value.length; i++)
+            {
+                _write(bytes, value[i]);
+            }
+        }
+        else
+        {
+            var keys = [];
+
+            for (var key in value)
+            {
+                if (value.hasOwnProperty(key) && typeof value[key] !== 'undefined' && typeof value[key] !== 'function')
+                {
+                    keys.push(key);
+                }
+            }
+
+            _writeHeader(bytes, 0x80, 16, [ 0, 0xde, 0xdf ], keys.length);
+
+            for (var i = 0; i < keys.length; i++)
+            {
+                _write(bytes, keys[i]);
+                _write(bytes, value[keys[i]]);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    var _read = function(state)
+    {
+        var view = state.view;
+        var type = view.getUint8(state.offset++);
+        var size = 0;
+
+        if (type < 0x80)
+        {
+            return type;
+        }
+        else if (type >= 0xe0)
+        {
+            return type - 0x100;
+        }
+        else if (type < 0x90)
+        {
+            return _readMap(state, type & 0x0f);
+        }
+        else if (type < 0xa0)
+        {
+            return _readArray(state, type & 0x0f);
+        }
+        else if (type < 0xc0)
+        {
+            return _readString(state, type & 0x1f);
+        }
+
+        var offset = state.offset;
+
+        switch (type)
+        {
+            case 0xc0: return null;
+            case 0xc2: return false;
+            case 0xc3: return true;
+            case 0xc4: case 0xd9: state.offset += 1; return _readString(state, view.getUint8(offset));
+            case 0xc5: case 0xda: state.offset += 2; return _readString(state, view.getUint16(offset));
+            case 0xc6: case 0xdb: state.offset += 4; return _readString(state, view.getUint32(offset));
+            case 0xca: state.offset += 4; return view.getFloat32(offset);
+            case 0xcb: state.offset += 8; return view.getFloat64(offset);
+            case 0xcc: state.offset += 1; return view.getUint8(offset);
+            case 0xcd: state.offset += 2; return view.getUint16(offset);
+            case 0xce: state.offset += 4; return view.getUint32(offset);
+            case 0xcf: state.offset += 8; return view.getUint32(offset) * 0x100000000 + view.getUint32(offset + 4);
+            case 0xd0: state.offset += 1; return view.getInt8(offset);
+            case 0xd1: state.offset += 2; return view.getInt16(offset);
+            case 0xd2: state.offset += 4; return view.getInt32(offset);
+            case 0xd3: state.offset += 8; return view.getInt32(offset) * 0x100000000 + view.getUint32(offset + 4);
+            case 0xdc: state.offset += 2; return _readArray(state, view.getUint16(offset));
+            case 0xdd: state.offset += 4; return _readArray(state, view.getUint32(offset));
+            case 0xde: state.offset += 2; return _readMap(state, view.getUint16(offset));
+            case 0xdf: state.offset += 4; return _readMap(state, view.getUint32(offset));
+        }
+
+        throw new Error("Unsupported MessagePack type: " + type);
+    }
+
+    //--------------------------------------------------------------------------
+    var _readString = function(state, size)
+    {
+        if (state.offset + size > state.bytes.length)
+        {
+            throw new Error("Truncated MessagePack string.");
+        }
+
+        var text = _decodeUTF8(state.bytes, state.offset, size);
+        state.offset += size;
+        return text;
+    }
+
+    //--------------------------------------------------------------------------
+    var _readArray = function(state, size)
+    {
+        var array = new Array(size);
+
+        for (var i = 0; i < size; i++)
+        {
+            array[i] = _read(state);
+        }
+
+        return array;
+    }
+
+    //--------------------------------------------------------------------------
+    var _readMap = function(state, size)
+    {
+        var map = {};
+
+        for (var i = 0; i < size; i++)
+        {
+            var key = _read(state);
+            map[key] = _read(state);
+        }
+
+        return map;
+    }
+
+    return {
+        // Returns an ArrayBuffer holding the encoded value.
+        encode: function(value)
+        {
+            var bytes = [];
+            _write(bytes, value);
+            return new Uint8Array(bytes).buffer;
+        },
+
+        // Decodes the single value in an ArrayBuffer, or throws an Error.
+        decode: function(buffer)
+        {
+            var state = {
+                bytes: new Uint8Array(buffer),
+                view: new DataView(buffer),
+                offset: 0
+            };
+
+            var value = _read(state);
+
+            if (state.offset !== state.bytes.length)
+            {
+                throw new Error("Unexpected data after the MessagePack value.");
+            }
+
+            return value;
+        }
+    };
+
+})();
@@ -0,0 +1,382 @@
+// =============================================================================
+//
+// Copyright (c) 2014 Brannon Dorsey <http://brannondorsey.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+// An edit in the ot.js format the server uses: positive numbers retain
+// characters, negative numbers delete them and strings are inserted.
+function TextOperation()
+{
+    this.ops = [];
+    this.baseLength = 0;
+    this.targetLength = 0;
+}
+
+TextOperation.prototype.retain = function(n)
+{
+    if (n <= 0) return this;
+    this.baseLength += n;
+    this.targetLength += n;
+    var last = this.ops.length - 1;
+    if (last >= 0 && typeof this.ops[last] === 'number' && this.ops[last] > 0) {
+        this.ops[last] += n;
+    } else {
+        this.ops.push(n);
+    }
+    return this;
+}
+
+TextOperation.prototype.insert = function(text)
+{
+    if (text.length === 0) return this;
+    this.targetLength += text.length;
+    var ops = this.ops;
+    var last = ops.length - 1;
+    if (last >= 0 && typeof ops[last] === 'string') {
+        ops[last] += text;
+    } else if (last >= 0 && ops[last] < 0) {
+        // Keep inserts ahead of deletes, so equal operations look the same.
+        if (last > 0 && typeof ops[last - 1] === 'string') {
+            ops[last - 1] += text;
+        } else {
+            ops.splice(last, 0, text);
+        }
+    } else {
+        ops.push(text);
+    }
+    return this;
+}
+
+TextOperation.prototype.remove = function(n)
+{
+    if (n <= 0) return this;
+    this.baseLength += n;
+    var last = this.ops.length - 1;
+    if (last >= 0 && typeof this.ops[last] === 'number' && this.ops[last] < 0) {
+        this.ops[last] -= n;
+    } else {
+        this.ops.push(-n);
+    }
+    return this;
+}
+
+TextOperation.prototype.isNoop = function()
+{
+    return this.ops.length === 0 ||
+           (this.ops.length === 1 && typeof this.ops[0] === 'number' && this.ops[0] > 0);
+}
+
+TextOperation.prototype.toJSON = function()
+{
+    return this.ops;
+}
+
+TextOperation.fromJSON = function(ops)
+{
+    var operation = new TextOperation();
+    _.each(ops, function(op) {
+        if (typeof op === 'string') operation.insert(op);
+        else if (op > 0) operation.retain(op);
+        else operation.remove(-op);
+    });
+    return operation;
+}
+
+// The operation that has the effect of this one followed by other.
+TextOperation.prototype.compose = function(other)
+{
+    var result = new TextOperation();
+    var ops1 = this.ops, ops2 = other.ops;
+    var i1 = 0, i2 = 0;
+    var op1 = ops1[i1++], op2 = ops2[i2++];
+
+    while (!_.isUndefined(op1) || !_.isUndefined(op2)) {
+        if (typeof op1 === 'number' && op1 < 0) {
+            result.remove(-op1);
+            op1 = ops1[i1++];
+        } else if (typeof op2 === 'string') {
+            result.insert(op2);
+            op2 = ops2[i2++];
+        } else if (_.isUndefined(op1) || _.isUndefined(op2)) {
+            throw new Error('Operations cannot be composed.');
+        } else if (typeof op1 === 'string') {
+            if (op2 > 0) {
+                // Retain part of an insert.
+                var length = Math.min(op1.length, op2);
+                result.insert(op1.slice(0, length));
+                op1 = op1.length > op2 ? op1.slice(op2) : ops1[i1++];
+                op2 = op2 > length ? op2 - length : ops2[i2++];
+            } else {
+                // Delete part of an insert.
+                var removed = Math.min(op1.length, -op2);
+                op1 = op1.length > removed ? op1.slice(removed) : ops1[i1++];
+                op2 = -op2 > removed ? op2 + removed : ops2[i2++];
+            }
+        } else {
+            var n = Math.min(op1, Math.abs(op2));
+            if (op2 > 0) result.retain(n); else result.remove(n);
+            op1 = op1 > n ? op1 - n : ops1[i1++];
+            op2 = Math.abs(op2) > n ? (op2 > 0 ? op2 - n : op2 + n) : ops2[i2++];
+        }
+    }
+
+    return result;
+}
+
+// Given a and b made against the same document, returns [a', b'] such that
+// applying a then b' is the same as applying b then a'.
+TextOperation.transform = function(a, b)
+{
+    var aPrime = new TextOperation();
+    var bPrime = new TextOperation();
+    var ops1 = a.ops, ops2 = b.ops;
+    var i1 = 0, i2 = 0;
+    var op1 = ops1[i1++], op2 = ops2[i2++];
+
+    while (!_.isUndefined(op1) || !_.isUndefined(op2)) {
+        if (typeof op1 === 'string') {
+            aPrime.insert(op1);
+            bPrime.retain(op1.length);
+            op1 = ops1[i1++];
+        } else if (typeof op2 === 'string') {
+            aPrime.retain(op2.length);
+            bPrime.insert(op2);
+            op2 = ops2[i2++];
+        } else if (_.isUndefined(op1) || _.isUndefined(op2)) {
+            throw new Error('Operations cannot be transformed.');
+        } else {
+            var n = Math.min(Math.abs(op1), Math.abs(op2));
+            if (op1 > 0 && op2 > 0) {
+                aPrime.retain(n);
+                bPrime.retain(n);
+            } else if (op1 < 0 && op2 > 0) {
+                aPrime.remove(n);
+            } else if (op1 > 0 && op2 < 0) {
+                bPrime.remove(n);
+            }
+            // Both deleted the same text, so neither has to.
+            op1 = Math.abs(op1) > n ? (op1 > 0 ? op1 - n : op1 + n) : ops1[i1++];
+            op2 = Math.abs(op2) > n ? (op2 > 0 ? op2 - n : op2 + n) : ops2[i2++];
+        }
+    }
+
+    return [aPrime, bPrime];
+}
+
+// Keeps an edit session in step with the server's copy of a sketch file.
+// Local changes are sent one operation at a time; changes made while one
+// is waiting to be acknowledged are buffered, and operations from other
+// editors are transformed against both before they are applied.
+function SketchDocument(projectName, fileName, editSession)
+{
+    var _self = this;
+    var _revision = 0;
+    var _isOpen = false;
+    var _isApplying = false;
+    var _outstanding = undefined;
+    var _buffer = undefined;
+    var _Range = ace.require('ace/range').Range;
+
+    var _setContents = function(contents)
+    {
+        if (editSession.getValue() === contents) return;
+        _isApplying = true;
+        editSession.getDocument().setValue(contents);
+        _isApplying = false;
+    }
+
+    // The operation that turns the server's contents into the local ones.
+    var _diff = function(from, to)
+    {
+        var prefix = 0;
+        while (prefix < from.length && prefix < to.length &&
+               from.charAt(prefix) === to.charAt(prefix)) ++prefix;
+        var suffix = 0;
+        while (suffix < from.length - prefix && suffix < to.length - prefix &&
+               from.charAt(from.length - 1 - suffix) === to.charAt(to.length - 1 - suffix)) ++suffix;
+        return new TextOperation().retain(prefix)
+                                  .remove(from.length - prefix - suffix)
+                                  .insert(to.slice(prefix, to.length - suffix))
+                                  .retain(suffix);
+    }
+
+    var _send = function(operation)
+    {
+        _outstanding = operation;
+        JSONRPCClient.call('edit-document',
+                           { projectName: projectName,
+                             fileName: fileName,
+                             revision: _revision,
+                             operation: operation.toJSON(),
+                             clientUUID: CLIENT_UUID },
+                           function(result) {
+                               _revision = result.revision;
+                               var buffer = _buffer;
+                               _outstanding = undefined;
+                               _buffer = undefined;
+                               if (buffer) _send(buffer);
+                           },
+                           function(error) {
+                               console.log('Edit rejected, reloading ' + fileName);
+                               _self.open(false);
+                           });
+    }
+
+    var _applyLocal = function(operation)
+    {
+        if (operation.isNoop()) return;
+        if (_.isUndefined(_outstanding)) {
+            _send(operation);
+        } else if (_.isUndefined(_buffer)) {
+            _buffer = operation;
+        } else {
+            _buffer = _buffer.compose(operation);
+        }
+    }
+
+    var _applyToSession = function(operation)
+    {
+        var doc = editSession.getDocument();
+        var index = 0;
+        _isApplying = true;
+        _.each(operation.ops, function(op) {
+            if (typeof op === 'string') {
+                doc.insert(doc.indexToPosition(index, 0), op);
+                index += op.length;
+            } else if (op > 0) {
+                index += op;
+            } else {
+                doc.remove(_Range.fromPoints(doc.indexToPosition(index, 0),
+                                             doc.indexToPosition(index - op, 0)));
+            }
+        });
+        _isApplying = false;
+    }
+
+    var _onChange = function(e)
+    {
+        if (_isApplying || !_isOpen) return;
+
+        // Older versions of Ace wrap the delta in e.data.
+        var delta = e.data || e;
+        var doc = editSession.getDocument();
+        var newLine = delta.nl || doc.getNewLineCharacter();
+        var text;
+
+        if (!_.isUndefined(delta.text)) {
+            text = delta.text;
+        } else if (delta.action === 'insertLines' || delta.action === 'removeLines') {
+            text = delta.lines.join(newLine) + newLine;
+        } else {
+            text = delta.lines.join(newLine);
+        }
+
+        var isInsert = delta.action.indexOf('insert') === 0;
+        var index = doc.positionToIndex(delta.range ? delta.range.start : delta.start, 0);
+        var length = doc.getValue().length;
+        var baseLength = isInsert ? length - text.length : length + text.length;
+
+        var operation = new TextOperation().retain(index);
+        if (isInsert) operation.insert(text); else operation.remove(text.length);
+        operation.retain(baseLength - index - (isInsert ? 0 : text.length));
+
+        _applyLocal(operation);
+    }
+
+    // Subscribe to the server's copy.  With keepLocal, changes made while
+    // disconnected are sent as an edit; otherwise the server's copy wins.
+    this.open = function(keepLocal)
+    {
+        _isOpen = false;
+        _outstanding = undefined;
+        _buffer = undefined;
+
+        JSONRPCClient.call('open-document',
+                           { projectName: projectName,
+                             fileName: fileName,
+                             clientUUID: CLIENT_UUID },
+                           function(result) {
+                               _revision = result.revision;
+                               _isOpen = true;
+                               if (keepLocal) {
+                                   _applyLocal(_diff(result.fileContents, editSession.getValue()));
+                               } else {
+                                   _setContents(result.fileContents);
+                               }
+                           },
+                           function(error) {
+                               console.log('Unable to open ' + fileName);
+                           });
+    }
+
+    this.close = function()
+    {
+        editSession.removeListener('change', _onChange);
+        if (!_isOpen) return;
+        _isOpen = false;
+        JSONRPCClient.call('close-document',
+                           { projectName: projectName,
+                             fileName: fileName,
+                             clientUUID: CLIENT_UUID },
+                           function(result) {},
+                           function(error) {});
+    }
+
+    // An operation another editor made, as the server applied it.
+    this.receive = function(params)
+    {
+        if (!_isOpen || params.clientUUID === CLIENT_UUID) return;
+
+        var operation = TextOperation.fromJSON(params.operation);
+
+        if (!_.isUndefined(_outstanding)) {
+            var pair = TextOperation.transform(_outstanding, operation);
+            _outstanding = pair[0];
+            operation = pair[1];
+        }
+
+        if (!_.isUndefined(_buffer)) {
+            var pair = TextOperation.transform(_buffer, operation);
+            _buffer = pair[0];
+            operation = pair[1];
+        }
+
+        _applyToSession(operation);
+        _revision = params.revision;
+    }
+
+    // The server replaced its copy, e.g. after the whole project was saved.
+    this.reset = function(params)
+    {
+        _outstanding = undefined;
+        _buffer = undefined;
+        _revision = params.revision;
+        _setContents(params.fileContents);
+    }
+
+    this.getFileName = function()
+    {
+        return fileName;
+    }
+
+    editSession.on('change', _onChange);
+}
@@ -49,6 +49,64 @@ function SketchEditor(callback)
     var _editor = ace.edit('editor');
 
     var _currentRunTaskId = undefined;
+    var _currentCheckTaskId = undefined;
+    var _subscribedProjectName = undefined;
+    var _documents = [];
+
+    // receive the messages about this project, e.g. its build output, but
+    // not those about projects open in other editors
+    var _subscribeToProject = function(projectName)
+    {
+        if (_subscribedProjectName === projectName) return;
+
+        if (!_.isUndefined(_subscribedProjectName)) {
+            JSONRPCClient.call('unsubscribe',
+                               { topics: [ 'project/' + _subscribedProjectName ] },
+                               function(result) {},
+                               function(error) {});
+        }
+
+        _subscribedProjectName = projectName;
+
+        if (projectName) {
+            JSONRPCClient.call('subscribe',
+                               { topics: [ 'project/' + projectName ] },
+                               function(result) {},
+                               function(error) {
+                                   console.log("Unable to subscribe to project messages.");
+                               });
+        }
+    }
+
+    // share each open file with other editors of the project, so edits are
+    // merged on the server instead of overwriting each other on save
+    var _openDocuments = function(keepLocal)
+    {
+        _.each(_documents, function(document) {
+            document.close();
+        });
+
+        _documents = [];
+
+        if (!_self.projectLoaded() || _project.isTemplate()) return;
+
+        _.each(_tabs, function(tab) {
+            var document = new SketchDocument(_project.getName(),
+                                              tab.fileName,
+                                              tab.editSession);
+            document.open(keepLocal);
+            _documents.push(document);
+        });
+    }
+
+    var _getDocument = function(params)
+    {
+        if (!_self.projectLoaded() || params.projectName !== _project.getName()) return undefined;
+
+        return _.find(_documents, function(document) {
+            return document.getFileName() === params.fileName;
+        });
+    }
 
     var _applySettings = function(editorSettings)
     {
@@ -83,8 +141,69 @@ function SketchEditor(callback)
         });
     }
 
+    // completions from the symbol index of openFrameworks, the addons and
+    // the project's own classes
+    var _symbolCompleter = {
+        getCompletions: function(editor, session, pos, prefix, callback) {
+            if (prefix.length === 0) {
+                callback(null, []);
+                return;
+            }
+
+            JSONRPCClient.call('get-completions',
+                               { projectName: _self.projectLoaded() ? _project.getName() : '',
+                                 prefix: prefix },
+                               function(result) {
+                                   callback(null, _.map(result.symbols, function(symbol) {
+                                       return {
+                                           caption: symbol.name,
+                                           value: symbol.name,
+                                           meta: symbol.kind,
+                                           docText: symbol.signature,
+                                           score: 1000
+                                       };
+                                   }));
+                               },
+                               function(error) {
+                                   callback(null, []);
+                               });
+        }
+    };
+
+    // openFrameworks and addon names from the server's dictionary, with
+    // close matches for typos ranked below the prefix matches
+    var _dictionaryCompleter = {
+        getCompletions: function(editor, session, pos, prefix, callback) {
+            if (prefix.length === 0) {
+                callback(null, []);
+                return;
+            }
+
+            JSONRPCClient.call('complete-symbol',
+                               { prefix: prefix },
+                               function(result) {
+                                   var toCompletion = function(match) {
+                                       return {
+                                           caption: match.name,
+                                           value: match.name,
+                                           meta: match.library,
+                                           score: 900 - match.distance * 100
+                                       };
+                                   };
+                                   callback(null, _.map(result.matches, toCompletion)
+                                                   .concat(_.map(result.similarMatches, toCompletion)));
+                               },
+                               function(error) {
+                                   callback(null, []);
+                               });
+        }
+    };
+
     var _registerEvents = function()
     {
+        var languageTools = ace.require("ace/ext/language_tools");
+        languageTools.addCompleter(_symbolCompleter);
+        languageTools.addCompleter(_dictionaryCompleter);
 
         // autocomplete trigger
         _editor.commands.on("afterExec", function(e){
@@ -312,16 +431,42 @@ function SketchEditor(callback)
         _project = new Project(projectName, function(result) {
 
             _initTabs();
+            _subscribeToProject(projectName);
+            _openDocuments(false);
             onSuccess(result);
 
         }, onError);
     }
 
+    // subscriptions end with the connection, so renew them on reconnecting
+    this.resubscribe = function()
+    {
+        var projectName = _subscribedProjectName;
+        _subscribedProjectName = undefined;
+        _subscribeToProject(projectName);
+        _openDocuments(true);
+    }
+
+    // an edit another editor made to an open file
+    this.applyDocumentOperation = function(params)
+    {
+        var document = _getDocument(params);
+        if (document) document.receive(params);
+    }
+
+    // the server replaced an open file, e.g. after a save
+    this.resetDocument = function(params)
+    {
+        var document = _getDocument(params);
+        if (document) document.reset(params);
+    }
+
     this.loadTemplateProject = function(onSuccess, onError)
     {
         _project = new Project('', function(result) {
 
             _initTabs();
+            _openDocuments(false);
             onSuccess(result);
 
         }, onError,
@@ -331,10 +476,13 @@ function SketchEditor(callback)
     this.saveProject = function(onSuccess, onError)
     {
         _updateProject();
-        _project.save(function(){
+        _project.save(function(result){
             _.each(_tabs, function(tab){
                 tab.tabElement.removeClass('unsaved');
             });
+            if (result && result.checkTaskId) {
+                _currentCheckTaskId = result.checkTaskId;
+            }
             onSuccess();
         }, onError);
     }
@@ -345,7 +493,11 @@ function SketchEditor(callback)
         _project.assignName(projectName);
         _renameTab(oldName, projectName);
         _updateProject();
-        _project.create(onSuccess, onError);
+        _project.create(function(result) {
+            _subscribeToProject(projectName);
+            _openDocuments(true);
+            onSuccess(result);
+        }, onError);
     }
 
     this.deleteProject = function(onSuccess, onError)
@@ -363,6 +515,8 @@ function SketchEditor(callback)
         _project.rename(newProjectName, function(result){
             console.log("renaming tab");
             _renameTab(oldProjectName, newProjectName);
+            _subscribeToProject(newProjectName);
+            _openDocuments(true);
             onSuccess(result);
         
         }, onError);
@@ -451,6 +605,7 @@ function SketchEditor(callback)
                     new ace.createEditSession(classFile.fileContents, 
                                         _settings.getData().setMode));
             _resizeTabs(true);
+            _openDocuments(true);
             onSuccess(); // should I pass result object?
         }, onError);
     }
@@ -462,6 +617,7 @@ function SketchEditor(callback)
             tab.tabElement.remove();
             _tabs = _.without(_tabs, tab);
             _resizeTabs(true);
+            _openDocuments(true);
             onSuccess(result);
         }, onError);
     }
@@ -471,6 +627,7 @@ function SketchEditor(callback)
         _project.renameClass(className, newClassName, function(result){
             
             _renameTab(className, newClassName);
+            _openDocuments(true);
 
             onSuccess(result);
         }, onError);
@@ -540,6 +697,11 @@ function SketchEditor(callback)
         return _currentRunTaskId;
     }
 
+    this.getCurrentCheckTaskId = function()
+    {
+        return _currentCheckTaskId;
+    }
+
     this.resize = function()
     {
         _editor.resize();
@@ -631,7 +793,7 @@ function SketchEditor(callback)
                             onError);
     }
 
-    this.annotate = function(compileError)
+    this.annotate = function(compileError, keepSelectedTab)
     {
         var tab = _getTab(compileError.tabName);
 
@@ -676,7 +838,9 @@ function SketchEditor(callback)
                     numAnnotationBadges++;
                 }
 
-                _self.selectTab(compileError.tabName);
+                if (!keepSelectedTab) {
+                    _self.selectTab(compileError.tabName);
+                }
             }
             
             tab.editSession.setAnnotations(newAnnotations);
@@ -152,6 +152,14 @@ $(document).ready( function()
 
             checkVersion();
         }
+        else if (evt.method == "documentOperation")
+        {
+            sketchEditor.applyDocumentOperation(evt.params);
+        }
+        else if (evt.method == "documentReset")
+        {
+            sketchEditor.resetDocument(evt.params);
+        }
         else if (evt.method == "updateEditorSettings")
         {  
             // check that the update didn't come from this client 
@@ -239,6 +247,9 @@ $(document).ready( function()
 
         } else if (evt.method == "taskStarted") {
             // TODO: add a task for the uuid
+            if (evt.params.uuid == sketchEditor.getCurrentCheckTaskId()) {
+                sketchEditor.clearAnnotations();
+            }
 
         } else if (evt.method == "taskCancelled") {
             // TODO: remove the task with the uuid
@@ -282,6 +293,11 @@ $(document).ready( function()
                 }
 
                 consoleEmulator.log(evt.params.message + '\n');
+            } else if (evt.params.uuid == sketchEditor.getCurrentCheckTaskId()) {
+                // a syntax check after saving
+                if (!_.isUndefined(evt.params.compileError)) {
+                    sketchEditor.annotate(evt.params.compileError, true);
+                }
             }
 
         } else {
@@ -294,11 +310,26 @@ $(document).ready( function()
     function onWebSocketOpen(evt) {
         console.log("on open");
         console.log(evt);
+
+        // the server only sends settings and project messages to the
+        // clients that ask for them
+        JSONRPCClient.call('subscribe',
+                           { topics: [ 'settings' ] },
+                           function(result) {},
+                           function(error) {
+                               console.log("Unable to subscribe to settings.");
+                           });
+
+        if (!_.isUndefined(sketchEditor)) {
+            sketchEditor.resubscribe();
+        }
     }
 
-    function onWebSocketMessage(evt) {
+    function onWebSocketMessage(evt, message) {
         try {
-            var json = JSON.parse(evt.data);
+            // The client has already decoded the message, whether it was
+            // sent as JSON or MessagePack.
+            var json = _.isUndefined(message) ? JSON.parse(evt.data) : message;
 
             if (json.module == "Logger") {
                 handleLoggerEvent(json);
@@ -551,6 +582,7 @@ $(document).ready( function()
     JSONRPCClient = new $.JsonRpcClient({ 
             ajaxUrl: getDefaultPostURL(),
             socketUrl: getDefaultWebSocketURL(), // get a websocket for the localhost
+            encoding: 'msgpack', // file contents and build output aren't escaped
             onmessage: onWebSocketMessage,
             onopen: onWebSocketOpen,
             onclose: onWebSocketClose,
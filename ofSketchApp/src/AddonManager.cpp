@@ -87,6 +87,7 @@ void AddonManager::onDirectoryWatcherItemAdded(const ofx::DirectoryWatcher::Dire
     std::string path = evt.item.path();
     std::string name = Poco::Path(path).getBaseName();
 
+    Poco::FastMutex::ScopedLock lock(_mutex);
     _addons[name] = Addon::SharedPtr(new Addon(name, path));
 
 }
@@ -99,6 +100,8 @@ void AddonManager::onDirectoryWatcherItemRemoved(const ofx::DirectoryWatcher::Di
     std::string path = evt.item.path();
     std::string name = Poco::Path(path).getBaseName();
 
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
     std::map<std::string, Addon::SharedPtr>::iterator iter = _addons.find(name);
 
     if (iter != _addons.end())
@@ -138,6 +141,8 @@ void AddonManager::onDirectoryWatcherError(const Poco::Exception& exc)
 
 std::vector<Addon::SharedPtr> AddonManager::getAddons() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
     std::vector<Addon::SharedPtr> addons;
 
     std::map<std::string, Addon::SharedPtr>::const_iterator iter = _addons.begin();
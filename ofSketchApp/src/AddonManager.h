@@ -28,6 +28,7 @@
 
 #include <string>
 #include <set>
+#include "Poco/Mutex.h"
 #include "Poco/URI.h"
 #include "Poco/RegularExpression.h"
 #include "ofx/IO/DirectoryUtils.h"
@@ -67,6 +68,9 @@ private:
 
     ofx::IO::DirectoryFilter _directoryFilter;
 
+    /// \brief The watcher changes the addons while calls read them.
+    mutable Poco::FastMutex _mutex;
+
 };
 
 
@@ -0,0 +1,196 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "AddressMatcher.h"
+#include "Poco/NumberParser.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+AddressMatcher::Node::Node():
+    isNetwork(false)
+{
+    children[0] = 0;
+    children[1] = 0;
+}
+
+
+AddressMatcher::AddressMatcher():
+    _ipv4(1),
+    _ipv6(1)
+{
+}
+
+
+bool AddressMatcher::add(const std::string& network)
+{
+    Poco::Net::IPAddress address;
+    unsigned int prefixLength = 0;
+
+    return parse(network, address, prefixLength) && add(address, prefixLength);
+}
+
+
+bool AddressMatcher::add(const Poco::Net::IPAddress& address,
+                         unsigned int prefixLength)
+{
+    if (prefixLength > address.length() * 8)
+    {
+        return false;
+    }
+
+    const Poco::UInt8* bytes = static_cast<const Poco::UInt8*>(address.addr());
+
+    if (address.length() == IPV4_LENGTH)
+    {
+        _add(_ipv4, bytes, prefixLength);
+    }
+    else
+    {
+        _add(_ipv6, bytes, prefixLength);
+    }
+
+    return true;
+}
+
+
+bool AddressMatcher::matches(const Poco::Net::IPAddress& address) const
+{
+    const Poco::UInt8* bytes = static_cast<const Poco::UInt8*>(address.addr());
+
+    if (address.length() == IPV4_LENGTH)
+    {
+        return _matches(_ipv4, bytes, IPV4_LENGTH);
+    }
+    else if (address.isIPv4Mapped())
+    {
+        // The IPv4 address is in the last four bytes.
+        return _matches(_ipv4, bytes + IPV6_LENGTH - IPV4_LENGTH, IPV4_LENGTH)
+            || _matches(_ipv6, bytes, IPV6_LENGTH);
+    }
+
+    return _matches(_ipv6, bytes, IPV6_LENGTH);
+}
+
+
+void AddressMatcher::clear()
+{
+    _ipv4.assign(1, Node());
+    _ipv6.assign(1, Node());
+}
+
+
+bool AddressMatcher::empty() const
+{
+    return _ipv4.size() == 1 && !_ipv4[0].isNetwork
+        && _ipv6.size() == 1 && !_ipv6[0].isNetwork;
+}
+
+
+bool AddressMatcher::parse(const std::string& network,
+                           Poco::Net::IPAddress& address,
+                           unsigned int& prefixLength)
+{
+    std::string::size_type slash = network.find('/');
+
+    if (!Poco::Net::IPAddress::tryParse(network.substr(0, slash), address))
+    {
+        return false;
+    }
+
+    if (slash == std::string::npos)
+    {
+        prefixLength = address.length() * 8;
+        return true;
+    }
+
+    std::string length = network.substr(slash + 1);
+
+    return !length.empty()
+        && length.find_first_not_of("0123456789") == std::string::npos
+        && Poco::NumberParser::tryParseUnsigned(length, prefixLength)
+        && prefixLength <= address.length() * 8;
+}
+
+
+void AddressMatcher::_add(Trie& trie,
+                          const Poco::UInt8* bytes,
+                          unsigned int prefixLength)
+{
+    Poco::UInt32 node = 0;
+
+    for (unsigned int i = 0; i < prefixLength; ++i)
+    {
+        // A wider network already holds this one.
+        if (trie[node].isNetwork)
+        {
+            return;
+        }
+
+        int bit = (bytes[i / 8] >> (7 - i % 8)) & 1;
+
+        if (trie[node].children[bit] == 0)
+        {
+            trie[node].children[bit] = Poco::UInt32(trie.size());
+            trie.push_back(Node());
+        }
+
+        node = trie[node].children[bit];
+    }
+
+    // Everything below is now covered, but the nodes are left in place;
+    // the trie is rebuilt from scratch when the settings change.
+    trie[node].isNetwork = true;
+}
+
+
+bool AddressMatcher::_matches(const Trie& trie,
+                              const Poco::UInt8* bytes,
+                              std::size_t length)
+{
+    Poco::UInt32 node = 0;
+
+    for (std::size_t i = 0; i < length * 8; ++i)
+    {
+        if (trie[node].isNetwork)
+        {
+            return true;
+        }
+
+        node = trie[node].children[(bytes[i / 8] >> (7 - i % 8)) & 1];
+
+        if (node == 0)
+        {
+            return false;
+        }
+    }
+
+    return trie[node].isNetwork;
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,93 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include "Poco/Net/IPAddress.h"
+#include "Poco/Types.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Matches IP addresses against networks such as "192.168.1.0/24",
+///        using a binary trie over the address bits.
+class AddressMatcher
+{
+public:
+    AddressMatcher();
+
+    /// \returns false if network isn't an address or CIDR block.
+    bool add(const std::string& network);
+
+    /// \returns false if prefixLength is longer than the address.
+    bool add(const Poco::Net::IPAddress& address, unsigned int prefixLength);
+
+    bool matches(const Poco::Net::IPAddress& address) const;
+
+    void clear();
+
+    bool empty() const;
+
+    static bool parse(const std::string& network,
+                      Poco::Net::IPAddress& address,
+                      unsigned int& prefixLength);
+
+    enum
+    {
+        IPV4_LENGTH = 4,
+        IPV6_LENGTH = 16
+    };
+
+private:
+    struct Node
+    {
+        Node();
+
+        Poco::UInt32 children[2]; // 0 for none, since the root is no child
+        bool isNetwork;
+    };
+
+    typedef std::vector<Node> Trie;
+
+    Trie _ipv4;
+    Trie _ipv6;
+
+    static void _add(Trie& trie,
+                     const Poco::UInt8* bytes,
+                     unsigned int prefixLength);
+
+    static bool _matches(const Trie& trie,
+                         const Poco::UInt8* bytes,
+                         std::size_t length);
+
+};
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,384 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "AdmissionRoute.h"
+#include <algorithm>
+#include "Poco/String.h"
+#include "ofLog.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+const std::string AdmissionRoute::TOO_MANY_REQUESTS_REASON = "Too Many Requests";
+
+
+AdmissionRoute::Settings::Settings():
+    allowRemote(false),
+    requestsPerSecond(DEFAULT_REQUESTS_PER_SECOND),
+    requestBurst(DEFAULT_REQUEST_BURST),
+    maximumWebSockets(DEFAULT_MAXIMUM_WEBSOCKETS),
+    callsPerSecond(DEFAULT_CALLS_PER_SECOND),
+    callBurst(DEFAULT_CALL_BURST)
+{
+}
+
+
+AdmissionRoute::Settings AdmissionRoute::Settings::fromJson(const Json::Value& json)
+{
+    Settings settings;
+
+    settings.requestsPerSecond = json.get("requestsPerSecond", settings.requestsPerSecond).asDouble();
+    settings.requestBurst = json.get("requestBurst", settings.requestBurst).asDouble();
+    settings.maximumWebSockets = json.get("maximumWebSockets", Json::UInt64(settings.maximumWebSockets)).asUInt();
+    settings.callsPerSecond = json.get("callsPerSecond", settings.callsPerSecond).asDouble();
+    settings.callBurst = json.get("callBurst", settings.callBurst).asDouble();
+
+    // A bucket that can't hold one token would never admit anything.
+    settings.requestsPerSecond = std::max(0.0, settings.requestsPerSecond);
+    settings.requestBurst = std::max(1.0, settings.requestBurst);
+    settings.callsPerSecond = std::max(0.0, settings.callsPerSecond);
+    settings.callBurst = std::max(1.0, settings.callBurst);
+
+    return settings;
+}
+
+
+AdmissionRoute::TokenBucket::TokenBucket(double tokens_):
+    tokens(tokens_)
+{
+}
+
+
+bool AdmissionRoute::TokenBucket::take(double rate, double burst)
+{
+    Poco::Timestamp now;
+
+    tokens = std::min(burst, tokens + rate * (now - updated) / 1000000.0);
+    updated = now;
+
+    if (tokens < 1)
+    {
+        return false;
+    }
+
+    tokens -= 1;
+    return true;
+}
+
+
+bool AdmissionRoute::TokenBucket::isFull(double rate, double burst) const
+{
+    return tokens + rate * updated.elapsed() / 1000000.0 >= burst;
+}
+
+
+AdmissionRoute::Client::Client(const Settings& settings):
+    requests(settings.requestBurst),
+    calls(settings.callBurst),
+    webSockets(0)
+{
+}
+
+
+AdmissionRoute::AdmissionRoute():
+    _rejectedRequests(0),
+    _rejectedCalls(0)
+{
+    setSettings(Settings());
+}
+
+
+AdmissionRoute::~AdmissionRoute()
+{
+}
+
+
+void AdmissionRoute::setSettings(const Settings& settings)
+{
+    AddressMatcher allowed;
+
+    // The local host may always connect.
+    allowed.add("127.0.0.0/8");
+    allowed.add("::1");
+
+    if (settings.allowRemote)
+    {
+        if (settings.whitelistedIPs.empty())
+        {
+            allowed.add("0.0.0.0/0");
+            allowed.add("::/0");
+        }
+
+        for (std::size_t i = 0; i < settings.whitelistedIPs.size(); ++i)
+        {
+            if (!allowed.add(settings.whitelistedIPs[i]))
+            {
+                ofLogWarning("AdmissionRoute::setSettings") << "Invalid whitelisted address: " << settings.whitelistedIPs[i];
+            }
+        }
+    }
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    _settings = settings;
+    std::swap(_allowed, allowed);
+}
+
+
+AdmissionRoute::Settings AdmissionRoute::getSettings() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return _settings;
+}
+
+
+bool AdmissionRoute::canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                                      bool isSecurePort) const
+{
+    // The server only asks the routes whether they can handle a request,
+    // so admitting it, which takes from the host's budget, happens here.
+    return !const_cast<AdmissionRoute*>(this)->_admitRequest(request);
+}
+
+
+void AdmissionRoute::handleRequest(Poco::Net::HTTPServerRequest& request,
+                                   Poco::Net::HTTPServerResponse& response)
+{
+    if (isAllowed(request.clientAddress().host()))
+    {
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTPStatus(HTTP_TOO_MANY_REQUESTS),
+                                    TOO_MANY_REQUESTS_REASON);
+        response.set("Retry-After", "1");
+    }
+    else
+    {
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_FORBIDDEN);
+    }
+
+    response.setKeepAlive(false);
+    response.setContentLength(0);
+    response.send();
+}
+
+
+bool AdmissionRoute::isAllowed(const Poco::Net::IPAddress& address) const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return _allowed.matches(address);
+}
+
+
+bool AdmissionRoute::admitCall(const Poco::Net::IPAddress& address)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (!_allowed.matches(address))
+    {
+        ++_rejectedCalls;
+        return false;
+    }
+    else if (_isLocal(address) || _settings.callsPerSecond <= 0)
+    {
+        return true;
+    }
+
+    Client* client = _getClient(address);
+
+    if (client && client->calls.take(_settings.callsPerSecond, _settings.callBurst))
+    {
+        return true;
+    }
+
+    ++_rejectedCalls;
+    return false;
+}
+
+
+void AdmissionRoute::webSocketOpened(const Poco::Net::IPAddress& address)
+{
+    if (_isLocal(address))
+    {
+        return;
+    }
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Client* client = _getClient(address);
+
+    if (client)
+    {
+        ++client->webSockets;
+    }
+}
+
+
+void AdmissionRoute::webSocketClosed(const Poco::Net::IPAddress& address)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<std::string, Client>::iterator iter = _clients.find(_getKey(address));
+
+    if (iter != _clients.end() && iter->second.webSockets > 0)
+    {
+        --iter->second.webSockets;
+    }
+}
+
+
+Json::Value AdmissionRoute::toJson() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Json::Value json;
+    json["rejectedRequests"] = Json::UInt64(_rejectedRequests);
+    json["rejectedCalls"] = Json::UInt64(_rejectedCalls);
+    json["clients"] = Json::UInt64(_clients.size());
+    return json;
+}
+
+
+bool AdmissionRoute::_admitRequest(const Poco::Net::HTTPServerRequest& request)
+{
+    const Poco::Net::IPAddress& address = request.clientAddress().host();
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (!_allowed.matches(address))
+    {
+        ++_rejectedRequests;
+        ofLogVerbose("AdmissionRoute::_admitRequest") << "Rejected connection from: " << address.toString();
+        return false;
+    }
+    else if (_isLocal(address))
+    {
+        return true;
+    }
+
+    Client* client = _getClient(address);
+
+    if (!client)
+    {
+        ++_rejectedRequests;
+        return false;
+    }
+
+    if (_settings.requestsPerSecond > 0
+     && !client->requests.take(_settings.requestsPerSecond, _settings.requestBurst))
+    {
+        ++_rejectedRequests;
+        return false;
+    }
+
+    // The count goes up once the handshake is done; a few handshakes at
+    // once may still get past the limit.
+    if (_settings.maximumWebSockets > 0
+     && client->webSockets >= _settings.maximumWebSockets
+     && Poco::icompare(request.get("Upgrade", ""), "websocket") == 0)
+    {
+        ++_rejectedRequests;
+        return false;
+    }
+
+    return true;
+}
+
+
+AdmissionRoute::Client* AdmissionRoute::_getClient(const Poco::Net::IPAddress& address)
+{
+    std::string key = _getKey(address);
+
+    std::map<std::string, Client>::iterator iter = _clients.find(key);
+
+    if (iter != _clients.end())
+    {
+        return &iter->second;
+    }
+
+    if (_clients.size() >= MAXIMUM_CLIENTS)
+    {
+        _forgetIdleClients();
+
+        if (_clients.size() >= MAXIMUM_CLIENTS)
+        {
+            return 0;
+        }
+    }
+
+    return &_clients.insert(std::make_pair(key, Client(_settings))).first->second;
+}
+
+
+void AdmissionRoute::_forgetIdleClients()
+{
+    std::map<std::string, Client>::iterator iter = _clients.begin();
+
+    while (iter != _clients.end())
+    {
+        const Client& client = iter->second;
+
+        // A host with a full budget would be back where it started.
+        if (client.webSockets == 0
+         && client.requests.isFull(_settings.requestsPerSecond, _settings.requestBurst)
+         && client.calls.isFull(_settings.callsPerSecond, _settings.callBurst))
+        {
+            _clients.erase(iter++);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+
+bool AdmissionRoute::_isLocal(const Poco::Net::IPAddress& address)
+{
+    if (address.isIPv4Mapped())
+    {
+        const Poco::UInt8* bytes = static_cast<const Poco::UInt8*>(address.addr());
+        return bytes[AddressMatcher::IPV6_LENGTH - AddressMatcher::IPV4_LENGTH] == 127;
+    }
+
+    return address.isLoopback();
+}
+
+
+std::string AdmissionRoute::_getKey(const Poco::Net::IPAddress& address)
+{
+    const char* bytes = static_cast<const char*>(address.addr());
+
+    if (address.isIPv4Mapped())
+    {
+        return std::string(bytes + AddressMatcher::IPV6_LENGTH - AddressMatcher::IPV4_LENGTH,
+                           AddressMatcher::IPV4_LENGTH);
+    }
+
+    return std::string(bytes, address.length());
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,166 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <json/json.h>
+#include "Poco/Mutex.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/Net/IPAddress.h"
+#include "Poco/Timestamp.h"
+#include "ofxHTTP.h"
+#include "AddressMatcher.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Turns away hosts that aren't allowed to connect, or that are
+///        connecting too often.  The local host isn't limited.
+class AdmissionRoute: public ofx::HTTP::BaseRoute
+{
+public:
+    typedef std::shared_ptr<AdmissionRoute> SharedPtr;
+
+    struct Settings
+    {
+        Settings();
+
+        bool allowRemote;
+
+        /// \brief If empty, any remote host may connect.
+        std::vector<std::string> whitelistedIPs;
+
+        double requestsPerSecond; // 0 for no limit
+        double requestBurst;
+        std::size_t maximumWebSockets; // 0 for no limit
+        double callsPerSecond; // 0 for no limit
+        double callBurst;
+
+        /// \brief Read the limits, but not the whitelist.
+        static Settings fromJson(const Json::Value& json);
+    };
+
+    AdmissionRoute();
+
+    virtual ~AdmissionRoute();
+
+    void setSettings(const Settings& settings);
+
+    Settings getSettings() const;
+
+    /// \returns true if the request must be turned away.
+    bool canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                          bool isSecurePort) const;
+
+    void handleRequest(Poco::Net::HTTPServerRequest& request,
+                       Poco::Net::HTTPServerResponse& response);
+
+    bool isAllowed(const Poco::Net::IPAddress& address) const;
+
+    /// \returns false if the host may not make another call yet.
+    bool admitCall(const Poco::Net::IPAddress& address);
+
+    void webSocketOpened(const Poco::Net::IPAddress& address);
+
+    void webSocketClosed(const Poco::Net::IPAddress& address);
+
+    Json::Value toJson() const;
+
+    static SharedPtr makeShared()
+    {
+        return SharedPtr(new AdmissionRoute());
+    }
+
+    static const std::string TOO_MANY_REQUESTS_REASON;
+
+    enum
+    {
+        DEFAULT_REQUESTS_PER_SECOND = 50,
+        DEFAULT_REQUEST_BURST = 200,
+        DEFAULT_MAXIMUM_WEBSOCKETS = 16,
+        DEFAULT_CALLS_PER_SECOND = 20,
+        DEFAULT_CALL_BURST = 100,
+
+        HTTP_TOO_MANY_REQUESTS = 429,
+        MAXIMUM_CLIENTS = 1024
+    };
+
+private:
+    /// \brief Allows a burst of events, then refills at a steady rate.
+    struct TokenBucket
+    {
+        TokenBucket(double tokens);
+
+        double tokens;
+        Poco::Timestamp updated;
+
+        bool take(double rate, double burst);
+
+        bool isFull(double rate, double burst) const;
+    };
+
+    struct Client
+    {
+        Client(const Settings& settings);
+
+        TokenBucket requests;
+        TokenBucket calls;
+        std::size_t webSockets;
+    };
+
+    Settings _settings;
+
+    AddressMatcher _allowed;
+
+    std::map<std::string, Client> _clients;
+
+    Poco::UInt64 _rejectedRequests;
+    Poco::UInt64 _rejectedCalls;
+
+    mutable Poco::FastMutex _mutex;
+
+    /// \returns true if the request may go on to the other routes.
+    bool _admitRequest(const Poco::Net::HTTPServerRequest& request);
+
+    /// \returns the state of a host, or 0 if too many hosts are tracked.
+    Client* _getClient(const Poco::Net::IPAddress& address);
+
+    void _forgetIdleClients();
+
+    static bool _isLocal(const Poco::Net::IPAddress& address);
+
+    static std::string _getKey(const Poco::Net::IPAddress& address);
+
+};
+
+
+} } // namespace of::Sketch
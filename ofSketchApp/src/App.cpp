@@ -42,9 +42,22 @@ App::App():
     _compiler(_taskQueue, ofToDataPath("Resources/Templates/CompilerTemplates"),
               ofToDataPath("openFrameworks", true)),
     _addonManager(ofToDataPath(_ofSketchSettings.getAddonsDir())),
-    _projectManager(ofToDataPath(_ofSketchSettings.getProjectDir(), true)),
+    _projectManager(ofToDataPath(_ofSketchSettings.getProjectDir(), true),
+                    _ofSketchSettings.getStorageDurability()),
+    _projectHistory(_ofSketchSettings.getHistoryDir(),
+                    _ofSketchSettings.getStorageDurability()),
+    _projectIndex(_ofSketchSettings.getHistoryDir() + "/index.json",
+                  _ofSketchSettings.getStorageDurability()),
+    _symbolIndexer(_ofSketchSettings.getIndexDir(),
+                   _ofSketchSettings.getStorageDurability()),
     _uploadRouter(ofToDataPath(_ofSketchSettings.getProjectDir(), true)),
-    _missingDependencies(true)
+    _staticAssetRoute(StaticAssetRoute::makeShared(ofToDataPath("DocumentRoot", true),
+                                                   _ofSketchSettings.getCacheDir() + "/DocumentRoot")),
+    _admissionRoute(AdmissionRoute::makeShared()),
+    _rpcDispatcher(_topicRouter),
+    _rpcRoute(RPCRoute::makeShared(_rpcDispatcher)),
+    _missingDependencies(true),
+    _lastDocumentSave(0)
 {
     if (hasDependency("make"))
     {
@@ -54,6 +67,26 @@ App::App():
     ofLogNotice("App::App") << "Editor setting's projectDir: " << _ofSketchSettings.getProjectDir();
     _taskQueue.registerTaskEvents(this);
 
+    _projectIndex.reset(_projectManager.getProjects());
+
+    _compiler.setupBuildWorkers(_ofSketchSettings.getBuildWorkers());
+    _topicRouter.setSettings(_ofSketchSettings.getSendQueue());
+    _admissionRoute->setSettings(_ofSketchSettings.getAdmission());
+    _rpcDispatcher.setAdmissionRoute(_admissionRoute);
+
+    std::map<std::string, std::string> symbolLibraries;
+    symbolLibraries["openFrameworks"] = _ofSketchSettings.getOpenFrameworksDir() + "/libs/openFrameworks";
+
+    std::vector<Addon::SharedPtr> addons = _addonManager.getAddons();
+
+    for (std::size_t i = 0; i < addons.size(); ++i)
+    {
+        symbolLibraries[addons[i]->getName()] = addons[i]->getPath().toString() + "/src";
+    }
+
+    _symbolIndexer.start(symbolLibraries,
+                         ofToDataPath("Resources/ofFunctionDictionary.json", true));
+
     ofLogNotice("App::App") << "Starting server on port: " << _ofSketchSettings.getPort() << " With Websocket Buffer Size: " << _ofSketchSettings.getBufferSize();
 
     ofx::HTTP::BasicJSONRPCServerSettings settings; // TODO: load from file.
@@ -64,6 +97,19 @@ App::App():
 
     server = ofx::HTTP::BasicJSONRPCServer::makeShared(settings);
 
+    // Routes added later are tried first, so the cached assets are served
+    // ahead of the file system route.
+    _staticAssetRoute->setup();
+    server->addRoute(_staticAssetRoute);
+
+    // Ahead of the JSONRPC server's own route, so that HTTP calls run on
+    // the dispatcher's strands too.
+    server->addRoute(_rpcRoute);
+
+    // Added last, so that hosts that may not connect are turned away
+    // before any other route looks at their requests.
+    server->addRoute(_admissionRoute);
+
     // Must register for all events before initializing server.
     ofSSLManager::registerAllEvents(this);
 
@@ -86,6 +132,9 @@ App::~App()
 
     server->getWebSocketRoute()->unregisterWebSocketEvents(this);
     server->getPostRoute()->unregisterPostEvents(&_uploadRouter);
+    server->removeRoute(_admissionRoute);
+    server->removeRoute(_rpcRoute);
+    server->removeRoute(_staticAssetRoute);
 
     ofSSLManager::unregisterAllEvents(this);
 }
@@ -104,130 +153,219 @@ void App::setup()
                                                           ofToDataPath("ssl/cacert.pem")));
 
     // TODO: configure these via settings files
-    server->registerMethod("load-project",
-                           "Load the requested project.",
-                           this,
-                           &App::loadProject);
-
-    server->registerMethod("load-template-project",
-                           "Load an anonymous project.",
-                           this,
-                           &App::loadTemplateProject);
-
-    server->registerMethod("save-project",
-                           "Save the current project.",
-                           this,
-                           &App::saveProject);
-
-    server->registerMethod("create-project",
-                           "Create a new project.",
-                           this,
-                           &App::createProject);
-
-    server->registerMethod("delete-project",
-                           "Delete the current project.",
-                           this,
-                           &App::deleteProject);
-
-    server->registerMethod("rename-project",
-                           "Rename the current project.",
-                           this,
-                           &App::renameProject);
-
-    server->registerMethod("notify-project-closed",
-                           "Notify the server that project was closed.",
-                           this,
-                           &App::notifyProjectClosed);
-
-    server->registerMethod("request-project-closed",
-                           "Broadcast a project close request to connected clients.",
-                           this,
-                           &App::requestProjectClosed);
-
-    server->registerMethod("request-app-quit",
-                           "Quit the app.",
-                           this,
-                           &App::requestAppQuit);
-
-    server->registerMethod("create-class",
-                           "Create a new class for the current project.",
-                           this,
-                           &App::createClass);
-
-    server->registerMethod("delete-class",
-                           "Delete a select class from for the current project.",
-                           this,
-                           &App::deleteClass);
-
-    server->registerMethod("rename-class",
-                           "Rename a select class from for the current project.",
-                           this,
-                           &App::renameClass);
-
-    server->registerMethod("run-project",
-                           "Run the requested project.",
-                           this,
-                           &App::runProject);
-
-    server->registerMethod("compile-project",
-                           "Run the requested project.",
-                           this,
-                           &App::compileProject);
-
-    server->registerMethod("stop",
-                           "Stop the requested project.",
-                           this,
-                           &App::stop);
-
-    server->registerMethod("get-project-list",
-                           "Get list of all projects in the Project directory.",
-                           this,
-                           &App::getProjectList);
-
-    server->registerMethod("load-editor-settings",
-                           "Get the editor settings.",
-                           this,
-                           &App::loadEditorSettings);
-
-    server->registerMethod("save-editor-settings",
-                           "Save the editor settings.",
-                           this,
-                           &App::saveEditorSettings);
-
-    server->registerMethod("load-ofsketch-settings",
-                           "Get ofSketch settings.",
-                           this,
-                           &App::loadOfSketchSettings);
-
-    server->registerMethod("save-ofsketch-settings",
-                           "Save ofSketch settings.",
-                           this,
-                           &App::saveOfSketchSettings);
-
-    server->registerMethod("get-addon-list",
-                           "Get a list of all addons.",
-                           this,
-                           &App::getAddonList);
-
-    server->registerMethod("get-project-addon-list",
-                           "Get a list of addons for a project.",
-                           this,
-                           &App::getProjectAddonList);
-
-    server->registerMethod("add-project-addon",
-                           "Add an addon to a project.",
-                           this,
-                           &App::addProjectAddon);
-
-    server->registerMethod("remove-project-addon",
-                           "Remove an addon from a project.",
-                           this,
-                           &App::removeProjectAddon);
-
-    server->registerMethod("export-project",
-                           "Export the project for target platform.",
-                           this,
-                           &App::exportProject);
+    _registerMethod("load-project",
+                    "Load the requested project.",
+                    &App::loadProject);
+
+    _registerMethod("load-template-project",
+                    "Load an anonymous project.",
+                    &App::loadTemplateProject);
+
+    _registerMethod("save-project",
+                    "Save the current project.",
+                    &App::saveProject);
+
+    _registerMethod("create-project",
+                    "Create a new project.",
+                    &App::createProject,
+                    RPCDispatcher::PROJECT_LIST_STRAND);
+
+    _registerMethod("duplicate-project",
+                    "Duplicate a project under a new name.",
+                    &App::duplicateProject,
+                    RPCDispatcher::PROJECT_LIST_STRAND);
+
+    _registerMethod("delete-project",
+                    "Delete the current project.",
+                    &App::deleteProject,
+                    RPCDispatcher::PROJECT_LIST_STRAND);
+
+    _registerMethod("rename-project",
+                    "Rename the current project.",
+                    &App::renameProject,
+                    RPCDispatcher::PROJECT_LIST_STRAND);
+
+    _registerMethod("notify-project-closed",
+                    "Notify the server that project was closed.",
+                    &App::notifyProjectClosed);
+
+    _registerMethod("request-project-closed",
+                    "Broadcast a project close request to connected clients.",
+                    &App::requestProjectClosed);
+
+    _registerMethod("request-app-quit",
+                    "Quit the app.",
+                    &App::requestAppQuit);
+
+    _registerMethod("create-class",
+                    "Create a new class for the current project.",
+                    &App::createClass);
+
+    _registerMethod("delete-class",
+                    "Delete a select class from for the current project.",
+                    &App::deleteClass);
+
+    _registerMethod("rename-class",
+                    "Rename a select class from for the current project.",
+                    &App::renameClass);
+
+    _registerMethod("run-project",
+                    "Run the requested project.",
+                    &App::runProject);
+
+    _registerMethod("compile-project",
+                    "Run the requested project.",
+                    &App::compileProject);
+
+    _registerMethod("stop",
+                    "Stop the requested project.",
+                    &App::stop);
+
+    _registerMethod("get-project-list",
+                    "Get list of all projects in the Project directory.",
+                    &App::getProjectList,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("get-build-profiles",
+                    "Get the profiles that projects can be built with.",
+                    &App::getBuildProfiles,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("get-build-workers",
+                    "Get the build workers and their health.",
+                    &App::getBuildWorkers,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("get-toolchains",
+                    "Get the toolchains that projects can be cross compiled with.",
+                    &App::getToolchains,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("get-project-build-options",
+                    "Get the build options of a project.",
+                    &App::getProjectBuildOptions);
+
+    _registerMethod("set-project-build-options",
+                    "Change the build options of a project.",
+                    &App::setProjectBuildOptions);
+
+    _registerMethod("get-project-summaries",
+                    "Get a page of project summaries matching a query.",
+                    &App::getProjectSummaries,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("load-editor-settings",
+                    "Get the editor settings.",
+                    &App::loadEditorSettings,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("save-editor-settings",
+                    "Save the editor settings.",
+                    &App::saveEditorSettings);
+
+    _registerMethod("load-ofsketch-settings",
+                    "Get ofSketch settings.",
+                    &App::loadOfSketchSettings,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("save-ofsketch-settings",
+                    "Save ofSketch settings.",
+                    &App::saveOfSketchSettings);
+
+    _registerMethod("get-addon-list",
+                    "Get a list of all addons.",
+                    &App::getAddonList,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("get-project-addon-list",
+                    "Get a list of addons for a project.",
+                    &App::getProjectAddonList);
+
+    _registerMethod("add-project-addon",
+                    "Add an addon to a project.",
+                    &App::addProjectAddon);
+
+    _registerMethod("remove-project-addon",
+                    "Remove an addon from a project.",
+                    &App::removeProjectAddon);
+
+    _registerMethod("export-project",
+                    "Export the project for target platform.",
+                    &App::exportProject);
+
+    _registerMethod("open-document",
+                    "Open a project file for collaborative editing.",
+                    &App::openDocument);
+
+    _registerMethod("edit-document",
+                    "Apply an edit operation to an open project file.",
+                    &App::editDocument);
+
+    _registerMethod("close-document",
+                    "Stop editing a project file.",
+                    &App::closeDocument);
+
+    _registerMethod("get-project-history",
+                    "Get the saved versions of a project.",
+                    &App::getProjectHistory);
+
+    _registerMethod("diff-project-versions",
+                    "Compare two saved versions of a project.",
+                    &App::diffProjectVersions);
+
+    _registerMethod("get-completions",
+                    "Get the symbols that start with a prefix.",
+                    &App::getCompletions,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("find-definition",
+                    "Find where a symbol is declared.",
+                    &App::findDefinition,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("complete-symbol",
+                    "Get the openFrameworks and addon names that start with, or nearly with, a prefix.",
+                    &App::completeSymbol,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod(TopicRouter::SUBSCRIBE_METHOD,
+                    "Receive the messages published to a list of topics.",
+                    &App::subscribe,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod(TopicRouter::UNSUBSCRIBE_METHOD,
+                    "Stop receiving the messages published to a list of topics.",
+                    &App::unsubscribe,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod(TopicRouter::SET_ENCODING_METHOD,
+                    "Choose how messages sent over the websocket are encoded, json or msgpack.",
+                    &App::setEncoding,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("get-connection-stats",
+                    "Get how far behind each websocket connection is.",
+                    &App::getConnectionStats,
+                    "",
+                    RPCDispatcher::UNORDERED);
+
+    _registerMethod("restore-project-version",
+                    "Restore a saved version of a project.",
+                    &App::restoreProjectVersion);
 
     server->start();
 
@@ -243,6 +381,14 @@ void App::setup()
 
 void App::update()
 {
+    _topicRouter.update();
+
+    if (ofGetElapsedTimeMillis() - _lastDocumentSave > DOCUMENT_SAVE_INTERVAL)
+    {
+        _postDocumentSaves();
+        _projectIndex.save();
+        _lastDocumentSave = ofGetElapsedTimeMillis();
+    }
 }
 
 
@@ -263,10 +409,13 @@ void App::exit()
     Json::Value params;
     params["foo"] = "bar";
     Json::Value json = Utils::toJSONMethod("Server", "appExit", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
-    server->getWebSocketRoute()->broadcast(frame);
+    _topicRouter.broadcast(json);
     ofLogNotice("App::exit") << "appExit frame broadcasted" << endl;
 
+    _postDocumentSaves();
+    _rpcDispatcher.waitForCalls();
+    _projectIndex.save();
+
     // Reset default logger.
     ofLogToConsole();
 }
@@ -302,6 +451,7 @@ void App::loadProject(const void* pSender, ofx::JSONRPC::MethodArgs& args)
         if (_projectManager.projectExists(projectName))
         {
             _projectManager.loadProject(pSender, args);
+            _symbolIndexer.indexProject(*_projectManager.getProject(projectName));
         }
         else args.error["message"] = "The requested project does not exist.";
     }
@@ -322,8 +472,21 @@ void App::saveProject(const void* pSender, ofx::JSONRPC::MethodArgs& args)
     if (_projectManager.projectExists(projectName))
     {
         _projectManager.saveProject(pSender, args);
-        const Project& project = _projectManager.getProject(projectName);
-        _compiler.generateSourceFiles(project);
+        // Edits made through open documents take precedence.
+        _saveDocuments(projectName);
+        Project::SharedPtr project = _projectManager.getProject(projectName);
+        _reloadDocuments(*project);
+        _projectHistory.snapshot(*project);
+        _projectIndex.update(*project);
+
+        std::vector<std::string> changedFiles = _compiler.generateSourceFiles(*project);
+
+        // Report errors in what changed without waiting for a build.
+        if (!changedFiles.empty())
+        {
+            _symbolIndexer.updateProject(*project, changedFiles);
+            args.result["checkTaskId"] = _compiler.check(*project, changedFiles).toString();
+        }
     }
     else args.error["message"] = "The requested project does not exist.";
 }
@@ -335,17 +498,61 @@ void App::createProject(const void* pSender, ofx::JSONRPC::MethodArgs& args)
     if (!_projectManager.projectExists(projectName))
     {
         _projectManager.createProject(pSender, args);
+
+        std::string createdName = args.params["projectData"]["projectFile"]["name"].asString();
+
+        if (_projectManager.projectExists(createdName))
+        {
+            _projectHistory.snapshot(*_projectManager.getProject(createdName));
+            _projectIndex.update(*_projectManager.getProject(createdName));
+        }
     }
     else args.error["message"] = "That project name already exists.";
 }
 
 
+void App::duplicateProject(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+    std::string newProjectName = args.params["newProjectName"].asString();
+
+    if (!_projectManager.projectExists(projectName))
+    {
+        args.error["message"] = "The project that you are trying to duplicate does not exist.";
+    }
+    else if (_projectManager.projectExists(newProjectName))
+    {
+        args.error["message"] = "That project name already exists.";
+    }
+    else
+    {
+        _saveDocuments(projectName);
+        _projectManager.duplicateProject(pSender, args);
+
+        if (_projectManager.projectExists(newProjectName))
+        {
+            _projectHistory.snapshot(*_projectManager.getProject(newProjectName));
+            _projectIndex.update(*_projectManager.getProject(newProjectName));
+        }
+    }
+}
+
+
 void App::deleteProject(const void* pSender, ofx::JSONRPC::MethodArgs& args)
 {
     std::string projectName = args.params["projectName"].asString();
     if (_projectManager.projectExists(projectName))
     {
+        _documentManager.closeProject(projectName);
+        _symbolIndexer.removeProject(_projectManager.getProject(projectName)->getPath());
         _projectManager.deleteProject(pSender, args);
+
+        if (args.error.isNull())
+        {
+            _projectHistory.remove(projectName);
+            _projectIndex.remove(projectName);
+        }
+
         requestProjectClosed(pSender, args);
     }
     else args.error["message"] = "The project that you are trying to delete does not exist.";
@@ -357,7 +564,16 @@ void App::renameProject(const void* pSender, ofx::JSONRPC::MethodArgs& args)
     std::string projectName = args.params["projectName"].asString();
     if (_projectManager.projectExists(projectName))
     {
+        _saveDocuments(projectName);
+        _documentManager.closeProject(projectName);
+        _symbolIndexer.removeProject(_projectManager.getProject(projectName)->getPath());
         _projectManager.renameProject(pSender, args);
+
+        if (args.error.isNull())
+        {
+            _projectHistory.rename(projectName, args.params["newProjectName"].asString());
+            _projectIndex.rename(projectName, args.params["newProjectName"].asString());
+        }
         requestProjectClosed(pSender, args);
     }
     else args.error["message"] = "The project that you are trying to delete does not exist.";
@@ -377,13 +593,12 @@ void App::requestProjectClosed(const void* pSender, ofx::JSONRPC::MethodArgs& ar
     std::string projectName = args.params["projectName"].asString();
     std::string clientUUID = args.params["clientUUID"].asString();
 
-    // broadcast requestProjectClosed settings to all connected clients
+    // send requestProjectClosed to the clients that have the project open
     Json::Value params;
     params["projectName"] = projectName;
     params["clientUUID"] = clientUUID;
     Json::Value json = Utils::toJSONMethod("Server", "requestProjectClosed", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
-    server->getWebSocketRoute()->broadcast(frame);
+    _topicRouter.publish(TopicRouter::getProjectTopic(projectName), json);
 }
 
 
@@ -401,8 +616,10 @@ void App::createClass(const void* pSender, ofx::JSONRPC::MethodArgs& args)
     if (_projectManager.projectExists(projectName))
     {
         std::string className = args.params["className"].asString();
-        Project& project = _projectManager.getProjectRef(projectName);
-        args.result["classFile"] = project.createClass(className);
+        Project::SharedPtr project = _projectManager.getProject(projectName);
+        args.result["classFile"] = project->createClass(className);
+        _projectHistory.snapshot(*project);
+        _projectIndex.update(*project);
 
     }
     else args.error["message"] = "The requested project does not exist.";
@@ -415,9 +632,11 @@ void App::deleteClass(const void* pSender, ofx::JSONRPC::MethodArgs& args)
     if (_projectManager.projectExists(projectName))
     {
         std::string className = args.params["className"].asString();
-        Project& project = _projectManager.getProjectRef(projectName);
-        if (project.deleteClass(className))
+        Project::SharedPtr project = _projectManager.getProject(projectName);
+        if (project->deleteClass(className))
         {
+            _projectHistory.snapshot(*project);
+            _projectIndex.update(*project);
             args.result["message"] = className + "class deleted.";
         }
         else args.error["message"] = "Error deleting the class.";
@@ -433,9 +652,11 @@ void App::renameClass(const void* pSender, ofx::JSONRPC::MethodArgs& args)
     {
         std::string className = args.params["className"].asString();
         std::string newClassName = args.params["newClassName"].asString();
-        Project& project = _projectManager.getProjectRef(projectName);
-        if (project.renameClass(className, newClassName))
+        Project::SharedPtr project = _projectManager.getProject(projectName);
+        if (project->renameClass(className, newClassName))
         {
+            _projectHistory.snapshot(*project);
+            _projectIndex.update(*project);
             args.result["message"] = className + " class renamed to " + newClassName;
         }
         else args.error["message"] = "Error renaming " + className + " class.";
@@ -449,9 +670,17 @@ void App::runProject(const void* pSender, ofx::JSONRPC::MethodArgs& args)
     std::string projectName = args.params["projectName"].asString();
     if (_projectManager.projectExists(projectName))
     {
+        BuildProfile profile;
+
+        if (!_getBuildProfile(args.params, profile))
+        {
+            args.error["message"] = "The requested build profile does not exist.";
+            return;
+        }
+
         ofLogNotice("App::run") << "Running " << projectName << " project";
-        const Project& project = _projectManager.getProject(projectName);
-        Poco::UUID taskId = _compiler.run(project);
+        Project::SharedPtr project = _projectManager.getProject(projectName);
+        Poco::UUID taskId = _compiler.run(*project, profile);
         ofLogNotice("APP::run") << "Task ID: " << taskId.toString();
         args.result = taskId.toString();
     }
@@ -464,9 +693,26 @@ void App::compileProject(const void* pSender, ofx::JSONRPC::MethodArgs& args)
     std::string projectName = args.params["projectName"].asString();
     if (_projectManager.projectExists(projectName))
     {
-        ofLogNotice("App::compileProject") << "Compiling " << projectName << " project";
-        const Project& project = _projectManager.getProject(projectName);
-        Poco::UUID taskId = _compiler.compile(project);
+        BuildProfile profile;
+
+        if (!_getBuildProfile(args.params, profile))
+        {
+            args.error["message"] = "The requested build profile does not exist.";
+            return;
+        }
+
+        Toolchain toolchain;
+
+        if (!_getToolchain(args.params, toolchain))
+        {
+            args.error["message"] = "The requested toolchain does not exist.";
+            return;
+        }
+
+        ofLogNotice("App::compileProject") << "Compiling " << projectName << " project with the " << profile.name << " profile for " << toolchain.name;
+        Project::SharedPtr project = _projectManager.getProject(projectName);
+        Poco::UUID taskId = _compiler.compile(*project, profile, toolchain);
+        _projectIndex.buildStarted(projectName, taskId);
         ofLogNotice("App::compileProject") << "Task ID: " << taskId.toString();
         args.result = taskId.toString();
     }
@@ -474,6 +720,71 @@ void App::compileProject(const void* pSender, ofx::JSONRPC::MethodArgs& args)
 }
 
 
+void App::getBuildProfiles(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::map<std::string, BuildProfile> profiles = _ofSketchSettings.getBuildProfiles();
+    std::map<std::string, BuildProfile>::const_iterator iter = profiles.begin();
+
+    args.result["profiles"] = Json::Value(Json::arrayValue);
+    args.result["defaultProfile"] = BuildProfile::DEFAULT_PROFILE;
+
+    for (; iter != profiles.end(); ++iter)
+    {
+        args.result["profiles"].append(iter->second.toJson());
+    }
+}
+
+
+void App::getBuildWorkers(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    args.result = _compiler.getBuildWorkers().toJson();
+}
+
+
+void App::getToolchains(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::map<std::string, Toolchain> toolchains = _ofSketchSettings.getToolchains();
+    std::map<std::string, Toolchain>::const_iterator iter = toolchains.begin();
+
+    args.result["toolchains"] = Json::Value(Json::arrayValue);
+    args.result["defaultToolchain"] = Toolchain::NATIVE;
+
+    for (; iter != toolchains.end(); ++iter)
+    {
+        args.result["toolchains"].append(iter->second.toJson());
+    }
+}
+
+
+void App::getProjectBuildOptions(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+    if (_projectManager.projectExists(projectName))
+    {
+        args.result = _projectManager.getProject(projectName)->getBuildOptions();
+    }
+    else args.error["message"] = "The requested project does not exist.";
+}
+
+
+void App::setProjectBuildOptions(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+    if (_projectManager.projectExists(projectName))
+    {
+        Project::SharedPtr project = _projectManager.getProject(projectName);
+
+        if (project->setBuildOptions(args.params["buildOptions"]))
+        {
+            _compiler.generateSourceFiles(*project);
+            args.result = project->getBuildOptions();
+        }
+        else args.error["message"] = "Error saving the build options.";
+    }
+    else args.error["message"] = "The requested project does not exist.";
+}
+
+
 void App::stop(const void* pSender, ofx::JSONRPC::MethodArgs& args)
 {
     if (args.params.isMember("taskId"))
@@ -496,6 +807,12 @@ void App::getProjectList(const void* pSender, ofx::JSONRPC::MethodArgs& args)
 }
 
 
+void App::getProjectSummaries(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    args.result = _projectIndex.query(args.params);
+}
+
+
 void App::getAddonList(const void *pSender, ofx::JSONRPC::MethodArgs &args)
 {
     ofLogVerbose("App::getAddonList") << " sending addon list.";
@@ -523,11 +840,11 @@ void App::getProjectAddonList(const void *pSender, ofx::JSONRPC::MethodArgs &arg
     std::string projectName = args.params["projectName"].asString();
     if (_projectManager.projectExists(projectName))
     {
-        const Project& project = _projectManager.getProject(projectName);
+        Project::SharedPtr project = _projectManager.getProject(projectName);
 
-        if (project.hasAddons())
+        if (project->hasAddons())
         {
-            std::vector<std::string> addons = project.getAddons();
+            std::vector<std::string> addons = project->getAddons();
 
             for (unsigned int i = 0; i < addons.size(); ++i)
             {
@@ -553,8 +870,10 @@ void App::addProjectAddon(const void* pSender, ofx::JSONRPC::MethodArgs& args)
 
     if (_projectManager.projectExists(projectName))
     {
-        Project& project = _projectManager.getProjectRef(projectName);
-        project.addAddon(addon);
+        Project::SharedPtr project = _projectManager.getProject(projectName);
+        project->addAddon(addon);
+        _projectHistory.snapshot(*project);
+        _projectIndex.update(*project);
     }
     else args.error["message"] = "The requested project does not exist.";
 }
@@ -567,8 +886,13 @@ void App::removeProjectAddon(const void* pSender, ofx::JSONRPC::MethodArgs& args
 
     if (_projectManager.projectExists(projectName))
     {
-        Project& project = _projectManager.getProjectRef(projectName);
-        project.removeAddon(addon);
+        Project::SharedPtr project = _projectManager.getProject(projectName);
+
+        if (project->removeAddon(addon))
+        {
+            _projectHistory.snapshot(*project);
+            _projectIndex.update(*project);
+        }
     }
     else args.error["message"] = "The requested project does not exist.";
 }
@@ -587,14 +911,13 @@ void App::saveEditorSettings(const void *pSender, ofx::JSONRPC::MethodArgs &args
     _editorSettings.update(settings);
     _editorSettings.save();
 
-    // broadcast new editor settings to all connected clients
+    // send new editor settings to the clients that subscribe to settings
     Json::Value params;
     params["data"] = settings;
     params["clientUUID"] = args.params["clientUUID"];
     ofLogNotice("App::saveEditorSettings") << "clientUUID: " << params["clientUUID"] << endl;
     Json::Value json = Utils::toJSONMethod("Server", "updateEditorSettings", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
-    server->getWebSocketRoute()->broadcast(frame);
+    _topicRouter.publish(TopicRouter::SETTINGS_TOPIC, json);
 }
 
 void App::loadOfSketchSettings(const void *pSender, ofx::JSONRPC::MethodArgs &args)
@@ -611,14 +934,17 @@ void App::saveOfSketchSettings(const void *pSender, ofx::JSONRPC::MethodArgs &ar
     _ofSketchSettings.update(settings);
     _ofSketchSettings.save();
 
-    // broadcast new editor settings to all connected clients
+    _compiler.setupBuildWorkers(_ofSketchSettings.getBuildWorkers());
+    _topicRouter.setSettings(_ofSketchSettings.getSendQueue());
+    _admissionRoute->setSettings(_ofSketchSettings.getAdmission());
+
+    // send new ofSketch settings to the clients that subscribe to settings
     Json::Value params;
     params["data"] = settings;
     params["clientUUID"] = args.params["clientUUID"];
 
     Json::Value json = Utils::toJSONMethod("Server", "updateOfSketchSettings", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
-    server->getWebSocketRoute()->broadcast(frame);
+    _topicRouter.publish(TopicRouter::SETTINGS_TOPIC, json);
 }
 
 void App::exportProject(const void *pSender, ofx::JSONRPC::MethodArgs &args) {
@@ -629,23 +955,384 @@ void App::exportProject(const void *pSender, ofx::JSONRPC::MethodArgs &args) {
 //    Project& project = _projectManager.getProjectRef(projectName);
 }
 
+void App::openDocument(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+    std::string fileName = args.params["fileName"].asString();
+    std::string clientUUID = args.params["clientUUID"].asString();
+
+    if (_projectManager.projectExists(projectName))
+    {
+        Project::SharedPtr project = _projectManager.getProject(projectName);
+
+        std::string contents;
+
+        if (project->getFileContents(fileName, contents))
+        {
+            std::size_t revision = 0;
+
+            args.result["fileContents"] = _documentManager.open(projectName,
+                                                                fileName,
+                                                                contents,
+                                                                clientUUID,
+                                                                RPCDispatcher::getCallingConnection(),
+                                                                revision);
+            args.result["revision"] = Json::UInt64(revision);
+        }
+        else args.error["message"] = "The requested file does not exist.";
+    }
+    else args.error["message"] = "The requested project does not exist.";
+}
+
+
+void App::editDocument(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+    std::string fileName = args.params["fileName"].asString();
+    std::size_t revision = args.params["revision"].asUInt64();
+
+    TextOperation operation;
+
+    if (!TextOperation::fromJson(args.params["operation"], operation))
+    {
+        args.error["message"] = "Invalid operation sent to edit-document method.";
+        return;
+    }
+
+    TextOperation transformed;
+
+    if (_documentManager.edit(projectName, fileName, revision, operation, transformed))
+    {
+        args.result["revision"] = Json::UInt64(revision);
+
+        // Send the operation as applied so other editors can catch up.
+        Json::Value params;
+        params["projectName"] = projectName;
+        params["fileName"] = fileName;
+        params["revision"] = Json::UInt64(revision);
+        params["operation"] = transformed.toJson();
+        params["clientUUID"] = args.params["clientUUID"];
+        Json::Value json = Utils::toJSONMethod("Server", "documentOperation", params);
+        _topicRouter.publish(TopicRouter::getProjectTopic(projectName), json);
+    }
+    else args.error["message"] = "The edit could not be applied. Reload the document.";
+}
+
+
+void App::closeDocument(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+    std::string fileName = args.params["fileName"].asString();
+    std::string clientUUID = args.params["clientUUID"].asString();
+
+    _documentManager.close(projectName, fileName, clientUUID);
+}
+
+
+void App::getProjectHistory(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+
+    if (_projectManager.projectExists(projectName))
+    {
+        args.result["versions"] = _projectHistory.getVersions(projectName);
+    }
+    else args.error["message"] = "The requested project does not exist.";
+}
+
+
+void App::diffProjectVersions(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+
+    if (_projectManager.projectExists(projectName))
+    {
+        ProjectHistory::Files from;
+        ProjectHistory::Files to;
+        std::vector<std::string> fromAddons;
+        std::vector<std::string> toAddons;
+
+        if (!_projectHistory.getVersion(projectName,
+                                        args.params["from"].asUInt64(),
+                                        from,
+                                        fromAddons))
+        {
+            args.error["message"] = "The requested version does not exist.";
+            return;
+        }
+
+        // Without a "to" version, compare against the project as it is now.
+        if (args.params.isMember("to"))
+        {
+            if (!_projectHistory.getVersion(projectName,
+                                            args.params["to"].asUInt64(),
+                                            to,
+                                            toAddons))
+            {
+                args.error["message"] = "The requested version does not exist.";
+                return;
+            }
+        }
+        else
+        {
+            Project::SharedPtr project = _projectManager.getProject(projectName);
+            const Json::Value& data = project->getData();
+
+            to[data["projectFile"]["fileName"].asString()] = data["projectFile"]["fileContents"].asString();
+
+            for (unsigned int i = 0; i < project->getNumClasses(); ++i)
+            {
+                to[data["classes"][i]["fileName"].asString()] = data["classes"][i]["fileContents"].asString();
+            }
+        }
+
+        args.result["files"] = ProjectHistory::diff(from, to);
+    }
+    else args.error["message"] = "The requested project does not exist.";
+}
+
+
+void App::restoreProjectVersion(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+
+    if (_projectManager.projectExists(projectName))
+    {
+        ProjectHistory::Files files;
+        std::vector<std::string> addons;
+
+        if (_projectHistory.getVersion(projectName,
+                                       args.params["version"].asUInt64(),
+                                       files,
+                                       addons))
+        {
+            // Open editors would otherwise overwrite the restored files.
+            _documentManager.closeProject(projectName);
+
+            Project::SharedPtr project = _projectManager.getProject(projectName);
+
+            if (project->restore(files, addons))
+            {
+                // Restoring is itself a new version, so it can be undone.
+                _projectHistory.snapshot(*project);
+                _projectIndex.update(*project);
+                _symbolIndexer.updateProject(*project, _compiler.generateSourceFiles(*project));
+                args.result["data"] = project->getData();
+                requestProjectClosed(pSender, args);
+            }
+            else args.error["message"] = "Error restoring the project.";
+        }
+        else args.error["message"] = "The requested version does not exist.";
+    }
+    else args.error["message"] = "The requested project does not exist.";
+}
+
+
+void App::getCompletions(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+    std::string prefix = args.params["prefix"].asString();
+
+    if (!prefix.empty())
+    {
+        std::string projectPath;
+
+        if (_projectManager.projectExists(projectName))
+        {
+            projectPath = _projectManager.getProject(projectName)->getPath();
+        }
+
+        std::size_t limit = DEFAULT_COMPLETION_LIMIT;
+
+        if (args.params.isMember("limit"))
+        {
+            limit = std::min(args.params["limit"].asUInt(), (unsigned int)MAXIMUM_COMPLETION_LIMIT);
+        }
+
+        std::vector<Symbol> symbols;
+
+        _symbolIndexer.complete(projectPath,
+                                prefix,
+                                args.params["scope"].asString(),
+                                limit,
+                                symbols);
+
+        args.result["symbols"] = Json::Value(Json::arrayValue);
+        args.result["isIndexing"] = _symbolIndexer.isIndexing();
+
+        for (std::size_t i = 0; i < symbols.size(); ++i)
+        {
+            if (!projectPath.empty())
+            {
+                args.result["symbols"].append(_toJson(*_projectManager.getProject(projectName), symbols[i]));
+            }
+            else args.result["symbols"].append(symbols[i].toJson());
+        }
+    }
+    else args.error["message"] = "Incorrect parameters sent to get-completions method.";
+}
+
+
+void App::findDefinition(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+    std::string name = args.params["name"].asString();
+
+    if (!name.empty())
+    {
+        std::string projectPath;
+
+        if (_projectManager.projectExists(projectName))
+        {
+            projectPath = _projectManager.getProject(projectName)->getPath();
+        }
+
+        std::vector<Symbol> symbols;
+
+        _symbolIndexer.findDefinitions(projectPath,
+                                       name,
+                                       args.params["scope"].asString(),
+                                       symbols);
+
+        args.result["symbols"] = Json::Value(Json::arrayValue);
+
+        for (std::size_t i = 0; i < symbols.size(); ++i)
+        {
+            if (!projectPath.empty())
+            {
+                args.result["symbols"].append(_toJson(*_projectManager.getProject(projectName), symbols[i]));
+            }
+            else args.result["symbols"].append(symbols[i].toJson());
+        }
+    }
+    else args.error["message"] = "Incorrect parameters sent to find-definition method.";
+}
+
+void App::completeSymbol(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    std::string prefix = args.params["prefix"].asString();
+
+    if (!prefix.empty())
+    {
+        std::size_t limit = DEFAULT_COMPLETION_LIMIT;
+
+        if (args.params.isMember("limit"))
+        {
+            limit = std::min(args.params["limit"].asUInt(), (unsigned int)MAXIMUM_COMPLETION_LIMIT);
+        }
+
+        // Short prefixes are close to nearly every name.
+        std::size_t maxDistance = 0;
+
+        if (prefix.size() >= 6)
+        {
+            maxDistance = 2;
+        }
+        else if (prefix.size() >= 3)
+        {
+            maxDistance = 1;
+        }
+
+        if (args.params.isMember("fuzzy") && !args.params["fuzzy"].asBool())
+        {
+            maxDistance = 0;
+        }
+
+        std::vector<SymbolDictionary::Match> matches;
+        std::vector<SymbolDictionary::Match> similarMatches;
+
+        _symbolIndexer.completeSymbol(prefix, maxDistance, limit, matches, similarMatches);
+
+        args.result["matches"] = Json::Value(Json::arrayValue);
+        args.result["similarMatches"] = Json::Value(Json::arrayValue);
+
+        for (std::size_t i = 0; i < matches.size(); ++i)
+        {
+            args.result["matches"].append(matches[i].toJson());
+        }
+
+        for (std::size_t i = 0; i < similarMatches.size(); ++i)
+        {
+            args.result["similarMatches"].append(similarMatches[i].toJson());
+        }
+    }
+    else args.error["message"] = "Incorrect parameters sent to complete-symbol method.";
+}
+
+
+void App::subscribe(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    // The connection is subscribed by App::onWebSocketFrameReceivedEvent,
+    // which sees the same call.
+    const Json::Value& topics = args.params["topics"];
+
+    if (topics.isArray())
+    {
+        args.result["topics"] = Json::Value(Json::arrayValue);
+
+        for (unsigned int i = 0; i < topics.size(); ++i)
+        {
+            if (TopicRouter::isValidTopic(topics[i].asString()))
+            {
+                args.result["topics"].append(topics[i]);
+            }
+        }
+    }
+    else args.error["message"] = "Incorrect parameters sent to subscribe method.";
+}
+
+
+void App::unsubscribe(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    subscribe(pSender, args);
+}
+
+
+void App::setEncoding(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    // Like subscriptions, the encoding is bound to the connection by
+    // App::onWebSocketFrameReceivedEvent.
+    TopicRouter::Encoding encoding;
+
+    if (TopicRouter::getEncoding(args.params["encoding"].asString(), encoding))
+    {
+        args.result["encoding"] = TopicRouter::toString(encoding);
+    }
+    else args.error["message"] = "Unknown encoding: " + args.params["encoding"].asString();
+}
+
+
+void App::getConnectionStats(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    args.result = _topicRouter.toJson();
+    args.result["queuedCalls"] = Json::UInt64(_rpcDispatcher.getQueuedCount());
+    args.result["admission"] = _admissionRoute->toJson();
+}
+
+
 bool App::onWebSocketOpenEvent(ofx::HTTP::WebSocketOpenEventArgs& args)
 {
     ofLogVerbose("App::onWebSocketOpenEvent") << "Connection opened from: " << args.getConnectionRef().getClientAddress().toString();
 
+    _admissionRoute->webSocketOpened(args.getConnectionRef().getClientAddress().host());
+    _topicRouter.addConnection(args.getConnectionRef());
+    _rpcDispatcher.addConnection(args.getConnectionRef());
+
     // Here, we need to send all initial values, settings, etc to the
     // client before any other messages arrive.
 
-    Json::Value params = _taskQueue.toJson();
-
-    Json::Value json = Utils::toJSONMethod("TaskQueue", "taskList", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
+    std::string buffer;
+    JSONWriter writer(buffer);
+    Utils::beginJSONMethod(writer, "TaskQueue", "taskList");
+    _taskQueue.write(writer);
+    writer.endObject();
 
     // Send the update to the client that just connected.
-    args.getConnectionRef().sendFrame(frame);
+    _topicRouter.send(args.getConnectionRef(),
+                      TopicRouter::SharedFrame(new ofx::HTTP::WebSocketFrame(buffer)));
 
     // Send version info.
-    params.clear();
+    Json::Value params;
     params["version"] = getVersion();
     params["major"] = getVersionMajor();
     params["minor"] = getVersionMinor();
@@ -653,17 +1340,14 @@ bool App::onWebSocketOpenEvent(ofx::HTTP::WebSocketOpenEventArgs& args)
     params["special"] = getVersionSpecial();
     params["target"] = Utils::toString(Utils::getTargetPlatform());
 
-    json = Utils::toJSONMethod("Server", "version", params);
-    frame = ofx::HTTP::WebSocketFrame(Utils::toJSONString(json));
-
-    args.getConnectionRef().sendFrame(frame);
+    Json::Value json = Utils::toJSONMethod("Server", "version", params);
+    _topicRouter.send(args.getConnectionRef(), json);
 
     if (_missingDependencies)
     {
         params = Json::nullValue;
         json = Utils::toJSONMethod("Server", "missingDependencies", params);
-        frame = ofx::HTTP::WebSocketFrame(Utils::toJSONString(json));
-        args.getConnectionRef().sendFrame(frame);
+        _topicRouter.send(args.getConnectionRef(), json);
     }
 
     return false; // did not handle it
@@ -679,6 +1363,11 @@ bool App::onWebSocketCloseEvent(ofx::HTTP::WebSocketCloseEventArgs& args)
 
     ofLogVerbose("App::onWebSocketCloseEvent") << ss.str();
 
+    _rpcDispatcher.removeConnection(args.getConnectionRef());
+    _topicRouter.removeConnection(args.getConnectionRef());
+    _documentManager.closeConnection(&args.getConnectionRef());
+    _admissionRoute->webSocketClosed(args.getConnectionRef().getClientAddress().host());
+
     return false; // did not handle it
 }
 
@@ -686,13 +1375,38 @@ bool App::onWebSocketCloseEvent(ofx::HTTP::WebSocketCloseEventArgs& args)
 bool App::onWebSocketFrameReceivedEvent(ofx::HTTP::WebSocketFrameEventArgs& args)
 {
     ofLogVerbose("App::onWebSocketFrameReceivedEvent") << "Frame received from: " << args.getConnectionRef().getClientAddress().toString();
-    return false; // did not handle it
+
+    std::string text = args.getFrameRef().toString();
+
+    // Clients that asked for MessagePack may send it too.
+    if (args.getFrameRef().isBinary())
+    {
+        Json::Value json;
+
+        if (!MessagePack::read(text, json))
+        {
+            ofLogWarning("App::onWebSocketFrameReceivedEvent") << "Invalid MessagePack frame from: " << args.getConnectionRef().getClientAddress().toString();
+            return false;
+        }
+
+        _topicRouter.handleCalls(args.getConnectionRef(), json);
+        return _rpcDispatcher.handleCalls(args.getConnectionRef(), json);
+    }
+
+    // Subscriptions and encodings are bound to the connection here, then
+    // answered by their methods like any other call.
+    _topicRouter.handleFrame(args.getConnectionRef(), text);
+
+    // Calls are run on the dispatcher's workers rather than on this
+    // connection's thread.  The JSONRPC server still answers HTTP calls.
+    return _rpcDispatcher.handleFrame(args.getConnectionRef(), text);
 }
 
 
 bool App::onWebSocketFrameSentEvent(ofx::HTTP::WebSocketFrameEventArgs& args)
 {
 //    ofLogVerbose("App::onWebSocketFrameSentEvent") << "Frame sent to: " << args.getConnectionRef().getClientAddress().toString();
+    _topicRouter.frameSent(args.getConnectionRef(), args.getFrameRef());
     return false; // did not handle it
 }
 
@@ -757,74 +1471,60 @@ void App::onSSLPrivateKeyPassphraseRequired(std::string& args)
 
 bool App::onTaskQueued(const ofx::TaskQueuedEventArgs& args)
 {
-    Json::Value params;
-    params["name"] = args.getTaskName();
-    params["uuid"] = args.getTaskId().toString();
-    Json::Value json = Utils::toJSONMethod("TaskQueue", "taskQueued", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
-    server->getWebSocketRoute()->broadcast(frame);
+    TaskMessage message("taskQueued", args.getTaskName(), args.getTaskId());
+    _topicRouter.publish(_getTaskTopics(args.getTaskName(), args.getTaskId(), true), message);
     return false;
 }
 
 
 bool App::onTaskStarted(const ofx::TaskStartedEventArgs& args)
 {
-    Json::Value params;
-    params["name"] = args.getTaskName();
-    params["uuid"] = args.getTaskId().toString();
-    Json::Value json = Utils::toJSONMethod("TaskQueue", "taskStarted", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
-    server->getWebSocketRoute()->broadcast(frame);
+    TaskMessage message("taskStarted", args.getTaskName(), args.getTaskId());
+    _topicRouter.publish(_getTaskTopics(args.getTaskName(), args.getTaskId(), true), message);
     return false;
 }
 
 
 bool App::onTaskCancelled(const ofx::TaskCancelledEventArgs& args)
 {
-    Json::Value params;
-    params["name"] = args.getTaskName();
-    params["uuid"] = args.getTaskId().toString();
-    Json::Value json = Utils::toJSONMethod("TaskQueue", "taskCancelled", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
-    server->getWebSocketRoute()->broadcast(frame);
+    _projectIndex.buildFinished(args.getTaskId(), ProjectIndex::BUILD_CANCELLED);
+
+    TaskMessage message("taskCancelled", args.getTaskName(), args.getTaskId());
+    _topicRouter.publish(_getTaskTopics(args.getTaskName(), args.getTaskId(), true), message);
     return false;
 }
 
 
 bool App::onTaskFinished(const ofx::TaskFinishedEventArgs& args)
 {
-    Json::Value params;
-    params["name"] = args.getTaskName();
-    params["uuid"] = args.getTaskId().toString();
-    Json::Value json = Utils::toJSONMethod("TaskQueue", "taskFinished", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
-    server->getWebSocketRoute()->broadcast(frame);
+    _projectIndex.buildFinished(args.getTaskId(), ProjectIndex::BUILD_SUCCEEDED);
+
+    TaskMessage message("taskFinished", args.getTaskName(), args.getTaskId());
+    _topicRouter.publish(_getTaskTopics(args.getTaskName(), args.getTaskId(), true), message);
     return false;
 }
 
 
 bool App::onTaskFailed(const ofx::TaskFailedEventArgs& args)
 {
-    Json::Value params;
-    params["name"] = args.getTaskName();
-    params["uuid"] = args.getTaskId().toString();
-    params["exception"] = args.getException().displayText();
-    Json::Value json = Utils::toJSONMethod("TaskQueue", "taskFailed", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
-    server->getWebSocketRoute()->broadcast(frame);
+    _projectIndex.buildFinished(args.getTaskId(), ProjectIndex::BUILD_FAILED);
+
+    std::string exception = args.getException().displayText();
+    TaskMessage message("taskFailed", args.getTaskName(), args.getTaskId());
+    message.setException(exception);
+    _topicRouter.publish(_getTaskTopics(args.getTaskName(), args.getTaskId(), true), message);
     return false;
 }
 
 
 bool App::onTaskProgress(const ofx::TaskProgressEventArgs& args)
 {
-    Json::Value params;
-    params["name"] = args.getTaskName();
-    params["uuid"] = args.getTaskId().toString();
-    params["progress"] = args.getProgress();
-    Json::Value json = Utils::toJSONMethod("TaskQueue", "taskProgress", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
-    server->getWebSocketRoute()->broadcast(frame);
+    TaskMessage message("taskProgress", args.getTaskName(), args.getTaskId());
+    message.setProgress(args.getProgress());
+    _topicRouter.publish(_getTaskTopics(args.getTaskName(), args.getTaskId(), false),
+                         message,
+                         TopicRouter::PRIORITY_LATEST,
+                         TopicRouter::getTaskTopic(args.getTaskId()));
     return false;
 }
 
@@ -832,26 +1532,213 @@ bool App::onTaskProgress(const ofx::TaskProgressEventArgs& args)
 bool App::onTaskData(const ofx::TaskDataEventArgs<std::string>& args)
 {
     // We use the custom events to send status messages, and other custom
-    // events for custom data specific events.
-    Json::Value params;
-    params["name"] = args.getTaskName();
-    params["uuid"] = args.getTaskId().toString();
-    params["message"] = args.getData();
+    // events for custom data specific events.  Each line of build output
+    // is one of these, so it is written straight into the frames.
+    const std::string& data = args.getData();
+
+    TaskMessage message("taskMessage", args.getTaskName(), args.getTaskId());
+    message.setMessage(data);
 
-    Json::Value error = _compiler.parseError(args.getData());
+    Json::Value error = _compiler.parseError(data);
+
+    // Plain build output may be dropped for a client that can't keep up,
+    // but not the errors the editor annotates.
+    TopicRouter::Priority priority = TopicRouter::PRIORITY_VERBOSE;
 
     if (!error.empty())
     {
-        params["compileError"] = error;
+        message.setCompileError(error);
+        priority = TopicRouter::PRIORITY_REQUIRED;
     }
 
-    Json::Value json = Utils::toJSONMethod("TaskQueue", "taskMessage", params);
-    ofx::HTTP::WebSocketFrame frame(Utils::toJSONString(json));
-    server->getWebSocketRoute()->broadcast(frame);
+    if (_compiler.isBuildFailure(data))
+    {
+        _projectIndex.buildError(args.getTaskId());
+        priority = TopicRouter::PRIORITY_REQUIRED;
+    }
+    else if (data == UnityBuild::RETRY_MESSAGE)
+    {
+        _projectIndex.buildRestarted(args.getTaskId());
+        priority = TopicRouter::PRIORITY_REQUIRED;
+    }
+
+    _topicRouter.publish(_getTaskTopics(args.getTaskName(), args.getTaskId(), false),
+                         message,
+                         priority);
     return false;
 }
 
 
+void App::_registerMethod(const std::string& name,
+                          const std::string& description,
+                          Method method,
+                          const std::string& strand,
+                          RPCDispatcher::Ordering ordering)
+{
+    _rpcDispatcher.registerMethod(name, this, method, strand, ordering);
+}
+
+
+bool App::_getBuildProfile(const Json::Value& params, BuildProfile& profile) const
+{
+    std::string name = params.get("profile", BuildProfile::DEFAULT_PROFILE).asString();
+
+    std::map<std::string, BuildProfile> profiles = _ofSketchSettings.getBuildProfiles();
+    std::map<std::string, BuildProfile>::const_iterator iter = profiles.find(name);
+
+    if (iter == profiles.end())
+    {
+        return false;
+    }
+
+    profile = iter->second;
+    return true;
+}
+
+
+bool App::_getToolchain(const Json::Value& params, Toolchain& toolchain) const
+{
+    std::string name = params.get("toolchain", Toolchain::NATIVE).asString();
+
+    std::map<std::string, Toolchain> toolchains = _ofSketchSettings.getToolchains();
+    std::map<std::string, Toolchain>::const_iterator iter = toolchains.find(name);
+
+    if (iter == toolchains.end())
+    {
+        return false;
+    }
+
+    toolchain = iter->second;
+    return true;
+}
+
+
+std::vector<std::string> App::_getTaskTopics(const std::string& taskName,
+                                             const Poco::UUID& taskId,
+                                             bool isLifecycle) const
+{
+    std::vector<std::string> topics;
+    topics.push_back(TopicRouter::getTaskTopic(taskId));
+
+    // Build and check tasks are named after the project's path and run
+    // tasks after the project.
+    std::string projectName = Poco::Path(taskName).getFileName();
+
+    if (!projectName.empty())
+    {
+        topics.push_back(TopicRouter::getProjectTopic(projectName));
+    }
+
+    if (isLifecycle)
+    {
+        topics.push_back(TopicRouter::TASKS_TOPIC);
+    }
+
+    return topics;
+}
+
+
+Json::Value App::_toJson(const Project& project, const Symbol& symbol) const
+{
+    Json::Value json = symbol.toJson();
+
+    std::string fileName;
+    std::size_t sketchLine = 0;
+
+    // Only the project's own symbols have paths relative to the project.
+    if (symbol.file.compare(0, 4, "src/") == 0
+     && _compiler.findSketchLine(project.getPath() + "/" + symbol.file,
+                                 symbol.line,
+                                 fileName,
+                                 sketchLine))
+    {
+        json["tabName"] = fileName;
+        json["row"] = Json::UInt64(sketchLine);
+    }
+
+    return json;
+}
+
+
+void App::_saveDocuments(const std::string& projectName)
+{
+    DocumentManager::Revisions revisions;
+    DocumentManager::Files dirtyFiles = _documentManager.getDirtyFiles(projectName, revisions);
+
+    Project::SharedPtr project = _projectManager.getProject(projectName);
+
+    if (dirtyFiles.empty() || !project)
+    {
+        return;
+    }
+
+    if (project->updateFiles(dirtyFiles))
+    {
+        _documentManager.setSaved(projectName, revisions);
+        _projectHistory.snapshot(*project);
+        _projectIndex.update(*project);
+    }
+    else
+    {
+        // The documents stay dirty, so the save is tried again.
+        ofLogError("App::_saveDocuments") << "Unable to save edits to " << projectName;
+    }
+}
+
+
+void App::_saveProjectDocuments(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+{
+    _saveDocuments(args.params["projectName"].asString());
+}
+
+
+void App::_postDocumentSaves()
+{
+    std::vector<std::string> projectNames = _documentManager.getDirtyProjects();
+
+    for (std::size_t i = 0; i < projectNames.size(); ++i)
+    {
+        Json::Value params;
+        params["projectName"] = projectNames[i];
+
+        // Saved on the project's strand, so it can't race its calls.
+        _rpcDispatcher.post(projectNames[i],
+                            this,
+                            &App::_saveProjectDocuments,
+                            params);
+    }
+}
+
+
+void App::_reloadDocuments(const Project& project)
+{
+    const Json::Value& data = project.getData();
+
+    DocumentManager::Files files;
+    files[data["projectFile"]["fileName"].asString()] = data["projectFile"]["fileContents"].asString();
+
+    for (Json::ArrayIndex i = 0; i < data["classes"].size(); ++i)
+    {
+        files[data["classes"][i]["fileName"].asString()] = data["classes"][i]["fileContents"].asString();
+    }
+
+    std::map<std::string, std::size_t> revisions = _documentManager.reload(project.getName(), files);
+
+    std::map<std::string, std::size_t>::const_iterator iter = revisions.begin();
+
+    for (; iter != revisions.end(); ++iter)
+    {
+        Json::Value params;
+        params["projectName"] = project.getName();
+        params["fileName"] = iter->first;
+        params["revision"] = Json::UInt64(iter->second);
+        params["fileContents"] = files[iter->first];
+        Json::Value json = Utils::toJSONMethod("Server", "documentReset", params);
+        _topicRouter.publish(TopicRouter::getProjectTopic(project.getName()), json);
+    }
+}
+
+
 std::string App::getVersion()
 {
     std::stringstream ss;
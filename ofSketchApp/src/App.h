@@ -37,12 +37,23 @@
 #include "ofxHTTP.h"
 #include "ofxJSONRPC.h"
 #include "AddonManager.h"
+#include "AdmissionRoute.h"
 #include "Compiler.h"
+#include "DocumentManager.h"
 #include "EditorSettings.h"
+#include "MessagePack.h"
 #include "OfSketchSettings.h"
 #include "ProcessTaskQueue.h"
 #include "Project.h"
+#include "ProjectHistory.h"
+#include "ProjectIndex.h"
 #include "ProjectManager.h"
+#include "RPCDispatcher.h"
+#include "RPCRoute.h"
+#include "StaticAssetRoute.h"
+#include "SymbolIndexer.h"
+#include "TopicRouter.h"
+#include "UnityBuild.h"
 #include "UploadRouter.h"
 #include "Utils.h"
 #include "WebSocketLoggerChannel.h"
@@ -71,6 +82,7 @@ public:
     void loadTemplateProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void saveProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void createProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void duplicateProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void deleteProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void renameProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void createClass(const void* pSender, ofx::JSONRPC::MethodArgs& args);
@@ -78,8 +90,14 @@ public:
     void renameClass(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void runProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void compileProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void getBuildProfiles(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void getBuildWorkers(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void getToolchains(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void getProjectBuildOptions(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void setProjectBuildOptions(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void stop(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void getProjectList(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void getProjectSummaries(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void loadEditorSettings(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void saveEditorSettings(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void loadOfSketchSettings(const void* pSender, ofx::JSONRPC::MethodArgs& args);
@@ -92,6 +110,19 @@ public:
     void addProjectAddon(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void removeProjectAddon(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void exportProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void openDocument(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void editDocument(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void closeDocument(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void getProjectHistory(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void diffProjectVersions(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void restoreProjectVersion(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void getCompletions(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void findDefinition(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void completeSymbol(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void subscribe(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void unsubscribe(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void setEncoding(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void getConnectionStats(const void* pSender, ofx::JSONRPC::MethodArgs& args);
 
     bool onWebSocketOpenEvent(ofx::HTTP::WebSocketOpenEventArgs& args);
     bool onWebSocketCloseEvent(ofx::HTTP::WebSocketCloseEventArgs& args);
@@ -126,6 +157,18 @@ public:
 
     static const std::string VERSION_SPECIAL;
 
+    enum
+    {
+        /// \brief How often edited documents are written to disk.
+        DOCUMENT_SAVE_INTERVAL = 2000,
+
+        /// \brief The number of completions returned by default.
+        DEFAULT_COMPLETION_LIMIT = 50,
+
+        /// \brief The most completions returned for one request.
+        MAXIMUM_COMPLETION_LIMIT = 1000
+    };
+
 private:
     ofx::HTTP::BasicJSONRPCServer::SharedPtr server;
 
@@ -139,13 +182,71 @@ private:
     Compiler            _compiler;
     AddonManager        _addonManager;
     ProjectManager      _projectManager;
+    DocumentManager     _documentManager;
+    ProjectHistory      _projectHistory;
+    ProjectIndex        _projectIndex;
+    SymbolIndexer       _symbolIndexer;
     UploadRouter        _uploadRouter;
+    TopicRouter         _topicRouter;
+
+    StaticAssetRoute::SharedPtr _staticAssetRoute;
+    AdmissionRoute::SharedPtr _admissionRoute;
+
+    /// \brief Declared after the members the methods use, so that calls
+    ///        still running finish before those are destroyed.
+    RPCDispatcher       _rpcDispatcher;
+
+    RPCRoute::SharedPtr _rpcRoute;
 
     ofImage _logo;
     ofTrueTypeFont _font;
 
     bool _missingDependencies;
 
+    unsigned long long _lastDocumentSave;
+
+    /// \brief Save a project's edited documents.  Runs on the project's
+    ///        strand.
+    void _saveDocuments(const std::string& projectName);
+
+    void _saveProjectDocuments(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+
+    /// \brief Queue saves of the edited documents on their projects' strands.
+    void _postDocumentSaves();
+
+    /// \brief Bring open documents in line with a project that was saved
+    ///        as a whole, and tell their editors.
+    void _reloadDocuments(const Project& project);
+
+    typedef void (App::*Method)(const void*, ofx::JSONRPC::MethodArgs&);
+
+    /// \brief Register a method with the dispatcher, which runs both the
+    ///        websocket and HTTP calls.
+    /// \param strand A strand every call also runs on.
+    /// \param ordering UNORDERED for methods that only read locked state.
+    void _registerMethod(const std::string& name,
+                         const std::string& description,
+                         Method method,
+                         const std::string& strand = "",
+                         RPCDispatcher::Ordering ordering = RPCDispatcher::ORDERED);
+
+    /// \brief Look up the build profile named by params["profile"].
+    bool _getBuildProfile(const Json::Value& params, BuildProfile& profile) const;
+
+    /// \brief Look up the toolchain named by params["toolchain"].
+    bool _getToolchain(const Json::Value& params, Toolchain& toolchain) const;
+
+    /// \brief The topics that messages about a task are published to.
+    /// \param isLifecycle true for the task being queued, started or
+    ///        finished, which task lists subscribe to.
+    std::vector<std::string> _getTaskTopics(const std::string& taskName,
+                                            const Poco::UUID& taskId,
+                                            bool isLifecycle) const;
+
+    /// \brief Describe a symbol, with generated project locations mapped
+    ///        back to the sketch files they came from.
+    Json::Value _toJson(const Project& project, const Symbol& symbol) const;
+
 };
 
 
@@ -42,7 +42,8 @@ BaseProcessTask::BaseProcessTask(const std::string& name,
     Poco::Task(name),
     _command(command),
     _args(args),
-    _bufferSize(bufferSize)
+    _bufferSize(bufferSize),
+    _exitCode(-1)
 {
 }
 
@@ -102,9 +103,9 @@ void BaseProcessTask::runTask()
 
     Poco::Process::kill(ph);
 
-    int exitCode = ph.wait();
+    _exitCode = ph.wait();
 
-    ofLogVerbose("BaseProcessTask::runTask") << "Exit PID: " << ph.id() << " with: " << exitCode;
+    ofLogVerbose("BaseProcessTask::runTask") << "Exit PID: " << ph.id() << " with: " << _exitCode;
 }
 
 
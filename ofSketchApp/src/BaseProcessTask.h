@@ -66,6 +66,9 @@ protected:
     std::vector<std::string> _args;
 
     std::size_t _bufferSize;
+
+    /// \brief The exit code of the last run, or -1 before it has finished.
+    int _exitCode;
 };
 
 
@@ -0,0 +1,109 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "BlobStore.h"
+#include "Poco/DigestEngine.h"
+#include "Poco/File.h"
+#include "Poco/SHA1Engine.h"
+#include "ofFileUtils.h"
+#include "ofLog.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+BlobStore::BlobStore(const std::string& path): _path(path)
+{
+    Poco::File(_path).createDirectories();
+}
+
+
+BlobStore::~BlobStore()
+{
+}
+
+
+std::string BlobStore::put(const std::string& contents,
+                           FileTransaction& transaction,
+                           std::set<std::string>& staged) const
+{
+    std::string blobHash = hash(contents);
+
+    if (staged.find(blobHash) == staged.end() && !has(blobHash))
+    {
+        // Blobs are fanned out by the first two characters of their hash.
+        Poco::File(_path + "/" + blobHash.substr(0, 2)).createDirectories();
+        transaction.write(_getBlobPath(blobHash), contents, false);
+        staged.insert(blobHash);
+    }
+
+    return blobHash;
+}
+
+
+bool BlobStore::get(const std::string& blobHash, std::string& contents) const
+{
+    if (!has(blobHash)) return false;
+
+    contents = ofBufferFromFile(_getBlobPath(blobHash), true).getText();
+
+    return true;
+}
+
+
+bool BlobStore::has(const std::string& blobHash) const
+{
+    // Hashes may come from disk, so never let one escape the store.
+    if (blobHash.size() != 40 || blobHash.find_first_not_of("0123456789abcdef") != std::string::npos)
+    {
+        return false;
+    }
+
+    return Poco::File(_getBlobPath(blobHash)).exists();
+}
+
+
+const std::string& BlobStore::getPath() const
+{
+    return _path;
+}
+
+
+std::string BlobStore::hash(const std::string& contents)
+{
+    Poco::SHA1Engine engine;
+    engine.update(contents);
+    return Poco::DigestEngine::digestToHex(engine.digest());
+}
+
+
+std::string BlobStore::_getBlobPath(const std::string& blobHash) const
+{
+    return _path + "/" + blobHash.substr(0, 2) + "/" + blobHash.substr(2);
+}
+
+
+} } // namespace of::Sketch
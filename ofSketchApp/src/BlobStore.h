@@ -0,0 +1,67 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <set>
+#include <string>
+#include "FileTransaction.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Immutable blobs, named by the SHA-1 of their contents.
+class BlobStore
+{
+public:
+    BlobStore(const std::string& path);
+
+    virtual ~BlobStore();
+
+    /// \brief Stage contents unless the blob exists or is in staged.
+    std::string put(const std::string& contents,
+                    FileTransaction& transaction,
+                    std::set<std::string>& staged) const;
+
+    bool get(const std::string& hash, std::string& contents) const;
+
+    bool has(const std::string& hash) const;
+
+    const std::string& getPath() const;
+
+    static std::string hash(const std::string& contents);
+
+private:
+    std::string _path;
+
+    std::string _getBlobPath(const std::string& hash) const;
+
+};
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,104 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "BuildProfile.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+const std::string BuildProfile::DEFAULT_PROFILE = "release";
+
+
+BuildProfile::BuildProfile():
+    name(DEFAULT_PROFILE),
+    target("Release"),
+    binarySuffix(""),
+    objectDir(""),
+    optimization(""),
+    splitDwarf(false),
+    fastLinker(false)
+{
+}
+
+
+Json::Value BuildProfile::toJson() const
+{
+    Json::Value json;
+    json["name"] = name;
+    json["target"] = target;
+    json["binarySuffix"] = binarySuffix;
+    json["objectDir"] = objectDir;
+    json["optimization"] = optimization;
+    json["splitDwarf"] = splitDwarf;
+    json["fastLinker"] = fastLinker;
+    return json;
+}
+
+
+BuildProfile BuildProfile::fromJson(const std::string& name,
+                                   const Json::Value& json,
+                                   const BuildProfile& defaults)
+{
+    BuildProfile profile = defaults;
+    profile.name = name;
+    profile.target = json.get("target", profile.target).asString();
+    profile.binarySuffix = json.get("binarySuffix", profile.binarySuffix).asString();
+    profile.objectDir = json.get("objectDir", profile.objectDir).asString();
+    profile.optimization = json.get("optimization", profile.optimization).asString();
+    profile.splitDwarf = json.get("splitDwarf", profile.splitDwarf).asBool();
+    profile.fastLinker = json.get("fastLinker", profile.fastLinker).asBool();
+    return profile;
+}
+
+
+std::map<std::string, BuildProfile> BuildProfile::getDefaults()
+{
+    std::map<std::string, BuildProfile> profiles;
+
+    BuildProfile fast;
+    fast.name = "fast";
+    fast.binarySuffix = "_fast";
+    fast.objectDir = "obj/fast/";
+    fast.optimization = "-O1";
+    fast.splitDwarf = true;
+    fast.fastLinker = true;
+    profiles[fast.name] = fast;
+
+    BuildProfile release;
+    profiles[release.name] = release;
+
+    BuildProfile debug;
+    debug.name = "debug";
+    debug.target = "Debug";
+    debug.binarySuffix = "_debug";
+    profiles[debug.name] = debug;
+
+    return profiles;
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,70 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <map>
+#include <string>
+#include <json/json.h>
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief A named way of building and running a project, with its own
+///        object folder and executable.
+struct BuildProfile
+{
+    BuildProfile();
+
+    std::string name;
+
+    std::string target; // make target, i.e. Release or Debug
+
+    std::string binarySuffix; // e.g. _debug, appended to the project name
+
+    std::string objectDir; // e.g. obj/fast/, empty for the makefile default
+
+    std::string optimization; // e.g. -O1, empty for the makefile default
+
+    bool splitDwarf; // -g -gsplit-dwarf, where supported
+
+    bool fastLinker; // mold or lld, if one is installed
+
+    Json::Value toJson() const;
+
+    static BuildProfile fromJson(const std::string& name,
+                                 const Json::Value& json,
+                                 const BuildProfile& defaults = BuildProfile());
+
+    static std::map<std::string, BuildProfile> getDefaults();
+
+    static const std::string DEFAULT_PROFILE;
+};
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,257 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "BuildWorkerPool.h"
+#include "Poco/Net/SocketAddress.h"
+#include "Poco/Net/StreamSocket.h"
+#include "Poco/Exception.h"
+#include "Poco/Timespan.h"
+#include "ofLog.h"
+#include "ofUtils.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+BuildWorkerPool::Worker::Worker():
+    host(""),
+    port(DEFAULT_PORT),
+    jobs(DEFAULT_JOBS),
+    isHealthy(false),
+    failures(0),
+    lastChecked(0),
+    latency(0)
+{
+}
+
+
+Json::Value BuildWorkerPool::Worker::toJson() const
+{
+    Json::Value json;
+    json["host"] = host;
+    json["port"] = port;
+    json["jobs"] = Json::UInt64(jobs);
+    json["isHealthy"] = isHealthy;
+    json["failures"] = Json::UInt64(failures);
+    json["lastChecked"] = Json::Int64(lastChecked / 1000);
+    json["latency"] = Json::Int64(latency / 1000);
+    return json;
+}
+
+
+BuildWorkerPool::Settings::Settings():
+    enabled(false),
+    distcc("distcc"),
+#if defined(TARGET_OSX)
+    CC("clang"),
+    CXX("clang++"),
+#else
+    CC("gcc"),
+    CXX("g++"),
+#endif
+    checkInterval(DEFAULT_CHECK_INTERVAL),
+    connectTimeout(DEFAULT_CONNECT_TIMEOUT)
+{
+}
+
+
+BuildWorkerPool::Settings BuildWorkerPool::Settings::fromJson(const Json::Value& json)
+{
+    Settings settings;
+
+    settings.enabled = json.get("enabled", settings.enabled).asBool();
+    settings.distcc = json.get("distcc", settings.distcc).asString();
+    settings.CC = json.get("CC", settings.CC).asString();
+    settings.CXX = json.get("CXX", settings.CXX).asString();
+    settings.checkInterval = json.get("checkInterval", int(settings.checkInterval)).asInt();
+    settings.connectTimeout = json.get("connectTimeout", int(settings.connectTimeout)).asInt();
+
+    const Json::Value& workers = json["workers"];
+
+    for (unsigned int i = 0; i < workers.size(); ++i)
+    {
+        Worker worker;
+        worker.host = workers[i]["host"].asString();
+        worker.port = workers[i].get("port", DEFAULT_PORT).asUInt();
+        worker.jobs = workers[i].get("jobs", DEFAULT_JOBS).asUInt();
+
+        if (!worker.host.empty() && worker.jobs > 0)
+        {
+            settings.workers.push_back(worker);
+        }
+    }
+
+    return settings;
+}
+
+
+BuildWorkerPool::BuildWorkerPool()
+{
+}
+
+
+BuildWorkerPool::~BuildWorkerPool()
+{
+    _timer.stop();
+}
+
+
+void BuildWorkerPool::setup(const Settings& settings)
+{
+    _timer.stop();
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        _settings = settings;
+    }
+
+    if (settings.enabled && !settings.workers.empty() && settings.checkInterval > 0)
+    {
+        _timer.setStartInterval(0);
+        _timer.setPeriodicInterval(settings.checkInterval);
+        _timer.start(Poco::TimerCallback<BuildWorkerPool>(*this, &BuildWorkerPool::onCheck));
+    }
+}
+
+
+bool BuildWorkerPool::getHosts(std::string& hosts, std::size_t& jobs) const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    hosts.clear();
+    jobs = 0;
+
+    if (!_settings.enabled)
+    {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < _settings.workers.size(); ++i)
+    {
+        const Worker& worker = _settings.workers[i];
+
+        if (worker.isHealthy)
+        {
+            hosts += worker.host + ":" + ofToString(worker.port) + "/" + ofToString(worker.jobs) + " ";
+            jobs += worker.jobs;
+        }
+    }
+
+    return jobs > 0;
+}
+
+
+BuildWorkerPool::Settings BuildWorkerPool::getSettings() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return _settings;
+}
+
+
+Json::Value BuildWorkerPool::toJson() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Json::Value json;
+
+    json["enabled"] = _settings.enabled;
+    json["workers"] = Json::Value(Json::arrayValue);
+
+    for (std::size_t i = 0; i < _settings.workers.size(); ++i)
+    {
+        json["workers"].append(_settings.workers[i].toJson());
+    }
+
+    return json;
+}
+
+
+void BuildWorkerPool::onCheck(Poco::Timer& timer)
+{
+    std::vector<Worker> workers;
+    long connectTimeout = 0;
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        workers = _settings.workers;
+        connectTimeout = _settings.connectTimeout;
+    }
+
+    // Connect without holding the lock, since a dead worker takes the
+    // whole timeout to fail.
+    for (std::size_t i = 0; i < workers.size(); ++i)
+    {
+        Worker& worker = workers[i];
+        Poco::Timestamp start;
+
+        try
+        {
+            Poco::Net::StreamSocket socket;
+            socket.connect(Poco::Net::SocketAddress(worker.host, worker.port),
+                           Poco::Timespan(connectTimeout * 1000));
+            socket.close();
+
+            if (!worker.isHealthy)
+            {
+                ofLogNotice("BuildWorkerPool::onCheck") << "Build worker " << worker.host << ":" << worker.port << " is available.";
+            }
+
+            worker.isHealthy = true;
+            worker.failures = 0;
+            worker.latency = start.elapsed();
+        }
+        catch (const Poco::Exception& exc)
+        {
+            if (worker.isHealthy)
+            {
+                ofLogWarning("BuildWorkerPool::onCheck") << "Build worker " << worker.host << ":" << worker.port << " is unavailable: " << exc.displayText();
+            }
+
+            worker.isHealthy = false;
+            ++worker.failures;
+        }
+
+        worker.lastChecked = Poco::Timestamp().epochMicroseconds();
+    }
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    // Only keep the results if the workers were not replaced meanwhile.
+    if (_settings.workers.size() == workers.size())
+    {
+        for (std::size_t i = 0; i < workers.size(); ++i)
+        {
+            if (_settings.workers[i].host == workers[i].host
+             && _settings.workers[i].port == workers[i].port)
+            {
+                _settings.workers[i] = workers[i];
+            }
+        }
+    }
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,110 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include <json/json.h>
+#include "Poco/Mutex.h"
+#include "Poco/Timer.h"
+#include "Poco/Timestamp.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief The distcc workers that builds can be offloaded to, checked in
+///        the background so only healthy ones are used.
+class BuildWorkerPool
+{
+public:
+    struct Worker
+    {
+        Worker();
+
+        std::string host;
+        unsigned short port; // distccd listens on 3632 by default.
+        std::size_t jobs; // Parallel compiles to send to this worker.
+
+        bool isHealthy;
+        std::size_t failures; // Consecutive failed checks.
+        Poco::Timestamp::TimeVal lastChecked;
+        Poco::Timestamp::TimeDiff latency; // Microseconds to connect.
+
+        Json::Value toJson() const;
+    };
+
+    struct Settings
+    {
+        Settings();
+
+        bool enabled;
+        std::string distcc; // e.g. distcc or /usr/lib/distcc/distcc
+        std::string CC;  // The compiler to run on the workers, e.g. gcc
+        std::string CXX; // e.g. g++
+        long checkInterval; // Milliseconds between health checks.
+        long connectTimeout; // Milliseconds.
+        std::vector<Worker> workers;
+
+        static Settings fromJson(const Json::Value& json);
+    };
+
+    BuildWorkerPool();
+
+    virtual ~BuildWorkerPool();
+
+    void setup(const Settings& settings);
+
+    /// \returns false if the pool is disabled or no worker is healthy.
+    bool getHosts(std::string& hosts, std::size_t& jobs) const;
+
+    Settings getSettings() const;
+
+    Json::Value toJson() const;
+
+    void onCheck(Poco::Timer& timer);
+
+    enum
+    {
+        DEFAULT_PORT = 3632,
+        DEFAULT_JOBS = 4,
+        DEFAULT_CHECK_INTERVAL = 10000,
+        DEFAULT_CONNECT_TIMEOUT = 500
+    };
+
+private:
+    Settings _settings;
+
+    Poco::Timer _timer;
+
+    mutable Poco::FastMutex _mutex;
+
+};
+
+
+} } // namespace of::Sketch
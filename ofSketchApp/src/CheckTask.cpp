@@ -0,0 +1,151 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "CheckTask.h"
+#include "Poco/TaskNotification.h"
+#include "ofUtils.h"
+#include "Utils.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+CheckTask::CheckTask(const std::vector<std::string>& makeArgs,
+                     const Project& project,
+                     const std::vector<std::string>& files,
+                     SharedCache cache):
+    BaseProcessTask(project.getPath(), "make", std::vector<std::string>(), LINE_BUFFER_SIZE),
+    _makeArgs(makeArgs),
+    _projectPath(ofToDataPath(project.getPath(), true)),
+    _files(files),
+    _signature(ofJoinString(makeArgs, " ") + "\n" + ofJoinString(project.getAddons(), " ")),
+    _cache(cache),
+    _isDiscovering(false)
+{
+}
+
+
+CheckTask::~CheckTask()
+{
+}
+
+
+void CheckTask::runTask()
+{
+    CompileCommands commands;
+
+    {
+        // Other checks of the project wait for the dry run instead of
+        // starting their own.
+        Poco::FastMutex::ScopedLock lock(_cache->mutex);
+
+        if (_cache->signature != _signature)
+        {
+            _discover(_cache->commands);
+
+            if (!isCancelled())
+            {
+                _cache->signature = _signature;
+            }
+        }
+
+        commands = _cache->commands;
+    }
+
+    CompileCommands::Command main;
+
+    if (!commands.find("src/main.cpp", main))
+    {
+        ofLogWarning("CheckTask::runTask") << "Unable to find the compiler flags of " << _projectPath;
+        return;
+    }
+
+    for (std::size_t i = 0; i < _files.size() && !isCancelled(); ++i)
+    {
+        std::string file = "src/" + _files[i];
+
+        CompileCommands::Command command;
+
+        // Class headers are not built on their own, but use the same flags.
+        if (!commands.find(file, command))
+        {
+            command = main;
+            command.push_back("-x");
+            command.push_back("c++");
+        }
+
+        command.push_back("-fsyntax-only");
+        command.push_back(file);
+
+        // The flags are relative to the project.
+        _command = "/bin/sh";
+        _args.clear();
+        _args.push_back("-c");
+        _args.push_back("cd \"$0\" && exec \"$@\"");
+        _args.push_back(_projectPath);
+        _args.insert(_args.end(), command.begin(), command.end());
+
+        BaseProcessTask::runTask();
+    }
+}
+
+
+void CheckTask::processLine(const std::string& line)
+{
+    if (_isDiscovering)
+    {
+        _lines.push_back(line);
+    }
+    else
+    {
+        postNotification(new Poco::TaskCustomNotification<std::string>(this, line));
+    }
+}
+
+
+void CheckTask::_discover(CompileCommands& commands)
+{
+    // -n prints the commands without running them and -B prints them for
+    // sources that are up to date too.
+    _command = "make";
+    _args = _makeArgs;
+    _args.insert(_args.begin(), "-B");
+    _args.insert(_args.begin(), "-n");
+
+    _lines.clear();
+    _isDiscovering = true;
+    BaseProcessTask::runTask();
+    _isDiscovering = false;
+
+    commands.parse(_projectPath, _lines);
+    _lines.clear();
+
+    // Also useful to clang based editors and tools.
+    Utils::JSONtoFile(_projectPath + "/" + CompileCommands::FILE_NAME, commands.toJson());
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,89 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include "Poco/Mutex.h"
+#include "Poco/SharedPtr.h"
+#include "BaseProcessTask.h"
+#include "CompileCommands.h"
+#include "Project.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Checks generated sources with -fsyntax-only, using the flags
+///        from a dry run of make.
+class CheckTask: public BaseProcessTask
+{
+public:
+    struct Cache
+    {
+        Poco::FastMutex mutex;
+        std::string signature;
+        CompileCommands commands;
+    };
+
+    typedef Poco::SharedPtr<Cache> SharedCache;
+
+    /// \param files The generated files to check, e.g. "main.cpp".
+    CheckTask(const std::vector<std::string>& makeArgs,
+              const Project& project,
+              const std::vector<std::string>& files,
+              SharedCache cache);
+
+    virtual ~CheckTask();
+
+    virtual void runTask();
+
+    virtual void processLine(const std::string& line);
+
+    enum
+    {
+        /// \brief Compiler commands with their include paths are long.
+        LINE_BUFFER_SIZE = 262144
+    };
+
+private:
+    std::vector<std::string> _makeArgs;
+    std::string _projectPath;
+    std::vector<std::string> _files;
+    std::string _signature;
+    SharedCache _cache;
+
+    bool _isDiscovering;
+    std::vector<std::string> _lines;
+
+    void _discover(CompileCommands& commands);
+
+};
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,265 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "CompileCommands.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+const std::string CompileCommands::FILE_NAME = "compile_commands.json";
+
+
+void CompileCommands::parse(const std::string& directory,
+                            const std::vector<std::string>& lines)
+{
+    _directory = directory;
+    _commands.clear();
+
+    for (std::size_t i = 0; i < lines.size(); ++i)
+    {
+        Command args = split(lines[i]);
+        Command command;
+
+        // Recipes may chain commands, e.g. mkdir -p obj && g++ ...
+        for (std::size_t j = 0; j <= args.size(); ++j)
+        {
+            if (j == args.size() || args[j] == "&&" || args[j] == "||" || args[j] == ";")
+            {
+                _parseCommand(command);
+                command.clear();
+            }
+            else
+            {
+                command.push_back(args[j]);
+            }
+        }
+    }
+}
+
+
+bool CompileCommands::find(const std::string& file, Command& command) const
+{
+    std::map<std::string, Command>::const_iterator iter = _commands.begin();
+
+    for (; iter != _commands.end(); ++iter)
+    {
+        const std::string& source = iter->first;
+
+        if (source == file
+         || (source.size() > file.size()
+          && source.compare(source.size() - file.size(), file.size(), file) == 0
+          && source[source.size() - file.size() - 1] == '/'))
+        {
+            command = iter->second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool CompileCommands::empty() const
+{
+    return _commands.empty();
+}
+
+
+void CompileCommands::clear()
+{
+    _directory.clear();
+    _commands.clear();
+}
+
+
+const std::string& CompileCommands::getDirectory() const
+{
+    return _directory;
+}
+
+
+Json::Value CompileCommands::toJson() const
+{
+    Json::Value json(Json::arrayValue);
+
+    std::map<std::string, Command>::const_iterator iter = _commands.begin();
+
+    for (; iter != _commands.end(); ++iter)
+    {
+        Json::Value entry;
+        entry["directory"] = _directory;
+        entry["file"] = iter->first;
+
+        for (std::size_t i = 0; i < iter->second.size(); ++i)
+        {
+            entry["arguments"].append(iter->second[i]);
+        }
+
+        entry["arguments"].append("-c");
+        entry["arguments"].append(iter->first);
+        json.append(entry);
+    }
+
+    return json;
+}
+
+
+CompileCommands::Command CompileCommands::split(const std::string& line)
+{
+    Command args;
+    std::string arg;
+    bool hasArg = false;
+    char quote = 0;
+
+    for (std::size_t i = 0; i < line.size(); ++i)
+    {
+        char c = line[i];
+
+        if (quote == '\'')
+        {
+            if (c == '\'') quote = 0;
+            else arg += c;
+        }
+        else if (quote == '"')
+        {
+            if (c == '"') quote = 0;
+            else if (c == '\\' && i + 1 < line.size()
+                  && (line[i + 1] == '"' || line[i + 1] == '\\' || line[i + 1] == '$'))
+            {
+                arg += line[++i];
+            }
+            else arg += c;
+        }
+        else if (c == '\'' || c == '"')
+        {
+            quote = c;
+            hasArg = true;
+        }
+        else if (c == '\\' && i + 1 < line.size())
+        {
+            arg += line[++i];
+            hasArg = true;
+        }
+        else if (c == ' ' || c == '\t')
+        {
+            if (hasArg)
+            {
+                args.push_back(arg);
+                arg.clear();
+                hasArg = false;
+            }
+        }
+        else if (c == ';')
+        {
+            if (hasArg)
+            {
+                args.push_back(arg);
+                arg.clear();
+                hasArg = false;
+            }
+
+            args.push_back(";");
+        }
+        else
+        {
+            arg += c;
+            hasArg = true;
+        }
+    }
+
+    if (hasArg)
+    {
+        args.push_back(arg);
+    }
+
+    return args;
+}
+
+
+void CompileCommands::_parseCommand(const Command& command)
+{
+    Command flags;
+    std::string source;
+    bool isCompile = false;
+
+    for (std::size_t i = 0; i < command.size(); ++i)
+    {
+        const std::string& arg = command[i];
+
+        if (arg == "-c")
+        {
+            isCompile = true;
+        }
+        else if (arg == "-o" || arg == "-MF" || arg == "-MT" || arg == "-MQ")
+        {
+            // Skip the output file too.
+            ++i;
+        }
+        else if (arg == "-MMD" || arg == "-MD" || arg == "-MP")
+        {
+        }
+        else if (i > 0 && !arg.empty() && arg[0] != '-' && _isSource(arg))
+        {
+            source = arg;
+        }
+        else if (flags.empty() && (arg == "distcc" || arg == "ccache"))
+        {
+            // Check locally with the compiler itself.
+        }
+        else
+        {
+            flags.push_back(arg);
+        }
+    }
+
+    if (isCompile && !source.empty() && !flags.empty())
+    {
+        _commands[source] = flags;
+    }
+}
+
+
+bool CompileCommands::_isSource(const std::string& path)
+{
+    static const char* extensions[] = { ".cpp", ".cc", ".cxx", ".c", ".m", ".mm" };
+
+    for (std::size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); ++i)
+    {
+        std::string extension(extensions[i]);
+
+        if (path.size() > extension.size()
+         && path.compare(path.size() - extension.size(), extension.size(), extension) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,75 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <json/json.h>
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief The compiler commands make -n prints for each source file.
+class CompileCommands
+{
+public:
+    typedef std::vector<std::string> Command;
+
+    void parse(const std::string& directory,
+               const std::vector<std::string>& lines);
+
+    /// \param file A path relative to the project, e.g. "src/main.cpp".
+    bool find(const std::string& file, Command& command) const;
+
+    bool empty() const;
+
+    void clear();
+
+    const std::string& getDirectory() const;
+
+    Json::Value toJson() const;
+
+    static Command split(const std::string& line);
+
+    static const std::string FILE_NAME;
+
+private:
+    std::string _directory;
+
+    std::map<std::string, Command> _commands;
+
+    void _parseCommand(const Command& command);
+
+    static bool _isSource(const std::string& path);
+
+};
+
+
+} } // namespace of::Sketch
@@ -24,6 +24,14 @@
 
 
 #include "Compiler.h"
+#include <algorithm>
+#include "Poco/DirectoryIterator.h"
+#include "Poco/Environment.h"
+#include "Poco/File.h"
+#include "Poco/String.h"
+#include "IncludeScanner.h"
+#include "UnityBuild.h"
+#include "Utils.h"
 
 
 namespace of {
@@ -37,83 +45,309 @@ Compiler::Compiler(ProcessTaskQueue& taskQueue,
     _pathToTemplates(pathToTemplates),
     _projectFileTemplate(ofBufferFromFile(ofToDataPath(_pathToTemplates + "/main.tmpl")).getText()),
     _classTemplate(ofBufferFromFile(ofToDataPath(_pathToTemplates + "/class.tmpl")).getText()),
-    _openFrameworksDir(openFrameworksDir)
+    _openFrameworksDir(openFrameworksDir),
+    _fastLinkerFlag(_findFastLinkerFlag())
 {
 }
 
 
-Poco::UUID Compiler::compile(const Project& project)
+Poco::UUID Compiler::compile(const Project& project,
+                             const BuildProfile& profile,
+                             const Toolchain& toolchain)
 {
+    _loadSourceMap(project);
+
+    MakeTask::Settings settings = _getMakeSettings(project, profile, toolchain);
+
+    return _taskQueue.start(new MakeTask(settings, project, profile.target));
+}
+
+
+Poco::UUID Compiler::check(const Project& project,
+                           const std::vector<std::string>& files)
+{
+    BuildProfile profile;
+    MakeTask::Settings settings = _getMakeSettings(project, profile, Toolchain());
+
+    // Checks are local, so that distcc does not hold them up.
+    settings.CC.clear();
+    settings.CXX.clear();
+    settings.numProcessors = 1;
+
+    Poco::UUID lastTaskId;
+    CheckTask::SharedCache cache;
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+
+        std::map<std::string, Poco::UUID>::const_iterator iter = _checkTasks.find(project.getPath());
+
+        if (iter != _checkTasks.end())
+        {
+            lastTaskId = iter->second;
+        }
+
+        CheckTask::SharedCache& projectCache = _checkCaches[project.getPath()];
+
+        if (projectCache.isNull())
+        {
+            projectCache = new CheckTask::Cache();
+        }
+
+        cache = projectCache;
+    }
+
+    // A newer check of the project makes the last one pointless.
+    if (!lastTaskId.isNull())
+    {
+        _taskQueue.cancel(lastTaskId);
+    }
+
+    Poco::UUID taskId = _taskQueue.start(new CheckTask(MakeTask::getArgs(settings, project, profile.target),
+                                                       project,
+                                                       files,
+                                                       cache));
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _checkTasks[project.getPath()] = taskId;
+
+    return taskId;
+}
+
+
+MakeTask::Settings Compiler::_getMakeSettings(const Project& project,
+                                              const BuildProfile& profile,
+                                              const Toolchain& toolchain) const
+{
+    bool isCrossCompiling = (toolchain.name != Toolchain::NATIVE);
+
     MakeTask::Settings settings;
     settings.ofRoot = _openFrameworksDir;
-    return _taskQueue.start(new MakeTask(settings, project, "Release"));
+    settings.optimization = profile.optimization;
+    settings.objectDir = profile.objectDir;
+
+    std::string cflags;
+    std::string ldflags;
+
+    if (!profile.binarySuffix.empty())
+    {
+        settings.binaryName = project.getName() + profile.binarySuffix;
+    }
+
+#if defined(TARGET_LINUX)
+    // Leaves the debug information out of the objects the linker reads.
+    // Older compilers don't imply -g, and do nothing without it.
+    if (profile.splitDwarf)
+    {
+        cflags = "-g -gsplit-dwarf";
+    }
+
+    // The host's mold or lld may not know the target.
+    if (profile.fastLinker && !isCrossCompiling)
+    {
+        ldflags = _fastLinkerFlag;
+    }
+#endif
+
+    std::string CC = "";
+    std::string CXX = "";
+
+    if (isCrossCompiling)
+    {
+        if (!toolchain.ofRoot.empty())
+        {
+            settings.ofRoot = ofToDataPath(toolchain.ofRoot, true);
+        }
+
+        settings.isCrossCompiling = true;
+        settings.platformArch = toolchain.platformArch;
+        settings.platformVariant = toolchain.platformVariant;
+        settings.sysroot = toolchain.sysroot;
+        settings.toolchainRoot = toolchain.toolchainRoot;
+        settings.gccPrefix = toolchain.prefix.substr(0, toolchain.prefix.find_last_not_of("-") + 1);
+
+        CC = toolchain.getCompiler("gcc");
+        CXX = toolchain.getCompiler("g++");
+
+        if (!toolchain.sysroot.empty())
+        {
+            cflags += " --sysroot=" + toolchain.sysroot;
+            ldflags += " --sysroot=" + toolchain.sysroot;
+        }
+
+        // Keep the objects and executable apart from the native ones.
+        settings.objectDir = (profile.objectDir.empty() ? "obj/" : profile.objectDir) + toolchain.name + "/";
+        settings.binaryName = project.getName() + profile.binarySuffix + "_" + toolchain.name;
+    }
+
+    std::string hosts;
+    std::size_t jobs = 0;
+
+    // If a worker fails mid-build, distcc compiles that file locally.
+    if (_buildWorkers.getHosts(hosts, jobs))
+    {
+        BuildWorkerPool::Settings workers = _buildWorkers.getSettings();
+        settings.distccHosts = hosts;
+
+        // Workers find the cross compiler on their own PATH.
+        CC = workers.distcc + " " + (isCrossCompiling ? toolchain.prefix + "gcc" : workers.CC);
+        CXX = workers.distcc + " " + (isCrossCompiling ? toolchain.prefix + "g++" : workers.CXX);
+        settings.numProcessors = std::max(settings.numProcessors, jobs);
+    }
+
+    settings.CC = CC;
+    settings.CXX = CXX;
+    settings.cflags = Poco::trim(cflags);
+    settings.ldflags = Poco::trim(ldflags);
+
+    return settings;
 }
 
 
-Poco::UUID Compiler::run(const Project& project)
+void Compiler::setupBuildWorkers(const BuildWorkerPool::Settings& settings)
 {
-    return _taskQueue.start(new RunTask(project, RunTask::RELEASE));
+    _buildWorkers.setup(settings);
 }
 
 
-void Compiler::generateSourceFiles(const Project& project)
+const BuildWorkerPool& Compiler::getBuildWorkers() const
 {
+    return _buildWorkers;
+}
+
+
+Poco::UUID Compiler::run(const Project& project,
+                         const BuildProfile& profile)
+{
+    _loadSourceMap(project);
+    return _taskQueue.start(new RunTask(project, profile));
+}
+
+
+std::vector<std::string> Compiler::generateSourceFiles(const Project& project)
+{
+    std::vector<std::string> changedFiles;
+
+    // The generated files are only rewritten when they change, so that
+    // make only rebuilds what the edit touched.
     ofDirectory src(project.getPath() + "/src");
-    src.remove(true);
-    src.create(true);
 
-    Json::Value projectData = project.getData();
-    std::string projectFile = _projectFileTemplate;
-    ofStringReplace(projectFile, "<projectfile>", projectData["projectFile"]["fileContents"].asString());
-    ofStringReplace(projectFile, "<projectname>", projectData["projectFile"]["name"].asString());
-    _replaceIncludes(projectFile);
-    ofBuffer sourceBuffer(projectFile);
-    ofBufferToFile(src.getAbsolutePath() + "/main.cpp", sourceBuffer);
+    if (!src.exists())
+    {
+        src.create(true);
+    }
+
+    std::set<std::string> generatedFiles;
+    generatedFiles.insert("main.cpp");
+    generatedFiles.insert(SourceMap::FILE_NAME);
+
+    const Json::Value& projectData = project.getData();
+
+    SourceMap sourceMap;
+
+    _generateFile(_projectFileTemplate,
+                  project.getPath(),
+                  "projectname",
+                  projectData["projectFile"]["name"].asString(),
+                  "projectfile",
+                  projectData["projectFile"]["fileContents"].asString(),
+                  src.getAbsolutePath(),
+                  "main.cpp",
+                  sourceMap,
+                  changedFiles);
 
     if (project.hasClasses())
     {
         for (unsigned int i = 0; i < projectData["classes"].size(); ++i)
         {
-            Json::Value c = projectData["classes"][i];
-        
-            std::string classFile = _classTemplate;
-            ofStringReplace(classFile, "<classname>", c["name"].asString());
-            ofStringReplace(classFile, "<classfile>", c["fileContents"].asString());
-            _replaceIncludes(classFile);
-        
-            ofBuffer sourceBuffer(classFile);
-            ofBufferToFile(src.getAbsolutePath() + "/" + c["name"].asString() + ".h", sourceBuffer);
+            const Json::Value& c = projectData["classes"][i];
+
+            generatedFiles.insert(c["name"].asString() + ".h");
+
+            _generateFile(_classTemplate,
+                          project.getPath(),
+                          "classname",
+                          c["name"].asString(),
+                          "classfile",
+                          c["fileContents"].asString(),
+                          src.getAbsolutePath(),
+                          c["name"].asString() + ".h",
+                          sourceMap,
+                          changedFiles);
         }
     }
+
+    Utils::JSONtoFile(src.getAbsolutePath() + "/" + SourceMap::FILE_NAME, sourceMap.toJson());
+
+    _removeStaleFiles(src.getAbsolutePath(), generatedFiles);
+
+    UnityBuild::generate(project, _openFrameworksDir, Poco::Environment::processorCount());
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _sourceMaps[project.getPath()] = sourceMap;
+    _lastProjectPath = project.getPath();
+
+    return changedFiles;
 }
 
 
 Json::Value Compiler::parseError(std::string message) const
 {
     // i.e. Mike-Test:8:6: error: cannot initialize a variable of type 'int' with an lvalue of type 'const char [3]'
+    // or /path/to/Mike-Test/src/main.cpp:3:10: fatal error: 'ofxFoo.h' file not found
 
     Json::Value compileError;
 
-    Poco::RegularExpression errorExpression(".+:[0-9]+:[0-9]+: (fatal error|error|warning|note): .+$", Poco::RegularExpression::RE_ANCHORED);
+    Poco::RegularExpression errorExpression("^(.+?):([0-9]+):([0-9]+): (fatal error|error|warning|note): (.+)$");
 
-    if (errorExpression.match(message))
+    std::vector<std::string> vals;
+
+    if (errorExpression.split(message, vals) == 6)
+    {
+        std::string tabName = vals[1];
+        std::size_t row = ofToInt(vals[2]);
+        std::string type = vals[4];
+
+        // ACE Editor refers to "note" as "info"
+        if (type == "note") type = "info";
+        else if (type == "fatal error") type = "error";
+
+        // Code from the sketch is already reported against the sketch file
+        // by its #line directive.  Anything else is in a generated file.
+        std::string fileName;
+        std::size_t sketchLine = 0;
+
+        if (findSketchLine(tabName, row, fileName, sketchLine))
+        {
+            tabName = fileName;
+            row = sketchLine;
+        }
+
+        compileError["tabName"] = tabName;
+        compileError["annotation"]["row"] = Json::UInt64(row);
+        compileError["annotation"]["column"] = ofToInt(vals[3]);
+        compileError["annotation"]["type"] = type;
+        compileError["annotation"]["text"] = vals[5];
+    }
+    else
     {
-        std::vector<std::string> vals = ofSplitString(message, ":");
+        // A location in a generated file reported while running, e.g. by an
+        // assertion or in a backtrace.
+        Poco::RegularExpression locationExpression("([^ \t:()]*src/[^ \t:()]+):([0-9]+)");
 
-        if (vals.size() == 5)
+        if (locationExpression.split(message, vals) == 3)
         {
-            ofStringReplace(vals[3], " ", "");
-        
-            // ACE Editor refers to "note" as "info"
-            if (vals[3] == "note") vals[3] = "info";
-            else if (vals[3] == "fatalerror") vals[3] = "error";
-        
-            compileError["tabName"] = vals[0];
-            compileError["annotation"]["row"] = ofToInt(vals[1]);
-            compileError["annotation"]["column"] = ofToInt(vals[2]);
-            compileError["annotation"]["type"] = vals[3];
-            compileError["annotation"]["text"] = vals[4];
-       
+            std::string fileName;
+            std::size_t sketchLine = 0;
+
+            if (findSketchLine(vals[1], ofToInt(vals[2]), fileName, sketchLine))
+            {
+                compileError["tabName"] = fileName;
+                compileError["annotation"]["row"] = Json::UInt64(sketchLine);
+                compileError["annotation"]["column"] = 0;
+                compileError["annotation"]["type"] = "error";
+                compileError["annotation"]["text"] = message;
+            }
         }
     }
 
@@ -121,29 +355,183 @@ Json::Value Compiler::parseError(std::string message) const
 }
 
 
-void Compiler::_replaceIncludes(std::string& fileContents)
+bool Compiler::findSketchLine(const std::string& path,
+                              std::size_t line,
+                              std::string& fileName,
+                              std::size_t& sketchLine) const
+{
+    std::size_t src = path.rfind("src/");
+
+    if (src == std::string::npos || (src > 0 && path[src - 1] != '/'))
+    {
+        return false;
+    }
+
+    std::string generatedFile = path.substr(src + 4);
+    std::string projectPath = (src > 0) ? path.substr(0, src - 1) : "";
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<std::string, SourceMap>::const_iterator iter = _sourceMaps.find(projectPath);
+
+    if (iter == _sourceMaps.end())
+    {
+        // Relative paths are reported by the most recent build.
+        iter = _sourceMaps.find(_lastProjectPath);
+    }
+
+    return iter != _sourceMaps.end()
+        && iter->second.find(generatedFile, line, fileName, sketchLine);
+}
+
+
+bool Compiler::isBuildFailure(const std::string& message) const
 {
-    Poco::RegularExpression includesExpression("#include .*\n");
-    Poco::RegularExpression::Match match;
+    // i.e. make[1]: *** [obj/linux64/Release/src/main.o] Error 1
+
+    Poco::RegularExpression failureExpression("make(\\[[0-9]+\\])?: \\*\\*\\* .*Error [0-9]+");
+
+    return failureExpression.match(message);
+}
+
 
+void Compiler::_generateFile(const SourceTemplate& sourceTemplate,
+                             const std::string& projectPath,
+                             const std::string& nameVariable,
+                             const std::string& name,
+                             const std::string& codeVariable,
+                             const std::string& contents,
+                             const std::string& srcPath,
+                             const std::string& generatedFile,
+                             SourceMap& sourceMap,
+                             std::vector<std::string>& changedFiles)
+{
+    SourceTemplate::Variables variables;
+    SourceTemplate::Lines lines;
     std::vector<std::string> includes;
+    std::vector<std::size_t> includeLines;
+    std::string code;
+    std::string sourceFile;
+
+    IncludeScanner::scan(contents, code, includes, includeLines);
+
+    std::size_t codeLines = std::count(code.begin(), code.end(), '\n') + 1;
 
-    int numMatches = 0;
-    std::size_t matchOffset = 0;
+    variables[nameVariable] = name;
+    variables["includes"] = ofJoinString(includes, "");
+    // Hoisted includes leave blank lines behind, so the code keeps its
+    // line numbers.
+    variables["line"] = "1";
+    variables[codeVariable].swap(code);
 
-    while (matchOffset < fileContents.size())
+    sourceTemplate.render(variables, sourceFile, lines);
+
+    if (lines.find("includes") != lines.end())
+    {
+        std::size_t line = lines["includes"];
+
+        for (std::size_t i = 0; i < includes.size(); ++i)
+        {
+            std::size_t count = std::count(includes[i].begin(), includes[i].end(), '\n');
+            sourceMap.add(generatedFile, line, count, name, includeLines[i]);
+            line += count;
+        }
+    }
+
+    if (lines.find(codeVariable) != lines.end())
     {
-        if (includesExpression.match(fileContents, matchOffset, match) == 0) break;
-        std::string include;
-        includesExpression.extract(fileContents, match.offset, include);
-        includes.push_back(include);
-        matchOffset = match.offset + match.length;
-        numMatches++;
+        sourceMap.add(generatedFile, lines[codeVariable], codeLines, name, 1);
+    }
+
+    std::string path = srcPath + "/" + generatedFile;
+
+    if (!ofFile::doesFileExist(path, false)
+     || ofBufferFromFile(path, true).getText() != sourceFile)
+    {
+        ofBuffer sourceBuffer(sourceFile);
+        ofBufferToFile(path, sourceBuffer);
+    }
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::string& lastSourceFile = _generatedFiles[projectPath + "/" + generatedFile];
+
+    if (lastSourceFile != sourceFile)
+    {
+        lastSourceFile.swap(sourceFile);
+        changedFiles.push_back(generatedFile);
+    }
+}
+
+
+void Compiler::_removeStaleFiles(const std::string& srcPath,
+                                 const std::set<std::string>& generatedFiles)
+{
+    try
+    {
+        Poco::DirectoryIterator iter(srcPath);
+        Poco::DirectoryIterator end;
+
+        for (; iter != end; ++iter)
+        {
+            // The unity build keeps its own units.
+            if (generatedFiles.find(iter.name()) == generatedFiles.end()
+             && iter.name().compare(0, UnityBuild::FILE_PREFIX.size(), UnityBuild::FILE_PREFIX) != 0)
+            {
+                ofLogVerbose("Compiler::_removeStaleFiles") << "Removing: " << iter->path();
+                iter->remove(true);
+            }
+        }
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogError("Compiler::_removeStaleFiles") << exc.displayText();
+    }
+}
+
+
+void Compiler::_loadSourceMap(const Project& project)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    _lastProjectPath = project.getPath();
+
+    if (_sourceMaps.find(project.getPath()) == _sourceMaps.end())
+    {
+        Json::Value json;
+
+        if (Utils::JSONfromFile(project.getPath() + "/src/" + SourceMap::FILE_NAME, json))
+        {
+            _sourceMaps[project.getPath()] = SourceMap::fromJson(json);
+        }
+    }
+}
+
+
+std::string Compiler::_findFastLinkerFlag()
+{
+#if defined(TARGET_LINUX)
+    std::vector<std::string> paths = ofSplitString(Poco::Environment::get("PATH", ""), ":", true, true);
+
+    const char* linkers[] = { "mold", "ld.lld" };
+    const char* flags[] = { "-fuse-ld=mold", "-fuse-ld=lld" };
+
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        for (std::size_t j = 0; j < paths.size(); ++j)
+        {
+            Poco::File linker(paths[j] + "/" + linkers[i]);
+
+            if (linker.exists() && linker.canExecute())
+            {
+                ofLogNotice("Compiler::_findFastLinkerFlag") << "Using " << linker.path() << " for fast builds.";
+                return flags[i];
+            }
+        }
     }
+#endif
 
-    includesExpression.subst(fileContents, "", Poco::RegularExpression::RE_GLOBAL);
-    ofStringReplace(fileContents, "<includes>", ofJoinString(includes, ""));
-    ofStringReplace(fileContents, "<line>", ofToString(includes.size()));
+    return "";
 }
 
 
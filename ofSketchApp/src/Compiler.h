@@ -26,8 +26,11 @@
 #pragma once
 
 
+#include <map>
+#include <set>
 #include <string>
 #include <json/json.h>
+#include "Poco/Mutex.h"
 #include "Poco/Pipe.h"
 #include "Poco/UUID.h"
 #include "Poco/Process.h"
@@ -40,6 +43,12 @@
 #include "ProcessTaskQueue.h"
 #include "MakeTask.h"
 #include "RunTask.h"
+#include "BuildProfile.h"
+#include "BuildWorkerPool.h"
+#include "CheckTask.h"
+#include "SourceMap.h"
+#include "SourceTemplate.h"
+#include "Toolchain.h"
 
 
 namespace of {
@@ -53,25 +62,89 @@ public:
              const std::string& pathToTemplates,
              const std::string& openFrameworksDir);
 
-    Poco::UUID compile(const Project& project);
-    Poco::UUID run(const Project& project);
+    Poco::UUID compile(const Project& project,
+                       const BuildProfile& profile = BuildProfile(),
+                       const Toolchain& toolchain = Toolchain());
+    Poco::UUID run(const Project& project,
+                   const BuildProfile& profile = BuildProfile());
 
-    void generateSourceFiles(const Project& project);
+    /// \brief Check generated files, e.g. "main.cpp", without building them.
+    Poco::UUID check(const Project& project,
+                     const std::vector<std::string>& files);
+
+    /// \returns the generated files that changed.
+    std::vector<std::string> generateSourceFiles(const Project& project);
     Json::Value parseError(std::string message) const;
+
+    /// \param path The generated file, as the compiler reports it.
+    bool findSketchLine(const std::string& path,
+                        std::size_t line,
+                        std::string& fileName,
+                        std::size_t& sketchLine) const;
+
+    /// \returns true if message is make reporting that a build failed.
+    bool isBuildFailure(const std::string& message) const;
+
+    /// \brief Offload builds to the given distcc workers.
+    void setupBuildWorkers(const BuildWorkerPool::Settings& settings);
+
+    const BuildWorkerPool& getBuildWorkers() const;
     
 private:
     ProcessTaskQueue& _taskQueue;
 
     std::string _pathToTemplates;
     std::string _pathToSrc;
-    std::string _projectFileTemplate;
-    std::string _classTemplate;
+    SourceTemplate _projectFileTemplate;
+    SourceTemplate _classTemplate;
     std::string _openFrameworksDir;
-    
+
+    /// \brief -fuse-ld=mold or -fuse-ld=lld, or empty if neither is
+    ///        installed.
+    std::string _fastLinkerFlag;
+
+    BuildWorkerPool _buildWorkers;
+
+    /// \brief Source maps of generated projects, keyed by project path.
+    std::map<std::string, SourceMap> _sourceMaps;
+    std::string _lastProjectPath;
+
+    /// \brief The last contents of each generated file, keyed by path.
+    std::map<std::string, std::string> _generatedFiles;
+
+    /// \brief The compile commands and last check of each project, keyed
+    ///        by project path.
+    std::map<std::string, CheckTask::SharedCache> _checkCaches;
+    std::map<std::string, Poco::UUID> _checkTasks;
+
+    mutable Poco::FastMutex _mutex;
+
+    void _generateFile(const SourceTemplate& sourceTemplate,
+                       const std::string& projectPath,
+                       const std::string& nameVariable,
+                       const std::string& name,
+                       const std::string& codeVariable,
+                       const std::string& contents,
+                       const std::string& srcPath,
+                       const std::string& generatedFile,
+                       SourceMap& sourceMap,
+                       std::vector<std::string>& changedFiles);
+
+    MakeTask::Settings _getMakeSettings(const Project& project,
+                                        const BuildProfile& profile,
+                                        const Toolchain& toolchain) const;
+
+    void _loadSourceMap(const Project& project);
+
+    /// \brief Remove the headers of deleted or renamed classes.
+    static void _removeStaleFiles(const std::string& srcPath,
+                                  const std::set<std::string>& generatedFiles);
+
+    static std::string _findFastLinkerFlag();
+
     void _parseAddons();
     void _getAddons();
 
-    void _replaceIncludes(std::string& fileContents);
 };
 
 
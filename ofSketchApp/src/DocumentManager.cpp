@@ -0,0 +1,304 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "DocumentManager.h"
+#include "ofLog.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+DocumentManager::DocumentManager()
+{
+}
+
+
+DocumentManager::~DocumentManager()
+{
+}
+
+
+std::string DocumentManager::open(const std::string& projectName,
+                                  const std::string& fileName,
+                                  const std::string& contents,
+                                  const std::string& clientUUID,
+                                  const void* connection,
+                                  std::size_t& revision)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Entry& entry = _documents[_makeKey(projectName, fileName)];
+
+    if (!entry.document)
+    {
+        entry.document = SketchDocument::SharedPtr(new SketchDocument(projectName,
+                                                                      fileName,
+                                                                      contents));
+
+        ofLogVerbose("DocumentManager::open") << "Opened " << projectName << "/" << fileName;
+    }
+
+    entry.subscribers.insert(clientUUID);
+
+    if (connection)
+    {
+        _connections[connection].insert(clientUUID);
+    }
+
+    revision = entry.document->getRevision();
+
+    return entry.document->getContents();
+}
+
+
+bool DocumentManager::edit(const std::string& projectName,
+                           const std::string& fileName,
+                           std::size_t& revision,
+                           const TextOperation& operation,
+                           TextOperation& transformed)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Documents::iterator iter = _documents.find(_makeKey(projectName, fileName));
+
+    if (iter == _documents.end())
+    {
+        ofLogError("DocumentManager::edit") << projectName << "/" << fileName << " is not open.";
+        return false;
+    }
+
+    SketchDocument::SharedPtr document = iter->second.document;
+
+    if (!document->receive(revision, operation, transformed))
+    {
+        ofLogError("DocumentManager::edit") << "Rejected operation against revision " << revision << " of " << projectName << "/" << fileName;
+        return false;
+    }
+
+    revision = document->getRevision();
+
+    return true;
+}
+
+
+void DocumentManager::close(const std::string& projectName,
+                            const std::string& fileName,
+                            const std::string& clientUUID)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Documents::iterator iter = _documents.find(_makeKey(projectName, fileName));
+
+    if (iter != _documents.end())
+    {
+        iter->second.subscribers.erase(clientUUID);
+
+        // Dirty documents are dropped by setSaved() once saved.
+        if (iter->second.subscribers.empty() && !iter->second.document->isDirty())
+        {
+            _documents.erase(iter);
+        }
+    }
+}
+
+
+void DocumentManager::closeConnection(const void* connection)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<const void*, std::set<std::string> >::iterator iter = _connections.find(connection);
+
+    if (iter == _connections.end())
+    {
+        return;
+    }
+
+    std::set<std::string>::const_iterator client = iter->second.begin();
+
+    for (; client != iter->second.end(); ++client)
+    {
+        _unsubscribe(*client);
+    }
+
+    _connections.erase(iter);
+}
+
+
+void DocumentManager::closeProject(const std::string& projectName)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Documents::iterator iter = _documents.begin();
+
+    while (iter != _documents.end())
+    {
+        if (iter->second.document->getProjectName() == projectName)
+        {
+            _documents.erase(iter++);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+
+bool DocumentManager::isOpen(const std::string& projectName,
+                             const std::string& fileName) const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return _documents.find(_makeKey(projectName, fileName)) != _documents.end();
+}
+
+
+std::vector<std::string> DocumentManager::getDirtyProjects() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::set<std::string> projectNames;
+
+    Documents::const_iterator iter = _documents.begin();
+
+    for (; iter != _documents.end(); ++iter)
+    {
+        if (iter->second.document->isDirty())
+        {
+            projectNames.insert(iter->second.document->getProjectName());
+        }
+    }
+
+    return std::vector<std::string>(projectNames.begin(), projectNames.end());
+}
+
+
+DocumentManager::Files DocumentManager::getDirtyFiles(const std::string& projectName,
+                                                      Revisions& revisions) const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Files dirtyFiles;
+
+    Documents::const_iterator iter = _documents.begin();
+
+    for (; iter != _documents.end(); ++iter)
+    {
+        SketchDocument::SharedPtr document = iter->second.document;
+
+        if (document->getProjectName() == projectName && document->isDirty())
+        {
+            dirtyFiles[document->getFileName()] = document->getContents();
+            revisions[document->getFileName()] = document->getRevision();
+        }
+    }
+
+    return dirtyFiles;
+}
+
+
+void DocumentManager::setSaved(const std::string& projectName,
+                               const Revisions& revisions)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Revisions::const_iterator iter = revisions.begin();
+
+    for (; iter != revisions.end(); ++iter)
+    {
+        Documents::iterator document = _documents.find(_makeKey(projectName, iter->first));
+
+        // Edits made while the files were written are saved next time.
+        if (document == _documents.end()
+         || document->second.document->getRevision() != iter->second)
+        {
+            continue;
+        }
+
+        document->second.document->setClean();
+
+        if (document->second.subscribers.empty())
+        {
+            _documents.erase(document);
+        }
+    }
+}
+
+
+std::map<std::string, std::size_t> DocumentManager::reload(const std::string& projectName,
+                                                           const Files& files)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<std::string, std::size_t> revisions;
+
+    Files::const_iterator iter = files.begin();
+
+    for (; iter != files.end(); ++iter)
+    {
+        Documents::iterator document = _documents.find(_makeKey(projectName, iter->first));
+
+        // Unsaved edits are newer than the files.
+        if (document != _documents.end()
+         && !document->second.document->isDirty()
+         && document->second.document->getContents() != iter->second)
+        {
+            document->second.document->reset(iter->second);
+            revisions[iter->first] = document->second.document->getRevision();
+        }
+    }
+
+    return revisions;
+}
+
+
+void DocumentManager::_unsubscribe(const std::string& clientUUID)
+{
+    Documents::iterator iter = _documents.begin();
+
+    while (iter != _documents.end())
+    {
+        iter->second.subscribers.erase(clientUUID);
+
+        if (iter->second.subscribers.empty() && !iter->second.document->isDirty())
+        {
+            _documents.erase(iter++);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+
+std::string DocumentManager::_makeKey(const std::string& projectName,
+                                      const std::string& fileName)
+{
+    return projectName + "/" + fileName;
+}
+
+
+} } // namespace of::Sketch
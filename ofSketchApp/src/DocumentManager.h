@@ -0,0 +1,114 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "Poco/Mutex.h"
+#include "SketchDocument.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Tracks the sketch files open for collaborative editing.
+class DocumentManager
+{
+public:
+    typedef std::map<std::string, std::string> Files;
+    typedef std::map<std::string, std::size_t> Revisions;
+
+    DocumentManager();
+    virtual ~DocumentManager();
+
+    /// \brief Subscribe a client, opening the document if needed.
+    std::string open(const std::string& projectName,
+                     const std::string& fileName,
+                     const std::string& contents,
+                     const std::string& clientUUID,
+                     const void* connection,
+                     std::size_t& revision);
+
+    bool edit(const std::string& projectName,
+              const std::string& fileName,
+              std::size_t& revision,
+              const TextOperation& operation,
+              TextOperation& transformed);
+
+    /// \brief Unsubscribe a client, dropping a clean document nobody has open.
+    void close(const std::string& projectName,
+               const std::string& fileName,
+               const std::string& clientUUID);
+
+    void closeConnection(const void* connection);
+
+    void closeProject(const std::string& projectName);
+
+    /// \returns the new revisions of the clean documents that were reset.
+    std::map<std::string, std::size_t> reload(const std::string& projectName,
+                                              const Files& files);
+
+    bool isOpen(const std::string& projectName,
+                const std::string& fileName) const;
+
+    std::vector<std::string> getDirtyProjects() const;
+
+    /// \param revisions Set to the revision of each file returned.
+    Files getDirtyFiles(const std::string& projectName,
+                        Revisions& revisions) const;
+
+    /// \brief Mark documents clean that haven't changed since they were
+    ///        saved at the given revisions.
+    void setSaved(const std::string& projectName, const Revisions& revisions);
+
+private:
+    struct Entry
+    {
+        SketchDocument::SharedPtr document;
+        std::set<std::string> subscribers;
+    };
+
+    typedef std::map<std::string, Entry> Documents;
+
+    Documents _documents;
+
+    std::map<const void*, std::set<std::string> > _connections;
+
+    void _unsubscribe(const std::string& clientUUID);
+
+    mutable Poco::FastMutex _mutex;
+
+    static std::string _makeKey(const std::string& projectName,
+                                const std::string& fileName);
+
+};
+
+
+} } // namespace of::Sketch
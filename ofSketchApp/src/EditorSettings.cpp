@@ -38,24 +38,28 @@ EditorSettings::EditorSettings(const std::string& path):
 
 void EditorSettings::update(const ofxJSONElement& data)
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     _data = data;
 }
 
 
 bool EditorSettings::load()
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data.open(_path);
 }
 
 
 bool EditorSettings::save()
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data.save(_path, true);
 }
 
 
-const Json::Value& EditorSettings::getData() const
+Json::Value EditorSettings::getData() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data;
 }
 
@@ -28,6 +28,7 @@
 
 #include <string>
 #include <json/json.h>
+#include "Poco/Mutex.h"
 #include "ofxJSONElement.h"
 
 
@@ -45,12 +46,16 @@ public:
     bool load();
     bool save();
 
-    const Json::Value& getData() const;
+    /// \brief A copy, since the settings may be saved meanwhile.
+    Json::Value getData() const;
 
 private:
     std::string _path;
     ofxJSONElement _data; //ofxJSONElement for load functionality
 
+    /// \brief Read by calls running in parallel with a save.
+    mutable Poco::FastMutex _mutex;
+
 };
 
 
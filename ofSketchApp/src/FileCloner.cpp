@@ -0,0 +1,252 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "FileCloner.h"
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "Poco/DirectoryIterator.h"
+#include "Poco/File.h"
+#include "Poco/Path.h"
+#include "ofConstants.h"
+#include "ofLog.h"
+
+#if defined(TARGET_LINUX)
+    #include <sys/ioctl.h>
+    #include <linux/fs.h>
+#elif defined(TARGET_OSX) && defined(__has_include)
+    #if __has_include(<sys/clonefile.h>)
+        #include <sys/clonefile.h>
+    #endif
+#endif
+
+
+namespace of {
+namespace Sketch {
+
+
+FileCloner::Stats::Stats(): linked(0), cloned(0), copied(0), skipped(0)
+{
+}
+
+
+bool FileCloner::cloneProject(const std::string& sourcePath,
+                              const std::string& destinationPath,
+                              Stats& stats)
+{
+    Poco::File destination(destinationPath);
+
+    if (destination.exists())
+    {
+        ofLogError("FileCloner::cloneProject") << destinationPath << " already exists.";
+        return false;
+    }
+
+    if (!_cloneDirectory(sourcePath, destinationPath, "", stats))
+    {
+        try
+        {
+            destination.remove(true);
+        }
+        catch (const Poco::Exception& exc)
+        {
+            ofLogError("FileCloner::cloneProject") << exc.displayText();
+        }
+
+        return false;
+    }
+
+    ofLogVerbose("FileCloner::cloneProject") << "Cloned " << sourcePath << " to " << destinationPath << ": " << stats.linked << " linked, " << stats.cloned << " cloned, " << stats.copied << " copied, " << stats.skipped << " skipped.";
+
+    return true;
+}
+
+
+bool FileCloner::cloneFile(const std::string& sourcePath,
+                           const std::string& destinationPath,
+                           Stats& stats)
+{
+#if defined(TARGET_OSX) && defined(CLONE_NOFOLLOW)
+    if (::clonefile(sourcePath.c_str(), destinationPath.c_str(), CLONE_NOFOLLOW) == 0)
+    {
+        ++stats.cloned;
+        return true;
+    }
+#elif defined(TARGET_LINUX) && defined(FICLONE)
+    int source = ::open(sourcePath.c_str(), O_RDONLY);
+
+    if (source >= 0)
+    {
+        struct stat status;
+        ::fstat(source, &status);
+
+        int destination = ::open(destinationPath.c_str(),
+                                 O_WRONLY | O_CREAT | O_EXCL,
+                                 status.st_mode & 0777);
+
+        if (destination >= 0)
+        {
+            bool isCloned = ::ioctl(destination, FICLONE, source) == 0;
+
+            ::close(destination);
+            ::close(source);
+
+            if (isCloned)
+            {
+                ++stats.cloned;
+                return true;
+            }
+
+            // Not supported on this filesystem.  Copy over the empty file.
+            ::unlink(destinationPath.c_str());
+        }
+        else
+        {
+            ::close(source);
+        }
+    }
+#endif
+
+    if (_copyFile(sourcePath, destinationPath))
+    {
+        ++stats.copied;
+        return true;
+    }
+
+    return false;
+}
+
+
+bool FileCloner::linkFile(const std::string& sourcePath,
+                          const std::string& destinationPath,
+                          Stats& stats)
+{
+    if (::link(sourcePath.c_str(), destinationPath.c_str()) == 0)
+    {
+        ++stats.linked;
+        return true;
+    }
+
+    // e.g. EXDEV across filesystems, or a filesystem without hard links.
+    return cloneFile(sourcePath, destinationPath, stats);
+}
+
+
+bool FileCloner::_isEditable(const std::string& relativeName)
+{
+    return relativeName.compare(0, 9, "bin/data/") == 0
+        || relativeName.compare(0, 7, "sketch/") == 0
+        || relativeName == "ofSketch.json"
+        || relativeName == "addons.make"
+        || relativeName == "config.make";
+}
+
+
+bool FileCloner::_cloneDirectory(const std::string& sourcePath,
+                                 const std::string& destinationPath,
+                                 const std::string& relativePath,
+                                 Stats& stats)
+{
+    try
+    {
+        Poco::File(destinationPath).createDirectories();
+
+        Poco::DirectoryIterator iter(sourcePath);
+        Poco::DirectoryIterator end;
+
+        while (iter != end)
+        {
+            std::string name = iter.name();
+            std::string relativeName = relativePath.empty() ? name : relativePath + "/" + name;
+            std::string destination = destinationPath + "/" + name;
+
+            if (iter->isLink())
+            {
+                ++stats.skipped;
+            }
+            else if (iter->isDirectory())
+            {
+                // Build products are regenerated and are named for the old
+                // project, so only the app's data folder is worth keeping.
+                if (relativeName == "obj"
+                 || (relativePath == "bin" && name != "data"))
+                {
+                    ++stats.skipped;
+                }
+                else if (!_cloneDirectory(iter->path(), destination, relativeName, stats))
+                {
+                    return false;
+                }
+            }
+            else if (relativePath == "bin")
+            {
+                ++stats.skipped;
+            }
+            else
+            {
+                bool success = _isEditable(relativeName)
+                    ? cloneFile(iter->path(), destination, stats)
+                    : linkFile(iter->path(), destination, stats);
+
+                if (!success)
+                {
+                    ofLogError("FileCloner::_cloneDirectory") << "Unable to clone " << iter->path() << ": " << std::strerror(errno);
+                    return false;
+                }
+            }
+
+            ++iter;
+        }
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogError("FileCloner::_cloneDirectory") << exc.displayText();
+        return false;
+    }
+
+    return true;
+}
+
+
+bool FileCloner::_copyFile(const std::string& sourcePath,
+                           const std::string& destinationPath)
+{
+    try
+    {
+        Poco::File(sourcePath).copyTo(destinationPath);
+        return true;
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogError("FileCloner::_copyFile") << exc.displayText();
+        return false;
+    }
+}
+
+
+} } // namespace of::Sketch
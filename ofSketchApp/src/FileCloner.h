@@ -0,0 +1,86 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Copies project trees, reflinking the files that are edited and
+///        hard linking the rest, which may only be replaced by a rename.
+class FileCloner
+{
+public:
+    struct Stats
+    {
+        Stats();
+
+        std::size_t linked;
+        std::size_t cloned;
+        std::size_t copied;
+        std::size_t skipped;
+    };
+
+    /// \returns false if destinationPath exists or a file can't be cloned.
+    static bool cloneProject(const std::string& sourcePath,
+                             const std::string& destinationPath,
+                             Stats& stats);
+
+    /// \brief Reflink a file, or copy it.
+    static bool cloneFile(const std::string& sourcePath,
+                          const std::string& destinationPath,
+                          Stats& stats);
+
+    /// \brief Hard link a file, or clone it.
+    static bool linkFile(const std::string& sourcePath,
+                         const std::string& destinationPath,
+                         Stats& stats);
+
+private:
+    enum Mode
+    {
+        MODE_LINK,
+        MODE_CLONE
+    };
+
+    static bool _isEditable(const std::string& relativeName);
+
+    static bool _cloneDirectory(const std::string& sourcePath,
+                                const std::string& destinationPath,
+                                const std::string& relativePath,
+                                Stats& stats);
+
+    static bool _copyFile(const std::string& sourcePath,
+                          const std::string& destinationPath);
+
+};
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,430 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "FileTransaction.h"
+#include <algorithm>
+#include <set>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "Poco/AtomicCounter.h"
+#include "Poco/Exception.h"
+#include "Poco/NumberFormatter.h"
+#include "Poco/Path.h"
+#include "Poco/SharedPtr.h"
+#include "Poco/Thread.h"
+#include "ofConstants.h"
+#include "ofLog.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+namespace {
+
+Poco::AtomicCounter tempFileCount;
+
+}
+
+
+const std::string FileTransaction::TEMP_FILE_SUFFIX = ".ofsketch-tmp";
+
+
+FileTransaction::SyncRunnable::SyncRunnable(int fd_, bool full_):
+    fd(fd_),
+    full(full_),
+    success(false),
+    error(0)
+{
+}
+
+
+void FileTransaction::SyncRunnable::run()
+{
+    success = _sync(fd, full);
+    error = success ? 0 : errno;
+}
+
+
+FileTransaction::FileTransaction(Durability durability):
+    _durability(durability),
+    _failed(false)
+{
+}
+
+
+FileTransaction::~FileTransaction()
+{
+    rollback();
+}
+
+
+bool FileTransaction::write(const std::string& path,
+                            const std::string& contents,
+                            bool replace)
+{
+    Entry entry;
+    entry.path = path;
+    entry.tempPath = _makeTempPath(path);
+    entry.replace = replace;
+    entry.fd = ::open(entry.tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+
+    if (entry.fd < 0)
+    {
+        ofLogError("FileTransaction::write") << "Unable to open " << entry.tempPath << ": " << std::strerror(errno);
+        _failed = true;
+        return false;
+    }
+
+    if (!_writeAll(entry.fd, contents))
+    {
+        ofLogError("FileTransaction::write") << "Unable to write " << entry.tempPath << ": " << std::strerror(errno);
+        ::close(entry.fd);
+        ::unlink(entry.tempPath.c_str());
+        _failed = true;
+        return false;
+    }
+
+    // The descriptor stays open so the flush can be batched in commit().
+    _entries.push_back(entry);
+
+    return true;
+}
+
+
+bool FileTransaction::commit()
+{
+    if (_failed)
+    {
+        ofLogError("FileTransaction::commit") << "A staged write failed, rolling back.";
+        rollback();
+        return false;
+    }
+
+    bool success = true;
+
+    std::vector<int> fds;
+
+    std::vector<Entry>::iterator iter = _entries.begin();
+
+    for (; iter != _entries.end(); ++iter)
+    {
+        fds.push_back(iter->fd);
+    }
+
+    // Flush every file before renaming any of them so that a crash can never
+    // expose a renamed file whose contents are still only in the page cache.
+    if (_durability != DURABILITY_NONE && !_syncAll(fds, _durability == DURABILITY_FULL))
+    {
+        ofLogError("FileTransaction::commit") << "Unable to sync staged files: " << std::strerror(errno);
+        success = false;
+    }
+
+    for (iter = _entries.begin(); iter != _entries.end(); ++iter)
+    {
+        ::close(iter->fd);
+        iter->fd = -1;
+    }
+
+    if (!success)
+    {
+        rollback();
+        return false;
+    }
+
+    std::set<std::string> directories;
+
+    iter = _entries.begin();
+
+    while (iter != _entries.end())
+    {
+        // Another writer may have put the same file there first, which is
+        // as good as ours.
+        if (!iter->replace && ::access(iter->path.c_str(), F_OK) == 0)
+        {
+            ::unlink(iter->tempPath.c_str());
+        }
+        else if (::rename(iter->tempPath.c_str(), iter->path.c_str()) == 0)
+        {
+            directories.insert(Poco::Path(iter->path).parent().toString());
+        }
+        else
+        {
+            int error = errno;
+
+            ::unlink(iter->tempPath.c_str());
+
+            if (iter->replace || ::access(iter->path.c_str(), F_OK) != 0)
+            {
+                ofLogError("FileTransaction::commit") << "Unable to rename " << iter->tempPath << ": " << std::strerror(error);
+                success = false;
+            }
+        }
+
+        ++iter;
+    }
+
+    _entries.clear();
+
+    if (_durability == DURABILITY_FULL)
+    {
+        fds.clear();
+
+        std::set<std::string>::const_iterator dirIter = directories.begin();
+
+        for (; dirIter != directories.end(); ++dirIter)
+        {
+            int fd = ::open(dirIter->c_str(), O_RDONLY);
+
+            if (fd < 0)
+            {
+                ofLogError("FileTransaction::commit") << "Unable to open directory " << *dirIter << ": " << std::strerror(errno);
+                success = false;
+            }
+            else
+            {
+                fds.push_back(fd);
+            }
+        }
+
+        if (!_syncAll(fds, true))
+        {
+            ofLogError("FileTransaction::commit") << "Unable to sync directories: " << std::strerror(errno);
+            success = false;
+        }
+
+        for (std::size_t i = 0; i < fds.size(); ++i)
+        {
+            ::close(fds[i]);
+        }
+    }
+
+    return success;
+}
+
+
+void FileTransaction::rollback()
+{
+    std::vector<Entry>::iterator iter = _entries.begin();
+
+    while (iter != _entries.end())
+    {
+        if (iter->fd >= 0)
+        {
+            ::close(iter->fd);
+        }
+
+        ::unlink(iter->tempPath.c_str());
+        ++iter;
+    }
+
+    _entries.clear();
+    _failed = false;
+}
+
+
+bool FileTransaction::empty() const
+{
+    return _entries.empty();
+}
+
+
+bool FileTransaction::append(const std::string& path,
+                             const std::string& contents,
+                             Durability durability)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+
+    if (fd < 0)
+    {
+        ofLogError("FileTransaction::append") << "Unable to open " << path << ": " << std::strerror(errno);
+        return false;
+    }
+
+    bool success = _writeAll(fd, contents);
+
+    if (success && durability != DURABILITY_NONE)
+    {
+        success = _sync(fd, durability == DURABILITY_FULL);
+    }
+
+    if (!success)
+    {
+        ofLogError("FileTransaction::append") << "Unable to append to " << path << ": " << std::strerror(errno);
+    }
+
+    ::close(fd);
+
+    return success;
+}
+
+
+FileTransaction::Durability FileTransaction::getDurability() const
+{
+    return _durability;
+}
+
+
+FileTransaction::Durability FileTransaction::fromString(const std::string& durability)
+{
+    if (durability == "none")
+    {
+        return DURABILITY_NONE;
+    }
+    else if (durability == "full")
+    {
+        return DURABILITY_FULL;
+    }
+    else if (durability == "normal" || durability.empty())
+    {
+        return DURABILITY_NORMAL;
+    }
+    else
+    {
+        ofLogWarning("FileTransaction::fromString") << "Unrecognized durability: " << durability;
+        return DURABILITY_NORMAL;
+    }
+}
+
+
+std::string FileTransaction::toString(Durability durability)
+{
+    switch (durability)
+    {
+        case DURABILITY_NONE:
+            return "none";
+        case DURABILITY_FULL:
+            return "full";
+        case DURABILITY_NORMAL:
+        default:
+            return "normal";
+    }
+}
+
+
+std::string FileTransaction::_makeTempPath(const std::string& path)
+{
+    return path + TEMP_FILE_SUFFIX + "-"
+         + Poco::NumberFormatter::format(static_cast<int>(::getpid())) + "-"
+         + Poco::NumberFormatter::format(++tempFileCount);
+}
+
+
+bool FileTransaction::_writeAll(int fd, const std::string& contents)
+{
+    const char* data = contents.data();
+    std::size_t remaining = contents.size();
+
+    while (remaining > 0)
+    {
+        ssize_t written = ::write(fd, data, remaining);
+
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        data += written;
+        remaining -= written;
+    }
+
+    return true;
+}
+
+
+bool FileTransaction::_sync(int fd, bool full)
+{
+#if defined(TARGET_OSX)
+    // fsync on OS X only reaches the drive cache.
+    if (full && ::fcntl(fd, F_FULLFSYNC) == 0) return true;
+#elif defined(TARGET_LINUX)
+    // The staged files are new, so their data and size are all a rename
+    // needs; the rest of their metadata is only flushed when asked.
+    if (!full) return ::fdatasync(fd) == 0;
+#endif
+    return ::fsync(fd) == 0;
+}
+
+
+bool FileTransaction::_syncAll(const std::vector<int>& fds, bool full)
+{
+    if (fds.size() == 1)
+    {
+        return _sync(fds[0], full);
+    }
+
+    // Only the staged files are flushed, not everything else waiting on
+    // the same file system.  Flushes that wait together share the file
+    // system's journal commits, so they are made in parallel.
+    bool success = true;
+
+    for (std::size_t first = 0; first < fds.size(); first += MAXIMUM_SYNC_THREADS)
+    {
+        std::size_t last = std::min<std::size_t>(first + MAXIMUM_SYNC_THREADS, fds.size());
+
+        std::vector<Poco::SharedPtr<SyncRunnable> > runnables;
+        std::vector<Poco::SharedPtr<Poco::Thread> > threads;
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            runnables.push_back(new SyncRunnable(fds[i], full));
+            threads.push_back(new Poco::Thread());
+
+            try
+            {
+                threads.back()->start(*runnables.back());
+            }
+            catch (const Poco::Exception&)
+            {
+                // Out of threads, so flush it on this one.
+                threads.back() = 0;
+                runnables.back()->run();
+            }
+        }
+
+        for (std::size_t i = 0; i < runnables.size(); ++i)
+        {
+            if (threads[i])
+            {
+                threads[i]->join();
+            }
+
+            if (!runnables[i]->success)
+            {
+                // For the caller's log.
+                errno = runnables[i]->error;
+                success = false;
+            }
+        }
+    }
+
+    return success;
+}
+
+
+} } // namespace of::Sketch
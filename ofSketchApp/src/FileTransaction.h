@@ -0,0 +1,124 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include "Poco/Runnable.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Writes files to temporary siblings and renames them into place,
+///        so the files FileCloner hard links are never modified.
+class FileTransaction
+{
+public:
+    enum Durability
+    {
+        DURABILITY_NONE,   // rename only
+        DURABILITY_NORMAL, // flush contents before renaming
+        DURABILITY_FULL    // also flush the directories
+    };
+
+    FileTransaction(Durability durability = DURABILITY_NORMAL);
+
+    ~FileTransaction();
+
+    /// \param replace If false, a file already at path is kept.
+    bool write(const std::string& path,
+               const std::string& contents,
+               bool replace = true);
+
+    /// \brief Flush and rename the staged files, or none if a write failed.
+    bool commit();
+
+    void rollback();
+
+    bool empty() const;
+
+    /// \brief Not atomic; for logs whose readers skip a partial last line.
+    static bool append(const std::string& path,
+                       const std::string& contents,
+                       Durability durability);
+
+    Durability getDurability() const;
+
+    static Durability fromString(const std::string& durability);
+    static std::string toString(Durability durability);
+
+    static const std::string TEMP_FILE_SUFFIX;
+
+    enum
+    {
+        /// \brief Files flushed at once by a commit.
+        MAXIMUM_SYNC_THREADS = 8
+    };
+
+private:
+    struct Entry
+    {
+        std::string path;
+        std::string tempPath;
+        int fd;
+        bool replace;
+    };
+
+    Durability _durability;
+
+    bool _failed;
+
+    std::vector<Entry> _entries;
+
+    /// \brief Flushes one file on a thread of its own.
+    class SyncRunnable: public Poco::Runnable
+    {
+    public:
+        SyncRunnable(int fd, bool full);
+
+        void run();
+
+        int fd;
+        bool full;
+        bool success;
+        int error; // errno, if the flush failed
+    };
+
+    static std::string _makeTempPath(const std::string& path);
+
+    static bool _writeAll(int fd, const std::string& contents);
+    static bool _sync(int fd, bool full);
+
+    /// \brief Flush the files open on fds, in parallel.
+    static bool _syncAll(const std::vector<int>& fds, bool full);
+
+};
+
+
+} } // namespace of::Sketch
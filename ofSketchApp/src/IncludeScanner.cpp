@@ -0,0 +1,268 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "IncludeScanner.h"
+#include <algorithm>
+
+
+namespace of {
+namespace Sketch {
+
+
+void IncludeScanner::scan(const std::string& source,
+                          std::string& code,
+                          std::vector<std::string>& includes,
+                          std::vector<std::size_t>& lines)
+{
+    code.clear();
+    code.reserve(source.size());
+
+    // The start of the source that has not yet been copied to code.
+    std::size_t copied = 0;
+    // Lines are only counted up to each include.
+    std::size_t counted = 0;
+    std::size_t line = 1;
+    std::size_t i = 0;
+    bool isLineStart = true;
+
+    while (i < source.size())
+    {
+        char c = source[i];
+
+        if (c == '\n')
+        {
+            isLineStart = true;
+            ++i;
+        }
+        else if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v')
+        {
+            ++i;
+        }
+        else if (c == '#' && isLineStart)
+        {
+            // Indentation before the directive goes with it.
+            std::size_t start = i;
+
+            while (start > copied && (source[start - 1] == ' ' || source[start - 1] == '\t'))
+            {
+                --start;
+            }
+
+            std::size_t name = i + 1;
+
+            while (name < source.size() && (source[name] == ' ' || source[name] == '\t'))
+            {
+                ++name;
+            }
+
+            std::size_t end = _findDirectiveEnd(source, i);
+
+            if (source.compare(name, 7, "include") == 0
+             && (name + 7 >= source.size() || !_isIdentifier(source[name + 7])))
+            {
+                code.append(source, copied, start - copied);
+                includes.push_back(source.substr(start, end - start));
+
+                line += std::count(source.begin() + counted, source.begin() + start, '\n');
+                counted = start;
+                lines.push_back(line);
+
+                code.append(std::count(source.begin() + start, source.begin() + end, '\n'), '\n');
+
+                if (includes.back().empty() || includes.back()[includes.back().size() - 1] != '\n')
+                {
+                    includes.back() += '\n';
+                }
+
+                copied = end;
+            }
+
+            i = end;
+            isLineStart = true;
+        }
+        else if (c == '/' && i + 1 < source.size() && source[i + 1] == '/')
+        {
+            // A line comment ends at a newline without a continuation.
+            i += 2;
+
+            while (i < source.size() && source[i] != '\n')
+            {
+                i += (source[i] == '\\' && i + 1 < source.size()) ? 2 : 1;
+            }
+        }
+        else if (c == '/' && i + 1 < source.size() && source[i + 1] == '*')
+        {
+            std::size_t end = source.find("*/", i + 2);
+            i = (end == std::string::npos) ? source.size() : end + 2;
+        }
+        else if (c == '"')
+        {
+            std::size_t end = _skipRawString(source, i);
+            i = (end == std::string::npos) ? _skipQuoted(source, i) : end;
+            isLineStart = false;
+        }
+        else if (c == '\'' && !(i > 0 && source[i - 1] >= '0' && source[i - 1] <= '9'))
+        {
+            i = _skipQuoted(source, i);
+            isLineStart = false;
+        }
+        else
+        {
+            ++i;
+            isLineStart = false;
+        }
+    }
+
+    code.append(source, copied, std::string::npos);
+}
+
+
+std::size_t IncludeScanner::_findDirectiveEnd(const std::string& source,
+                                              std::size_t position)
+{
+    std::size_t i = position;
+
+    while (i < source.size())
+    {
+        if (source[i] == '\n')
+        {
+            return i + 1;
+        }
+        else if (source[i] == '\\' && i + 1 < source.size())
+        {
+            i += 2;
+        }
+        else if (source[i] == '/' && i + 1 < source.size() && source[i + 1] == '*')
+        {
+            std::size_t end = source.find("*/", i + 2);
+            i = (end == std::string::npos) ? source.size() : end + 2;
+        }
+        else if (source[i] == '/' && i + 1 < source.size() && source[i + 1] == '/')
+        {
+            std::size_t end = source.find('\n', i);
+            return (end == std::string::npos) ? source.size() : end + 1;
+        }
+        else if (source[i] == '"')
+        {
+            i = _skipQuoted(source, i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    return source.size();
+}
+
+
+std::size_t IncludeScanner::_skipQuoted(const std::string& source,
+                                        std::size_t position)
+{
+    char quote = source[position];
+
+    std::size_t i = position + 1;
+
+    while (i < source.size())
+    {
+        if (source[i] == '\\')
+        {
+            i += 2;
+        }
+        else if (source[i] == quote)
+        {
+            return i + 1;
+        }
+        else if (source[i] == '\n')
+        {
+            // Unterminated.  Resynchronize at the end of the line.
+            return i;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    return source.size();
+}
+
+
+std::size_t IncludeScanner::_skipRawString(const std::string& source,
+                                           std::size_t position)
+{
+    // R"delimiter( ... )delimiter", optionally prefixed by u8, u, U or L.
+    if (position == 0 || source[position - 1] != 'R')
+    {
+        return std::string::npos;
+    }
+
+    std::size_t prefix = position - 1;
+
+    while (prefix > 0 && _isIdentifier(source[prefix - 1]))
+    {
+        --prefix;
+    }
+
+    std::string encoding = source.substr(prefix, position - 1 - prefix);
+
+    if (!encoding.empty() && encoding != "u8" && encoding != "u" && encoding != "U" && encoding != "L")
+    {
+        return std::string::npos;
+    }
+
+    std::size_t open = source.find('(', position + 1);
+
+    // Delimiters are at most 16 characters long.
+    if (open == std::string::npos || open - position - 1 > 16)
+    {
+        return std::string::npos;
+    }
+
+    std::string delimiter = source.substr(position + 1, open - position - 1);
+
+    if (delimiter.find_first_of(" ()\\\t\v\f\n\"") != std::string::npos)
+    {
+        return std::string::npos;
+    }
+
+    std::string terminator = ")" + delimiter + "\"";
+
+    std::size_t end = source.find(terminator, open + 1);
+
+    return (end == std::string::npos) ? source.size() : end + terminator.size();
+}
+
+
+bool IncludeScanner::_isIdentifier(char c)
+{
+    return (c >= 'a' && c <= 'z')
+        || (c >= 'A' && c <= 'Z')
+        || (c >= '0' && c <= '9')
+        || c == '_';
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,64 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Finds the #include directives in a sketch, skipping comments
+///        and literals.
+class IncludeScanner
+{
+public:
+    /// \param code Receives source with its #include lines left blank.
+    static void scan(const std::string& source,
+                     std::string& code,
+                     std::vector<std::string>& includes,
+                     std::vector<std::size_t>& lines);
+
+private:
+    static std::size_t _findDirectiveEnd(const std::string& source,
+                                         std::size_t position);
+
+    static std::size_t _skipQuoted(const std::string& source,
+                                   std::size_t position);
+
+    /// \returns std::string::npos if this is not a raw string.
+    static std::size_t _skipRawString(const std::string& source,
+                                      std::size_t position);
+
+    static bool _isIdentifier(char c);
+
+};
+
+
+} } // namespace of::Sketch
@@ -38,8 +38,19 @@ MakeTask::Settings::Settings():
     isSilent(true),
     CXX(""),
     CC(""),
+    distccHosts(""),
     platformVariant(""),
-    makefileDebug(false)
+    makefileDebug(false),
+    optimization(""),
+    cflags(""),
+    ldflags(""),
+    objectDir(""),
+    binaryName(""),
+    isCrossCompiling(false),
+    platformArch(""),
+    sysroot(""),
+    toolchainRoot(""),
+    gccPrefix("")
 {
 }
 
@@ -50,58 +61,155 @@ MakeTask::MakeTask(const Settings& settings,
     BaseProcessTask(project.getPath(), "make"),
     _settings(settings),
     _project(project),
-    _target(target)
+    _target(target),
+    _hasUnityErrors(false)
 {
-    _args.push_back("--directory=" + ofToDataPath(_project.getPath()));
+    _args = getArgs(_settings, _project, _target);
 
-    if (!_settings.ofRoot.empty())
+    ofLogNotice("MakeTask::MakeTask") << "Configuring Make Task with Args: " << ofToString(_args);
+}
+
+
+MakeTask::~MakeTask()
+{
+}
+
+
+std::vector<std::string> MakeTask::getArgs(const Settings& settings,
+                                           const Project& project,
+                                           const std::string& target)
+{
+    std::vector<std::string> args;
+
+    args.push_back("--directory=" + ofToDataPath(project.getPath()));
+
+    if (!settings.ofRoot.empty())
+    {
+        args.push_back("OF_ROOT=" + settings.ofRoot);
+    }
+
+    if (settings.numProcessors > 1)
     {
-        _args.push_back("OF_ROOT=" + _settings.ofRoot);
+        args.push_back("-j" + ofToString(settings.numProcessors));
     }
 
-    if (_settings.numProcessors > 1)
+    if (settings.isSilent)
     {
-        _args.push_back("-j" + ofToString(_settings.numProcessors));
+        args.push_back("-s");
     }
 
-    if (_settings.isSilent)
+    if (!settings.CC.empty())
     {
-        _args.push_back("-s");
+        args.push_back("CC=" + settings.CC);
     }
 
-    if (!_settings.CC.empty())
+    if (!settings.CXX.empty())
     {
-        _args.push_back("CC=" + _settings.CC);
+        args.push_back("CXX=" + settings.CXX);
     }
 
-    if (!_settings.CXX.empty())
+    // make exports command line variables to its recipes, so distcc sees
+    // the hosts without changing this process's environment.
+    if (!settings.distccHosts.empty())
     {
-        _args.push_back("CXX=" + _settings.CXX);
+        args.push_back("DISTCC_HOSTS=" + settings.distccHosts);
     }
 
-    if (!_settings.platformVariant.empty())
+    if (!settings.platformVariant.empty())
     {
-        _args.push_back("PLATFORM_VARIANT=" + _settings.platformVariant);
+        args.push_back("PLATFORM_VARIANT=" + settings.platformVariant);
     }
 
-    if (_settings.makefileDebug)
+    if (settings.isCrossCompiling)
     {
-        _args.push_back("MAKEFILE_DEBUG=1");
+        args.push_back("CROSS_COMPILING=1");
     }
 
-    _args.push_back(_target);
+    if (!settings.platformArch.empty())
+    {
+        args.push_back("PLATFORM_ARCH=" + settings.platformArch);
+    }
 
-    ofLogNotice("MakeTask::MakeTask") << "Configuring Make Task with Args: " << ofToString(_args);
+    if (!settings.sysroot.empty())
+    {
+        // The Raspberry Pi makefiles call the sysroot RPI_ROOT.
+        args.push_back("SYSROOT=" + settings.sysroot);
+        args.push_back("RPI_ROOT=" + settings.sysroot);
+    }
+
+    if (!settings.toolchainRoot.empty())
+    {
+        args.push_back("TOOLCHAIN_ROOT=" + settings.toolchainRoot);
+    }
+
+    if (!settings.gccPrefix.empty())
+    {
+        args.push_back("GCC_PREFIX=" + settings.gccPrefix);
+    }
+
+    if (settings.makefileDebug)
+    {
+        args.push_back("MAKEFILE_DEBUG=1");
+    }
+
+    if (!settings.optimization.empty())
+    {
+        std::string configuration = ofToUpper(target);
+        args.push_back("PROJECT_OPTIMIZATION_CFLAGS_" + configuration + "=" + settings.optimization);
+    }
+
+    if (!settings.cflags.empty())
+    {
+        args.push_back("PROJECT_CFLAGS=" + settings.cflags);
+    }
+
+    if (!settings.ldflags.empty())
+    {
+        args.push_back("PROJECT_LDFLAGS=" + settings.ldflags);
+    }
+
+    if (!settings.objectDir.empty())
+    {
+        args.push_back("OF_PROJECT_OBJ_OUTPUT_PATH=" + settings.objectDir);
+    }
+
+    if (!settings.binaryName.empty())
+    {
+        args.push_back("BIN_NAME=" + settings.binaryName);
+    }
+
+    args.push_back(target);
+
+    return args;
 }
 
 
-MakeTask::~MakeTask()
+void MakeTask::runTask()
 {
+    BaseProcessTask::runTask();
+
+    if (_exitCode != 0 && _hasUnityErrors && !isCancelled())
+    {
+        processLine(UnityBuild::RETRY_MESSAGE);
+
+        UnityBuild::disable(_project);
+        _hasUnityErrors = false;
+        _includeStack = UnityBuild::IncludeStack();
+
+        BaseProcessTask::runTask();
+    }
 }
 
 
 void MakeTask::processLine(const std::string& line)
 {
+    // Warnings, and lines that only mention a unit, don't make the unity
+    // build worth turning off.
+    if (UnityBuild::isUnityError(line, _includeStack))
+    {
+        _hasUnityErrors = true;
+    }
+
     postNotification(new Poco::TaskCustomNotification<std::string>(this, line));
 }
 
@@ -36,6 +36,7 @@
 #include "ofUtils.h"
 #include "Project.h"
 #include "BaseProcessTask.h"
+#include "UnityBuild.h"
 
 
 namespace of {
@@ -53,8 +54,17 @@ public:
 
     virtual ~MakeTask();
 
+    /// \brief Run make, retrying without a unity build if it failed in a
+    ///        unity translation unit.
+    virtual void runTask();
+
     virtual void processLine(const std::string& line);
 
+    /// \returns the arguments that make is run with.
+    static std::vector<std::string> getArgs(const Settings& settings,
+                                            const Project& project,
+                                            const std::string& target);
+
     struct Settings
     {
         std::string ofRoot;
@@ -64,18 +74,35 @@ public:
 
         std::string CXX; // CXX=/usr/lib/distcc/arm-linux-gnueabihf-g++
         std::string CC;  // CC=/usr/lib/distcc/arm-linux-gnueabihf-gcc
+        std::string distccHosts; // e.g. DISTCC_HOSTS=10.0.0.2:3632/8
 
         std::string platformVariant; // e.g. PLATFORM_VARIANT=udoo
         bool makefileDebug; // e.g. MAKEFILE_DEBUG=1
 
+        std::string optimization; // e.g. PROJECT_OPTIMIZATION_CFLAGS_RELEASE=-O1
+        std::string cflags;  // e.g. PROJECT_CFLAGS=-g -gsplit-dwarf
+        std::string ldflags; // e.g. PROJECT_LDFLAGS=-fuse-ld=lld
+        std::string objectDir; // e.g. OF_PROJECT_OBJ_OUTPUT_PATH=obj/fast/
+        std::string binaryName; // e.g. BIN_NAME=MyProject_fast
+
+        bool isCrossCompiling; // CROSS_COMPILING=1
+        std::string platformArch; // e.g. PLATFORM_ARCH=armv6l
+        std::string sysroot; // e.g. SYSROOT=/opt/raspberrypi/root
+        std::string toolchainRoot; // e.g. TOOLCHAIN_ROOT=/opt/raspberrypi/tools
+        std::string gccPrefix; // e.g. GCC_PREFIX=arm-linux-gnueabihf
+
         Settings();
     };
 
 private:
     Settings _settings;
-    const Project& _project;
+    /// \brief A copy, since the build outlives the call that started it.
+    Project _project;
     std::string _target;
 
+    bool _hasUnityErrors;
+    UnityBuild::IncludeStack _includeStack;
+
 };
 
 
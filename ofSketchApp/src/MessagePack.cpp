@@ -0,0 +1,476 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "MessagePack.h"
+#include <cstring>
+
+
+namespace of {
+namespace Sketch {
+
+
+namespace {
+
+const unsigned char STRING_TYPES[3] = { 0xd9, 0xda, 0xdb };
+const unsigned char ARRAY_TYPES[3] = { 0, 0xdc, 0xdd };
+const unsigned char MAP_TYPES[3] = { 0, 0xde, 0xdf };
+
+}
+
+
+MessagePack::Writer::Writer(std::string& buffer):
+    _buffer(buffer)
+{
+}
+
+
+void MessagePack::Writer::beginObject(std::size_t size)
+{
+    _writeHeader(0x80, 16, MAP_TYPES, size, _buffer);
+}
+
+
+void MessagePack::Writer::endObject()
+{
+}
+
+
+void MessagePack::Writer::beginArray(std::size_t size)
+{
+    _writeHeader(0x90, 16, ARRAY_TYPES, size, _buffer);
+}
+
+
+void MessagePack::Writer::endArray()
+{
+}
+
+
+void MessagePack::Writer::writeKey(const char* name, std::size_t size)
+{
+    writeString(name, size);
+}
+
+
+void MessagePack::Writer::writeString(const char* value, std::size_t size)
+{
+    _writeHeader(0xa0, 32, STRING_TYPES, size, _buffer);
+    _buffer.append(value, size);
+}
+
+
+void MessagePack::Writer::writeInt(Poco::Int64 value)
+{
+    if (value >= 0)
+    {
+        writeUInt(Poco::UInt64(value));
+    }
+    else if (value >= -32)
+    {
+        // A negative fixint.
+        _buffer += char(value);
+    }
+    else if (value >= -128)
+    {
+        _buffer += char(0xd0);
+        _writeBigEndian(Poco::UInt64(value), 1, _buffer);
+    }
+    else if (value >= -32768)
+    {
+        _buffer += char(0xd1);
+        _writeBigEndian(Poco::UInt64(value), 2, _buffer);
+    }
+    else if (value >= -2147483647 - 1)
+    {
+        _buffer += char(0xd2);
+        _writeBigEndian(Poco::UInt64(value), 4, _buffer);
+    }
+    else
+    {
+        _buffer += char(0xd3);
+        _writeBigEndian(Poco::UInt64(value), 8, _buffer);
+    }
+}
+
+
+void MessagePack::Writer::writeUInt(Poco::UInt64 value)
+{
+    if (value < 0x80)
+    {
+        // A positive fixint.
+        _buffer += char(value);
+    }
+    else if (value <= 0xff)
+    {
+        _buffer += char(0xcc);
+        _writeBigEndian(value, 1, _buffer);
+    }
+    else if (value <= 0xffff)
+    {
+        _buffer += char(0xcd);
+        _writeBigEndian(value, 2, _buffer);
+    }
+    else if (value <= 0xffffffff)
+    {
+        _buffer += char(0xce);
+        _writeBigEndian(value, 4, _buffer);
+    }
+    else
+    {
+        _buffer += char(0xcf);
+        _writeBigEndian(value, 8, _buffer);
+    }
+}
+
+
+void MessagePack::Writer::writeDouble(double value)
+{
+    Poco::UInt64 bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    _buffer += char(0xcb);
+    _writeBigEndian(bits, 8, _buffer);
+}
+
+
+void MessagePack::Writer::writeBool(bool value)
+{
+    _buffer += char(value ? 0xc3 : 0xc2);
+}
+
+
+void MessagePack::Writer::writeNull()
+{
+    _buffer += char(0xc0);
+}
+
+
+void MessagePack::write(const Json::Value& json, std::string& buffer)
+{
+    Writer writer(buffer);
+    writer.value(json);
+}
+
+
+std::string MessagePack::toString(const Json::Value& json)
+{
+    std::string buffer;
+    write(json, buffer);
+    return buffer;
+}
+
+
+bool MessagePack::read(const std::string& buffer, Json::Value& json)
+{
+    std::size_t offset = 0;
+    Json::Value value;
+
+    if (!_read(buffer, offset, 0, value) || offset != buffer.size())
+    {
+        return false;
+    }
+
+    json.swap(value);
+    return true;
+}
+
+
+void MessagePack::_writeHeader(unsigned char fixed,
+                               Poco::UInt64 fixedSizes,
+                               const unsigned char types[3],
+                               Poco::UInt64 size,
+                               std::string& buffer)
+{
+    if (size < fixedSizes)
+    {
+        buffer += char(fixed | size);
+    }
+    else if (types[0] != 0 && size <= 0xff)
+    {
+        buffer += char(types[0]);
+        _writeBigEndian(size, 1, buffer);
+    }
+    else if (size <= 0xffff)
+    {
+        buffer += char(types[1]);
+        _writeBigEndian(size, 2, buffer);
+    }
+    else
+    {
+        buffer += char(types[2]);
+        _writeBigEndian(size, 4, buffer);
+    }
+}
+
+
+void MessagePack::_writeBigEndian(Poco::UInt64 value,
+                                  std::size_t bytes,
+                                  std::string& buffer)
+{
+    while (bytes-- > 0)
+    {
+        buffer += char((value >> (bytes * 8)) & 0xff);
+    }
+}
+
+
+bool MessagePack::_read(const std::string& buffer,
+                        std::size_t& offset,
+                        std::size_t depth,
+                        Json::Value& json)
+{
+    if (offset >= buffer.size() || depth > MAXIMUM_DEPTH)
+    {
+        return false;
+    }
+
+    unsigned char type = static_cast<unsigned char>(buffer[offset++]);
+    Poco::UInt64 value = 0;
+
+    if (type < 0x80)
+    {
+        json = Json::UInt64(type);
+        return true;
+    }
+    else if (type >= 0xe0)
+    {
+        json = Json::Int64(static_cast<signed char>(type));
+        return true;
+    }
+    else if (type < 0x90)
+    {
+        return _readMap(buffer, offset, depth, type & 0x0f, json);
+    }
+    else if (type < 0xa0)
+    {
+        return _readArray(buffer, offset, depth, type & 0x0f, json);
+    }
+    else if (type < 0xc0)
+    {
+        return _readString(buffer, offset, type & 0x1f, json);
+    }
+
+    switch (type)
+    {
+        case 0xc0:
+            json = Json::Value();
+            return true;
+        case 0xc2:
+            json = false;
+            return true;
+        case 0xc3:
+            json = true;
+            return true;
+        case 0xc4: // bin 8
+        case 0xd9: // str 8
+            return _readBigEndian(buffer, offset, 1, value)
+                && _readString(buffer, offset, value, json);
+        case 0xc5: // bin 16
+        case 0xda: // str 16
+            return _readBigEndian(buffer, offset, 2, value)
+                && _readString(buffer, offset, value, json);
+        case 0xc6: // bin 32
+        case 0xdb: // str 32
+            return _readBigEndian(buffer, offset, 4, value)
+                && _readString(buffer, offset, value, json);
+        case 0xca: // float 32
+        {
+            if (!_readBigEndian(buffer, offset, 4, value))
+            {
+                return false;
+            }
+
+            Poco::UInt32 bits = Poco::UInt32(value);
+            float number = 0;
+            std::memcpy(&number, &bits, sizeof(number));
+            json = double(number);
+            return true;
+        }
+        case 0xcb: // float 64
+        {
+            if (!_readBigEndian(buffer, offset, 8, value))
+            {
+                return false;
+            }
+
+            double number = 0;
+            std::memcpy(&number, &value, sizeof(number));
+            json = number;
+            return true;
+        }
+        case 0xcc: // uint 8
+        case 0xcd: // uint 16
+        case 0xce: // uint 32
+        case 0xcf: // uint 64
+        {
+            if (!_readBigEndian(buffer, offset, std::size_t(1) << (type - 0xcc), value))
+            {
+                return false;
+            }
+
+            json = Json::UInt64(value);
+            return true;
+        }
+        case 0xd0: // int 8
+        case 0xd1: // int 16
+        case 0xd2: // int 32
+        case 0xd3: // int 64
+        {
+            std::size_t bytes = std::size_t(1) << (type - 0xd0);
+
+            if (!_readBigEndian(buffer, offset, bytes, value))
+            {
+                return false;
+            }
+
+            // Extend the sign of the shorter forms.
+            if (bytes < 8 && (value >> (bytes * 8 - 1)) & 1)
+            {
+                value |= ~Poco::UInt64(0) << (bytes * 8);
+            }
+
+            json = Json::Int64(value);
+            return true;
+        }
+        case 0xdc: // array 16
+            return _readBigEndian(buffer, offset, 2, value)
+                && _readArray(buffer, offset, depth, value, json);
+        case 0xdd: // array 32
+            return _readBigEndian(buffer, offset, 4, value)
+                && _readArray(buffer, offset, depth, value, json);
+        case 0xde: // map 16
+            return _readBigEndian(buffer, offset, 2, value)
+                && _readMap(buffer, offset, depth, value, json);
+        case 0xdf: // map 32
+            return _readBigEndian(buffer, offset, 4, value)
+                && _readMap(buffer, offset, depth, value, json);
+        default:
+            // Extension types, and 0xc1, which is never used.
+            return false;
+    }
+}
+
+
+bool MessagePack::_readBigEndian(const std::string& buffer,
+                                 std::size_t& offset,
+                                 std::size_t bytes,
+                                 Poco::UInt64& value)
+{
+    if (buffer.size() - offset < bytes)
+    {
+        return false;
+    }
+
+    value = 0;
+
+    for (std::size_t i = 0; i < bytes; ++i)
+    {
+        value = (value << 8) | static_cast<unsigned char>(buffer[offset++]);
+    }
+
+    return true;
+}
+
+
+bool MessagePack::_readString(const std::string& buffer,
+                              std::size_t& offset,
+                              Poco::UInt64 size,
+                              Json::Value& json)
+{
+    if (buffer.size() - offset < size)
+    {
+        return false;
+    }
+
+    json = buffer.substr(offset, std::size_t(size));
+    offset += std::size_t(size);
+    return true;
+}
+
+
+bool MessagePack::_readArray(const std::string& buffer,
+                             std::size_t& offset,
+                             std::size_t depth,
+                             Poco::UInt64 size,
+                             Json::Value& json)
+{
+    // Every element takes at least a byte, so a size larger than what is
+    // left can't be valid, and isn't allocated.
+    if (buffer.size() - offset < size)
+    {
+        return false;
+    }
+
+    json = Json::Value(Json::arrayValue);
+
+    if (size > 0)
+    {
+        json.resize(Json::ArrayIndex(size));
+    }
+
+    for (Json::ArrayIndex i = 0; i < size; ++i)
+    {
+        if (!_read(buffer, offset, depth + 1, json[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool MessagePack::_readMap(const std::string& buffer,
+                           std::size_t& offset,
+                           std::size_t depth,
+                           Poco::UInt64 size,
+                           Json::Value& json)
+{
+    if ((buffer.size() - offset) / 2 < size)
+    {
+        return false;
+    }
+
+    json = Json::Value(Json::objectValue);
+
+    for (Poco::UInt64 i = 0; i < size; ++i)
+    {
+        Json::Value key;
+
+        if (!_read(buffer, offset, depth + 1, key) || !key.isString())
+        {
+            return false;
+        }
+
+        if (!_read(buffer, offset, depth + 1, json[key.asString()]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+} } // namespace of::Sketch
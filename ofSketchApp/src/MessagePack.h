@@ -0,0 +1,120 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <json/json.h>
+#include "Poco/Types.h"
+#include "Utils.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Encodes and decodes messages as MessagePack <http://msgpack.org>.
+///        Binary values are decoded as strings; extensions are rejected.
+class MessagePack
+{
+public:
+    class Writer: public ValueWriter
+    {
+    public:
+        Writer(std::string& buffer);
+
+        void beginObject(std::size_t size);
+        void endObject();
+        void beginArray(std::size_t size);
+        void endArray();
+        void writeKey(const char* name, std::size_t size);
+        void writeString(const char* value, std::size_t size);
+        void writeInt(Poco::Int64 value);
+        void writeUInt(Poco::UInt64 value);
+        void writeDouble(double value);
+        void writeBool(bool value);
+        void writeNull();
+
+    private:
+        std::string& _buffer;
+
+    };
+
+    static void write(const Json::Value& json, std::string& buffer);
+
+    static std::string toString(const Json::Value& json);
+
+    /// \returns false if the buffer doesn't hold exactly one valid value.
+    static bool read(const std::string& buffer, Json::Value& json);
+
+    enum
+    {
+        MAXIMUM_DEPTH = 64
+    };
+
+private:
+    /// \param types The types with 8, 16 and 32 bit sizes, or 0 for none.
+    static void _writeHeader(unsigned char fixed,
+                             Poco::UInt64 fixedSizes,
+                             const unsigned char types[3],
+                             Poco::UInt64 size,
+                             std::string& buffer);
+
+    static void _writeBigEndian(Poco::UInt64 value,
+                                std::size_t bytes,
+                                std::string& buffer);
+
+    static bool _read(const std::string& buffer,
+                      std::size_t& offset,
+                      std::size_t depth,
+                      Json::Value& json);
+
+    static bool _readBigEndian(const std::string& buffer,
+                               std::size_t& offset,
+                               std::size_t bytes,
+                               Poco::UInt64& value);
+
+    static bool _readString(const std::string& buffer,
+                            std::size_t& offset,
+                            Poco::UInt64 size,
+                            Json::Value& json);
+
+    static bool _readArray(const std::string& buffer,
+                           std::size_t& offset,
+                           std::size_t depth,
+                           Poco::UInt64 size,
+                           Json::Value& json);
+
+    static bool _readMap(const std::string& buffer,
+                         std::size_t& offset,
+                         std::size_t depth,
+                         Poco::UInt64 size,
+                         Json::Value& json);
+
+};
+
+
+} } // namespace of::Sketch
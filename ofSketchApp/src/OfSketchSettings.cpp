@@ -60,41 +60,49 @@ OfSketchSettings::OfSketchSettings():
 
 bool OfSketchSettings::load(const std::string& path)
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data.open(path);
 }
 
     
 bool OfSketchSettings::save()
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data.save(_path, true);
 }
 
 
 void OfSketchSettings::update(const ofxJSONElement& data)
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     _data = data;
 }
 
 
-const Json::Value& OfSketchSettings::getData() const
+Json::Value OfSketchSettings::getData() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data;
 }
 
 
 int OfSketchSettings::getPort() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data["server"]["port"].asInt();
 }
 
 
 int OfSketchSettings::getBufferSize() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data["server"]["bufferSize"].asInt();
 }
 
 bool OfSketchSettings::getAllowRemote() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
     if (_data.isMember("allowRemote")) {
         return _data["allowRemote"].asBool();
     } else return false;
@@ -102,53 +110,99 @@ bool OfSketchSettings::getAllowRemote() const
 
 std::string OfSketchSettings::getProjectDir() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return ofToDataPath(_data["projectDir"].asString());
 }
 
 
 std::string OfSketchSettings::getSketchDir() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data["sketchDir"].asString();
 }
 
 std::string OfSketchSettings::getAddonsDir() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data["addonsDir"].asString();
 }
 
 
+std::string OfSketchSettings::getHistoryDir() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_data.isMember("historyDir"))
+    {
+        return ofToDataPath(_data["historyDir"].asString(), true);
+    }
+    else return ofToDataPath("History", true);
+}
+
+
+std::string OfSketchSettings::getIndexDir() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_data.isMember("indexDir"))
+    {
+        return ofToDataPath(_data["indexDir"].asString(), true);
+    }
+    else return ofToDataPath("Index", true);
+}
+
+
+std::string OfSketchSettings::getCacheDir() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_data.isMember("cacheDir"))
+    {
+        return ofToDataPath(_data["cacheDir"].asString(), true);
+    }
+    else return ofToDataPath("Cache", true);
+}
+
+
 std::string OfSketchSettings::getOpenFrameworksDir() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return ofToDataPath(_data["openFrameworksDir"].asString());
 }
 
 
 std::string OfSketchSettings::getOpenFrameworksVersion() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data["openFrameworksVersion"].asString();
 }
 
 
 std::string OfSketchSettings::getProjectSettingsFilename() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data["projectSettingsFilename"].asString();
 }
 
 
 std::string OfSketchSettings::getProjectExtension() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data["projectExtension"].asString();
 }
 
 
 std::string OfSketchSettings::getClassExtension() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _data["classExtension"].asString();
 }
 
 
 std::vector<std::string> OfSketchSettings::getWhitelistedIPs() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
     std::vector<std::string> IPs;
 
     if (_data.isMember("whitelistedIPs"))
@@ -162,4 +216,92 @@ std::vector<std::string> OfSketchSettings::getWhitelistedIPs() const
 }
 
 
+FileTransaction::Durability OfSketchSettings::getStorageDurability() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return FileTransaction::fromString(_data["storage"]["durability"].asString());
+}
+
+
+std::map<std::string, BuildProfile> OfSketchSettings::getBuildProfiles() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<std::string, BuildProfile> profiles = BuildProfile::getDefaults();
+
+    const Json::Value& buildProfiles = _data["buildProfiles"];
+
+    if (buildProfiles.isObject())
+    {
+        std::vector<std::string> names = buildProfiles.getMemberNames();
+
+        for (std::size_t i = 0; i < names.size(); ++i)
+        {
+            BuildProfile defaults = profiles.count(names[i]) ? profiles[names[i]] : BuildProfile();
+            profiles[names[i]] = BuildProfile::fromJson(names[i], buildProfiles[names[i]], defaults);
+        }
+    }
+
+    return profiles;
+}
+
+
+BuildWorkerPool::Settings OfSketchSettings::getBuildWorkers() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return BuildWorkerPool::Settings::fromJson(_data["buildWorkers"]);
+}
+
+
+TopicRouter::Settings OfSketchSettings::getSendQueue() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return TopicRouter::Settings::fromJson(_data["server"]["sendQueue"]);
+}
+
+
+AdmissionRoute::Settings OfSketchSettings::getAdmission() const
+{
+    AdmissionRoute::Settings settings;
+
+    // The getters below take the lock themselves.
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        settings = AdmissionRoute::Settings::fromJson(_data["server"]["admission"]);
+    }
+
+    settings.allowRemote = getAllowRemote();
+    settings.whitelistedIPs = getWhitelistedIPs();
+    return settings;
+}
+
+
+std::map<std::string, Toolchain> OfSketchSettings::getToolchains() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<std::string, Toolchain> toolchains;
+
+    Toolchain native;
+    toolchains[native.name] = native;
+
+    const Json::Value& json = _data["toolchains"];
+
+    if (json.isObject())
+    {
+        std::vector<std::string> names = json.getMemberNames();
+
+        for (std::size_t i = 0; i < names.size(); ++i)
+        {
+            if (names[i] != Toolchain::NATIVE)
+            {
+                toolchains[names[i]] = Toolchain::fromJson(names[i], json[names[i]]);
+            }
+        }
+    }
+
+    return toolchains;
+}
+
+
 } } // namespace of::Sketch
@@ -26,11 +26,19 @@
 #pragma once
 
 
+#include <map>
 #include <string>
 #include <json/json.h>
 #include "Poco/Environment.h"
+#include "Poco/Mutex.h"
 #include "ofUtils.h"
 #include "ofxJSONElement.h"
+#include "AdmissionRoute.h"
+#include "BuildProfile.h"
+#include "BuildWorkerPool.h"
+#include "FileTransaction.h"
+#include "Toolchain.h"
+#include "TopicRouter.h"
 
 
 namespace of {
@@ -47,7 +55,8 @@ public:
 
     void update(const ofxJSONElement& data);
 
-    const Json::Value& getData() const;
+    /// \brief A copy, since the settings may be saved meanwhile.
+    Json::Value getData() const;
 
     int getPort() const;
     int getBufferSize() const;
@@ -57,10 +66,30 @@ public:
     std::string getOpenFrameworksDir() const;
     std::string getOpenFrameworksVersion() const;
     std::string getAddonsDir() const;
+    std::string getHistoryDir() const;
+    std::string getIndexDir() const;
+    std::string getCacheDir() const;
     std::string getProjectSettingsFilename() const;
     std::string getProjectExtension() const;
     std::string getClassExtension() const;
     std::vector<std::string> getWhitelistedIPs() const;
+    FileTransaction::Durability getStorageDurability() const;
+
+    /// \brief The default build profiles, with any changes from the
+    ///        settings file applied.
+    std::map<std::string, BuildProfile> getBuildProfiles() const;
+
+    /// \brief The distcc workers that builds can be offloaded to.
+    BuildWorkerPool::Settings getBuildWorkers() const;
+
+    /// \brief The cross compilers, including the native one.
+    std::map<std::string, Toolchain> getToolchains() const;
+
+    /// \brief How far a websocket connection may fall behind.
+    TopicRouter::Settings getSendQueue() const;
+
+    /// \brief Which hosts may connect, and how often.
+    AdmissionRoute::Settings getAdmission() const;
 
 private:
     std::string _templateSettingsFilePath;
@@ -68,6 +97,9 @@ private:
 
     ofxJSONElement _data; //ofxJSONElement for load functionality
 
+    /// \brief Read by calls running in parallel with a save.
+    mutable Poco::FastMutex _mutex;
+
 };
 
 
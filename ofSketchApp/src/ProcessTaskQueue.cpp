@@ -30,6 +30,90 @@ namespace of {
 namespace Sketch {
 
 
+TaskMessage::TaskMessage(const std::string& method,
+                         const std::string& name,
+                         const Poco::UUID& uuid):
+    _method(method),
+    _name(name),
+    _uuid(uuid.toString()),
+    _hasProgress(false),
+    _progress(0),
+    _message(0),
+    _exception(0),
+    _compileError(0)
+{
+}
+
+
+void TaskMessage::setProgress(float progress)
+{
+    _hasProgress = true;
+    _progress = progress;
+}
+
+
+void TaskMessage::setMessage(const std::string& message)
+{
+    _message = &message;
+}
+
+
+void TaskMessage::setException(const std::string& exception)
+{
+    _exception = &exception;
+}
+
+
+void TaskMessage::setCompileError(const Json::Value& compileError)
+{
+    _compileError = &compileError;
+}
+
+
+void TaskMessage::write(ValueWriter& writer) const
+{
+    Utils::beginJSONMethod(writer, "TaskQueue", _method);
+
+    writer.beginObject(2
+                       + (_hasProgress ? 1 : 0)
+                       + (_message ? 1 : 0)
+                       + (_exception ? 1 : 0)
+                       + (_compileError ? 1 : 0));
+
+    writer.key("name");
+    writer.value(_name);
+    writer.key("uuid");
+    writer.value(_uuid);
+
+    if (_hasProgress)
+    {
+        writer.key("progress");
+        writer.value(_progress);
+    }
+
+    if (_message)
+    {
+        writer.key("message");
+        writer.value(*_message);
+    }
+
+    if (_exception)
+    {
+        writer.key("exception");
+        writer.value(*_exception);
+    }
+
+    if (_compileError)
+    {
+        writer.key("compileError");
+        writer.value(*_compileError);
+    }
+
+    writer.endObject();
+    writer.endObject();
+}
+
+
 ProcessTaskQueue::ProcessTaskQueue(int maximumTasks,
                                    Poco::ThreadPool& threadPool):
     ofx::TaskQueue_<std::string>(maximumTasks, threadPool)
@@ -158,24 +242,24 @@ bool ProcessTaskQueue::onTaskData(const ofx::TaskDataEventArgs<std::string>& arg
 }
 
 
-Json::Value ProcessTaskQueue::toJson() const
+void ProcessTaskQueue::write(ValueWriter& writer) const
 {
     /// TODO: This method may need to be syncrhonized (which means that
     /// all of our ProcessTaskQueue may need to be synchronized depending on
     /// how our websocket route is synchronized.
 
-    Json::Value json;
+    writer.beginArray(tasks.size());
 
     std::map<Poco::UUID, TaskProgress>::const_iterator iter = tasks.begin();
 
     while (iter != tasks.end())
     {
         // Add each of the current tasks to the json array.
-        json.append(iter->second.toJson());
+        iter->second.write(writer);
         ++iter;
     }
 
-    return json;
+    writer.endArray();
 }
 
 
@@ -30,6 +30,7 @@
 #include <vector>
 #include <json/json.h>
 #include "ofx/TaskQueue.h"
+#include "Utils.h"
 
 
 namespace of {
@@ -43,16 +44,18 @@ public:
     {
     }
 
-    Json::Value toJson() const
+    void write(ValueWriter& writer) const
     {
-        Json::Value progressJson;
-
-        progressJson["name"] = name;
-        progressJson["uuid"] = uuid.toString();
-        progressJson["progress"] = progress;
-        progressJson["message"] = message;
-
-        return progressJson;
+        writer.beginObject(4);
+        writer.key("name");
+        writer.value(name);
+        writer.key("uuid");
+        writer.value(uuid.toString());
+        writer.key("progress");
+        writer.value(progress);
+        writer.key("message");
+        writer.value(message);
+        writer.endObject();
     }
 
     std::string name;
@@ -63,6 +66,39 @@ public:
 };
 
 
+/// \brief A message about one task, which holds its values by reference.
+class TaskMessage: public WritableValue
+{
+public:
+    TaskMessage(const std::string& method,
+                const std::string& name,
+                const Poco::UUID& uuid);
+
+    void setProgress(float progress);
+
+    void setMessage(const std::string& message);
+
+    void setException(const std::string& exception);
+
+    void setCompileError(const Json::Value& compileError);
+
+    void write(ValueWriter& writer) const;
+
+private:
+    std::string _method;
+    std::string _name;
+    std::string _uuid;
+
+    bool _hasProgress;
+    float _progress;
+
+    const std::string* _message;
+    const std::string* _exception;
+    const Json::Value* _compileError;
+
+};
+
+
 class ProcessTaskQueue: public ofx::TaskQueue_<std::string>
 {
 public:
@@ -78,7 +114,8 @@ public:
     bool onTaskProgress(const ofx::TaskProgressEventArgs& args);
     bool onTaskData(const ofx::TaskDataEventArgs<std::string>& args);
 
-    Json::Value toJson() const;
+    /// \brief Write the tasks that are queued or running, as an array.
+    void write(ValueWriter& writer) const;
 
 protected:
     virtual void handleUserNotification(Poco::AutoPtr<Poco::TaskNotification> task,
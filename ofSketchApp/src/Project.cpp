@@ -25,7 +25,9 @@
 
 
 #include "Project.h"
+#include "FileCloner.h"
 #include "ofUtils.h"
+#include "Utils.h"
 
 
 namespace of {
@@ -33,6 +35,7 @@ namespace Sketch {
 
 
 const std::string Project::SKETCH_FILE_EXTENSION = "sketch";
+const std::string Project::BUILD_OPTIONS_FILE = "ofSketch.json";
 
 
 Project::~Project()
@@ -40,7 +43,10 @@ Project::~Project()
 }
 
 
-Project::Project(const std::string& path): _path(path), _isLoaded(false)
+Project::Project(const std::string& path, FileTransaction::Durability durability):
+    _path(path),
+    _isLoaded(false),
+    _durability(durability)
 {
     // this is not efficient at all! I am just keeping these FileTemplate loads in the project
     // constructor because it makes the most sense architecure wise.
@@ -84,6 +90,7 @@ void Project::load(const std::string& path, const std::string& name)
         }
 
         _loadAddons();
+        _loadBuildOptions();
         _isLoaded = true;
     }
 }
@@ -95,7 +102,7 @@ bool Project::isLoaded() const
 }
 
 
-void Project::save(const Json::Value& data)
+bool Project::save(const Json::Value& data)
 {
     // This method saves differences only
     // TODO: this is not working for some reason...
@@ -103,19 +110,25 @@ void Project::save(const Json::Value& data)
     {
         ofLogVerbose("Project::save") << data.toStyledString();
 
-        if (_data["projectFile"] != data["projectFile"])
+        // All changed files are committed together, and _data only changes
+        // once they are.
+        FileTransaction transaction(_durability);
+
+        Json::Value saved = _data;
+
+        if (saved["projectFile"] != data["projectFile"])
         {
-            _data["projectFile"] = data["projectFile"];
-            _saveFile(_data["projectFile"]);
+            saved["projectFile"] = data["projectFile"];
+            _saveFile(transaction, saved["projectFile"]);
         }
 
         // uses nested for loop in case classes are not in the same order
         std::vector<Json::Value> newClasses;
         std::vector<Json::Value> deletedClasses;
 
-        for (unsigned int i = 0; i < _data["classes"].size(); ++i)
+        for (unsigned int i = 0; i < saved["classes"].size(); ++i)
         {
-            Json::Value& classFile = _data["classes"][i];
+            Json::Value& classFile = saved["classes"][i];
 
             bool matchFound = false;
 
@@ -128,7 +141,7 @@ void Project::save(const Json::Value& data)
                     if (classFile != newClassFile)
                     {
                         classFile = newClassFile;
-                        _saveFile(classFile);
+                        _saveFile(transaction, classFile);
                     }
 
                     matchFound = true;
@@ -136,13 +149,113 @@ void Project::save(const Json::Value& data)
                 }
             }
 
-            if (!matchFound) _saveFile(classFile); // class is new
+            if (!matchFound) _saveFile(transaction, classFile); // class is new
         }
+
+        if (!transaction.commit())
+        {
+            ofLogError("Project::save") << "Unable to save " << getName() << " project.";
+            return false;
+        }
+
+        _data.swap(saved);
     }
     else
     {
         ofLogNotice("Project::save") << "Project data is the same. Not saving project.";
     }
+
+    return true;
+}
+
+
+bool Project::updateFiles(const std::map<std::string, std::string>& files)
+{
+    FileTransaction transaction(_durability);
+
+    Json::Value saved = _data;
+
+    std::map<std::string, std::string>::const_iterator iter = files.begin();
+
+    while (iter != files.end())
+    {
+        Json::Value* fileData = _findFile(saved, iter->first);
+
+        if (!fileData)
+        {
+            ofLogError("Project::updateFiles") << iter->first << " is not part of " << getName();
+            return false;
+        }
+
+        (*fileData)["fileContents"] = iter->second;
+        _saveFile(transaction, *fileData);
+        ++iter;
+    }
+
+    if (!transaction.commit())
+    {
+        return false;
+    }
+
+    _data.swap(saved);
+    return true;
+}
+
+
+bool Project::getFileContents(const std::string& fileName,
+                              std::string& contents) const
+{
+    if (_data["projectFile"]["fileName"] == fileName)
+    {
+        contents = _data["projectFile"]["fileContents"].asString();
+        return true;
+    }
+
+    for (unsigned int i = 0; i < getNumClasses(); ++i)
+    {
+        if (_data["classes"][i]["fileName"] == fileName)
+        {
+            contents = _data["classes"][i]["fileContents"].asString();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool Project::restore(const std::map<std::string, std::string>& files,
+                      const std::vector<std::string>& addons)
+{
+    FileTransaction transaction(_durability);
+
+    std::map<std::string, std::string>::const_iterator iter = files.begin();
+
+    while (iter != files.end())
+    {
+        transaction.write(getPath() + "/sketch/" + iter->first, iter->second);
+        ++iter;
+    }
+
+    transaction.write(getPath() + "/addons.make", ofJoinString(addons, "\n"));
+
+    if (!transaction.commit()) return false;
+
+    ofDirectory sketchDir(getPath() + "/sketch");
+    sketchDir.allowExt(SKETCH_FILE_EXTENSION);
+    sketchDir.listDir();
+
+    for (std::size_t i = 0; i < sketchDir.size(); ++i)
+    {
+        if (files.find(sketchDir.getName(i)) == files.end())
+        {
+            sketchDir.getFile(i).remove();
+        }
+    }
+
+    load(_path, getName());
+
+    return true;
 }
 
 
@@ -152,9 +265,10 @@ bool Project::create(const std::string& path)
 
     if (!project.exists()) 
     {
-        ofDirectory temp(ofToDataPath("Resources/Templates/SimpleTemplate"));
-        temp.copyTo(ofToDataPath(path));
-        return true;
+        FileCloner::Stats stats;
+        return FileCloner::cloneProject(ofToDataPath("Resources/Templates/SimpleTemplate"),
+                                        ofToDataPath(path),
+                                        stats);
     }
 
     return false;
@@ -239,10 +353,14 @@ Json::Value Project::createClass(const std::string& className)
     classFile["fileName"] = className + "." + SKETCH_FILE_EXTENSION;
     classFile["name"] = className;
     classFile["fileContents"] = fileContents;
-    _data["classes"][getNumClasses()] = classFile;
-    // TODO: re-loading is a terribly slow way to delete. Come back and optimize.
-    // Simply need to remove the Json::Value class in _data["classes"]
-    _saveFile(classFile);
+    FileTransaction transaction(_durability);
+    _saveFile(transaction, classFile);
+
+    if (transaction.commit())
+    {
+        _data["classes"][getNumClasses()] = classFile;
+    }
+
     return classFile;
 }
 
@@ -391,6 +509,53 @@ std::vector<std::string> Project::getAddons() const
     return _addons;
 }
 
+const Json::Value& Project::getBuildOptions() const
+{
+    return _buildOptions;
+}
+
+
+bool Project::setBuildOptions(const Json::Value& options)
+{
+    Json::Value buildOptions = _buildOptions;
+
+    if (options.isMember("unityBuild"))
+    {
+        buildOptions["unityBuild"] = options["unityBuild"].asBool();
+    }
+
+    FileTransaction transaction(_durability);
+
+    if (transaction.write(_path + "/" + BUILD_OPTIONS_FILE, Utils::toJSONString(buildOptions))
+     && transaction.commit())
+    {
+        _buildOptions = buildOptions;
+        return true;
+    }
+
+    return false;
+}
+
+
+bool Project::isUnityBuild() const
+{
+    return _buildOptions["unityBuild"].asBool();
+}
+
+
+void Project::_loadBuildOptions()
+{
+    _buildOptions = Json::Value(Json::objectValue);
+
+    ofFile buildOptionsFile(_path + "/" + BUILD_OPTIONS_FILE);
+
+    if (buildOptionsFile.exists())
+    {
+        Utils::JSONfromFile(buildOptionsFile.getAbsolutePath(), _buildOptions);
+    }
+}
+
+
 void Project::_loadAddons()
 {
     _addons.clear();
@@ -412,14 +577,36 @@ void Project::_loadAddons()
 
 void Project::_saveAddons()
 {
-    ofBuffer buffer(ofJoinString(_addons, "\n"));
-    ofBufferToFile(_path + "/addons.make", buffer);
+    FileTransaction transaction(_durability);
+
+    if (transaction.write(_path + "/addons.make", ofJoinString(_addons, "\n")))
+    {
+        transaction.commit();
+    }
 }
 
-void Project::_saveFile(const Json::Value& fileData)
+bool Project::_saveFile(FileTransaction& transaction, const Json::Value& fileData)
 {
-    ofBuffer fileBuffer(fileData["fileContents"].asString());
-    ofBufferToFile(getPath() + "/sketch/" + fileData["fileName"].asString(), fileBuffer);
+    return transaction.write(getPath() + "/sketch/" + fileData["fileName"].asString(),
+                             fileData["fileContents"].asString());
+}
+
+Json::Value* Project::_findFile(Json::Value& data, const std::string& fileName)
+{
+    if (data["projectFile"]["fileName"] == fileName)
+    {
+        return &data["projectFile"];
+    }
+
+    for (unsigned int i = 0; i < data["classes"].size(); ++i)
+    {
+        if (data["classes"][i]["fileName"] == fileName)
+        {
+            return &data["classes"][i];
+        }
+    }
+
+    return 0;
 }
 
 } } // namespace of::Sketch
@@ -27,12 +27,14 @@
 #pragma once
 
 
+#include <map>
 #include <string>
 #include <json/json.h>
 #include "Poco/URI.h"
 #include "ofTypes.h"
 #include "ofFileUtils.h"
 #include "Poco/RegularExpression.h"
+#include "FileTransaction.h"
 
 
 namespace of {
@@ -45,7 +47,8 @@ public:
     typedef std::shared_ptr<Project> SharedPtr;
     typedef std::weak_ptr<Project> WeakPtr;
 
-    Project(const std::string& path);
+    Project(const std::string& path,
+            FileTransaction::Durability durability = FileTransaction::DURABILITY_NORMAL);
     ~Project();
 
     const std::string& getPath() const;
@@ -59,7 +62,18 @@ public:
     bool remove();
     bool rename(const std::string& newName);
 
-    void save(const Json::Value& data);
+    bool save(const Json::Value& data);
+
+    /// \returns false if a file is unknown or could not be written.
+    bool updateFiles(const std::map<std::string, std::string>& files);
+
+    bool getFileContents(const std::string& fileName,
+                         std::string& contents) const;
+
+    /// \brief Replace all sketch files and addons, e.g. with an earlier
+    ///        version.  Sketch files not in files are removed.
+    bool restore(const std::map<std::string, std::string>& files,
+                 const std::vector<std::string>& addons);
     void load(const std::string& path,
               const std::string& name);
 
@@ -80,8 +94,21 @@ public:
 
     const Json::Value& getData() const;
 
+    /// \brief Options that change how the project is built.
+    const Json::Value& getBuildOptions() const;
+
+    /// \brief Merge options into the build options and save them.
+    bool setBuildOptions(const Json::Value& options);
+
+    /// \returns true if addon sources should be compiled as a few large
+    ///        translation units.
+    bool isUnityBuild() const;
+
     static const std::string SKETCH_FILE_EXTENSION;
 
+    /// \brief The file in the project folder holding its build options.
+    static const std::string BUILD_OPTIONS_FILE;
+
 private:
     std::string _path;
     std::string _classFileTemplate;
@@ -90,9 +117,16 @@ private:
 
     bool _isLoaded;
     Json::Value _data;
+    Json::Value _buildOptions;
+
+    /// \brief Project files are only written through FileTransaction, so
+    ///        the files a clone hard links to are replaced, never modified.
+    FileTransaction::Durability _durability;
 
-    void _saveFile(const Json::Value& fileData);
+    bool _saveFile(FileTransaction& transaction, const Json::Value& fileData);
+    static Json::Value* _findFile(Json::Value& data, const std::string& fileName);
     void _loadAddons();
+    void _loadBuildOptions();
     void _saveAddons();
 
 };
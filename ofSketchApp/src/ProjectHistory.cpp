@@ -0,0 +1,460 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "ProjectHistory.h"
+#include "Poco/File.h"
+#include "Poco/NumberParser.h"
+#include "ofFileUtils.h"
+#include "ofLog.h"
+#include "ofUtils.h"
+#include "Utils.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+ProjectHistory::ProjectHistory(const std::string& path,
+                               FileTransaction::Durability durability):
+    _path(path),
+    _durability(durability),
+    _blobs(path + "/objects")
+{
+    Poco::File(_path + "/projects").createDirectories();
+}
+
+
+ProjectHistory::~ProjectHistory()
+{
+}
+
+
+bool ProjectHistory::snapshot(const Project& project)
+{
+    const Json::Value& data = project.getData();
+
+    FileTransaction transaction(_durability);
+    std::set<std::string> staged;
+
+    Json::Value manifest;
+
+    manifest["projectFile"] = data["projectFile"]["fileName"];
+    manifest["files"][data["projectFile"]["fileName"].asString()] =
+        _blobs.put(data["projectFile"]["fileContents"].asString(), transaction, staged);
+
+    for (unsigned int i = 0; i < project.getNumClasses(); ++i)
+    {
+        const Json::Value& classFile = data["classes"][i];
+
+        manifest["files"][classFile["fileName"].asString()] =
+            _blobs.put(classFile["fileContents"].asString(), transaction, staged);
+    }
+
+    std::vector<std::string> addons = project.getAddons();
+
+    manifest["addons"] = Json::Value(Json::arrayValue);
+
+    for (std::size_t i = 0; i < addons.size(); ++i)
+    {
+        manifest["addons"].append(addons[i]);
+    }
+
+    std::string manifestHash = _blobs.put(Utils::toJSONString(manifest), transaction, staged);
+
+    std::vector<Version> versions;
+    _readLog(project.getName(), versions);
+
+    if (!versions.empty() && versions.back().manifest == manifestHash)
+    {
+        // Nothing changed since the last version.
+        return true;
+    }
+
+    // The blobs must be durable before the log refers to them.
+    if (!transaction.commit())
+    {
+        ofLogError("ProjectHistory::snapshot") << "Unable to store snapshot of " << project.getName();
+        return false;
+    }
+
+    std::stringstream line;
+    line << Poco::Timestamp().epochMicroseconds() << " " << manifestHash << "\n";
+
+    return FileTransaction::append(_getLogPath(project.getName()), line.str(), _durability);
+}
+
+
+Json::Value ProjectHistory::getVersions(const std::string& projectName) const
+{
+    Json::Value json(Json::arrayValue);
+
+    std::vector<Version> versions;
+    _readLog(projectName, versions);
+
+    for (std::size_t i = 0; i < versions.size(); ++i)
+    {
+        Json::Value version;
+        version["version"] = Json::UInt64(i);
+        version["timestamp"] = Json::Int64(versions[i].timestamp / 1000); // ms
+        version["id"] = versions[i].manifest;
+        json.append(version);
+    }
+
+    return json;
+}
+
+
+bool ProjectHistory::getVersion(const std::string& projectName,
+                                std::size_t version,
+                                Files& files,
+                                std::vector<std::string>& addons) const
+{
+    std::vector<Version> versions;
+    _readLog(projectName, versions);
+
+    if (version >= versions.size()) return false;
+
+    std::string manifestJson;
+    Json::Value manifest;
+
+    if (!_blobs.get(versions[version].manifest, manifestJson)
+     || !Utils::JSONfromString(manifestJson, manifest))
+    {
+        ofLogError("ProjectHistory::getVersion") << "Missing manifest for version " << version << " of " << projectName;
+        return false;
+    }
+
+    files.clear();
+    addons.clear();
+
+    std::vector<std::string> fileNames = manifest["files"].getMemberNames();
+
+    for (std::size_t i = 0; i < fileNames.size(); ++i)
+    {
+        if (!_blobs.get(manifest["files"][fileNames[i]].asString(), files[fileNames[i]]))
+        {
+            ofLogError("ProjectHistory::getVersion") << "Missing " << fileNames[i] << " for version " << version << " of " << projectName;
+            return false;
+        }
+    }
+
+    // Versions saved before a rename refer to the old project file.
+    std::string projectFile = manifest["projectFile"].asString();
+    std::string currentProjectFile = projectName + "." + Project::SKETCH_FILE_EXTENSION;
+
+    if (projectFile != currentProjectFile && files.find(projectFile) != files.end())
+    {
+        files[currentProjectFile].swap(files[projectFile]);
+        files.erase(projectFile);
+    }
+
+    for (Json::ArrayIndex i = 0; i < manifest["addons"].size(); ++i)
+    {
+        addons.push_back(manifest["addons"][i].asString());
+    }
+
+    return true;
+}
+
+
+bool ProjectHistory::rename(const std::string& projectName,
+                            const std::string& newProjectName)
+{
+    Poco::File log(_getLogPath(projectName));
+
+    if (!log.exists()) return true;
+
+    try
+    {
+        log.renameTo(_getLogPath(newProjectName));
+        return true;
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogError("ProjectHistory::rename") << exc.displayText();
+        return false;
+    }
+}
+
+
+bool ProjectHistory::remove(const std::string& projectName)
+{
+    Poco::File log(_getLogPath(projectName));
+
+    if (!log.exists()) return true;
+
+    try
+    {
+        log.remove();
+        return true;
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogError("ProjectHistory::remove") << exc.displayText();
+        return false;
+    }
+}
+
+
+Json::Value ProjectHistory::diff(const Files& from, const Files& to)
+{
+    Json::Value json(Json::objectValue);
+
+    Files::const_iterator fromIter = from.begin();
+
+    while (fromIter != from.end())
+    {
+        Files::const_iterator toIter = to.find(fromIter->first);
+
+        if (toIter == to.end())
+        {
+            json[fromIter->first]["status"] = "removed";
+        }
+        else if (toIter->second != fromIter->second)
+        {
+            json[fromIter->first]["status"] = "modified";
+            json[fromIter->first]["edits"] = diffLines(fromIter->second, toIter->second);
+        }
+
+        ++fromIter;
+    }
+
+    Files::const_iterator toIter = to.begin();
+
+    while (toIter != to.end())
+    {
+        if (from.find(toIter->first) == from.end())
+        {
+            json[toIter->first]["status"] = "added";
+        }
+
+        ++toIter;
+    }
+
+    return json;
+}
+
+
+namespace {
+
+
+void appendHunk(Json::Value& edits, const std::string& op, const std::string& line)
+{
+    Json::ArrayIndex size = edits.size();
+
+    if (size > 0 && edits[size - 1]["op"] == op)
+    {
+        if (op == "=")
+        {
+            edits[size - 1]["count"] = edits[size - 1]["count"].asUInt() + 1;
+        }
+        else
+        {
+            edits[size - 1]["lines"].append(line);
+        }
+    }
+    else
+    {
+        Json::Value hunk;
+        hunk["op"] = op;
+
+        if (op == "=")
+        {
+            hunk["count"] = 1;
+        }
+        else
+        {
+            hunk["lines"].append(line);
+        }
+
+        edits.append(hunk);
+    }
+}
+
+
+}
+
+
+Json::Value ProjectHistory::diffLines(const std::string& from, const std::string& to)
+{
+    std::vector<std::string> a = ofSplitString(from, "\n");
+    std::vector<std::string> b = ofSplitString(to, "\n");
+
+    int n = a.size();
+    int m = b.size();
+
+    // Myers' O(ND) algorithm.  Only the live diagonals of each round are
+    // kept, so memory grows with the square of the number of edits.
+    std::vector<std::vector<int> > trace;
+    std::vector<int> v(2 * (n + m) + 3, 0);
+    int offset = n + m + 1;
+    int editCount = -1;
+
+    for (int d = 0; d <= n + m && d <= MAXIMUM_DIFF_EDITS; ++d)
+    {
+        trace.push_back(std::vector<int>(v.begin() + offset - d, v.begin() + offset + d + 1));
+
+        for (int k = -d; k <= d; k += 2)
+        {
+            int x = 0;
+
+            if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+            {
+                x = v[offset + k + 1];
+            }
+            else
+            {
+                x = v[offset + k - 1] + 1;
+            }
+
+            int y = x - k;
+
+            while (x < n && y < m && a[x] == b[y])
+            {
+                ++x;
+                ++y;
+            }
+
+            v[offset + k] = x;
+
+            if (x >= n && y >= m)
+            {
+                editCount = d;
+                break;
+            }
+        }
+
+        if (editCount >= 0) break;
+    }
+
+    Json::Value edits(Json::arrayValue);
+
+    if (editCount < 0)
+    {
+        // Too many changes to be worth a line by line comparison.
+        for (int i = 0; i < n; ++i) appendHunk(edits, "-", a[i]);
+        for (int i = 0; i < m; ++i) appendHunk(edits, "+", b[i]);
+        return edits;
+    }
+
+    // Walk back through the trace, collecting the edits in reverse.
+    std::vector<std::pair<std::string, std::string> > reversed;
+
+    int x = n;
+    int y = m;
+
+    for (int d = editCount; d >= 0; --d)
+    {
+        const std::vector<int>& round = trace[d];
+        int k = x - y;
+
+        // round holds the diagonals -d through d of the previous round.
+        int previousK = 0;
+
+        if (k == -d || (k != d && round[k - 1 + d] < round[k + 1 + d]))
+        {
+            previousK = k + 1;
+        }
+        else
+        {
+            previousK = k - 1;
+        }
+
+        int previousX = (d == 0) ? 0 : round[previousK + d];
+        int previousY = previousX - previousK;
+
+        while (x > previousX && y > previousY)
+        {
+            reversed.push_back(std::make_pair("=", a[x - 1]));
+            --x;
+            --y;
+        }
+
+        if (d > 0)
+        {
+            if (x == previousX)
+            {
+                reversed.push_back(std::make_pair("+", b[y - 1]));
+            }
+            else
+            {
+                reversed.push_back(std::make_pair("-", a[x - 1]));
+            }
+        }
+
+        x = previousX;
+        y = previousY;
+    }
+
+    std::vector<std::pair<std::string, std::string> >::reverse_iterator iter = reversed.rbegin();
+
+    while (iter != reversed.rend())
+    {
+        appendHunk(edits, iter->first, iter->second);
+        ++iter;
+    }
+
+    return edits;
+}
+
+
+bool ProjectHistory::_readLog(const std::string& projectName,
+                              std::vector<Version>& versions) const
+{
+    versions.clear();
+
+    ofFile log(_getLogPath(projectName));
+
+    if (!log.exists()) return false;
+
+    std::vector<std::string> lines = ofSplitString(ofBufferFromFile(log.path()).getText(), "\n");
+
+    for (std::size_t i = 0; i < lines.size(); ++i)
+    {
+        std::vector<std::string> fields = ofSplitString(lines[i], " ");
+
+        Version version;
+
+        // A partial trailing line is left by an interrupted append.
+        if (fields.size() == 2
+         && fields[1].size() == 40
+         && Poco::NumberParser::tryParse64(fields[0], version.timestamp))
+        {
+            version.manifest = fields[1];
+            versions.push_back(version);
+        }
+    }
+
+    return true;
+}
+
+
+std::string ProjectHistory::_getLogPath(const std::string& projectName) const
+{
+    return _path + "/projects/" + projectName + ".log";
+}
+
+
+} } // namespace of::Sketch
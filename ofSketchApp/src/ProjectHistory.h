@@ -0,0 +1,99 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <json/json.h>
+#include "Poco/Timestamp.h"
+#include "BlobStore.h"
+#include "FileTransaction.h"
+#include "Project.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Snapshots of each saved project, kept in a shared BlobStore.
+class ProjectHistory
+{
+public:
+    typedef std::map<std::string, std::string> Files;
+
+    ProjectHistory(const std::string& path,
+                   FileTransaction::Durability durability = FileTransaction::DURABILITY_NORMAL);
+
+    virtual ~ProjectHistory();
+
+    /// \brief Record the project, unless it matches its latest version.
+    bool snapshot(const Project& project);
+
+    /// \returns the versions, oldest first.
+    Json::Value getVersions(const std::string& projectName) const;
+
+    bool getVersion(const std::string& projectName,
+                    std::size_t version,
+                    Files& files,
+                    std::vector<std::string>& addons) const;
+
+    bool rename(const std::string& projectName, const std::string& newProjectName);
+
+    bool remove(const std::string& projectName);
+
+    /// \returns the added, removed and modified files, by file name.
+    static Json::Value diff(const Files& from, const Files& to);
+
+    /// \returns a list of "=", "-" and "+" hunks that turn from into to.
+    static Json::Value diffLines(const std::string& from, const std::string& to);
+
+    enum
+    {
+        /// \brief Files that differ by more lines are shown as replaced.
+        MAXIMUM_DIFF_EDITS = 2000
+    };
+
+private:
+    struct Version
+    {
+        Poco::Timestamp::TimeVal timestamp;
+        std::string manifest;
+    };
+
+    std::string _path;
+    FileTransaction::Durability _durability;
+    BlobStore _blobs;
+
+    bool _readLog(const std::string& projectName, std::vector<Version>& versions) const;
+
+    std::string _getLogPath(const std::string& projectName) const;
+
+};
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,506 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "ProjectIndex.h"
+#include <algorithm>
+#include "Poco/File.h"
+#include "Poco/String.h"
+#include "ofFileUtils.h"
+#include "ofLog.h"
+#include "Utils.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+namespace {
+
+
+bool compareNames(const ProjectIndex::Summary* a, const ProjectIndex::Summary* b)
+{
+    return Poco::icompare(a->projectName, b->projectName) < 0;
+}
+
+
+bool compareLastModified(const ProjectIndex::Summary* a, const ProjectIndex::Summary* b)
+{
+    return a->lastModified < b->lastModified;
+}
+
+
+}
+
+
+ProjectIndex::Summary::Summary():
+    classCount(0),
+    lastModified(0),
+    buildStatus(BUILD_NONE),
+    lastBuild(0)
+{
+}
+
+
+Json::Value ProjectIndex::Summary::toJson() const
+{
+    Json::Value json;
+
+    json["projectName"] = projectName;
+    json["classCount"] = Json::UInt64(classCount);
+    json["addons"] = Json::Value(Json::arrayValue);
+
+    for (std::size_t i = 0; i < addons.size(); ++i)
+    {
+        json["addons"].append(addons[i]);
+    }
+
+    // Milliseconds, like the rest of the client facing timestamps.
+    json["lastModified"] = Json::Int64(lastModified / 1000);
+    json["buildStatus"] = toString(buildStatus);
+    json["lastBuild"] = Json::Int64(lastBuild / 1000);
+
+    return json;
+}
+
+
+ProjectIndex::Summary ProjectIndex::Summary::fromJson(const Json::Value& json)
+{
+    Summary summary;
+
+    summary.projectName = json["projectName"].asString();
+    summary.classCount = json["classCount"].asUInt();
+
+    for (unsigned int i = 0; i < json["addons"].size(); ++i)
+    {
+        summary.addons.push_back(json["addons"][i].asString());
+    }
+
+    summary.lastModified = Poco::Timestamp::TimeVal(json["lastModified"].asInt64()) * 1000;
+    summary.buildStatus = fromString(json["buildStatus"].asString());
+    summary.lastBuild = Poco::Timestamp::TimeVal(json["lastBuild"].asInt64()) * 1000;
+
+    // A build that was running when the app quit never finished.
+    if (summary.buildStatus == BUILD_RUNNING)
+    {
+        summary.buildStatus = BUILD_CANCELLED;
+    }
+
+    return summary;
+}
+
+
+ProjectIndex::ProjectIndex(const std::string& path,
+                           FileTransaction::Durability durability):
+    _path(path),
+    _durability(durability),
+    _isDirty(false)
+{
+    _load();
+}
+
+
+ProjectIndex::~ProjectIndex()
+{
+}
+
+
+void ProjectIndex::reset(const std::vector<Project::SharedPtr>& projects)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Summaries summaries;
+
+    for (std::size_t i = 0; i < projects.size(); ++i)
+    {
+        std::string projectName = projects[i]->getName();
+
+        Summaries::const_iterator iter = _summaries.find(projectName);
+
+        Summary previous = (iter != _summaries.end()) ? iter->second : Summary();
+
+        summaries[projectName] = _summarize(*projects[i], previous);
+    }
+
+    _summaries.swap(summaries);
+    _isDirty = true;
+}
+
+
+void ProjectIndex::update(const Project& project)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::string projectName = project.getName();
+
+    _summaries[projectName] = _summarize(project, _summaries[projectName]);
+    _isDirty = true;
+}
+
+
+void ProjectIndex::remove(const std::string& projectName)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_summaries.erase(projectName) > 0)
+    {
+        _isDirty = true;
+    }
+}
+
+
+void ProjectIndex::rename(const std::string& projectName,
+                          const std::string& newProjectName)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Summaries::iterator iter = _summaries.find(projectName);
+
+    if (iter != _summaries.end())
+    {
+        Summary summary = iter->second;
+        summary.projectName = newProjectName;
+        // The old executable is removed on rename.
+        summary.buildStatus = BUILD_NONE;
+        _summaries.erase(iter);
+        _summaries[newProjectName] = summary;
+        _isDirty = true;
+    }
+
+    Builds::iterator buildIter = _builds.begin();
+
+    for (; buildIter != _builds.end(); ++buildIter)
+    {
+        if (buildIter->second.projectName == projectName)
+        {
+            buildIter->second.projectName = newProjectName;
+        }
+    }
+}
+
+
+void ProjectIndex::buildStarted(const std::string& projectName,
+                                const Poco::UUID& taskId)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Build build;
+    build.projectName = projectName;
+    build.hasErrors = false;
+
+    _builds[taskId] = build;
+
+    Summaries::iterator iter = _summaries.find(projectName);
+
+    if (iter != _summaries.end())
+    {
+        iter->second.buildStatus = BUILD_RUNNING;
+        iter->second.lastBuild = Poco::Timestamp().epochMicroseconds();
+        _isDirty = true;
+    }
+}
+
+
+void ProjectIndex::buildError(const Poco::UUID& taskId)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Builds::iterator buildIter = _builds.find(taskId);
+
+    if (buildIter != _builds.end())
+    {
+        buildIter->second.hasErrors = true;
+    }
+}
+
+
+void ProjectIndex::buildRestarted(const Poco::UUID& taskId)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Builds::iterator buildIter = _builds.find(taskId);
+
+    if (buildIter != _builds.end())
+    {
+        buildIter->second.hasErrors = false;
+    }
+}
+
+
+void ProjectIndex::buildFinished(const Poco::UUID& taskId, BuildStatus status)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Builds::iterator buildIter = _builds.find(taskId);
+
+    if (buildIter == _builds.end())
+    {
+        return;
+    }
+
+    // make finishes as a task whether or not the build succeeded.
+    if (status == BUILD_SUCCEEDED && buildIter->second.hasErrors)
+    {
+        status = BUILD_FAILED;
+    }
+
+    Summaries::iterator iter = _summaries.find(buildIter->second.projectName);
+
+    if (iter != _summaries.end())
+    {
+        iter->second.buildStatus = status;
+        iter->second.lastBuild = Poco::Timestamp().epochMicroseconds();
+        _isDirty = true;
+    }
+
+    _builds.erase(buildIter);
+}
+
+
+Json::Value ProjectIndex::query(const Json::Value& query) const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::vector<const Summary*> matches;
+
+    if (query.isMember("projectNames"))
+    {
+        const Json::Value& projectNames = query["projectNames"];
+
+        for (unsigned int i = 0; i < projectNames.size(); ++i)
+        {
+            Summaries::const_iterator iter = _summaries.find(projectNames[i].asString());
+
+            if (iter != _summaries.end())
+            {
+                matches.push_back(&iter->second);
+            }
+        }
+    }
+    else
+    {
+        Summaries::const_iterator iter = _summaries.begin();
+
+        for (; iter != _summaries.end(); ++iter)
+        {
+            matches.push_back(&iter->second);
+        }
+    }
+
+    std::string name = Poco::toLower(query["name"].asString());
+    std::string addon = query["addon"].asString();
+    bool hasBuildStatus = query.isMember("buildStatus");
+    BuildStatus buildStatus = fromString(query["buildStatus"].asString());
+    Poco::Timestamp::TimeVal modifiedSince = Poco::Timestamp::TimeVal(query["modifiedSince"].asInt64()) * 1000;
+
+    std::vector<const Summary*> filtered;
+
+    for (std::size_t i = 0; i < matches.size(); ++i)
+    {
+        const Summary& summary = *matches[i];
+
+        if (!name.empty() && Poco::toLower(summary.projectName).find(name) == std::string::npos)
+            continue;
+
+        if (!addon.empty() && std::find(summary.addons.begin(), summary.addons.end(), addon) == summary.addons.end())
+            continue;
+
+        if (hasBuildStatus && summary.buildStatus != buildStatus)
+            continue;
+
+        if (summary.lastModified < modifiedSince)
+            continue;
+
+        filtered.push_back(&summary);
+    }
+
+    if (query["sortBy"].asString() == "lastModified")
+    {
+        std::stable_sort(filtered.begin(), filtered.end(), compareLastModified);
+    }
+    else if (!query.isMember("projectNames"))
+    {
+        std::stable_sort(filtered.begin(), filtered.end(), compareNames);
+    }
+
+    if (query["descending"].asBool())
+    {
+        std::reverse(filtered.begin(), filtered.end());
+    }
+
+    std::size_t offset = query["offset"].asUInt();
+    std::size_t limit = query.isMember("limit") ? query["limit"].asUInt() : std::size_t(DEFAULT_PAGE_SIZE);
+
+    limit = std::min(limit, std::size_t(MAXIMUM_PAGE_SIZE));
+
+    Json::Value result;
+
+    result["total"] = Json::UInt64(filtered.size());
+    result["offset"] = Json::UInt64(offset);
+    result["projects"] = Json::Value(Json::arrayValue);
+
+    for (std::size_t i = offset; i < filtered.size() && i < offset + limit; ++i)
+    {
+        result["projects"].append(filtered[i]->toJson());
+    }
+
+    return result;
+}
+
+
+bool ProjectIndex::save()
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (!_isDirty)
+    {
+        return true;
+    }
+
+    Json::Value json;
+
+    json["projects"] = Json::Value(Json::arrayValue);
+
+    Summaries::const_iterator iter = _summaries.begin();
+
+    for (; iter != _summaries.end(); ++iter)
+    {
+        json["projects"].append(iter->second.toJson());
+    }
+
+    FileTransaction transaction(_durability);
+
+    if (transaction.write(_path, Utils::toJSONString(json)) && transaction.commit())
+    {
+        _isDirty = false;
+        return true;
+    }
+
+    ofLogError("ProjectIndex::save") << "Unable to write " << _path;
+    return false;
+}
+
+
+std::string ProjectIndex::toString(BuildStatus status)
+{
+    switch (status)
+    {
+        case BUILD_NONE:
+            return "none";
+        case BUILD_RUNNING:
+            return "running";
+        case BUILD_SUCCEEDED:
+            return "succeeded";
+        case BUILD_FAILED:
+            return "failed";
+        case BUILD_CANCELLED:
+            return "cancelled";
+    }
+
+    return "none";
+}
+
+
+ProjectIndex::BuildStatus ProjectIndex::fromString(const std::string& status)
+{
+    if (status == "running") return BUILD_RUNNING;
+    else if (status == "succeeded") return BUILD_SUCCEEDED;
+    else if (status == "failed") return BUILD_FAILED;
+    else if (status == "cancelled") return BUILD_CANCELLED;
+    else return BUILD_NONE;
+}
+
+
+void ProjectIndex::_load()
+{
+    if (!Poco::File(_path).exists())
+    {
+        return;
+    }
+
+    Json::Value json;
+
+    if (!Utils::JSONfromFile(_path, json))
+    {
+        ofLogWarning("ProjectIndex::_load") << "Ignoring unreadable index " << _path;
+        return;
+    }
+
+    for (unsigned int i = 0; i < json["projects"].size(); ++i)
+    {
+        Summary summary = Summary::fromJson(json["projects"][i]);
+        _summaries[summary.projectName] = summary;
+    }
+}
+
+
+ProjectIndex::Summary ProjectIndex::_summarize(const Project& project,
+                                               const Summary& previous)
+{
+    Summary summary = previous;
+
+    summary.projectName = project.getName();
+    summary.classCount = project.getNumClasses();
+    summary.addons = project.getAddons();
+    summary.lastModified = 0;
+
+    std::vector<std::string> paths;
+    paths.push_back(project.getPath() + "/addons.make");
+
+    ofDirectory sketchDir(project.getPath() + "/sketch");
+
+    if (sketchDir.exists())
+    {
+        sketchDir.allowExt(Project::SKETCH_FILE_EXTENSION);
+        sketchDir.listDir();
+
+        for (std::size_t i = 0; i < sketchDir.size(); ++i)
+        {
+            paths.push_back(sketchDir.getPath(i));
+        }
+    }
+
+    for (std::size_t i = 0; i < paths.size(); ++i)
+    {
+        try
+        {
+            Poco::File file(paths[i]);
+
+            if (file.exists())
+            {
+                summary.lastModified = std::max(summary.lastModified,
+                                                file.getLastModified().epochMicroseconds());
+            }
+        }
+        catch (const Poco::Exception& exc)
+        {
+            ofLogWarning("ProjectIndex::_summarize") << exc.displayText();
+        }
+    }
+
+    return summary;
+}
+
+
+} } // namespace of::Sketch
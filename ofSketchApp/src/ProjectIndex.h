@@ -0,0 +1,136 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <json/json.h>
+#include "Poco/Mutex.h"
+#include "Poco/Timestamp.h"
+#include "Poco/UUID.h"
+#include "FileTransaction.h"
+#include "Project.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief A saved summary of every project, for listing many at once.
+class ProjectIndex
+{
+public:
+    enum BuildStatus
+    {
+        BUILD_NONE,
+        BUILD_RUNNING,
+        BUILD_SUCCEEDED,
+        BUILD_FAILED,
+        BUILD_CANCELLED
+    };
+
+    struct Summary
+    {
+        Summary();
+
+        std::string projectName;
+        std::size_t classCount;
+        std::vector<std::string> addons;
+        Poco::Timestamp::TimeVal lastModified;
+        BuildStatus buildStatus;
+        Poco::Timestamp::TimeVal lastBuild;
+
+        Json::Value toJson() const;
+        static Summary fromJson(const Json::Value& json);
+    };
+
+    ProjectIndex(const std::string& path,
+                 FileTransaction::Durability durability = FileTransaction::DURABILITY_NORMAL);
+
+    virtual ~ProjectIndex();
+
+    /// \brief Refresh the summaries, keeping their build results.
+    void reset(const std::vector<Project::SharedPtr>& projects);
+
+    void update(const Project& project);
+
+    void remove(const std::string& projectName);
+
+    void rename(const std::string& projectName, const std::string& newProjectName);
+
+    void buildStarted(const std::string& projectName, const Poco::UUID& taskId);
+
+    void buildError(const Poco::UUID& taskId);
+
+    void buildRestarted(const Poco::UUID& taskId);
+
+    void buildFinished(const Poco::UUID& taskId, BuildStatus status);
+
+    /// \returns {"total": n, "offset": o, "projects": [...]}.
+    Json::Value query(const Json::Value& query) const;
+
+    bool save();
+
+    static std::string toString(BuildStatus status);
+    static BuildStatus fromString(const std::string& status);
+
+    enum
+    {
+        DEFAULT_PAGE_SIZE = 100,
+        MAXIMUM_PAGE_SIZE = 1000
+    };
+
+private:
+    typedef std::map<std::string, Summary> Summaries;
+
+    struct Build
+    {
+        std::string projectName;
+        bool hasErrors;
+    };
+
+    typedef std::map<Poco::UUID, Build> Builds;
+
+    std::string _path;
+    FileTransaction::Durability _durability;
+
+    Summaries _summaries;
+    Builds _builds;
+
+    bool _isDirty;
+
+    mutable Poco::FastMutex _mutex;
+
+    void _load();
+
+    static Summary _summarize(const Project& project, const Summary& previous);
+
+};
+
+
+} } // namespace of::Sketch
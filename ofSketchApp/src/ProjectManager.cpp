@@ -25,15 +25,18 @@
 
 
 #include "ProjectManager.h"
+#include "FileCloner.h"
 
 
 namespace of {
 namespace Sketch {
 
 
-ProjectManager::ProjectManager(const std::string& path):
+ProjectManager::ProjectManager(const std::string& path,
+                               FileTransaction::Durability durability):
     _path(path),
-    _templateProject(ofToDataPath("Resources/Templates/NewProject", true))
+    _durability(durability),
+    _templateProject(ofToDataPath("Resources/Templates/NewProject", true), durability)
 {
     ofLogNotice("ProjectManager::ProjectManager") << "_path: " <<_path;
 
@@ -51,7 +54,7 @@ ProjectManager::ProjectManager(const std::string& path):
     while (iter != files.end())
     {
         ofLogVerbose("ProjectManager::ProjectManager") << *iter;
-        _projects.push_back(Project(*iter));
+        _projects.push_back(Project::SharedPtr(new Project(*iter, _durability)));
         ++iter;
     }
 }
@@ -62,37 +65,16 @@ ProjectManager::~ProjectManager()
 }
 
 
-// can this function be: return getProjectRef(projectName); only?
-const Project& ProjectManager::getProject(const std::string& projectName) const
+Project::SharedPtr ProjectManager::getProject(const std::string& projectName) const
 {
-    for (std::size_t i = 0; i < _projects.size(); ++i) 
-    {
-        if (_projects[i].getName() == projectName) 
-        {
-            return _projects[i];
-        }
-    }
-
-    return _projects[0]; //fallback
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return _findProject(projectName);
 }
 
 
-Project& ProjectManager::getProjectRef(const std::string& projectName)
-{
-    for (std::size_t i = 0; i < _projects.size(); ++i) 
-    {
-        if (_projects[i].getName() == projectName) 
-        {
-            return _projects[i];
-        }
-    }
-
-    return _projects[0]; //fallback
-}
-
-
-const std::vector<Project>& ProjectManager::getProjects() const
+std::vector<Project::SharedPtr> ProjectManager::getProjects() const
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     return _projects;
 }
 
@@ -116,13 +98,22 @@ const std::vector<Project>& ProjectManager::getProjects() const
 void ProjectManager::getProjectList(const void* pSender,
                                     ofx::JSONRPC::MethodArgs& args)
 {
-    Json::Value projectList;
+    // Size the list once, and hand it to the response without copying
+    // it.  The dispatcher writes it out directly.
+    Json::Value projectList(Json::arrayValue);
+
+    {
+        // The names are read under the lock that renames are made with.
+        Poco::FastMutex::ScopedLock lock(_mutex);
+
+        projectList.resize(_projects.size());
 
-    for (unsigned int i = 0; i < _projects.size(); ++i) {
-        projectList[i]["projectName"] = _projects[i].getName();
+        for (unsigned int i = 0; i < _projects.size(); ++i) {
+            projectList[i]["projectName"] = _projects[i]->getName();
+        }
     }
 
-    args.result = projectList;
+    args.result.swap(projectList);
     ofLogNotice("Project::getProjectList") << "Project list requested";
 }
 
@@ -134,32 +125,25 @@ void ProjectManager::loadProject(const void* pSender,
     {
         std::string projectName = args.params["projectName"].asString();
 
-        if (projectExists(projectName)) 
+        Project::SharedPtr project = getProject(projectName);
+
+        if (project)
         {
-            for (std::size_t i = 0; i < _projects.size(); ++i) 
+            if (!project->isLoaded())
             {
-                if (_projects[i].getName() == projectName) 
-                {
-                    Project& project = _projects[i];
-
-                    if (!project.isLoaded()) 
-                    {
-                        project.load(project.getPath(), projectName);
-                    }
-
-                    args.result["data"] = project.getData();
-                    args.result["alreadyOpen"] = ofContains(_openProjectNames, projectName);
-                    _openProjectNames.push_back(projectName);
-                    ofLogNotice("Project::loadProject") << "Loaded " << projectName << " project";
-
-                    return;
-                }
+                project->load(project->getPath(), projectName);
             }
-            ofLogError("Project::loadProject") << "Project: "<< projectName << " was not found";
+
+            args.result["data"] = project->getData();
+
+            Poco::FastMutex::ScopedLock lock(_mutex);
+            args.result["alreadyOpen"] = ofContains(_openProjectNames, projectName);
+            _openProjectNames.push_back(projectName);
+            ofLogNotice("Project::loadProject") << "Loaded " << projectName << " project";
         }
         else
         {
-            ofLogError("Project::loadProject") << "Error loading project";
+            ofLogError("Project::loadProject") << "Project: "<< projectName << " was not found";
         }
     }
     else
@@ -172,6 +156,9 @@ void ProjectManager::loadProject(const void* pSender,
 void ProjectManager::loadTemplateProject(const void *pSender,
                                          ofx::JSONRPC::MethodArgs &args)
 {
+    // Any connection may ask for the template.
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
     if (!_templateProject.isLoaded()) 
     {
         _templateProject.load(_templateProject.getPath(), _templateProject.getName());
@@ -192,10 +179,15 @@ void ProjectManager::saveProject(const void* pSender,
 
         std::string projectName = projectData["projectFile"]["name"].asString();
 
-        if (projectExists(projectName)) 
+        Project::SharedPtr project = getProject(projectName);
+
+        if (project)
         {
-            Project& project = getProjectRef(projectName);
-            project.save(projectData);
+            if (!project->save(projectData))
+            {
+                args.error["message"] = "Unable to save " + projectName + " project.";
+                return;
+            }
         }
 
         ofLogNotice("ProjectManager::saveProject") << "Saved " << projectName << " project";
@@ -211,31 +203,81 @@ void ProjectManager::createProject(const void* pSender,
 
     std::string projectName = args.params["projectData"]["projectFile"]["name"].asString();
 
-    ofDirectory projectDir(_templateProject.getPath());
+    FileCloner::Stats stats;
 
-    projectDir.copyTo(_path + "/" + projectName);
+    if (!FileCloner::cloneProject(_templateProject.getPath(),
+                                  _path + "/" + projectName,
+                                  stats))
+    {
+        args.error["message"] = "Error creating " + projectName + " project.";
+        ofLogError("Project::createProject") << "Error creating " << projectName << " project";
+        return;
+    }
 
     ofFile templateProjectFile(_path + "/" + projectName + "/sketch/NewProject." + Project::SKETCH_FILE_EXTENSION);
 
     templateProjectFile.remove();
 
-    Project project(_path + "/" + projectName);
-    project.save(projectData);
-    _projects.push_back(project);
-    args.result = project.getData();
+    Project::SharedPtr project(new Project(_path + "/" + projectName, _durability));
+    project->save(projectData);
+    args.result = project->getData();
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        _projects.push_back(project);
+    }
+
     ofLogNotice("Project::createProject") << "Created " << projectName << " project";
 }
 
+void ProjectManager::duplicateProject(const void* pSender,
+                                      ofx::JSONRPC::MethodArgs& args)
+{
+    std::string projectName = args.params["projectName"].asString();
+    std::string newProjectName = args.params["newProjectName"].asString();
+    Project::SharedPtr project = getProject(projectName);
+    std::string newPath = _path + "/" + newProjectName;
+
+    FileCloner::Stats stats;
+
+    if (!project || !FileCloner::cloneProject(project->getPath(), newPath, stats))
+    {
+        args.error["message"] = "Error duplicating " + projectName + " project.";
+        ofLogError("Project::duplicateProject") << "Error duplicating " << projectName << " project";
+        return;
+    }
+
+    // Renaming replaces the link, so the original sketch file is untouched.
+    ofFile projectFile(newPath + "/sketch/" + projectName + "." + Project::SKETCH_FILE_EXTENSION);
+    projectFile.renameTo(newPath + "/sketch/" + newProjectName + "." + Project::SKETCH_FILE_EXTENSION);
+
+    Project::SharedPtr newProject(new Project(newPath, _durability));
+    args.result = newProject->getData();
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        _projects.push_back(newProject);
+    }
+
+    ofLogNotice("Project::duplicateProject") << "Duplicated " << projectName << " project to " << newProjectName << " (" << stats.linked << " linked, " << stats.cloned << " cloned, " << stats.copied << " copied)";
+}
+
 void ProjectManager::deleteProject(const void *pSender,
                                    ofx::JSONRPC::MethodArgs &args)
 {
     std::string projectName = args.params["projectName"].asString();
-    Project& project = getProjectRef(projectName);
-    project.remove();
+    Project::SharedPtr project = getProject(projectName);
+
+    if (project)
+    {
+        project->remove();
+    }
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
 
     for (std::size_t i = 0; i < _projects.size(); ++i)
     {
-        if (_projects[i].getName() == projectName) 
+        if (_projects[i] == project)
         {
             _projects.erase(_projects.begin() + i);
             args.result["message"] = "Deleted " + projectName + " project.";
@@ -252,9 +294,12 @@ void ProjectManager::renameProject(const void *pSender, ofx::JSONRPC::MethodArgs
 {
     std::string projectName = args.params["projectName"].asString();
     std::string newProjectName = args.params["newProjectName"].asString();
-    Project& project = getProjectRef(projectName);
+    Project::SharedPtr project = getProject(projectName);
+
+    // Lookups read the names of every project.
+    Poco::FastMutex::ScopedLock lock(_mutex);
 
-    if (project.rename(newProjectName)) 
+    if (project && project->rename(newProjectName))
     {
         _removeFromOpenProjectNames(projectName);
         _openProjectNames.push_back(newProjectName);
@@ -272,15 +317,7 @@ void ProjectManager::renameProject(const void *pSender, ofx::JSONRPC::MethodArgs
 
 bool ProjectManager::projectExists(const std::string& projectName) const
 {
-    for (std::size_t i = 0; i < _projects.size(); ++i) 
-    {
-        if (projectName == _projects[i].getName())
-        {
-            return true;
-        }
-    }
-
-    return false;
+    return getProject(projectName).get() != 0;
 }
 
 
@@ -297,10 +334,25 @@ void ProjectManager::updateProject(const std::string& projectName)
 
 void ProjectManager::notifyProjectClosed(const std::string& projectName)
 {
+    Poco::FastMutex::ScopedLock lock(_mutex);
     _removeFromOpenProjectNames(projectName);
 }
 
 
+Project::SharedPtr ProjectManager::_findProject(const std::string& projectName) const
+{
+    for (std::size_t i = 0; i < _projects.size(); ++i)
+    {
+        if (_projects[i]->getName() == projectName)
+        {
+            return _projects[i];
+        }
+    }
+
+    return Project::SharedPtr();
+}
+
+
 bool ProjectManager::_removeFromOpenProjectNames(const std::string& projectName)
 {
     for (std::size_t i = 0; i < _openProjectNames.size(); i++)
@@ -33,6 +33,8 @@
 #include "ofx/IO/DirectoryUtils.h"
 #include "ofx/JSONRPC/MethodArgs.h"
 #include "ofx/JSONRPC/Utils.h"
+#include "Poco/Mutex.h"
+#include "FileTransaction.h"
 #include "Project.h"
 
 
@@ -45,17 +47,19 @@ class ProjectManager
 public:
     typedef std::shared_ptr<ProjectManager> SharedPtr;
 
-    ProjectManager(const std::string& path);
+    ProjectManager(const std::string& path,
+                   FileTransaction::Durability durability = FileTransaction::DURABILITY_NORMAL);
     virtual ~ProjectManager();
 
     // const std::vector<std::string>& getOpenProjectNames() const;
-    const std::vector<Project>& getProjects() const;
+    std::vector<Project::SharedPtr> getProjects() const;
 
     void getProjectList(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void loadProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void loadTemplateProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void saveProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void createProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
+    void duplicateProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void deleteProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void renameProject(const void* pSender, ofx::JSONRPC::MethodArgs& args);
     void notifyProjectClosed(const std::string& projectName);
@@ -63,20 +67,28 @@ public:
     void updateProject(const std::string& projectName);
 
     bool projectExists(const std::string& projectName) const;
-    const Project& getProject(const std::string& projectName) const;
-    Project& getProjectRef(const std::string& projectName);
 
-    static SharedPtr makeShared(const std::string& projectsPath)
+    /// \returns the project, or null if there is no such project.
+    Project::SharedPtr getProject(const std::string& projectName) const;
+
+    static SharedPtr makeShared(const std::string& projectsPath,
+                                FileTransaction::Durability durability = FileTransaction::DURABILITY_NORMAL)
     {
-        return SharedPtr(new ProjectManager(projectsPath));
+        return SharedPtr(new ProjectManager(projectsPath, durability));
     }
 
 private:
     std::string _path;
+    FileTransaction::Durability _durability;
     std::vector<std::string> _openProjectNames;
-    std::vector<Project> _projects;
+    std::vector<Project::SharedPtr> _projects;
     Project _templateProject;
 
+    /// \brief Guards the project list, not the projects in it.  Calls
+    ///        about a project are serialized by the RPCDispatcher.
+    mutable Poco::FastMutex _mutex;
+
+    Project::SharedPtr _findProject(const std::string& projectName) const;
     bool _removeFromOpenProjectNames(const std::string& projectName);
 };
 
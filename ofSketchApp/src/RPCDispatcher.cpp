@@ -0,0 +1,649 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "RPCDispatcher.h"
+#include <algorithm>
+#include "Poco/Environment.h"
+#include "Poco/Exception.h"
+#include "Poco/NumberFormatter.h"
+#include "Poco/Thread.h"
+#include "Poco/ThreadLocal.h"
+#include "Poco/Types.h"
+#include "ofLog.h"
+#include "Utils.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+namespace {
+
+/// \brief The connection whose call the worker is running.
+Poco::ThreadLocal<ofx::HTTP::WebSocketConnection*> callingConnection;
+
+}
+
+
+const std::string RPCDispatcher::PROJECT_LIST_STRAND = "projects";
+
+
+RPCDispatcher::Call::Call(const SharedBatch& batch_,
+                          const AbstractMethod::SharedPtr& method_,
+                          const Json::Value& request_,
+                          const std::vector<std::string>& strands_):
+    batch(batch_),
+    method(method_),
+    request(request_),
+    strands(strands_),
+    claimed(0)
+{
+    std::sort(strands.begin(), strands.end());
+    strands.erase(std::unique(strands.begin(), strands.end()), strands.end());
+}
+
+
+RPCDispatcher::Worker::Worker(RPCDispatcher& dispatcher):
+    _dispatcher(dispatcher)
+{
+}
+
+
+void RPCDispatcher::Worker::run()
+{
+    while (true)
+    {
+        Poco::AutoPtr<Poco::Notification> notification(_dispatcher._queue.waitDequeueNotification());
+
+        // The queue is woken with nothing in it when the dispatcher stops.
+        if (notification.isNull())
+        {
+            break;
+        }
+
+        Call* call = dynamic_cast<Call*>(notification.get());
+
+        if (call)
+        {
+            _dispatcher._run(*call);
+        }
+    }
+}
+
+
+RPCDispatcher::RPCDispatcher(TopicRouter& topicRouter, std::size_t workers):
+    _topicRouter(topicRouter),
+    _active(0),
+    _threadPool("RPCDispatcher")
+{
+    if (workers == 0)
+    {
+        workers = std::max<std::size_t>(MINIMUM_WORKERS, Poco::Environment::processorCount());
+    }
+
+    if (int(workers) > _threadPool.capacity())
+    {
+        _threadPool.addCapacity(int(workers) - _threadPool.capacity());
+    }
+
+    for (std::size_t i = 0; i < workers; ++i)
+    {
+        _workers.push_back(Poco::SharedPtr<Worker>(new Worker(*this)));
+        _threadPool.start(*_workers.back());
+    }
+}
+
+
+RPCDispatcher::~RPCDispatcher()
+{
+    _queue.wakeUpAll();
+    _threadPool.joinAll();
+}
+
+
+void RPCDispatcher::setAdmissionRoute(const AdmissionRoute::SharedPtr& admissionRoute)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _admissionRoute = admissionRoute;
+}
+
+
+void RPCDispatcher::addConnection(ofx::HTTP::WebSocketConnection& connection)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _connections[&connection] = TopicRouter::ENCODING_JSON;
+}
+
+
+void RPCDispatcher::removeConnection(ofx::HTTP::WebSocketConnection& connection)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _connections.erase(&connection);
+}
+
+
+bool RPCDispatcher::handleFrame(ofx::HTTP::WebSocketConnection& connection,
+                                const std::string& text)
+{
+    Json::Value json;
+    Json::Reader reader;
+
+    if (!reader.parse(text, json))
+    {
+        if (!isBatch(text) && text.find("\"jsonrpc\"") == std::string::npos)
+        {
+            return false;
+        }
+
+        _send(&connection, makeError(Json::Value(), PARSE_ERROR, "Parse error."));
+        return true;
+    }
+
+    return handleCalls(connection, json);
+}
+
+
+bool RPCDispatcher::handleCalls(ofx::HTTP::WebSocketConnection& connection,
+                                const Json::Value& json)
+{
+    // Leave anything that isn't a call to the other listeners.
+    if (!json.isArray() && (!json.isObject() || !json.isMember("method")))
+    {
+        return false;
+    }
+
+    SharedBatch batch(new Batch());
+    batch->connection = &connection;
+    batch->finished = 0;
+    batch->host = connection.getClientAddress().host();
+
+    // Calls about no project that change App or settings state run in
+    // order per connection, even within a batch.
+    _dispatch(batch,
+              json,
+              "connection/" + Poco::NumberFormatter::formatHex(reinterpret_cast<Poco::UIntPtr>(&connection)));
+
+    return true;
+}
+
+
+Json::Value RPCDispatcher::handleRequest(const Poco::Net::IPAddress& host,
+                                         const std::string& text)
+{
+    Json::Value json;
+    Json::Reader reader;
+
+    if (!reader.parse(text, json))
+    {
+        return makeError(Json::Value(), PARSE_ERROR, "Parse error.");
+    }
+
+    Poco::Event finished;
+
+    SharedBatch batch(new Batch());
+    batch->connection = 0;
+    batch->finished = &finished;
+    batch->host = host;
+
+    _dispatch(batch, json, "host/" + host.toString());
+
+    finished.wait();
+
+    // The last call has completed, so nothing else touches the batch now.
+    if (batch->responses.empty())
+    {
+        return Json::Value();
+    }
+
+    return batch->isBatch ? batch->responses : batch->responses[0u];
+}
+
+
+void RPCDispatcher::_dispatch(const SharedBatch& batch,
+                              const Json::Value& json,
+                              const std::string& clientStrand)
+{
+    batch->isBatch = json.isArray();
+    batch->responses = Json::Value(Json::arrayValue);
+
+    if (batch->isBatch && (json.empty() || json.size() > MAXIMUM_BATCH_SIZE))
+    {
+        batch->isBatch = false;
+        batch->remaining = 1;
+
+        Json::Value response = makeError(Json::Value(), INVALID_REQUEST, "Invalid batch.");
+        _complete(batch, response);
+        return;
+    }
+
+    // A single call is handled as a batch of one.
+    Json::ArrayIndex count = batch->isBatch ? json.size() : 1;
+
+    batch->remaining = count;
+
+    AdmissionRoute::SharedPtr admissionRoute;
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        admissionRoute = _admissionRoute;
+    }
+
+    for (Json::ArrayIndex i = 0; i < count; ++i)
+    {
+        const Json::Value& request = batch->isBatch ? json[i] : json;
+
+        if (!request.isObject()
+         || request["jsonrpc"] != "2.0"
+         || !request["method"].isString())
+        {
+            Json::Value response = makeError(Json::Value(), INVALID_REQUEST, "Invalid request.");
+            _complete(batch, response);
+            continue;
+        }
+
+        // Turn the call away before it can start a build, whether it came
+        // over the websocket or HTTP.
+        if (admissionRoute && !admissionRoute->admitCall(batch->host))
+        {
+            Json::Value response;
+
+            if (!_isNotification(request))
+            {
+                response = makeError(request["id"], RATE_LIMITED, "Too many calls.");
+            }
+
+            _complete(batch, response);
+            continue;
+        }
+
+        AbstractMethod::SharedPtr method;
+
+        {
+            Poco::FastMutex::ScopedLock lock(_mutex);
+
+            std::map<std::string, AbstractMethod::SharedPtr>::const_iterator iter = _methods.find(request["method"].asString());
+
+            if (iter != _methods.end())
+            {
+                method = iter->second;
+            }
+        }
+
+        if (method.isNull())
+        {
+            Json::Value response;
+
+            if (!_isNotification(request))
+            {
+                response = makeError(request["id"], METHOD_NOT_FOUND, "Method not found.");
+            }
+
+            _complete(batch, response);
+            continue;
+        }
+
+        // Switch encodings before anything else is sent, including the
+        // response to this call.
+        if (request["method"] == TopicRouter::SET_ENCODING_METHOD && batch->connection)
+        {
+            TopicRouter::Encoding encoding;
+
+            if (TopicRouter::getEncoding(request["params"]["encoding"].asString(), encoding))
+            {
+                Poco::FastMutex::ScopedLock lock(_mutex);
+
+                std::map<ofx::HTTP::WebSocketConnection*, TopicRouter::Encoding>::iterator iter = _connections.find(batch->connection);
+
+                if (iter != _connections.end())
+                {
+                    iter->second = encoding;
+                }
+            }
+        }
+
+        std::vector<std::string> strands;
+
+        std::string projectName = getProjectName(request);
+
+        // Calls about a project always take its strand, since its Project
+        // is changed in place.  Read-only calls about no project, e.g. the
+        // settings and lists loaded at startup, take no strand at all.
+        if (!projectName.empty())
+        {
+            strands.push_back(getProjectStrand(projectName));
+        }
+        else if (method->ordering == ORDERED)
+        {
+            strands.push_back(clientStrand);
+        }
+
+        // Renaming or duplicating also waits for calls about the new name.
+        if (request["params"]["newProjectName"].isString())
+        {
+            strands.push_back(getProjectStrand(request["params"]["newProjectName"].asString()));
+        }
+
+        if (!method->strand.empty())
+        {
+            strands.push_back(method->strand);
+        }
+
+        _schedule(new Call(batch, method, request, strands));
+    }
+}
+
+
+std::size_t RPCDispatcher::getQueuedCount() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::size_t count = _queue.size();
+
+    std::map<std::string, Strand>::const_iterator iter = _strands.begin();
+
+    for (; iter != _strands.end(); ++iter)
+    {
+        count += iter->second.pending.size();
+    }
+
+    return count;
+}
+
+
+void RPCDispatcher::waitForCalls()
+{
+    while (true)
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(_mutex);
+
+            if (_active == 0)
+            {
+                return;
+            }
+        }
+
+        Poco::Thread::sleep(WAIT_INTERVAL);
+    }
+}
+
+
+ofx::HTTP::WebSocketConnection* RPCDispatcher::getCallingConnection()
+{
+    return *callingConnection;
+}
+
+
+bool RPCDispatcher::isBatch(const std::string& text)
+{
+    std::string::size_type start = text.find_first_not_of(" \t\r\n");
+    return start != std::string::npos && text[start] == '[';
+}
+
+
+std::string RPCDispatcher::getProjectName(const Json::Value& request)
+{
+    const Json::Value& params = request["params"];
+
+    if (!params.isObject())
+    {
+        return "";
+    }
+    else if (params["projectName"].isString())
+    {
+        return params["projectName"].asString();
+    }
+    else if (params["projectData"].isObject())
+    {
+        // save-project sends the whole project.
+        return params["projectData"]["projectFile"]["name"].asString();
+    }
+
+    return "";
+}
+
+
+std::string RPCDispatcher::getProjectStrand(const std::string& projectName)
+{
+    return "project/" + projectName;
+}
+
+
+Json::Value RPCDispatcher::makeResult(const Json::Value& id,
+                                      const Json::Value& result)
+{
+    Json::Value json;
+    json["jsonrpc"] = "2.0";
+    json["result"] = result;
+    json["id"] = id;
+    return json;
+}
+
+
+Json::Value RPCDispatcher::makeError(const Json::Value& id,
+                                     int code,
+                                     const std::string& message,
+                                     const Json::Value& data)
+{
+    Json::Value json;
+    json["jsonrpc"] = "2.0";
+    json["error"]["code"] = code;
+    json["error"]["message"] = message;
+
+    if (!data.isNull())
+    {
+        json["error"]["data"] = data;
+    }
+
+    json["id"] = id;
+    return json;
+}
+
+
+void RPCDispatcher::_schedule(const Call::Ptr& call)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    ++_active;
+    _claim(call);
+}
+
+
+void RPCDispatcher::_claim(const Call::Ptr& call)
+{
+    while (call->claimed < call->strands.size())
+    {
+        const std::string& strand = call->strands[call->claimed];
+
+        std::map<std::string, Strand>::iterator iter = _strands.find(strand);
+
+        if (iter != _strands.end())
+        {
+            iter->second.pending.push_back(call);
+            return;
+        }
+
+        // The strand is free, so claim it.
+        _strands[strand];
+        ++call->claimed;
+    }
+
+    _queue.enqueueNotification(call);
+}
+
+
+void RPCDispatcher::_post(const std::string& projectName,
+                          const AbstractMethod::SharedPtr& method,
+                          const Json::Value& params)
+{
+    // The batch has no connection, so nothing is sent.
+    SharedBatch batch(new Batch());
+    batch->connection = 0;
+    batch->finished = 0;
+    batch->isBatch = false;
+    batch->responses = Json::Value(Json::arrayValue);
+    batch->remaining = 1;
+
+    Json::Value request;
+    request["jsonrpc"] = "2.0";
+    request["method"] = "post";
+    request["params"] = params;
+
+    _schedule(new Call(batch, method, request, std::vector<std::string>(1, getProjectStrand(projectName))));
+}
+
+
+void RPCDispatcher::_run(Call& call)
+{
+    *callingConnection = call.batch->connection;
+    Json::Value response = _invoke(*call.method, call.request);
+    *callingConnection = 0;
+
+    if (_isNotification(call.request))
+    {
+        response = Json::Value();
+    }
+
+    _complete(call.batch, response);
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    for (std::size_t i = 0; i < call.strands.size(); ++i)
+    {
+        std::map<std::string, Strand>::iterator iter = _strands.find(call.strands[i]);
+
+        if (iter == _strands.end())
+        {
+            continue;
+        }
+        else if (iter->second.pending.empty())
+        {
+            _strands.erase(iter);
+        }
+        else
+        {
+            // Hand the strand over, and let the call claim the rest.
+            Call::Ptr next = iter->second.pending.front();
+            iter->second.pending.pop_front();
+            ++next->claimed;
+            _claim(next);
+        }
+    }
+
+    --_active;
+}
+
+
+Json::Value RPCDispatcher::_invoke(AbstractMethod& method, const Json::Value& request)
+{
+    ofx::JSONRPC::MethodArgs args(request["params"]);
+
+    try
+    {
+        method.invoke(this, args);
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogError("RPCDispatcher::_invoke") << request["method"].asString() << ": " << exc.displayText();
+        return makeError(request["id"], INTERNAL_ERROR, exc.displayText());
+    }
+    catch (const std::exception& exc)
+    {
+        ofLogError("RPCDispatcher::_invoke") << request["method"].asString() << ": " << exc.what();
+        return makeError(request["id"], INTERNAL_ERROR, exc.what());
+    }
+
+    if (!args.error.isNull())
+    {
+        return makeError(request["id"],
+                         METHOD_ERROR,
+                         args.error.get("message", "Error.").asString(),
+                         args.error);
+    }
+
+    // Move the result into the response rather than copying it, since it
+    // may hold a whole project.
+    Json::Value response = makeResult(request["id"], Json::Value());
+    response["result"].swap(args.result);
+    return response;
+}
+
+
+void RPCDispatcher::_complete(const SharedBatch& batch, Json::Value& response)
+{
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+
+        if (!response.isNull())
+        {
+            batch->responses.append(Json::Value()).swap(response);
+        }
+
+        if (--batch->remaining != 0)
+        {
+            return;
+        }
+    }
+
+    // This was the batch's last call, so nothing else touches it now.
+    if (batch->finished)
+    {
+        batch->finished->set();
+    }
+    else if (!batch->responses.empty()) // notifications get no response at all
+    {
+        _send(batch->connection, batch->isBatch ? batch->responses : batch->responses[0u]);
+    }
+}
+
+
+void RPCDispatcher::_send(ofx::HTTP::WebSocketConnection* connection,
+                          const Json::Value& json)
+{
+    TopicRouter::Encoding encoding;
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+
+        std::map<ofx::HTTP::WebSocketConnection*, TopicRouter::Encoding>::const_iterator iter = _connections.find(connection);
+
+        if (iter == _connections.end())
+        {
+            return;
+        }
+
+        encoding = iter->second;
+    }
+
+    _topicRouter.send(*connection, TopicRouter::makeFrame(json, encoding));
+}
+
+
+bool RPCDispatcher::_isNotification(const Json::Value& request)
+{
+    return request.isObject() && !request.isMember("id");
+}
+
+
+} } // namespace of::Sketch
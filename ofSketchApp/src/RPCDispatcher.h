@@ -0,0 +1,303 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <json/json.h>
+#include "Poco/AutoPtr.h"
+#include "Poco/Event.h"
+#include "Poco/Mutex.h"
+#include "Poco/Notification.h"
+#include "Poco/NotificationQueue.h"
+#include "Poco/Runnable.h"
+#include "Poco/SharedPtr.h"
+#include "Poco/ThreadPool.h"
+#include "Poco/Net/IPAddress.h"
+#include "ofxHTTP.h"
+#include "ofxJSONRPC.h"
+#include "AdmissionRoute.h"
+#include "TopicRouter.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Runs the JSONRPC 2.0 calls sent over the websocket or HTTP on a
+///        pool of worker threads.
+///
+/// Calls about the same project run in order on that project's strand, and
+/// calls about no project in order on their connection's, or HTTP host's,
+/// strand, unless they only read.
+class RPCDispatcher
+{
+public:
+    /// \param workers The number of worker threads, or 0 for one per
+    ///        processor.
+    RPCDispatcher(TopicRouter& topicRouter, std::size_t workers = 0);
+
+    ~RPCDispatcher();
+
+    enum Ordering
+    {
+        ORDERED,  // calls about no project run in order per client
+        UNORDERED // calls about no project only read locked state
+    };
+
+    /// \param strand A strand every call to the method also runs on.
+    template <class ListenerClass>
+    void registerMethod(const std::string& name,
+                        ListenerClass* listener,
+                        void (ListenerClass::*method)(const void*, ofx::JSONRPC::MethodArgs&),
+                        const std::string& strand = "",
+                        Ordering ordering = ORDERED)
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        _methods[name] = AbstractMethod::SharedPtr(new Method<ListenerClass>(listener, method, strand, ordering));
+    }
+
+    /// \brief Run a method on a project's strand and discard the result.
+    template <class ListenerClass>
+    void post(const std::string& projectName,
+              ListenerClass* listener,
+              void (ListenerClass::*method)(const void*, ofx::JSONRPC::MethodArgs&),
+              const Json::Value& params)
+    {
+        AbstractMethod::SharedPtr function(new Method<ListenerClass>(listener, method, "", ORDERED));
+        _post(projectName, function, params);
+    }
+
+    void waitForCalls();
+
+    void setAdmissionRoute(const AdmissionRoute::SharedPtr& admissionRoute);
+
+    void addConnection(ofx::HTTP::WebSocketConnection& connection);
+
+    /// \brief Calls still running for the connection are not answered.
+    void removeConnection(ofx::HTTP::WebSocketConnection& connection);
+
+    /// \returns true if the frame held JSONRPC calls.
+    bool handleFrame(ofx::HTTP::WebSocketConnection& connection,
+                     const std::string& text);
+
+    bool handleCalls(ofx::HTTP::WebSocketConnection& connection,
+                     const Json::Value& json);
+
+    /// \brief Run the calls POSTed by a host and wait for them.
+    /// \returns the response, or null if every call was a notification.
+    Json::Value handleRequest(const Poco::Net::IPAddress& host,
+                              const std::string& text);
+
+    std::size_t getQueuedCount() const;
+
+    /// \returns the connection whose call is running on this thread, or 0.
+    static ofx::HTTP::WebSocketConnection* getCallingConnection();
+
+    static bool isBatch(const std::string& text);
+
+    static std::string getProjectName(const Json::Value& request);
+
+    static std::string getProjectStrand(const std::string& projectName);
+
+    static const std::string PROJECT_LIST_STRAND;
+
+    static Json::Value makeResult(const Json::Value& id,
+                                  const Json::Value& result);
+
+    static Json::Value makeError(const Json::Value& id,
+                                 int code,
+                                 const std::string& message,
+                                 const Json::Value& data = Json::Value());
+
+    enum ErrorCode
+    {
+        PARSE_ERROR = -32700,
+        INVALID_REQUEST = -32600,
+        METHOD_NOT_FOUND = -32601,
+        INTERNAL_ERROR = -32603,
+
+        METHOD_ERROR = -32000,
+        RATE_LIMITED = -32001
+    };
+
+    enum
+    {
+        MAXIMUM_BATCH_SIZE = 64,
+        MINIMUM_WORKERS = 2,
+        WAIT_INTERVAL = 10
+    };
+
+private:
+    class AbstractMethod
+    {
+    public:
+        typedef Poco::SharedPtr<AbstractMethod> SharedPtr;
+
+        AbstractMethod(const std::string& strand_, Ordering ordering_):
+            strand(strand_),
+            ordering(ordering_)
+        {
+        }
+
+        virtual ~AbstractMethod()
+        {
+        }
+
+        virtual void invoke(const void* pSender, ofx::JSONRPC::MethodArgs& args) = 0;
+
+        std::string strand;
+        Ordering ordering;
+    };
+
+    template <class ListenerClass>
+    class Method: public AbstractMethod
+    {
+    public:
+        typedef void (ListenerClass::*Function)(const void*, ofx::JSONRPC::MethodArgs&);
+
+        Method(ListenerClass* listener,
+               Function function,
+               const std::string& strand,
+               Ordering ordering):
+            AbstractMethod(strand, ordering),
+            _listener(listener),
+            _function(function)
+        {
+        }
+
+        void invoke(const void* pSender, ofx::JSONRPC::MethodArgs& args)
+        {
+            (_listener->*_function)(pSender, args);
+        }
+
+    private:
+        ListenerClass* _listener;
+        Function _function;
+    };
+
+    /// \brief The calls from one frame.
+    struct Batch
+    {
+        ofx::HTTP::WebSocketConnection* connection;
+        Poco::Event* finished; // set instead of sending, for HTTP calls
+        Poco::Net::IPAddress host; // whose call budget the calls come out of
+        bool isBatch; // false for a single call
+        Json::Value responses;
+        std::size_t remaining;
+    };
+
+    typedef Poco::SharedPtr<Batch> SharedBatch;
+
+    class Call: public Poco::Notification
+    {
+    public:
+        typedef Poco::AutoPtr<Call> Ptr;
+
+        Call(const SharedBatch& batch,
+             const AbstractMethod::SharedPtr& method,
+             const Json::Value& request,
+             const std::vector<std::string>& strands);
+
+        SharedBatch batch;
+        AbstractMethod::SharedPtr method;
+        Json::Value request;
+
+        /// \brief Sorted, so calls claim them in the same order.
+        std::vector<std::string> strands;
+        std::size_t claimed;
+    };
+
+    class Worker: public Poco::Runnable
+    {
+    public:
+        Worker(RPCDispatcher& dispatcher);
+
+        void run();
+
+    private:
+        RPCDispatcher& _dispatcher;
+    };
+
+    struct Strand
+    {
+        std::deque<Call::Ptr> pending;
+    };
+
+    TopicRouter& _topicRouter;
+
+    std::map<std::string, AbstractMethod::SharedPtr> _methods;
+
+    AdmissionRoute::SharedPtr _admissionRoute;
+
+    std::map<ofx::HTTP::WebSocketConnection*, TopicRouter::Encoding> _connections;
+
+    std::map<std::string, Strand> _strands;
+
+    std::size_t _active;
+
+    Poco::NotificationQueue _queue;
+
+    std::vector<Poco::SharedPtr<Worker> > _workers;
+
+    Poco::ThreadPool _threadPool;
+
+    mutable Poco::FastMutex _mutex;
+
+    /// \param clientStrand The strand for calls about no project.
+    void _dispatch(const SharedBatch& batch,
+                   const Json::Value& json,
+                   const std::string& clientStrand);
+
+    void _schedule(const Call::Ptr& call);
+
+    /// \brief Must be called with _mutex held.
+    void _claim(const Call::Ptr& call);
+
+    void _post(const std::string& projectName,
+               const AbstractMethod::SharedPtr& method,
+               const Json::Value& params);
+
+    void _run(Call& call);
+
+    Json::Value _invoke(AbstractMethod& method, const Json::Value& request);
+
+    /// \param response Moved into the batch, or null for a notification.
+    void _complete(const SharedBatch& batch, Json::Value& response);
+
+    /// \brief Must be called without _mutex held.
+    void _send(ofx::HTTP::WebSocketConnection* connection, const Json::Value& json);
+
+    static bool _isNotification(const Json::Value& request);
+
+};
+
+
+} } // namespace of::Sketch
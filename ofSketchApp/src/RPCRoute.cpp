@@ -0,0 +1,117 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+
+#include "RPCRoute.h"
+#include "Poco/Net/MediaType.h"
+#include "Poco/URI.h"
+#include "ofLog.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+const std::string RPCRoute::POST_PATH = "/post";
+
+
+RPCRoute::RPCRoute(RPCDispatcher& dispatcher):
+    _dispatcher(dispatcher)
+{
+}
+
+
+RPCRoute::~RPCRoute()
+{
+}
+
+
+bool RPCRoute::canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                                bool isSecurePort) const
+{
+    if (request.getMethod() != Poco::Net::HTTPRequest::HTTP_POST
+     || Poco::URI(request.getURI()).getPath() != POST_PATH)
+    {
+        return false;
+    }
+
+    // Uploads to the same path are left to the post route.
+    return Poco::Net::MediaType(request.getContentType()).matches("application", "json");
+}
+
+
+void RPCRoute::handleRequest(Poco::Net::HTTPServerRequest& request,
+                             Poco::Net::HTTPServerResponse& response)
+{
+    if (request.hasContentLength()
+     && request.getContentLength64() > MAXIMUM_REQUEST_SIZE)
+    {
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_REQUESTENTITYTOOLARGE);
+        response.setContentLength(0);
+        response.send();
+        return;
+    }
+
+    std::string text;
+    char buffer[BUFFER_SIZE];
+
+    std::istream& input = request.stream();
+
+    while (input.read(buffer, BUFFER_SIZE) || input.gcount() > 0)
+    {
+        text.append(buffer, std::size_t(input.gcount()));
+
+        // A chunked request doesn't say how large it is up front.
+        if (text.size() > MAXIMUM_REQUEST_SIZE)
+        {
+            response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_REQUESTENTITYTOOLARGE);
+            response.setKeepAlive(false);
+            response.setContentLength(0);
+            response.send();
+            return;
+        }
+    }
+
+    Json::Value json = _dispatcher.handleRequest(request.clientAddress().host(), text);
+
+    if (json.isNull())
+    {
+        // Notifications get no response at all.
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NO_CONTENT);
+        response.setContentLength(0);
+        response.send();
+        return;
+    }
+
+    Json::FastWriter writer;
+    std::string body = writer.write(json);
+
+    response.setContentType("application/json");
+    response.sendBuffer(body.data(), body.size());
+}
+
+
+} } // namespace of::Sketch
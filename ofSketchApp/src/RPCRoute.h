@@ -0,0 +1,81 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+
+#pragma once
+
+
+#include <string>
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "ofxHTTP.h"
+#include "RPCDispatcher.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Hands JSONRPC calls POSTed over HTTP to the dispatcher, so they
+///        run on the same strands as the websocket's.
+class RPCRoute: public ofx::HTTP::BaseRoute
+{
+public:
+    typedef std::shared_ptr<RPCRoute> SharedPtr;
+
+    RPCRoute(RPCDispatcher& dispatcher);
+
+    virtual ~RPCRoute();
+
+    bool canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                          bool isSecurePort) const;
+
+    void handleRequest(Poco::Net::HTTPServerRequest& request,
+                       Poco::Net::HTTPServerResponse& response);
+
+    static SharedPtr makeShared(RPCDispatcher& dispatcher)
+    {
+        return SharedPtr(new RPCRoute(dispatcher));
+    }
+
+    /// \brief The path the client POSTs its calls to.
+    static const std::string POST_PATH;
+
+    enum
+    {
+        /// \brief save-project sends the whole project.
+        MAXIMUM_REQUEST_SIZE = 64 * 1024 * 1024,
+
+        BUFFER_SIZE = 8192
+    };
+
+private:
+    RPCDispatcher& _dispatcher;
+
+};
+
+
+} } // namespace of::Sketch
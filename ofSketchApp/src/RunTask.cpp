@@ -32,8 +32,8 @@ namespace of {
 namespace Sketch {
 
 
-RunTask::RunTask(const Project& project, Target target):
-    BaseProcessTask(project.getName(), getExecutable(project, target))
+RunTask::RunTask(const Project& project, const BuildProfile& profile):
+    BaseProcessTask(project.getName(), getExecutable(project, profile))
 {
 }
 
@@ -49,9 +49,9 @@ void RunTask::processLine(const std::string& line)
 }
 
 
-std::string RunTask::getExecutable(const Project& project, Target target)
+std::string RunTask::getExecutable(const Project& project, const BuildProfile& profile)
 {
-    std::string suffix = (target == DEBUG) ? "_debug" : "";
+    const std::string& suffix = profile.binarySuffix;
 
 #if defined(TARGET_OSX)
     return project.getPath() + "/bin/" + project.getName() + suffix + ".app/Contents/MacOS/" + project.getName() + suffix;
@@ -36,6 +36,7 @@
 #include "ofUtils.h"
 #include "Project.h"
 #include "BaseProcessTask.h"
+#include "BuildProfile.h"
 
 
 namespace of {
@@ -45,20 +46,13 @@ namespace Sketch {
 class RunTask: public BaseProcessTask
 {
 public:
-    enum Target
-    {
-        DEBUG,
-        RELEASE
-    };
-
-    RunTask(const Project& project, Target target);
+    RunTask(const Project& project, const BuildProfile& profile);
 
     virtual ~RunTask();
 
     virtual void processLine(const std::string& line);
 
-    static std::string getExecutable(const Project& project, Target target);
-    static std::string getExecutablePath(const Project& project, Target target);
+    static std::string getExecutable(const Project& project, const BuildProfile& profile);
 
 };
 
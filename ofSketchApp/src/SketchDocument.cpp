@@ -0,0 +1,142 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "SketchDocument.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+SketchDocument::SketchDocument(const std::string& projectName,
+                               const std::string& fileName,
+                               const std::string& contents):
+    _projectName(projectName),
+    _fileName(fileName),
+    _contents(contents),
+    _revision(0),
+    _isDirty(false)
+{
+}
+
+
+SketchDocument::~SketchDocument()
+{
+}
+
+
+bool SketchDocument::receive(std::size_t revision,
+                             const TextOperation& operation,
+                             TextOperation& transformed)
+{
+    std::size_t oldestRevision = _revision - _history.size();
+
+    if (revision < oldestRevision || revision > _revision) return false;
+
+    transformed = operation;
+
+    // Bring the operation up to date with everything it has not seen.
+    for (std::size_t i = revision - oldestRevision; i < _history.size(); ++i)
+    {
+        TextOperation operationPrime;
+        TextOperation historyPrime;
+
+        if (!TextOperation::transform(transformed,
+                                      _history[i],
+                                      operationPrime,
+                                      historyPrime))
+        {
+            return false;
+        }
+
+        transformed = operationPrime;
+    }
+
+    if (!transformed.apply(_contents, _contents)) return false;
+
+    _history.push_back(transformed);
+
+    if (_history.size() > MAXIMUM_HISTORY_SIZE)
+    {
+        _history.pop_front();
+    }
+
+    ++_revision;
+
+    if (!transformed.isNoop())
+    {
+        _isDirty = true;
+    }
+
+    return true;
+}
+
+
+const std::string& SketchDocument::getProjectName() const
+{
+    return _projectName;
+}
+
+
+const std::string& SketchDocument::getFileName() const
+{
+    return _fileName;
+}
+
+
+const std::string& SketchDocument::getContents() const
+{
+    return _contents;
+}
+
+
+std::size_t SketchDocument::getRevision() const
+{
+    return _revision;
+}
+
+
+bool SketchDocument::isDirty() const
+{
+    return _isDirty;
+}
+
+
+void SketchDocument::setClean()
+{
+    _isDirty = false;
+}
+
+
+void SketchDocument::reset(const std::string& contents)
+{
+    _contents = contents;
+    _history.clear();
+    ++_revision;
+    _isDirty = false;
+}
+
+
+} } // namespace of::Sketch
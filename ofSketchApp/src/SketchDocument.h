@@ -0,0 +1,87 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <deque>
+#include <string>
+#include "ofTypes.h"
+#include "TextOperation.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief The server's copy of a sketch file being edited.
+class SketchDocument
+{
+public:
+    typedef std::shared_ptr<SketchDocument> SharedPtr;
+
+    SketchDocument(const std::string& projectName,
+                   const std::string& fileName,
+                   const std::string& contents);
+
+    virtual ~SketchDocument();
+
+    /// \brief Apply an operation made against an earlier revision.
+    bool receive(std::size_t revision,
+                 const TextOperation& operation,
+                 TextOperation& transformed);
+
+    const std::string& getProjectName() const;
+    const std::string& getFileName() const;
+    const std::string& getContents() const;
+
+    std::size_t getRevision() const;
+
+    bool isDirty() const;
+    void setClean();
+
+    /// \brief Replace the contents and forget the older revisions.
+    void reset(const std::string& contents);
+
+    enum
+    {
+        MAXIMUM_HISTORY_SIZE = 500
+    };
+
+private:
+    std::string _projectName;
+    std::string _fileName;
+    std::string _contents;
+
+    std::deque<TextOperation> _history;
+
+    std::size_t _revision;
+
+    bool _isDirty;
+
+};
+
+
+} } // namespace of::Sketch
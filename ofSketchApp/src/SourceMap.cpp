@@ -0,0 +1,159 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "SourceMap.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+const std::string SourceMap::FILE_NAME = "ofSketch.map";
+
+
+SourceMap::SourceMap()
+{
+}
+
+
+SourceMap::~SourceMap()
+{
+}
+
+
+void SourceMap::add(const std::string& generatedFile,
+                    std::size_t line,
+                    std::size_t count,
+                    const std::string& fileName,
+                    std::size_t sketchLine)
+{
+    Region region;
+    region.line = line;
+    region.count = count;
+    region.fileName = fileName;
+    region.sketchLine = sketchLine;
+
+    _files[generatedFile].push_back(region);
+}
+
+
+bool SourceMap::find(const std::string& generatedFile,
+                     std::size_t line,
+                     std::string& fileName,
+                     std::size_t& sketchLine) const
+{
+    std::map<std::string, std::vector<Region> >::const_iterator iter = _files.find(generatedFile);
+
+    if (iter == _files.end())
+    {
+        return false;
+    }
+
+    const std::vector<Region>& regions = iter->second;
+
+    for (std::size_t i = 0; i < regions.size(); ++i)
+    {
+        if (line >= regions[i].line && line < regions[i].line + regions[i].count)
+        {
+            fileName = regions[i].fileName;
+            sketchLine = regions[i].sketchLine + (line - regions[i].line);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool SourceMap::empty() const
+{
+    return _files.empty();
+}
+
+
+void SourceMap::clear()
+{
+    _files.clear();
+}
+
+
+Json::Value SourceMap::toJson() const
+{
+    Json::Value json(Json::objectValue);
+
+    std::map<std::string, std::vector<Region> >::const_iterator iter = _files.begin();
+
+    for (; iter != _files.end(); ++iter)
+    {
+        Json::Value& regions = json[iter->first];
+        regions = Json::Value(Json::arrayValue);
+
+        for (std::size_t i = 0; i < iter->second.size(); ++i)
+        {
+            const Region& region = iter->second[i];
+
+            Json::Value value;
+            value["line"] = Json::UInt64(region.line);
+            value["count"] = Json::UInt64(region.count);
+            value["fileName"] = region.fileName;
+            value["sketchLine"] = Json::UInt64(region.sketchLine);
+            regions.append(value);
+        }
+    }
+
+    return json;
+}
+
+
+SourceMap SourceMap::fromJson(const Json::Value& json)
+{
+    SourceMap sourceMap;
+
+    if (!json.isObject())
+    {
+        return sourceMap;
+    }
+
+    std::vector<std::string> generatedFiles = json.getMemberNames();
+
+    for (std::size_t i = 0; i < generatedFiles.size(); ++i)
+    {
+        const Json::Value& regions = json[generatedFiles[i]];
+
+        for (unsigned int j = 0; j < regions.size(); ++j)
+        {
+            sourceMap.add(generatedFiles[i],
+                          regions[j]["line"].asUInt(),
+                          regions[j]["count"].asUInt(),
+                          regions[j]["fileName"].asString(),
+                          regions[j]["sketchLine"].asUInt());
+        }
+    }
+
+    return sourceMap;
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,83 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <json/json.h>
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Maps lines of generated source files back to sketch files.
+class SourceMap
+{
+public:
+    SourceMap();
+
+    virtual ~SourceMap();
+
+    void add(const std::string& generatedFile,
+             std::size_t line,
+             std::size_t count,
+             const std::string& fileName,
+             std::size_t sketchLine);
+
+    /// \returns false if the line was generated from a template.
+    bool find(const std::string& generatedFile,
+              std::size_t line,
+              std::string& fileName,
+              std::size_t& sketchLine) const;
+
+    bool empty() const;
+
+    void clear();
+
+    Json::Value toJson() const;
+
+    static SourceMap fromJson(const Json::Value& json);
+
+    static const std::string FILE_NAME;
+
+private:
+    struct Region
+    {
+        std::size_t line;
+        std::size_t count;
+        std::string fileName;
+        std::size_t sketchLine;
+    };
+
+    std::map<std::string, std::vector<Region> > _files;
+
+};
+
+
+} } // namespace of::Sketch
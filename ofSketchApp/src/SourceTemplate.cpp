@@ -0,0 +1,179 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "SourceTemplate.h"
+#include <algorithm>
+
+
+namespace of {
+namespace Sketch {
+
+
+SourceTemplate::SourceTemplate()
+{
+}
+
+
+SourceTemplate::SourceTemplate(const std::string& source)
+{
+    parse(source);
+}
+
+
+SourceTemplate::~SourceTemplate()
+{
+}
+
+
+void SourceTemplate::parse(const std::string& source)
+{
+    _segments.clear();
+
+    Segment literal;
+    literal.newlines = 0;
+
+    std::size_t i = 0;
+
+    while (i < source.size())
+    {
+        if (source[i] == '<')
+        {
+            std::size_t end = i + 1;
+
+            while (end < source.size()
+               && ((source[end] >= 'a' && source[end] <= 'z') || source[end] == '_'))
+            {
+                ++end;
+            }
+
+            if (end > i + 1 && end < source.size() && source[end] == '>')
+            {
+                if (!literal.text.empty())
+                {
+                    _segments.push_back(literal);
+                    literal.text.clear();
+                    literal.newlines = 0;
+                }
+
+                Segment placeholder;
+                placeholder.text = source.substr(i, end + 1 - i);
+                placeholder.name = source.substr(i + 1, end - i - 1);
+                placeholder.newlines = 0;
+                _segments.push_back(placeholder);
+
+                i = end + 1;
+                continue;
+            }
+        }
+
+        if (source[i] == '\n')
+        {
+            ++literal.newlines;
+        }
+
+        literal.text += source[i];
+        ++i;
+    }
+
+    if (!literal.text.empty())
+    {
+        _segments.push_back(literal);
+    }
+}
+
+
+void SourceTemplate::render(const Variables& variables,
+                            std::string& output) const
+{
+    _render(variables, output, 0);
+}
+
+
+void SourceTemplate::render(const Variables& variables,
+                            std::string& output,
+                            Lines& lines) const
+{
+    lines.clear();
+    _render(variables, output, &lines);
+}
+
+
+void SourceTemplate::_render(const Variables& variables,
+                             std::string& output,
+                             Lines* lines) const
+{
+    std::size_t size = 0;
+
+    for (std::size_t i = 0; i < _segments.size(); ++i)
+    {
+        size += _getValue(variables, _segments[i]).size();
+    }
+
+    output.clear();
+    output.reserve(size);
+
+    std::size_t line = 1;
+
+    for (std::size_t i = 0; i < _segments.size(); ++i)
+    {
+        const Segment& segment = _segments[i];
+        const std::string& value = _getValue(variables, segment);
+
+        output.append(value);
+
+        if (lines)
+        {
+            if (segment.name.empty())
+            {
+                line += segment.newlines;
+            }
+            else
+            {
+                lines->insert(std::make_pair(segment.name, line));
+                line += std::count(value.begin(), value.end(), '\n');
+            }
+        }
+    }
+}
+
+
+const std::string& SourceTemplate::_getValue(const Variables& variables,
+                                             const Segment& segment) const
+{
+    if (!segment.name.empty())
+    {
+        Variables::const_iterator iter = variables.find(segment.name);
+
+        if (iter != variables.end())
+        {
+            return iter->second;
+        }
+    }
+
+    return segment.text;
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,83 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief A source template with <name> placeholders, parsed once.
+class SourceTemplate
+{
+public:
+    typedef std::map<std::string, std::string> Variables;
+
+    /// \brief The line, from 1, of each placeholder's first use.
+    typedef std::map<std::string, std::size_t> Lines;
+
+    SourceTemplate();
+
+    SourceTemplate(const std::string& source);
+
+    virtual ~SourceTemplate();
+
+    void parse(const std::string& source);
+
+    /// \brief Placeholders without a value, e.g. <vector>, are kept.
+    void render(const Variables& variables, std::string& output) const;
+
+    void render(const Variables& variables,
+                std::string& output,
+                Lines& lines) const;
+
+private:
+    struct Segment
+    {
+        std::string text;
+        std::string name; // empty for literal text
+
+        std::size_t newlines;
+    };
+
+    std::vector<Segment> _segments;
+
+    void _render(const Variables& variables,
+                 std::string& output,
+                 Lines* lines) const;
+
+    const std::string& _getValue(const Variables& variables,
+                                 const Segment& segment) const;
+
+};
+
+
+} } // namespace of::Sketch
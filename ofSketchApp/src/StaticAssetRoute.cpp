@@ -0,0 +1,715 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "StaticAssetRoute.h"
+#include <algorithm>
+#include <sstream>
+#include "Poco/DateTimeFormat.h"
+#include "Poco/DateTimeFormatter.h"
+#include "Poco/DeflatingStream.h"
+#include "Poco/DigestEngine.h"
+#include "Poco/DirectoryIterator.h"
+#include "Poco/Exception.h"
+#include "Poco/File.h"
+#include "Poco/FileStream.h"
+#include "Poco/NumberParser.h"
+#include "Poco/Path.h"
+#include "Poco/SHA1Engine.h"
+#include "Poco/StreamCopier.h"
+#include "Poco/String.h"
+#include "Poco/StringTokenizer.h"
+#include "Poco/URI.h"
+#include "ofLog.h"
+#include "ofxMediaType.h"
+#include "FileTransaction.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+const std::string StaticAssetRoute::DEFAULT_DOCUMENT = "index.html";
+const std::string StaticAssetRoute::GZIP_ENCODING = "gzip";
+const std::string StaticAssetRoute::BROTLI_ENCODING = "br";
+const std::string StaticAssetRoute::VERSION_PARAMETER = "v";
+const std::string StaticAssetRoute::IMMUTABLE_CACHE_CONTROL = "public, max-age=31536000, immutable";
+const std::string StaticAssetRoute::REVALIDATE_CACHE_CONTROL = "no-cache";
+
+
+StaticAssetRoute::Asset::Asset():
+    isFingerprinted(false)
+{
+}
+
+
+StaticAssetRoute::StaticAssetRoute(const std::string& documentRoot,
+                                   const std::string& cacheDir):
+    _documentRoot(Poco::Path(documentRoot).makeDirectory().toString()),
+    _cacheDir(Poco::Path(cacheDir).makeDirectory().toString())
+{
+}
+
+
+StaticAssetRoute::~StaticAssetRoute()
+{
+}
+
+
+void StaticAssetRoute::setup()
+{
+    _assets.clear();
+
+    std::vector<std::string> paths;
+    _findAssets(_documentRoot, paths);
+
+    // Pages are stamped with the versions of the assets they link to, so
+    // they are loaded last.
+    std::vector<std::string> pages;
+
+    for (std::size_t i = 0; i < paths.size(); ++i)
+    {
+        if (_isHTML(paths[i]))
+        {
+            pages.push_back(paths[i]);
+        }
+        else
+        {
+            _addAsset(paths[i]);
+        }
+    }
+
+    for (std::size_t i = 0; i < pages.size(); ++i)
+    {
+        _addAsset(pages[i]);
+    }
+
+    std::size_t bytes = 0;
+
+    std::map<std::string, Asset>::const_iterator asset = _assets.begin();
+
+    for (; asset != _assets.end(); ++asset)
+    {
+        std::map<std::string, Representation>::const_iterator iter = asset->second.representations.begin();
+
+        for (; iter != asset->second.representations.end(); ++iter)
+        {
+            bytes += iter->second.data.size();
+        }
+    }
+
+    ofLogNotice("StaticAssetRoute::setup") << "Serving " << _assets.size() << " assets (" << bytes / 1024 << " KB) from " << _documentRoot;
+}
+
+
+bool StaticAssetRoute::canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                                        bool isSecurePort) const
+{
+    if (request.getMethod() != Poco::Net::HTTPRequest::HTTP_GET
+     && request.getMethod() != Poco::Net::HTTPRequest::HTTP_HEAD)
+    {
+        return false;
+    }
+
+    // Leave websocket handshakes to the websocket route.
+    if (request.has("Upgrade"))
+    {
+        return false;
+    }
+
+    return _assets.find(_getAssetName(request.getURI())) != _assets.end();
+}
+
+
+void StaticAssetRoute::handleRequest(Poco::Net::HTTPServerRequest& request,
+                                     Poco::Net::HTTPServerResponse& response)
+{
+    std::map<std::string, Asset>::const_iterator asset = _assets.find(_getAssetName(request.getURI()));
+
+    if (asset == _assets.end())
+    {
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_FOUND);
+        response.setContentLength(0);
+        response.send();
+        return;
+    }
+
+    const std::map<std::string, Representation>& representations = asset->second.representations;
+
+    std::string acceptEncoding = request.get("Accept-Encoding", "");
+    std::string coding;
+
+    if (representations.find(BROTLI_ENCODING) != representations.end()
+     && acceptsEncoding(acceptEncoding, BROTLI_ENCODING))
+    {
+        coding = BROTLI_ENCODING;
+    }
+    else if (representations.find(GZIP_ENCODING) != representations.end()
+          && acceptsEncoding(acceptEncoding, GZIP_ENCODING))
+    {
+        coding = GZIP_ENCODING;
+    }
+
+    const Representation& representation = representations.find(coding)->second;
+
+    // Caches must not hand a compressed copy to a browser that didn't ask
+    // for one.
+    if (representations.size() > 1)
+    {
+        response.set("Vary", "Accept-Encoding");
+    }
+
+    // A link stamped with an older version still gets the current asset,
+    // but it mustn't be cached under that link for good.
+    if (asset->second.isFingerprinted
+     || _getVersion(request.getURI()) == asset->second.fingerprint)
+    {
+        response.set("Cache-Control", IMMUTABLE_CACHE_CONTROL);
+    }
+    else
+    {
+        response.set("Cache-Control", REVALIDATE_CACHE_CONTROL);
+    }
+
+    response.set("ETag", representation.etag);
+    response.set("Last-Modified", Poco::DateTimeFormatter::format(asset->second.lastModified,
+                                                                  Poco::DateTimeFormat::HTTP_FORMAT));
+
+    if (matchesETag(request.get("If-None-Match", ""), representation.etag))
+    {
+        // A 304 has no body; without a length of 0 the connection can't
+        // be kept alive for the next request.
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED);
+        response.setChunkedTransferEncoding(false);
+        response.setContentLength(0);
+        response.send();
+        return;
+    }
+
+    if (!coding.empty())
+    {
+        response.set("Content-Encoding", coding);
+    }
+
+    response.setContentType(asset->second.mediaType);
+    response.sendBuffer(representation.data.data(), representation.data.size());
+}
+
+
+bool StaticAssetRoute::acceptsEncoding(const std::string& acceptEncoding,
+                                       const std::string& coding)
+{
+    bool acceptsAny = false;
+
+    Poco::StringTokenizer codings(acceptEncoding,
+                                  ",",
+                                  Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+
+    for (std::size_t i = 0; i < codings.count(); ++i)
+    {
+        // e.g. "gzip;q=0.5"
+        std::string::size_type semicolon = codings[i].find(';');
+        std::string name = Poco::toLower(Poco::trim(codings[i].substr(0, semicolon)));
+        double quality = 1;
+
+        if (semicolon != std::string::npos)
+        {
+            std::string parameter = Poco::trim(codings[i].substr(semicolon + 1));
+
+            if (parameter.compare(0, 2, "q=") == 0
+             && !Poco::NumberParser::tryParseFloat(parameter.substr(2), quality))
+            {
+                quality = 0;
+            }
+        }
+
+        if (name == coding)
+        {
+            return quality > 0;
+        }
+        else if (name == "*")
+        {
+            acceptsAny = quality > 0;
+        }
+    }
+
+    return acceptsAny;
+}
+
+
+bool StaticAssetRoute::matchesETag(const std::string& ifNoneMatch,
+                                   const std::string& etag)
+{
+    Poco::StringTokenizer etags(ifNoneMatch,
+                                ",",
+                                Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+
+    for (std::size_t i = 0; i < etags.count(); ++i)
+    {
+        // If-None-Match uses the weak comparison.
+        std::string candidate = etags[i];
+
+        if (candidate.compare(0, 2, "W/") == 0)
+        {
+            candidate.erase(0, 2);
+        }
+
+        if (candidate == "*" || candidate == etag)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool StaticAssetRoute::isFingerprinted(const std::string& path)
+{
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    std::string::size_type extension = name.rfind('.');
+
+    if (extension == std::string::npos)
+    {
+        return false;
+    }
+
+    // e.g. "app.3f2a9c1b.js" or "app-3f2a9c1b.min.js"
+    Poco::StringTokenizer parts(name.substr(0, extension), ".-");
+
+    for (std::size_t i = 1; i < parts.count(); ++i)
+    {
+        const std::string& part = parts[i];
+
+        if (part.size() >= MINIMUM_FINGERPRINT_LENGTH
+         && part.find_first_not_of("0123456789abcdefABCDEF") == std::string::npos
+         && part.find_first_of("0123456789") != std::string::npos)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void StaticAssetRoute::_findAssets(const std::string& path,
+                                   std::vector<std::string>& paths) const
+{
+    try
+    {
+        Poco::DirectoryIterator iter(path);
+        Poco::DirectoryIterator end;
+
+        for (; iter != end; ++iter)
+        {
+            std::string extension = Poco::toLower(Poco::Path(iter->path()).getExtension());
+
+            if (iter->isHidden() || extension == "gz" || extension == BROTLI_ENCODING)
+            {
+                continue;
+            }
+            else if (iter->isDirectory())
+            {
+                _findAssets(iter->path(), paths);
+            }
+            else if (iter->isFile())
+            {
+                paths.push_back(iter->path());
+            }
+        }
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogWarning("StaticAssetRoute::_findAssets") << "Unable to search " << path << ": " << exc.displayText();
+    }
+}
+
+
+void StaticAssetRoute::_addAsset(const std::string& path)
+{
+    std::string name = _getName(path);
+
+    if (name.empty())
+    {
+        return;
+    }
+
+    try
+    {
+        Poco::File file(path);
+
+        if (file.getSize() > MAXIMUM_ASSET_SIZE)
+        {
+            ofLogNotice("StaticAssetRoute::_addAsset") << "Not caching " << name << ", it is " << file.getSize() << " bytes.";
+            return;
+        }
+
+        Asset asset;
+        asset.mediaType = ofx::MediaTypeMap::getDefault()->getMediaTypeForPath(Poco::Path(path)).toString();
+        asset.lastModified = file.getLastModified();
+        asset.isFingerprinted = isFingerprinted(name);
+
+        std::string data;
+        Poco::FileInputStream input(path);
+        Poco::StreamCopier::copyToString(input, data);
+
+        if (_isHTML(path))
+        {
+            data = _stampLinks(name, data);
+        }
+
+        _encode(name, asset, data);
+
+        // There is no brotli encoder here, but one built alongside the
+        // asset is served as long as it is newer.  Pages are changed by
+        // stamping, so theirs would be out of date.
+        Poco::File brotli(path + "." + BROTLI_ENCODING);
+
+        if (!_isHTML(path)
+         && brotli.exists()
+         && brotli.isFile()
+         && brotli.getLastModified() >= asset.lastModified)
+        {
+            Representation br;
+            Poco::FileInputStream brotliInput(brotli.path());
+            Poco::StreamCopier::copyToString(brotliInput, br.data);
+            br.etag = "\"" + asset.fingerprint + "-" + BROTLI_ENCODING + "\"";
+            asset.representations[BROTLI_ENCODING] = br;
+        }
+
+        _assets[name] = asset;
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogWarning("StaticAssetRoute::_addAsset") << "Unable to load " << path << ": " << exc.displayText();
+    }
+}
+
+
+void StaticAssetRoute::_encode(const std::string& name,
+                               Asset& asset,
+                               const std::string& data) const
+{
+    Poco::SHA1Engine sha1;
+    sha1.update(data);
+
+    asset.fingerprint = Poco::DigestEngine::digestToHex(sha1.digest()).substr(0, FINGERPRINT_LENGTH);
+
+    // Each encoding is a different representation, so it needs its own
+    // strong validator.
+    Representation identity;
+    identity.data = data;
+    identity.etag = "\"" + asset.fingerprint + "\"";
+    asset.representations[""] = identity;
+
+    Representation gzip;
+
+    if (_isCompressible(name)
+     && data.size() >= MINIMUM_COMPRESSED_SIZE
+     && _compress(name, asset, data, gzip.data))
+    {
+        gzip.etag = "\"" + asset.fingerprint + "-" + GZIP_ENCODING + "\"";
+        asset.representations[GZIP_ENCODING] = gzip;
+    }
+}
+
+
+std::string StaticAssetRoute::_stampLinks(const std::string& name,
+                                          const std::string& html) const
+{
+    std::string result;
+    result.reserve(html.size());
+
+    std::string::size_type position = 0;
+
+    while (true)
+    {
+        std::string::size_type attribute = std::min(html.find("src=", position),
+                                                    html.find("href=", position));
+
+        if (attribute == std::string::npos)
+        {
+            break;
+        }
+
+        std::string::size_type open = html.find('=', attribute) + 1;
+
+        if (open >= html.size() || (html[open] != '"' && html[open] != '\''))
+        {
+            result.append(html, position, open - position);
+            position = open;
+            continue;
+        }
+
+        std::string::size_type close = html.find(html[open], open + 1);
+
+        if (close == std::string::npos)
+        {
+            break;
+        }
+
+        std::string link = html.substr(open + 1, close - open - 1);
+
+        result.append(html, position, open + 1 - position);
+
+        std::map<std::string, Asset>::const_iterator asset = _assets.find(_resolveLink(name, link));
+
+        if (asset != _assets.end()
+         && !asset->second.isFingerprinted
+         && link.find('?') == std::string::npos)
+        {
+            std::string::size_type fragment = link.find('#');
+            link.insert(std::min(fragment, link.size()),
+                        "?" + VERSION_PARAMETER + "=" + asset->second.fingerprint);
+        }
+
+        result += link;
+        position = close;
+    }
+
+    result.append(html, position, std::string::npos);
+    return result;
+}
+
+
+bool StaticAssetRoute::_compress(const std::string& name,
+                                 const Asset& asset,
+                                 const std::string& data,
+                                 std::string& compressed) const
+{
+    // The cached copy is named for the contents it was made from, e.g.
+    // "js/ofSketch.js.1a2b3c4d5e6f7a8b.gz".
+    Poco::Path cachePath(_cacheDir + name);
+    std::string prefix = cachePath.getFileName() + ".";
+    std::string compressedPath = cachePath.toString() + "." + asset.fingerprint + ".gz";
+
+    try
+    {
+        Poco::File cached(compressedPath);
+
+        if (cached.exists())
+        {
+            Poco::FileInputStream input(compressedPath);
+            Poco::StreamCopier::copyToString(input, compressed);
+            return true;
+        }
+
+        std::ostringstream output;
+
+        Poco::DeflatingOutputStream deflater(output,
+                                             Poco::DeflatingStreamBuf::STREAM_GZIP,
+                                             COMPRESSION_LEVEL);
+        deflater.write(data.data(), data.size());
+        deflater.close();
+
+        compressed = output.str();
+
+        // Some files, like minified fonts, don't get any smaller.
+        if (compressed.size() >= data.size())
+        {
+            return false;
+        }
+
+        Poco::File directory(cachePath.parent());
+        directory.createDirectories();
+
+        // Remove the copies made from earlier versions.
+        std::vector<std::string> files;
+        directory.list(files);
+
+        for (std::size_t i = 0; i < files.size(); ++i)
+        {
+            if (files[i].size() == prefix.size() + FINGERPRINT_LENGTH + 3
+             && files[i].compare(0, prefix.size(), prefix) == 0
+             && Poco::Path(files[i]).getExtension() == "gz")
+            {
+                Poco::File(Poco::Path(cachePath.parent(), files[i])).remove();
+            }
+        }
+
+        FileTransaction transaction(FileTransaction::DURABILITY_NONE);
+
+        if (!transaction.write(compressedPath, compressed) || !transaction.commit())
+        {
+            ofLogWarning("StaticAssetRoute::_compress") << "Unable to cache " << compressedPath;
+        }
+
+        return true;
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogWarning("StaticAssetRoute::_compress") << "Unable to compress " << name << ": " << exc.displayText();
+        return false;
+    }
+}
+
+
+std::string StaticAssetRoute::_getName(const std::string& path) const
+{
+    if (path.compare(0, _documentRoot.size(), _documentRoot) != 0)
+    {
+        return "";
+    }
+
+    std::string name = path.substr(_documentRoot.size());
+    std::replace(name.begin(), name.end(), '\\', '/');
+    return name;
+}
+
+
+std::string StaticAssetRoute::_getAssetName(const std::string& uri)
+{
+    std::string path;
+
+    try
+    {
+        path = Poco::URI(uri).getPath();
+    }
+    catch (const Poco::SyntaxException& exc)
+    {
+        return "";
+    }
+
+    if (!path.empty() && path[0] == '/')
+    {
+        path.erase(0, 1);
+    }
+
+    if (path.empty() || path[path.size() - 1] == '/')
+    {
+        path += DEFAULT_DOCUMENT;
+    }
+
+    return path;
+}
+
+
+std::string StaticAssetRoute::_getVersion(const std::string& uri)
+{
+    std::string query;
+
+    try
+    {
+        query = Poco::URI(uri).getQuery();
+    }
+    catch (const Poco::SyntaxException& exc)
+    {
+        return "";
+    }
+
+    Poco::StringTokenizer parameters(query, "&", Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+
+    for (std::size_t i = 0; i < parameters.count(); ++i)
+    {
+        if (parameters[i].compare(0, VERSION_PARAMETER.size() + 1, VERSION_PARAMETER + "=") == 0)
+        {
+            return parameters[i].substr(VERSION_PARAMETER.size() + 1);
+        }
+    }
+
+    return "";
+}
+
+
+std::string StaticAssetRoute::_resolveLink(const std::string& page,
+                                           const std::string& link)
+{
+    std::string path = link.substr(0, link.find_first_of("?#"));
+
+    if (path.empty()
+     || path.compare(0, 2, "//") == 0
+     || path.find(':') != std::string::npos)
+    {
+        // Another host, or a data:, mailto: or javascript: link.
+        return "";
+    }
+
+    if (path[0] == '/')
+    {
+        path.erase(0, 1);
+    }
+    else
+    {
+        path = page.substr(0, page.rfind('/') + 1) + path;
+    }
+
+    std::vector<std::string> segments;
+    Poco::StringTokenizer parts(path, "/");
+
+    for (std::size_t i = 0; i < parts.count(); ++i)
+    {
+        if (parts[i] == "..")
+        {
+            if (segments.empty())
+            {
+                return "";
+            }
+
+            segments.pop_back();
+        }
+        else if (!parts[i].empty() && parts[i] != ".")
+        {
+            segments.push_back(parts[i]);
+        }
+    }
+
+    std::string name;
+
+    for (std::size_t i = 0; i < segments.size(); ++i)
+    {
+        name += (i > 0 ? "/" : "") + segments[i];
+    }
+
+    return name;
+}
+
+
+bool StaticAssetRoute::_isCompressible(const std::string& path)
+{
+    std::string extension = Poco::toLower(Poco::Path(path).getExtension());
+
+    return extension == "html"
+        || extension == "htm"
+        || extension == "js"
+        || extension == "css"
+        || extension == "json"
+        || extension == "map"
+        || extension == "svg"
+        || extension == "txt"
+        || extension == "xml"
+        || extension == "ttf"
+        || extension == "eot"
+        || extension == "otf";
+}
+
+
+bool StaticAssetRoute::_isHTML(const std::string& path)
+{
+    std::string extension = Poco::toLower(Poco::Path(path).getExtension());
+    return extension == "html" || extension == "htm";
+}
+
+
+} } // namespace of::Sketch
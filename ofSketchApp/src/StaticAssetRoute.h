@@ -0,0 +1,160 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/Timestamp.h"
+#include "ofxHTTP.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Serves the DocumentRoot from memory, compressed when the browser
+///        accepts it.  Changes are only seen after a restart.
+class StaticAssetRoute: public ofx::HTTP::BaseRoute
+{
+public:
+    typedef std::shared_ptr<StaticAssetRoute> SharedPtr;
+
+    StaticAssetRoute(const std::string& documentRoot,
+                     const std::string& cacheDir);
+
+    virtual ~StaticAssetRoute();
+
+    /// \brief Load the assets.  Must be called before the server starts.
+    void setup();
+
+    bool canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                          bool isSecurePort) const;
+
+    void handleRequest(Poco::Net::HTTPServerRequest& request,
+                       Poco::Net::HTTPServerResponse& response);
+
+    static bool acceptsEncoding(const std::string& acceptEncoding,
+                                const std::string& coding);
+
+    static bool matchesETag(const std::string& ifNoneMatch,
+                            const std::string& etag);
+
+    /// \returns true for a name with a content hash, e.g. "app.3f2a9c1b.js".
+    static bool isFingerprinted(const std::string& path);
+
+    static SharedPtr makeShared(const std::string& documentRoot,
+                                const std::string& cacheDir)
+    {
+        return SharedPtr(new StaticAssetRoute(documentRoot, cacheDir));
+    }
+
+    static const std::string DEFAULT_DOCUMENT;
+    static const std::string GZIP_ENCODING;
+    static const std::string BROTLI_ENCODING;
+
+    static const std::string VERSION_PARAMETER;
+
+    static const std::string IMMUTABLE_CACHE_CONTROL;
+    static const std::string REVALIDATE_CACHE_CONTROL;
+
+    enum
+    {
+        MINIMUM_COMPRESSED_SIZE = 1024,
+
+        /// \brief Larger files are left to the file system route.
+        MAXIMUM_ASSET_SIZE = 32 * 1024 * 1024,
+
+        COMPRESSION_LEVEL = 9,
+        FINGERPRINT_LENGTH = 16,
+        MINIMUM_FINGERPRINT_LENGTH = 8
+    };
+
+private:
+    struct Representation
+    {
+        std::string data;
+        std::string etag;
+    };
+
+    struct Asset
+    {
+        Asset();
+
+        std::string mediaType;
+
+        std::string fingerprint;
+
+        Poco::Timestamp lastModified;
+
+        bool isFingerprinted;
+
+        /// \brief By content coding, "" for the asset itself.
+        std::map<std::string, Representation> representations;
+    };
+
+    std::string _documentRoot;
+    std::string _cacheDir;
+
+    /// \brief Only changed by setup().
+    std::map<std::string, Asset> _assets;
+
+    void _findAssets(const std::string& path, std::vector<std::string>& paths) const;
+
+    void _addAsset(const std::string& path);
+
+    void _encode(const std::string& name, Asset& asset, const std::string& data) const;
+
+    /// \brief Stamp the links in a page with their assets' versions.
+    std::string _stampLinks(const std::string& name, const std::string& html) const;
+
+    /// \brief Gzip an asset, or use the cached copy of the same contents.
+    bool _compress(const std::string& name,
+                   const Asset& asset,
+                   const std::string& data,
+                   std::string& compressed) const;
+
+    std::string _getName(const std::string& path) const;
+
+    static std::string _getAssetName(const std::string& uri);
+
+    static std::string _getVersion(const std::string& uri);
+
+    /// \returns the asset name, or "" if it points outside the root.
+    static std::string _resolveLink(const std::string& page,
+                                    const std::string& link);
+
+    static bool _isCompressible(const std::string& path);
+
+    static bool _isHTML(const std::string& path);
+
+};
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,85 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "Symbol.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+Symbol::Symbol():
+    name(""),
+    scope(""),
+    signature(""),
+    file(""),
+    line(0),
+    kind(KIND_FUNCTION)
+{
+}
+
+
+Json::Value Symbol::toJson() const
+{
+    Json::Value json;
+    json["name"] = name;
+    json["scope"] = scope;
+    json["signature"] = signature;
+    json["file"] = file;
+    json["line"] = Json::UInt64(line);
+    json["kind"] = toString(kind);
+    return json;
+}
+
+
+std::string Symbol::toString(Kind kind)
+{
+    switch (kind)
+    {
+        case KIND_CLASS:
+            return "class";
+        case KIND_FUNCTION:
+            return "function";
+        case KIND_METHOD:
+            return "method";
+        case KIND_FIELD:
+            return "field";
+        case KIND_VARIABLE:
+            return "variable";
+        case KIND_ENUM:
+            return "enum";
+        case KIND_ENUMERATOR:
+            return "enumerator";
+        case KIND_TYPEDEF:
+            return "typedef";
+        case KIND_MACRO:
+            return "macro";
+    }
+
+    return "unknown";
+}
+
+
+} } // namespace of::Sketch
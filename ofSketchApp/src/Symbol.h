@@ -0,0 +1,73 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <json/json.h>
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief A declaration found in a header or a generated source.
+struct Symbol
+{
+    enum Kind
+    {
+        KIND_CLASS,
+        KIND_FUNCTION,
+        KIND_METHOD,
+        KIND_FIELD,
+        KIND_VARIABLE,
+        KIND_ENUM,
+        KIND_ENUMERATOR,
+        KIND_TYPEDEF,
+        KIND_MACRO
+    };
+
+    Symbol();
+
+    std::string name;
+
+    std::string scope; // e.g. ofx::HTTP, or the class a member belongs to
+
+    std::string signature; // e.g. void ofDrawCircle(float x, float y, float radius)
+
+    std::string file;
+
+    std::size_t line; // Counting from 1.
+
+    Kind kind;
+
+    Json::Value toJson() const;
+
+    static std::string toString(Kind kind);
+};
+
+
+} } // namespace of::Sketch
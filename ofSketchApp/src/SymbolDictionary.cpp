@@ -0,0 +1,620 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "SymbolDictionary.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <map>
+#include "Poco/Exception.h"
+#include "Poco/File.h"
+#include "Poco/String.h"
+#include "ofLog.h"
+#include "Utils.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+const char SymbolDictionary::MAGIC[4] = { 'O', 'F', 'S', 'D' };
+
+
+namespace {
+
+
+struct TrieNode
+{
+    unsigned char label;
+    std::map<unsigned char, std::size_t> children;
+    std::vector<std::size_t> entries;
+};
+
+
+struct SortedEntry
+{
+    std::string key;
+    const SymbolDictionary::Entry* entry;
+
+    bool operator < (const SortedEntry& other) const
+    {
+        if (key != other.key) return key < other.key;
+        if (entry->library != other.entry->library) return entry->library < other.entry->library;
+        return entry->name < other.entry->name;
+    }
+};
+
+
+struct Candidate
+{
+    std::size_t distance;
+    std::size_t entry;
+
+    bool operator < (const Candidate& other) const
+    {
+        // Entries are stored breadth first, i.e. shortest name first.
+        return distance != other.distance ? distance < other.distance : entry < other.entry;
+    }
+};
+
+
+struct SearchFrame
+{
+    std::size_t node;
+    std::vector<std::size_t> row;
+    std::vector<std::size_t> parentRow;
+    std::size_t distance;
+};
+
+
+}
+
+
+SymbolDictionary::Entry::Entry():
+    name(""),
+    library(""),
+    kind(Symbol::KIND_FUNCTION)
+{
+}
+
+
+SymbolDictionary::Match::Match():
+    distance(0)
+{
+}
+
+
+Json::Value SymbolDictionary::Match::toJson() const
+{
+    Json::Value json;
+    json["name"] = name;
+    json["library"] = library;
+    json["kind"] = Symbol::toString(kind);
+    json["distance"] = Json::UInt64(distance);
+    return json;
+}
+
+
+SymbolDictionary::SymbolDictionary():
+    _header(0),
+    _nodes(0),
+    _entries(0),
+    _strings(0)
+{
+}
+
+
+bool SymbolDictionary::load(const std::string& path)
+{
+    clear();
+
+    try
+    {
+        Poco::File file(path);
+
+        if (!file.exists() || file.getSize() < sizeof(Header))
+        {
+            return false;
+        }
+
+        _memory = new Poco::SharedMemory(file, Poco::SharedMemory::AM_READ);
+
+        if (_map(_memory->begin(), _memory->end() - _memory->begin()))
+        {
+            return true;
+        }
+
+        ofLogWarning("SymbolDictionary::load") << "Ignoring an invalid symbol dictionary: " << path;
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogError("SymbolDictionary::load") << "Unable to map " << path << ": " << exc.displayText();
+    }
+
+    clear();
+    return false;
+}
+
+
+bool SymbolDictionary::assign(const std::string& data)
+{
+    clear();
+
+    _data = data;
+
+    if (_map(_data.data(), _data.size()))
+    {
+        return true;
+    }
+
+    clear();
+    return false;
+}
+
+
+void SymbolDictionary::clear()
+{
+    _header = 0;
+    _nodes = 0;
+    _entries = 0;
+    _strings = 0;
+    _memory = 0;
+    _data.clear();
+}
+
+
+std::size_t SymbolDictionary::size() const
+{
+    return _header ? _header->entryCount : 0;
+}
+
+
+void SymbolDictionary::complete(const std::string& prefix,
+                                std::size_t limit,
+                                std::vector<Match>& matches) const
+{
+    if (!_header || limit == 0)
+    {
+        return;
+    }
+
+    std::string key = Poco::toLower(prefix);
+    const NodeRecord* node = _nodes;
+
+    for (std::size_t i = 0; i < key.size() && node; ++i)
+    {
+        node = _findChild(*node, key[i]);
+    }
+
+    if (!node)
+    {
+        return;
+    }
+
+    // Breadth first, so shorter names come first.
+    std::deque<std::size_t> queue;
+    queue.push_back(node - _nodes);
+
+    while (!queue.empty())
+    {
+        const NodeRecord& current = _nodes[queue.front()];
+        queue.pop_front();
+
+        if (!_addEntries(current, 0, limit, matches))
+        {
+            return;
+        }
+
+        for (std::size_t i = 0; i < current.childCount; ++i)
+        {
+            queue.push_back(current.firstChild + i);
+        }
+    }
+}
+
+
+void SymbolDictionary::findSimilar(const std::string& prefix,
+                                   std::size_t maxDistance,
+                                   std::size_t limit,
+                                   std::vector<Match>& matches) const
+{
+    if (!_header || limit == 0 || prefix.empty())
+    {
+        return;
+    }
+
+    std::string key = Poco::toLower(prefix);
+    std::size_t n = key.size();
+
+    // Otherwise every name would be within reach.
+    maxDistance = std::min(maxDistance, n - 1);
+
+    const std::size_t none = std::size_t(-1);
+
+    // A depth first walk of the trie that keeps the row of the edit
+    // distance table for the path to each node.  The last column is the
+    // distance between the query and the path; subtrees whose row is all
+    // over maxDistance can't get any closer and are skipped.  Swapping two
+    // neighbouring characters counts as one edit.
+    std::vector<Candidate> candidates;
+    std::vector<SearchFrame> stack(1);
+
+    stack.back().node = 0;
+    stack.back().distance = none;
+
+    for (std::size_t j = 0; j <= n; ++j)
+    {
+        stack.back().row.push_back(j);
+    }
+
+    std::size_t visited = 0;
+
+    while (!stack.empty() && visited < MAXIMUM_SEARCH_NODES)
+    {
+        SearchFrame frame;
+        frame.node = stack.back().node;
+        frame.row.swap(stack.back().row);
+        frame.parentRow.swap(stack.back().parentRow);
+        frame.distance = stack.back().distance;
+        stack.pop_back();
+
+        const NodeRecord& node = _nodes[frame.node];
+
+        for (std::size_t i = 0; i < node.childCount; ++i, ++visited)
+        {
+            std::size_t childIndex = node.firstChild + i;
+            const NodeRecord& child = _nodes[childIndex];
+
+            std::vector<std::size_t> row(n + 1);
+            row[0] = frame.row[0] + 1;
+            std::size_t minimum = row[0];
+
+            for (std::size_t j = 1; j <= n; ++j)
+            {
+                std::size_t substitution = frame.row[j - 1] + (key[j - 1] == child.label ? 0 : 1);
+                row[j] = std::min(std::min(frame.row[j] + 1, row[j - 1] + 1), substitution);
+
+                if (j > 1
+                 && !frame.parentRow.empty()
+                 && key[j - 1] == node.label
+                 && key[j - 2] == child.label)
+                {
+                    row[j] = std::min(row[j], frame.parentRow[j - 2] + 1);
+                }
+
+                minimum = std::min(minimum, row[j]);
+            }
+
+            std::size_t distance = frame.distance;
+
+            if (row[n] <= maxDistance && (distance == none || row[n] < distance))
+            {
+                distance = row[n];
+            }
+
+            // Names under an exact prefix are found by complete().
+            if (distance == 0)
+            {
+                continue;
+            }
+
+            if (distance != none)
+            {
+                for (std::size_t j = 0; j < child.entryCount; ++j)
+                {
+                    Candidate candidate;
+                    candidate.distance = distance;
+                    candidate.entry = child.firstEntry + j;
+                    candidates.push_back(candidate);
+                }
+            }
+
+            if (minimum <= maxDistance || distance != none)
+            {
+                stack.push_back(SearchFrame());
+                stack.back().node = childIndex;
+                stack.back().row.swap(row);
+                stack.back().parentRow = frame.row;
+                stack.back().distance = distance;
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+
+    for (std::size_t i = 0; i < candidates.size() && i < limit; ++i)
+    {
+        const EntryRecord& record = _entries[candidates[i].entry];
+
+        Match match;
+        match.name = _getString(record.name);
+        match.library = _getString(record.library);
+        match.kind = static_cast<Symbol::Kind>(record.kind);
+        match.distance = candidates[i].distance;
+        matches.push_back(match);
+    }
+}
+
+
+std::string SymbolDictionary::serialize(const std::vector<Entry>& entries)
+{
+    std::vector<SortedEntry> sorted;
+
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        if (!entries[i].name.empty())
+        {
+            SortedEntry entry;
+            entry.key = Poco::toLower(entries[i].name);
+            entry.entry = &entries[i];
+            sorted.push_back(entry);
+        }
+    }
+
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<TrieNode> trie(1);
+    trie[0].label = 0;
+
+    for (std::size_t i = 0; i < sorted.size(); ++i)
+    {
+        if (i > 0
+         && sorted[i].key == sorted[i - 1].key
+         && sorted[i].entry->library == sorted[i - 1].entry->library
+         && sorted[i].entry->name == sorted[i - 1].entry->name)
+        {
+            continue;
+        }
+
+        std::size_t node = 0;
+
+        for (std::size_t j = 0; j < sorted[i].key.size(); ++j)
+        {
+            unsigned char label = sorted[i].key[j];
+            std::map<unsigned char, std::size_t>::const_iterator iter = trie[node].children.find(label);
+
+            if (iter != trie[node].children.end())
+            {
+                node = iter->second;
+            }
+            else
+            {
+                trie.push_back(TrieNode());
+                trie.back().label = label;
+                trie[node].children[label] = trie.size() - 1;
+                node = trie.size() - 1;
+            }
+        }
+
+        if (trie[node].entries.size() < 0xFFFF)
+        {
+            trie[node].entries.push_back(i);
+        }
+    }
+
+    std::string strings(1, '\0');
+    std::map<std::string, Poco::UInt32> stringOffsets;
+    stringOffsets[""] = 0;
+
+    // Breadth first, which keeps the children of each node together.
+    std::vector<std::size_t> order(1, 0);
+    std::vector<NodeRecord> nodeRecords;
+    std::vector<EntryRecord> entryRecords;
+
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        const TrieNode& node = trie[order[i]];
+
+        NodeRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.label = node.label;
+        record.firstChild = order.size();
+        record.childCount = node.children.size();
+        record.firstEntry = entryRecords.size();
+        record.entryCount = node.entries.size();
+        nodeRecords.push_back(record);
+
+        std::map<unsigned char, std::size_t>::const_iterator iter = node.children.begin();
+
+        for (; iter != node.children.end(); ++iter)
+        {
+            order.push_back(iter->second);
+        }
+
+        for (std::size_t j = 0; j < node.entries.size(); ++j)
+        {
+            const Entry& entry = *sorted[node.entries[j]].entry;
+            const std::string* texts[2] = { &entry.name, &entry.library };
+            Poco::UInt32 offsets[2];
+
+            for (std::size_t k = 0; k < 2; ++k)
+            {
+                std::map<std::string, Poco::UInt32>::const_iterator offset = stringOffsets.find(*texts[k]);
+
+                if (offset == stringOffsets.end())
+                {
+                    offset = stringOffsets.insert(std::make_pair(*texts[k], Poco::UInt32(strings.size()))).first;
+                    strings.append(texts[k]->c_str(), texts[k]->size() + 1);
+                }
+
+                offsets[k] = offset->second;
+            }
+
+            EntryRecord entryRecord;
+            entryRecord.name = offsets[0];
+            entryRecord.library = offsets[1];
+            entryRecord.kind = entry.kind;
+            entryRecords.push_back(entryRecord);
+        }
+    }
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.nodeCount = nodeRecords.size();
+    header.entryCount = entryRecords.size();
+    header.nodesOffset = sizeof(Header);
+    header.entriesOffset = header.nodesOffset + nodeRecords.size() * sizeof(NodeRecord);
+    header.stringsOffset = header.entriesOffset + entryRecords.size() * sizeof(EntryRecord);
+    header.stringsSize = strings.size();
+
+    std::string data;
+    data.reserve(header.stringsOffset + header.stringsSize);
+    data.append(reinterpret_cast<const char*>(&header), sizeof(Header));
+    data.append(reinterpret_cast<const char*>(&nodeRecords[0]), nodeRecords.size() * sizeof(NodeRecord));
+
+    if (!entryRecords.empty())
+    {
+        data.append(reinterpret_cast<const char*>(&entryRecords[0]), entryRecords.size() * sizeof(EntryRecord));
+    }
+
+    data.append(strings);
+
+    return data;
+}
+
+
+std::vector<std::string> SymbolDictionary::loadFunctionNames(const std::string& path)
+{
+    std::vector<std::string> names;
+    Json::Value json;
+
+    if (Utils::JSONfromFile(path, json))
+    {
+        const Json::Value& functions = json["globalFunctions"];
+
+        for (unsigned int i = 0; i < functions.size(); ++i)
+        {
+            names.push_back(functions[i].asString());
+        }
+    }
+    else ofLogError("SymbolDictionary::loadFunctionNames") << "Unable to load " << path;
+
+    return names;
+}
+
+
+bool SymbolDictionary::_map(const char* begin, std::size_t size)
+{
+    if (size < sizeof(Header))
+    {
+        return false;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(begin);
+
+    Poco::UInt64 nodesEnd = Poco::UInt64(header->nodesOffset) + Poco::UInt64(header->nodeCount) * sizeof(NodeRecord);
+    Poco::UInt64 entriesEnd = Poco::UInt64(header->entriesOffset) + Poco::UInt64(header->entryCount) * sizeof(EntryRecord);
+    Poco::UInt64 stringsEnd = Poco::UInt64(header->stringsOffset) + header->stringsSize;
+
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+     || header->version != VERSION
+     || header->nodeCount == 0
+     || nodesEnd > size
+     || entriesEnd > size
+     || stringsEnd > size
+     || header->stringsSize == 0
+     || begin[stringsEnd - 1] != '\0')
+    {
+        return false;
+    }
+
+    const NodeRecord* nodes = reinterpret_cast<const NodeRecord*>(begin + header->nodesOffset);
+
+    // Searches follow these without checking them again.  Children always
+    // come after their parent, so the walks can't loop.
+    for (std::size_t i = 0; i < header->nodeCount; ++i)
+    {
+        if ((nodes[i].childCount > 0 && nodes[i].firstChild <= i)
+         || Poco::UInt64(nodes[i].firstChild) + nodes[i].childCount > header->nodeCount
+         || Poco::UInt64(nodes[i].firstEntry) + nodes[i].entryCount > header->entryCount)
+        {
+            return false;
+        }
+    }
+
+    _header = header;
+    _nodes = nodes;
+    _entries = reinterpret_cast<const EntryRecord*>(begin + header->entriesOffset);
+    _strings = begin + header->stringsOffset;
+    return true;
+}
+
+
+const char* SymbolDictionary::_getString(Poco::UInt32 offset) const
+{
+    return (offset < _header->stringsSize) ? _strings + offset : "";
+}
+
+
+const SymbolDictionary::NodeRecord* SymbolDictionary::_findChild(const NodeRecord& node,
+                                                                 unsigned char c) const
+{
+    const NodeRecord* first = _nodes + node.firstChild;
+    std::size_t count = node.childCount;
+
+    while (count > 0)
+    {
+        std::size_t step = count / 2;
+
+        if (first[step].label < c)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    return (first < _nodes + node.firstChild + node.childCount && first->label == c) ? first : 0;
+}
+
+
+bool SymbolDictionary::_addEntries(const NodeRecord& node,
+                                   std::size_t distance,
+                                   std::size_t& remaining,
+                                   std::vector<Match>& matches) const
+{
+    for (std::size_t i = 0; i < node.entryCount && remaining > 0; ++i)
+    {
+        const EntryRecord& record = _entries[node.firstEntry + i];
+
+        Match match;
+        match.name = _getString(record.name);
+        match.library = _getString(record.library);
+        match.kind = static_cast<Symbol::Kind>(record.kind);
+        match.distance = distance;
+        matches.push_back(match);
+        --remaining;
+    }
+
+    return remaining > 0;
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,154 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include <json/json.h>
+#include "Poco/SharedMemory.h"
+#include "Poco/SharedPtr.h"
+#include "Poco/Types.h"
+#include "Symbol.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief A read only trie of the openFrameworks functions and the addons'
+///        global symbols, laid out breadth first.
+class SymbolDictionary
+{
+public:
+    struct Entry
+    {
+        Entry();
+
+        std::string name;
+
+        std::string library; // e.g. openFrameworks or ofxGui
+
+        Symbol::Kind kind;
+    };
+
+    struct Match: public Entry
+    {
+        Match();
+
+        std::size_t distance; // 0 for a prefix match
+
+        Json::Value toJson() const;
+    };
+
+    SymbolDictionary();
+
+    /// \returns false if the file is missing or not a valid dictionary.
+    bool load(const std::string& path);
+
+    bool assign(const std::string& data);
+
+    void clear();
+
+    std::size_t size() const;
+
+    void complete(const std::string& prefix,
+                  std::size_t limit,
+                  std::vector<Match>& matches) const;
+
+    /// \brief Find names within maxDistance edits of prefix, closest first.
+    void findSimilar(const std::string& prefix,
+                     std::size_t maxDistance,
+                     std::size_t limit,
+                     std::vector<Match>& matches) const;
+
+    static std::string serialize(const std::vector<Entry>& entries);
+
+    static std::vector<std::string> loadFunctionNames(const std::string& path);
+
+    enum
+    {
+        VERSION = 1,
+
+        MAXIMUM_SEARCH_NODES = 200000
+    };
+
+private:
+    struct Header
+    {
+        char magic[4];
+        Poco::UInt32 version;
+        Poco::UInt32 nodeCount;
+        Poco::UInt32 entryCount;
+        Poco::UInt32 nodesOffset;
+        Poco::UInt32 entriesOffset;
+        Poco::UInt32 stringsOffset;
+        Poco::UInt32 stringsSize;
+    };
+
+    struct NodeRecord
+    {
+        Poco::UInt32 firstChild;
+        Poco::UInt32 firstEntry;
+        Poco::UInt16 childCount;
+        Poco::UInt16 entryCount;
+        Poco::UInt8 label;
+        Poco::UInt8 reserved[3];
+    };
+
+    struct EntryRecord
+    {
+        Poco::UInt32 name;
+        Poco::UInt32 library;
+        Poco::UInt32 kind;
+    };
+
+    Poco::SharedPtr<Poco::SharedMemory> _memory;
+    std::string _data;
+
+    const Header* _header;
+    const NodeRecord* _nodes;
+    const EntryRecord* _entries;
+    const char* _strings;
+
+    bool _map(const char* begin, std::size_t size);
+
+    const char* _getString(Poco::UInt32 offset) const;
+
+    const NodeRecord* _findChild(const NodeRecord& node, unsigned char c) const;
+
+    /// \returns false once remaining reaches 0.
+    bool _addEntries(const NodeRecord& node,
+                     std::size_t distance,
+                     std::size_t& remaining,
+                     std::vector<Match>& matches) const;
+
+    static const char MAGIC[4];
+
+};
+
+
+} } // namespace of::Sketch
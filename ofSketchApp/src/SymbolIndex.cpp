@@ -0,0 +1,500 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "SymbolIndex.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include "Poco/Exception.h"
+#include "Poco/File.h"
+#include "Poco/Path.h"
+#include "ofLog.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+const char SymbolIndex::MAGIC[4] = { 'O', 'F', 'S', 'I' };
+
+
+namespace {
+
+
+struct Entry
+{
+    std::string key;
+    const Symbol* symbol;
+    Poco::UInt32 file;
+
+    bool operator < (const Entry& other) const
+    {
+        return key < other.key;
+    }
+};
+
+
+std::string toLower(const std::string& text)
+{
+    std::string result(text);
+
+    for (std::size_t i = 0; i < result.size(); ++i)
+    {
+        result[i] = std::tolower(static_cast<unsigned char>(result[i]));
+    }
+
+    return result;
+}
+
+
+class StringTable
+{
+public:
+    StringTable()
+    {
+        add("");
+    }
+
+    Poco::UInt32 add(const std::string& text)
+    {
+        std::map<std::string, Poco::UInt32>::const_iterator iter = _offsets.find(text);
+
+        if (iter != _offsets.end())
+        {
+            return iter->second;
+        }
+
+        Poco::UInt32 offset = _data.size();
+        _data.append(text.c_str(), text.size() + 1);
+        _offsets[text] = offset;
+        return offset;
+    }
+
+    const std::string& getData() const
+    {
+        return _data;
+    }
+
+private:
+    std::string _data;
+    std::map<std::string, Poco::UInt32> _offsets;
+
+};
+
+
+}
+
+
+SymbolIndex::File::File():
+    path(""),
+    modified(0)
+{
+}
+
+
+SymbolIndex::SymbolIndex():
+    _header(0),
+    _files(0),
+    _symbols(0),
+    _strings(0)
+{
+}
+
+
+bool SymbolIndex::load(const std::string& path)
+{
+    clear();
+
+    try
+    {
+        Poco::File file(path);
+
+        if (!file.exists() || file.getSize() < sizeof(Header))
+        {
+            return false;
+        }
+
+        _memory = new Poco::SharedMemory(file, Poco::SharedMemory::AM_READ);
+
+        if (_map(_memory->begin(), _memory->end() - _memory->begin()))
+        {
+            return true;
+        }
+
+        ofLogWarning("SymbolIndex::load") << "Ignoring an invalid symbol index: " << path;
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogError("SymbolIndex::load") << "Unable to map " << path << ": " << exc.displayText();
+    }
+
+    clear();
+    return false;
+}
+
+
+bool SymbolIndex::assign(const std::string& data)
+{
+    clear();
+
+    _data = data;
+
+    if (_map(_data.data(), _data.size()))
+    {
+        return true;
+    }
+
+    clear();
+    return false;
+}
+
+
+void SymbolIndex::clear()
+{
+    _header = 0;
+    _files = 0;
+    _symbols = 0;
+    _strings = 0;
+    _memory = 0;
+    _data.clear();
+}
+
+
+std::size_t SymbolIndex::size() const
+{
+    return _header ? _header->symbolCount : 0;
+}
+
+
+void SymbolIndex::complete(const std::string& prefix,
+                           const std::string& scope,
+                           std::size_t limit,
+                           std::vector<Symbol>& results) const
+{
+    if (!_header)
+    {
+        return;
+    }
+
+    std::string key = toLower(prefix);
+
+    for (std::size_t i = _lowerBound(key); i < _header->symbolCount && limit > 0; ++i)
+    {
+        const SymbolRecord& record = _symbols[i];
+
+        if (_compare(_getString(record.name), key, key.size()) != 0)
+        {
+            break;
+        }
+
+        if (_isInScope(record, scope))
+        {
+            results.push_back(_getSymbol(record));
+            --limit;
+        }
+    }
+}
+
+
+void SymbolIndex::find(const std::string& name,
+                       const std::string& scope,
+                       std::vector<Symbol>& results) const
+{
+    if (!_header)
+    {
+        return;
+    }
+
+    std::string key = toLower(name);
+
+    for (std::size_t i = _lowerBound(key); i < _header->symbolCount; ++i)
+    {
+        const SymbolRecord& record = _symbols[i];
+        const char* recordName = _getString(record.name);
+
+        if (_compare(recordName, key, key.size() + 1) != 0)
+        {
+            break;
+        }
+
+        if (name == recordName && _isInScope(record, scope))
+        {
+            results.push_back(_getSymbol(record));
+        }
+    }
+}
+
+
+void SymbolIndex::getFiles(std::vector<File>& files) const
+{
+    files.clear();
+
+    for (std::size_t i = 0; _header && i < _header->fileCount; ++i)
+    {
+        File file;
+        file.path = _getString(_files[i].path);
+        file.modified = _files[i].modified;
+        files.push_back(file);
+    }
+}
+
+
+void SymbolIndex::getSymbols(std::vector<std::vector<Symbol> >& symbols) const
+{
+    symbols.clear();
+
+    if (!_header)
+    {
+        return;
+    }
+
+    symbols.resize(_header->fileCount);
+
+    for (std::size_t i = 0; i < _header->symbolCount; ++i)
+    {
+        if (_symbols[i].file < symbols.size())
+        {
+            symbols[_symbols[i].file].push_back(_getSymbol(_symbols[i]));
+        }
+    }
+}
+
+
+std::string SymbolIndex::serialize(const std::vector<File>& files,
+                                   const std::vector<std::vector<Symbol> >& symbols)
+{
+    std::vector<Entry> entries;
+
+    for (std::size_t i = 0; i < files.size() && i < symbols.size(); ++i)
+    {
+        for (std::size_t j = 0; j < symbols[i].size(); ++j)
+        {
+            Entry entry;
+            entry.key = toLower(symbols[i][j].name);
+            entry.symbol = &symbols[i][j];
+            entry.file = i;
+            entries.push_back(entry);
+        }
+    }
+
+    std::stable_sort(entries.begin(), entries.end());
+
+    StringTable strings;
+
+    std::vector<FileRecord> fileRecords(files.size());
+
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        fileRecords[i].path = strings.add(files[i].path);
+        fileRecords[i].reserved = 0;
+        fileRecords[i].modified = files[i].modified;
+    }
+
+    std::vector<SymbolRecord> symbolRecords(entries.size());
+
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        const Symbol& symbol = *entries[i].symbol;
+        symbolRecords[i].name = strings.add(symbol.name);
+        symbolRecords[i].scope = strings.add(symbol.scope);
+        symbolRecords[i].signature = strings.add(symbol.signature);
+        symbolRecords[i].file = entries[i].file;
+        symbolRecords[i].line = symbol.line;
+        symbolRecords[i].kind = symbol.kind;
+    }
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.fileCount = fileRecords.size();
+    header.symbolCount = symbolRecords.size();
+    header.filesOffset = sizeof(Header);
+    header.symbolsOffset = header.filesOffset + fileRecords.size() * sizeof(FileRecord);
+    header.stringsOffset = header.symbolsOffset + symbolRecords.size() * sizeof(SymbolRecord);
+    header.stringsSize = strings.getData().size();
+
+    std::string data;
+    data.reserve(header.stringsOffset + header.stringsSize);
+    data.append(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+    if (!fileRecords.empty())
+    {
+        data.append(reinterpret_cast<const char*>(&fileRecords[0]), fileRecords.size() * sizeof(FileRecord));
+    }
+
+    if (!symbolRecords.empty())
+    {
+        data.append(reinterpret_cast<const char*>(&symbolRecords[0]), symbolRecords.size() * sizeof(SymbolRecord));
+    }
+
+    data.append(strings.getData());
+
+    return data;
+}
+
+
+bool SymbolIndex::save(const std::string& path,
+                       const std::string& data,
+                       FileTransaction::Durability durability)
+{
+    try
+    {
+        Poco::File(Poco::Path(path).parent()).createDirectories();
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogError("SymbolIndex::save") << "Unable to create the index folder: " << exc.displayText();
+        return false;
+    }
+
+    // The rename leaves indexes that are already mapped untouched.
+    FileTransaction transaction(durability);
+    return transaction.write(path, data) && transaction.commit();
+}
+
+
+bool SymbolIndex::_map(const char* begin, std::size_t size)
+{
+    if (size < sizeof(Header))
+    {
+        return false;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(begin);
+
+    Poco::UInt64 filesEnd = Poco::UInt64(header->filesOffset) + Poco::UInt64(header->fileCount) * sizeof(FileRecord);
+    Poco::UInt64 symbolsEnd = Poco::UInt64(header->symbolsOffset) + Poco::UInt64(header->symbolCount) * sizeof(SymbolRecord);
+    Poco::UInt64 stringsEnd = Poco::UInt64(header->stringsOffset) + header->stringsSize;
+
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+     || header->version != VERSION
+     || filesEnd > size
+     || symbolsEnd > size
+     || stringsEnd > size
+     || header->stringsSize == 0
+     || begin[stringsEnd - 1] != '\0')
+    {
+        return false;
+    }
+
+    _header = header;
+    _files = reinterpret_cast<const FileRecord*>(begin + header->filesOffset);
+    _symbols = reinterpret_cast<const SymbolRecord*>(begin + header->symbolsOffset);
+    _strings = begin + header->stringsOffset;
+    return true;
+}
+
+
+const char* SymbolIndex::_getString(Poco::UInt32 offset) const
+{
+    return (offset < _header->stringsSize) ? _strings + offset : "";
+}
+
+
+Symbol SymbolIndex::_getSymbol(const SymbolRecord& record) const
+{
+    Symbol symbol;
+    symbol.name = _getString(record.name);
+    symbol.scope = _getString(record.scope);
+    symbol.signature = _getString(record.signature);
+    symbol.line = record.line;
+    symbol.kind = static_cast<Symbol::Kind>(record.kind);
+
+    if (record.file < _header->fileCount)
+    {
+        symbol.file = _getString(_files[record.file].path);
+    }
+
+    return symbol;
+}
+
+
+bool SymbolIndex::_isInScope(const SymbolRecord& record, const std::string& scope) const
+{
+    if (scope.empty())
+    {
+        return true;
+    }
+
+    const char* recordScope = _getString(record.scope);
+    std::size_t length = std::strlen(recordScope);
+
+    // ofVec3f matches both ofVec3f and a qualified ns::ofVec3f.
+    return length >= scope.size()
+        && scope.compare(0, scope.size(), recordScope + length - scope.size()) == 0
+        && (length == scope.size() || recordScope[length - scope.size() - 1] == ':');
+}
+
+
+std::size_t SymbolIndex::_lowerBound(const std::string& name) const
+{
+    std::size_t first = 0;
+    std::size_t count = _header->symbolCount;
+
+    while (count > 0)
+    {
+        std::size_t step = count / 2;
+        std::size_t middle = first + step;
+
+        if (_compare(_getString(_symbols[middle].name), name, name.size() + 1) < 0)
+        {
+            first = middle + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    return first;
+}
+
+
+int SymbolIndex::_compare(const char* left, const std::string& right, std::size_t length)
+{
+    // right is already lower case.  Comparing the terminating zero as well
+    // compares whole names.
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        unsigned char l = std::tolower(static_cast<unsigned char>(left[i]));
+        unsigned char r = (i < right.size()) ? static_cast<unsigned char>(right[i]) : 0;
+
+        if (l != r)
+        {
+            return (l < r) ? -1 : 1;
+        }
+        else if (l == 0)
+        {
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,148 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include "Poco/SharedMemory.h"
+#include "Poco/SharedPtr.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Types.h"
+#include "FileTransaction.h"
+#include "Symbol.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief A read only table of symbols sorted by name, which is memory
+///        mapped and searched in place.
+class SymbolIndex
+{
+public:
+    struct File
+    {
+        File();
+
+        std::string path;
+        Poco::Timestamp::TimeVal modified;
+    };
+
+    SymbolIndex();
+
+    /// \returns false if the file is missing or not a valid index.
+    bool load(const std::string& path);
+
+    bool assign(const std::string& data);
+
+    void clear();
+
+    std::size_t size() const;
+
+    /// \param scope If not empty, only symbols declared in this scope.
+    void complete(const std::string& prefix,
+                  const std::string& scope,
+                  std::size_t limit,
+                  std::vector<Symbol>& results) const;
+
+    void find(const std::string& name,
+              const std::string& scope,
+              std::vector<Symbol>& results) const;
+
+    void getFiles(std::vector<File>& files) const;
+
+    void getSymbols(std::vector<std::vector<Symbol> >& symbols) const;
+
+    static std::string serialize(const std::vector<File>& files,
+                                 const std::vector<std::vector<Symbol> >& symbols);
+
+    static bool save(const std::string& path,
+                     const std::string& data,
+                     FileTransaction::Durability durability);
+
+    enum
+    {
+        VERSION = 1
+    };
+
+private:
+    struct Header
+    {
+        char magic[4];
+        Poco::UInt32 version;
+        Poco::UInt32 fileCount;
+        Poco::UInt32 symbolCount;
+        Poco::UInt32 filesOffset;
+        Poco::UInt32 symbolsOffset;
+        Poco::UInt32 stringsOffset;
+        Poco::UInt32 stringsSize;
+    };
+
+    struct FileRecord
+    {
+        Poco::UInt32 path;
+        Poco::UInt32 reserved;
+        Poco::Int64 modified;
+    };
+
+    struct SymbolRecord
+    {
+        Poco::UInt32 name;
+        Poco::UInt32 scope;
+        Poco::UInt32 signature;
+        Poco::UInt32 file;
+        Poco::UInt32 line;
+        Poco::UInt32 kind;
+    };
+
+    Poco::SharedPtr<Poco::SharedMemory> _memory;
+    std::string _data;
+
+    const Header* _header;
+    const FileRecord* _files;
+    const SymbolRecord* _symbols;
+    const char* _strings;
+
+    bool _map(const char* begin, std::size_t size);
+
+    const char* _getString(Poco::UInt32 offset) const;
+
+    Symbol _getSymbol(const SymbolRecord& record) const;
+
+    bool _isInScope(const SymbolRecord& record, const std::string& scope) const;
+
+    std::size_t _lowerBound(const std::string& name) const;
+
+    static int _compare(const char* left, const std::string& right, std::size_t length);
+
+    static const char MAGIC[4];
+
+};
+
+
+} } // namespace of::Sketch
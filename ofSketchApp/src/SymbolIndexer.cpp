@@ -0,0 +1,524 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "SymbolIndexer.h"
+#include "Poco/DirectoryIterator.h"
+#include "Poco/File.h"
+#include "Poco/Path.h"
+#include "Poco/String.h"
+#include "ofFileUtils.h"
+#include "ofLog.h"
+#include "SymbolScanner.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+const std::string SymbolIndexer::CORE_LIBRARY = "openFrameworks";
+
+
+SymbolIndexer::SymbolIndexer(const std::string& path,
+                             FileTransaction::Durability durability):
+    _path(path),
+    _durability(durability),
+    _index(new SymbolIndex()),
+    _dictionary(new SymbolDictionary()),
+    _thread("SymbolIndexer"),
+    _isIndexing(false),
+    _isStopping(false)
+{
+}
+
+
+SymbolIndexer::~SymbolIndexer()
+{
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        _isStopping = true;
+    }
+
+    if (_thread.isRunning())
+    {
+        _thread.join();
+    }
+}
+
+
+void SymbolIndexer::start(const std::map<std::string, std::string>& libraries,
+                          const std::string& functionDictionary)
+{
+    if (_thread.isRunning())
+    {
+        return;
+    }
+
+    SharedIndex index = new SymbolIndex();
+    Poco::SharedPtr<SymbolDictionary> dictionary = new SymbolDictionary();
+
+    // Completions work from the saved index while it is updated.
+    index->load(_getIndexPath());
+    dictionary->load(_getDictionaryPath());
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _index = index;
+    _dictionary = dictionary;
+    _libraries = libraries;
+    _functionDictionary = functionDictionary;
+    _isIndexing = true;
+    _thread.start(*this);
+}
+
+
+void SymbolIndexer::run()
+{
+    Poco::Timestamp start;
+
+    std::vector<SymbolIndex::File> lastFiles;
+    std::vector<std::vector<Symbol> > lastSymbols;
+    std::map<std::string, std::string> libraries;
+    bool hasDictionary = false;
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        _index->getFiles(lastFiles);
+        _index->getSymbols(lastSymbols);
+        libraries = _libraries;
+        hasDictionary = _dictionary->size() > 0;
+    }
+
+    std::map<std::string, std::size_t> lastFileIndexes;
+
+    for (std::size_t i = 0; i < lastFiles.size(); ++i)
+    {
+        lastFileIndexes[lastFiles[i].path] = i;
+    }
+
+    std::vector<std::string> headers;
+    std::vector<std::string> headerLibraries;
+
+    std::map<std::string, std::string>::const_iterator library = libraries.begin();
+
+    for (; library != libraries.end(); ++library)
+    {
+        _findHeaders(library->second, headers);
+        headerLibraries.resize(headers.size(), library->first);
+    }
+
+    std::vector<SymbolIndex::File> files;
+    std::vector<std::string> fileLibraries;
+    std::vector<std::vector<Symbol> > symbols;
+    std::size_t scanned = 0;
+
+    for (std::size_t i = 0; i < headers.size(); ++i)
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(_mutex);
+
+            if (_isStopping)
+            {
+                _isIndexing = false;
+                return;
+            }
+        }
+
+        SymbolIndex::File file;
+        file.path = headers[i];
+
+        try
+        {
+            file.modified = Poco::File(file.path).getLastModified().epochMicroseconds();
+        }
+        catch (const Poco::Exception& exc)
+        {
+            continue;
+        }
+
+        files.push_back(file);
+        fileLibraries.push_back(headerLibraries[i]);
+        symbols.push_back(std::vector<Symbol>());
+
+        std::map<std::string, std::size_t>::const_iterator iter = lastFileIndexes.find(file.path);
+
+        if (iter != lastFileIndexes.end()
+         && lastFiles[iter->second].modified == file.modified
+         && iter->second < lastSymbols.size())
+        {
+            symbols.back().swap(lastSymbols[iter->second]);
+        }
+        else
+        {
+            SymbolScanner::scan(ofBufferFromFile(file.path).getText(), file.path, symbols.back());
+            ++scanned;
+        }
+    }
+
+    bool isChanged = scanned > 0 || files.size() != lastFiles.size();
+
+    if (isChanged)
+    {
+        std::string data = SymbolIndex::serialize(files, symbols);
+        SharedIndex index = new SymbolIndex();
+
+        if (!SymbolIndex::save(_getIndexPath(), data, _durability) || !index->load(_getIndexPath()))
+        {
+            ofLogWarning("SymbolIndexer::run") << "Unable to save the symbol index to " << _getIndexPath();
+            index->assign(data);
+        }
+
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        _index = index;
+    }
+
+    if (isChanged || !hasDictionary || _isNewer(_functionDictionary, _getDictionaryPath()))
+    {
+        _buildDictionary(fileLibraries, symbols);
+    }
+
+    ofLogNotice("SymbolIndexer::run") << "Indexed " << files.size() << " headers (" << scanned << " scanned) in " << start.elapsed() / 1000 << " ms.";
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _isIndexing = false;
+}
+
+
+void SymbolIndexer::updateProject(const Project& project,
+                                  const std::vector<std::string>& files)
+{
+    std::map<std::string, std::vector<Symbol> > scanned;
+
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        std::string file = "src/" + files[i];
+        ofFile source(project.getPath() + "/" + file);
+
+        if (source.exists())
+        {
+            SymbolScanner::scan(ofBufferFromFile(source.path()).getText(), file, scanned[file]);
+        }
+        else
+        {
+            scanned[file];
+        }
+    }
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    ProjectSymbols& projectSymbols = _projectSymbols[project.getPath()];
+    std::map<std::string, std::vector<Symbol> >::iterator iter = scanned.begin();
+
+    for (; iter != scanned.end(); ++iter)
+    {
+        if (iter->second.empty())
+        {
+            projectSymbols.erase(iter->first);
+        }
+        else
+        {
+            projectSymbols[iter->first].swap(iter->second);
+        }
+    }
+
+    std::vector<SymbolIndex::File> indexFiles;
+    std::vector<std::vector<Symbol> > indexSymbols;
+
+    for (ProjectSymbols::const_iterator file = projectSymbols.begin(); file != projectSymbols.end(); ++file)
+    {
+        SymbolIndex::File indexFile;
+        indexFile.path = file->first;
+        indexFiles.push_back(indexFile);
+        indexSymbols.push_back(file->second);
+    }
+
+    SharedIndex index = new SymbolIndex();
+    index->assign(SymbolIndex::serialize(indexFiles, indexSymbols));
+    _projectIndexes[project.getPath()] = index;
+}
+
+
+void SymbolIndexer::indexProject(const Project& project)
+{
+    std::vector<std::string> files;
+    files.push_back("main.cpp");
+
+    const Json::Value& classes = project.getData()["classes"];
+
+    for (unsigned int i = 0; i < classes.size(); ++i)
+    {
+        files.push_back(classes[i]["name"].asString() + ".h");
+    }
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        _projectSymbols.erase(project.getPath());
+    }
+
+    updateProject(project, files);
+}
+
+
+void SymbolIndexer::removeProject(const std::string& projectPath)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _projectSymbols.erase(projectPath);
+    _projectIndexes.erase(projectPath);
+}
+
+
+void SymbolIndexer::complete(const std::string& projectPath,
+                             const std::string& prefix,
+                             const std::string& scope,
+                             std::size_t limit,
+                             std::vector<Symbol>& results) const
+{
+    SharedIndex projectIndex = _getProjectIndex(projectPath);
+    SharedIndex index;
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        index = _index;
+    }
+
+    std::size_t count = results.size();
+
+    if (!projectIndex.isNull())
+    {
+        projectIndex->complete(prefix, scope, limit, results);
+    }
+
+    index->complete(prefix, scope, limit - std::min(limit, results.size() - count), results);
+}
+
+
+void SymbolIndexer::findDefinitions(const std::string& projectPath,
+                                    const std::string& name,
+                                    const std::string& scope,
+                                    std::vector<Symbol>& results) const
+{
+    SharedIndex projectIndex = _getProjectIndex(projectPath);
+    SharedIndex index;
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        index = _index;
+    }
+
+    if (!projectIndex.isNull())
+    {
+        projectIndex->find(name, scope, results);
+    }
+
+    index->find(name, scope, results);
+}
+
+
+void SymbolIndexer::completeSymbol(const std::string& prefix,
+                                   std::size_t maxDistance,
+                                   std::size_t limit,
+                                   std::vector<SymbolDictionary::Match>& matches,
+                                   std::vector<SymbolDictionary::Match>& similarMatches) const
+{
+    Poco::SharedPtr<SymbolDictionary> dictionary;
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        dictionary = _dictionary;
+    }
+
+    dictionary->complete(prefix, limit, matches);
+
+    if (maxDistance > 0)
+    {
+        dictionary->findSimilar(prefix, maxDistance, limit, similarMatches);
+    }
+}
+
+
+bool SymbolIndexer::isIndexing() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return _isIndexing;
+}
+
+
+std::size_t SymbolIndexer::size() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return _index->size();
+}
+
+
+SymbolIndexer::SharedIndex SymbolIndexer::_getProjectIndex(const std::string& projectPath) const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<std::string, SharedIndex>::const_iterator iter = _projectIndexes.find(projectPath);
+
+    return (iter != _projectIndexes.end()) ? iter->second : SharedIndex();
+}
+
+
+void SymbolIndexer::_findHeaders(const std::string& path,
+                                 std::vector<std::string>& headers) const
+{
+    try
+    {
+        Poco::File folder(path);
+
+        if (!folder.exists() || !folder.isDirectory())
+        {
+            return;
+        }
+
+        Poco::DirectoryIterator iter(folder);
+        Poco::DirectoryIterator end;
+
+        for (; iter != end; ++iter)
+        {
+            if (iter->isLink())
+            {
+                continue;
+            }
+            else if (iter->isDirectory())
+            {
+                _findHeaders(iter->path(), headers);
+            }
+            else
+            {
+                std::string extension = Poco::toLower(Poco::Path(iter->path()).getExtension());
+
+                if (extension == "h" || extension == "hpp")
+                {
+                    headers.push_back(iter->path());
+                }
+            }
+        }
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogWarning("SymbolIndexer::_findHeaders") << "Unable to search " << path << ": " << exc.displayText();
+    }
+}
+
+
+void SymbolIndexer::_buildDictionary(const std::vector<std::string>& libraries,
+                                     const std::vector<std::vector<Symbol> >& symbols)
+{
+    std::vector<SymbolDictionary::Entry> entries;
+
+    // The kinds of the listed functions, most of which are declared in
+    // the core headers.
+    std::map<std::string, Symbol::Kind> coreKinds;
+
+    for (std::size_t i = 0; i < symbols.size() && i < libraries.size(); ++i)
+    {
+        for (std::size_t j = 0; j < symbols[i].size(); ++j)
+        {
+            const Symbol& symbol = symbols[i][j];
+
+            // Addon classes are often in a namespace, e.g. ofx::HTTP.
+            if ((!symbol.scope.empty() && symbol.kind != Symbol::KIND_CLASS)
+             || symbol.kind == Symbol::KIND_METHOD
+             || symbol.kind == Symbol::KIND_FIELD)
+            {
+                continue;
+            }
+
+            if (libraries[i] == CORE_LIBRARY)
+            {
+                coreKinds.insert(std::make_pair(symbol.name, symbol.kind));
+            }
+            else
+            {
+                SymbolDictionary::Entry entry;
+                entry.name = symbol.name;
+                entry.library = libraries[i];
+                entry.kind = symbol.kind;
+                entries.push_back(entry);
+            }
+        }
+    }
+
+    std::vector<std::string> names = SymbolDictionary::loadFunctionNames(_functionDictionary);
+
+    for (std::size_t i = 0; i < names.size(); ++i)
+    {
+        SymbolDictionary::Entry entry;
+        entry.name = names[i];
+        entry.library = CORE_LIBRARY;
+
+        std::map<std::string, Symbol::Kind>::const_iterator kind = coreKinds.find(names[i]);
+
+        if (kind != coreKinds.end())
+        {
+            entry.kind = kind->second;
+        }
+
+        entries.push_back(entry);
+    }
+
+    std::string data = SymbolDictionary::serialize(entries);
+    Poco::SharedPtr<SymbolDictionary> dictionary = new SymbolDictionary();
+
+    if (!SymbolIndex::save(_getDictionaryPath(), data, _durability) || !dictionary->load(_getDictionaryPath()))
+    {
+        ofLogWarning("SymbolIndexer::_buildDictionary") << "Unable to save the symbol dictionary to " << _getDictionaryPath();
+        dictionary->assign(data);
+    }
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _dictionary = dictionary;
+}
+
+
+std::string SymbolIndexer::_getIndexPath() const
+{
+    return _path + "/symbols.idx";
+}
+
+
+std::string SymbolIndexer::_getDictionaryPath() const
+{
+    return _path + "/dictionary.idx";
+}
+
+
+bool SymbolIndexer::_isNewer(const std::string& path, const std::string& otherPath)
+{
+    try
+    {
+        Poco::File file(path);
+        Poco::File otherFile(otherPath);
+
+        return file.exists()
+            && (!otherFile.exists() || otherFile.getLastModified() < file.getLastModified());
+    }
+    catch (const Poco::Exception& exc)
+    {
+        return false;
+    }
+}
+
+} } // namespace of::Sketch
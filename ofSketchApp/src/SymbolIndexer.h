@@ -0,0 +1,134 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include "Poco/Mutex.h"
+#include "Poco/Runnable.h"
+#include "Poco/SharedPtr.h"
+#include "Poco/Thread.h"
+#include "FileTransaction.h"
+#include "Project.h"
+#include "SymbolDictionary.h"
+#include "SymbolIndex.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Keeps the shared header index and each project's index of its
+///        generated sources up to date.
+class SymbolIndexer: public Poco::Runnable
+{
+public:
+    SymbolIndexer(const std::string& path,
+                  FileTransaction::Durability durability);
+
+    virtual ~SymbolIndexer();
+
+    /// \brief Load the saved index and update it in the background.
+    void start(const std::map<std::string, std::string>& libraries,
+               const std::string& functionDictionary);
+
+    void run();
+
+    /// \param files The generated files that changed, e.g. "main.cpp".
+    void updateProject(const Project& project,
+                       const std::vector<std::string>& files);
+
+    void indexProject(const Project& project);
+
+    void removeProject(const std::string& projectPath);
+
+    /// \brief The project's symbols come first.
+    void complete(const std::string& projectPath,
+                  const std::string& prefix,
+                  const std::string& scope,
+                  std::size_t limit,
+                  std::vector<Symbol>& results) const;
+
+    void findDefinitions(const std::string& projectPath,
+                         const std::string& name,
+                         const std::string& scope,
+                         std::vector<Symbol>& results) const;
+
+    /// \param maxDistance If not 0, also find names close to prefix.
+    void completeSymbol(const std::string& prefix,
+                        std::size_t maxDistance,
+                        std::size_t limit,
+                        std::vector<SymbolDictionary::Match>& matches,
+                        std::vector<SymbolDictionary::Match>& similarMatches) const;
+
+    bool isIndexing() const;
+
+    std::size_t size() const;
+
+private:
+    typedef Poco::SharedPtr<SymbolIndex> SharedIndex;
+
+    typedef std::map<std::string, std::vector<Symbol> > ProjectSymbols;
+
+    std::string _path;
+    FileTransaction::Durability _durability;
+
+    std::map<std::string, std::string> _libraries;
+    std::string _functionDictionary;
+
+    SharedIndex _index;
+    Poco::SharedPtr<SymbolDictionary> _dictionary;
+
+    std::map<std::string, ProjectSymbols> _projectSymbols;
+    std::map<std::string, SharedIndex> _projectIndexes;
+
+    Poco::Thread _thread;
+    bool _isIndexing;
+    bool _isStopping;
+
+    mutable Poco::FastMutex _mutex;
+
+    SharedIndex _getProjectIndex(const std::string& projectPath) const;
+
+    void _findHeaders(const std::string& path,
+                      std::vector<std::string>& headers) const;
+
+    void _buildDictionary(const std::vector<std::string>& libraries,
+                          const std::vector<std::vector<Symbol> >& symbols);
+
+    std::string _getIndexPath() const;
+    std::string _getDictionaryPath() const;
+
+    static bool _isNewer(const std::string& path, const std::string& otherPath);
+
+    static const std::string CORE_LIBRARY;
+
+};
+
+
+} } // namespace of::Sketch
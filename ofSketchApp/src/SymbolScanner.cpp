@@ -0,0 +1,935 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "SymbolScanner.h"
+#include <cctype>
+
+
+namespace of {
+namespace Sketch {
+
+
+void SymbolScanner::scan(const std::string& source,
+                         const std::string& file,
+                         std::vector<Symbol>& symbols)
+{
+    Tokens tokens;
+
+    _tokenize(source, file, tokens, symbols);
+
+    Scopes scopes(1);
+    scopes[0].type = Scope::SCOPE_NAMESPACE;
+
+    Tokens statement;
+    int depth = 0;
+
+    for (std::size_t i = 0; i < tokens.size(); ++i)
+    {
+        const Token& token = tokens[i];
+        const std::string& text = token.text;
+        Scope::Type type = scopes.back().type;
+
+        if (type == Scope::SCOPE_BLOCK)
+        {
+            if (text == "{")
+            {
+                Scope block;
+                block.type = Scope::SCOPE_BLOCK;
+                scopes.push_back(block);
+            }
+            else if (text == "}")
+            {
+                scopes.pop_back();
+            }
+
+            continue;
+        }
+
+        if (type == Scope::SCOPE_ENUM)
+        {
+            if (text == "}")
+            {
+                scopes.pop_back();
+                statement.clear();
+            }
+            else if (text == ",")
+            {
+                statement.clear();
+            }
+            else if (text == "{")
+            {
+                Scope block;
+                block.type = Scope::SCOPE_BLOCK;
+                scopes.push_back(block);
+            }
+            else
+            {
+                if (statement.empty() && token.isWord && !std::isdigit(text[0]))
+                {
+                    // Enumerators of plain enums belong to the enclosing scope.
+                    Scopes enclosing(scopes.begin(), scopes.end() - 1);
+
+                    Symbol symbol;
+                    symbol.name = text;
+                    symbol.scope = _getScope(enclosing);
+                    symbol.signature = scopes.back().name.empty() ? text : scopes.back().name + "::" + text;
+                    symbol.file = file;
+                    symbol.line = token.line;
+                    symbol.kind = Symbol::KIND_ENUMERATOR;
+                    symbols.push_back(symbol);
+                }
+
+                statement.push_back(token);
+            }
+
+            continue;
+        }
+
+        if (text == "(" || text == "[")
+        {
+            ++depth;
+        }
+        else if ((text == ")" || text == "]") && depth > 0)
+        {
+            --depth;
+        }
+
+        if (depth > 0 && text == ";")
+        {
+            // Unbalanced brackets, e.g. from both sides of an #ifdef.
+            depth = 0;
+            statement.clear();
+        }
+        else if (depth > 0)
+        {
+            statement.push_back(token);
+        }
+        else if (text == "{")
+        {
+            _openScope(statement, scopes, file, symbols);
+            statement.clear();
+        }
+        else if (text == "}")
+        {
+            if (scopes.size() > 1)
+            {
+                scopes.pop_back();
+            }
+
+            statement.clear();
+        }
+        else if (text == ";")
+        {
+            _declaration(statement, scopes, file, symbols);
+            statement.clear();
+        }
+        else if (text == ":"
+              && statement.size() == 1
+              && (statement[0].text == "public"
+               || statement[0].text == "protected"
+               || statement[0].text == "private"))
+        {
+            statement.clear();
+        }
+        else
+        {
+            statement.push_back(token);
+        }
+    }
+}
+
+
+void SymbolScanner::_tokenize(const std::string& source,
+                              const std::string& file,
+                              Tokens& tokens,
+                              std::vector<Symbol>& symbols)
+{
+    std::size_t size = source.size();
+    std::size_t line = 1;
+    bool isLineStart = true;
+    std::size_t i = 0;
+
+    while (i < size)
+    {
+        char c = source[i];
+        char next = (i + 1 < size) ? source[i + 1] : '\0';
+
+        if (c == '\n')
+        {
+            ++line;
+            isLineStart = true;
+            ++i;
+        }
+        else if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            ++i;
+        }
+        else if (c == '/' && next == '/')
+        {
+            while (i < size && source[i] != '\n')
+            {
+                ++i;
+            }
+        }
+        else if (c == '/' && next == '*')
+        {
+            i += 2;
+
+            while (i < size && !(source[i] == '*' && i + 1 < size && source[i + 1] == '/'))
+            {
+                if (source[i] == '\n')
+                {
+                    ++line;
+                }
+
+                ++i;
+            }
+
+            i += 2;
+        }
+        else if (c == '#' && isLineStart)
+        {
+            std::size_t directiveLine = line;
+            std::size_t end = i + 1;
+
+            // The directive ends at a newline that is not escaped.
+            while (end < size && source[end] != '\n')
+            {
+                if (source[end] == '\\' && end + 1 < size && source[end + 1] == '\n')
+                {
+                    ++line;
+                    ++end;
+                }
+
+                ++end;
+            }
+
+            std::string directive = source.substr(i + 1, end - i - 1);
+            std::size_t position = directive.find_first_not_of(" \t");
+
+            if (position != std::string::npos && directive.compare(position, 6, "define") == 0)
+            {
+                position = directive.find_first_not_of(" \t", position + 6);
+                std::size_t nameEnd = position;
+
+                while (nameEnd < directive.size() && _isIdentifier(directive[nameEnd]))
+                {
+                    ++nameEnd;
+                }
+
+                if (position != std::string::npos && nameEnd > position)
+                {
+                    std::string name = directive.substr(position, nameEnd - position);
+                    std::size_t valueEnd = directive.find_last_not_of(" \t\r\\\n");
+                    bool hasParameters = (nameEnd < directive.size() && directive[nameEnd] == '(');
+                    bool hasValue = (valueEnd != std::string::npos && valueEnd >= nameEnd);
+
+                    // Include guards define a name without a value.
+                    if (hasParameters || hasValue)
+                    {
+                        std::size_t signatureEnd = hasParameters ? directive.find(')', nameEnd) : nameEnd - 1;
+
+                        Symbol symbol;
+                        symbol.name = name;
+                        symbol.signature = directive.substr(position, signatureEnd == std::string::npos ? nameEnd - position : signatureEnd + 1 - position);
+                        symbol.file = file;
+                        symbol.line = directiveLine;
+                        symbol.kind = Symbol::KIND_MACRO;
+                        symbols.push_back(symbol);
+                    }
+                }
+            }
+
+            i = end;
+        }
+        else
+        {
+            isLineStart = false;
+
+            Token token;
+            token.line = line;
+            token.isWord = false;
+
+            if (c == '"' || c == '\'')
+            {
+                bool isRaw = (c == '"' && i > 0 && source[i - 1] == 'R' && !tokens.empty() && tokens.back().isWord);
+                std::size_t end = i + 1;
+
+                if (isRaw)
+                {
+                    std::size_t open = source.find('(', end);
+                    std::string delimiter = ")" + source.substr(end, open - end) + "\"";
+                    std::size_t close = (open == std::string::npos) ? std::string::npos : source.find(delimiter, open);
+                    end = (close == std::string::npos) ? size : close + delimiter.size();
+                    tokens.pop_back();
+                }
+                else
+                {
+                    while (end < size && source[end] != c && source[end] != '\n')
+                    {
+                        end += (source[end] == '\\') ? 2 : 1;
+                    }
+
+                    ++end;
+                }
+
+                for (std::size_t j = i; j < end && j < size; ++j)
+                {
+                    if (source[j] == '\n')
+                    {
+                        ++line;
+                    }
+                }
+
+                token.text = std::string(2, c);
+                i = end;
+            }
+            else if (_isIdentifier(c))
+            {
+                std::size_t end = i;
+
+                // Numbers may contain dots and digit separators.
+                while (end < size
+                    && (_isIdentifier(source[end])
+                     || (std::isdigit(static_cast<unsigned char>(c)) && (source[end] == '.' || source[end] == '\''))))
+                {
+                    ++end;
+                }
+
+                token.text = source.substr(i, end - i);
+                token.isWord = true;
+                i = end;
+            }
+            else if ((c == ':' && next == ':') || (c == '-' && next == '>'))
+            {
+                token.text = source.substr(i, 2);
+                i += 2;
+            }
+            else
+            {
+                token.text = std::string(1, c);
+                ++i;
+            }
+
+            tokens.push_back(token);
+        }
+    }
+}
+
+
+void SymbolScanner::_openScope(const Tokens& statement,
+                               Scopes& scopes,
+                               const std::string& file,
+                               std::vector<Symbol>& symbols)
+{
+    Tokens head = _stripTemplate(statement);
+
+    Scope scope;
+    scope.type = Scope::SCOPE_BLOCK;
+
+    std::size_t first = (!head.empty() && head[0].text == "typedef") ? 1 : 0;
+    std::string keyword = (first < head.size()) ? head[first].text : "";
+
+    if (_find(head, "namespace") != std::string::npos)
+    {
+        std::size_t end = _find(head, "namespace") + 1;
+
+        // namespace a::b, but not attributes after the name.
+        while (end < head.size()
+            && ((head[end].isWord && (head[end - 1].text == "namespace" || head[end - 1].text == "::"))
+             || (head[end].text == "::" && head[end - 1].isWord)))
+        {
+            ++end;
+        }
+
+        scope.type = Scope::SCOPE_NAMESPACE;
+        scope.name = _join(head, _find(head, "namespace") + 1, end);
+    }
+    else if (head.size() == 2 && keyword == "extern" && !head[1].isWord)
+    {
+        // extern "C" adds no scope of its own.
+        scope.type = Scope::SCOPE_NAMESPACE;
+    }
+    else if (keyword == "class" || keyword == "struct" || keyword == "union")
+    {
+        std::size_t end = _find(head, ":", first);
+        std::size_t nameEnd = (end == std::string::npos) ? head.size() : end;
+
+        scope.type = Scope::SCOPE_CLASS;
+
+        for (std::size_t i = first + 1; i < nameEnd; ++i)
+        {
+            if (head[i].isWord && head[i].text != "final" && !_isMacroName(head[i].text))
+            {
+                scope.name = head[i].text;
+            }
+            else if (head[i].text == "<" || head[i].text == "(")
+            {
+                break;
+            }
+        }
+
+        if (!scope.name.empty())
+        {
+            Symbol symbol;
+            symbol.name = scope.name;
+            symbol.scope = _getScope(scopes);
+            symbol.signature = _join(head, first, head.size());
+            symbol.file = file;
+            symbol.line = head[first].line;
+            symbol.kind = Symbol::KIND_CLASS;
+            symbols.push_back(symbol);
+        }
+    }
+    else if (keyword == "enum")
+    {
+        std::size_t end = _find(head, ":", first);
+        std::size_t nameEnd = (end == std::string::npos) ? head.size() : end;
+
+        scope.type = Scope::SCOPE_ENUM;
+
+        for (std::size_t i = first + 1; i < nameEnd; ++i)
+        {
+            if (head[i].isWord && head[i].text != "class" && head[i].text != "struct")
+            {
+                scope.name = head[i].text;
+            }
+        }
+
+        if (!scope.name.empty())
+        {
+            Symbol symbol;
+            symbol.name = scope.name;
+            symbol.scope = _getScope(scopes);
+            symbol.signature = _join(head, first, head.size());
+            symbol.file = file;
+            symbol.line = head[first].line;
+            symbol.kind = Symbol::KIND_ENUM;
+            symbols.push_back(symbol);
+        }
+    }
+    else if (_find(head, "=") != std::string::npos)
+    {
+        // A variable with a braced initializer.
+        Tokens declaration(head.begin(), head.begin() + _find(head, "="));
+        _variables(declaration, scopes, file, symbols);
+    }
+    else if (_findParameters(head) != std::string::npos)
+    {
+        // A function definition, whose body is skipped.
+        _function(head, scopes, file, symbols);
+    }
+
+    scopes.push_back(scope);
+}
+
+
+void SymbolScanner::_declaration(const Tokens& statement,
+                                 const Scopes& scopes,
+                                 const std::string& file,
+                                 std::vector<Symbol>& symbols)
+{
+    Tokens tokens = _stripTemplate(statement);
+
+    if (tokens.size() < 2)
+    {
+        return;
+    }
+
+    const std::string& first = tokens[0].text;
+
+    if (first == "typedef")
+    {
+        _typedef(tokens, scopes, file, symbols);
+    }
+    else if (first == "using")
+    {
+        if (tokens.size() > 3 && tokens[2].text == "=")
+        {
+            Symbol symbol;
+            symbol.name = tokens[1].text;
+            symbol.scope = _getScope(scopes);
+            symbol.signature = _join(tokens, 0, tokens.size());
+            symbol.file = file;
+            symbol.line = tokens[0].line;
+            symbol.kind = Symbol::KIND_TYPEDEF;
+            symbols.push_back(symbol);
+        }
+    }
+    else if (first == "friend"
+          || first == "namespace"
+          || first == "static_assert"
+          || first == "class"
+          || first == "struct"
+          || first == "union"
+          || first == "enum")
+    {
+        // Forward declarations and the like.
+    }
+    else if (!_function(tokens, scopes, file, symbols))
+    {
+        _variables(tokens, scopes, file, symbols);
+    }
+}
+
+
+bool SymbolScanner::_function(const Tokens& tokens,
+                              const Scopes& scopes,
+                              const std::string& file,
+                              std::vector<Symbol>& symbols)
+{
+    std::size_t parameters = _findParameters(tokens);
+
+    if (parameters == std::string::npos || parameters == 0)
+    {
+        return false;
+    }
+
+    std::size_t close = _findClose(tokens, parameters);
+
+    // Unwrap MACRO(..., declaration), e.g. OF_DEPRECATED_MSG.
+    if (parameters == 1 && _isMacroName(tokens[0].text))
+    {
+        std::size_t begin = parameters + 1;
+
+        for (std::size_t i = begin; i + 1 < close; i = _findClose(tokens, i))
+        {
+            if (tokens[i].text == ",")
+            {
+                begin = i + 1;
+            }
+        }
+
+        Tokens inner(tokens.begin() + begin, tokens.begin() + (close - 1));
+        _declaration(inner, scopes, file, symbols);
+        return true;
+    }
+
+    // Variables constructed with arguments look like functions.
+    for (std::size_t i = parameters + 1; i + 1 < close; ++i)
+    {
+        if (!tokens[i].isWord && tokens[i].text.size() == 2 && (tokens[i].text[0] == '"' || tokens[i].text[0] == '\''))
+        {
+            return false;
+        }
+        else if (tokens[i].isWord && std::isdigit(tokens[i].text[0]) && tokens[i - 1].text != "=" && tokens[i - 1].text != "[")
+        {
+            return false;
+        }
+    }
+
+    std::size_t nameBegin = parameters - 1;
+    std::size_t operatorPosition = _find(tokens, "operator");
+
+    if (operatorPosition != std::string::npos && operatorPosition < parameters)
+    {
+        nameBegin = operatorPosition;
+    }
+    else if (!tokens[nameBegin].isWord || _isKeyword(tokens[nameBegin].text))
+    {
+        return false;
+    }
+    else if (nameBegin > 0 && tokens[nameBegin - 1].text == "~")
+    {
+        // Destructors are never completed.
+        return true;
+    }
+
+    Symbol symbol;
+    symbol.name = _join(tokens, nameBegin, parameters);
+    symbol.scope = _getScope(scopes);
+    symbol.file = file;
+    symbol.line = tokens[nameBegin].line;
+    symbol.kind = (scopes.back().type == Scope::SCOPE_CLASS) ? Symbol::KIND_METHOD : Symbol::KIND_FUNCTION;
+
+    // Out of line definitions, e.g. void ofApp::setup().
+    std::size_t returnEnd = nameBegin;
+
+    while (returnEnd > 1 && tokens[returnEnd - 1].text == "::" && tokens[returnEnd - 2].isWord)
+    {
+        returnEnd -= 2;
+    }
+
+    if (returnEnd < nameBegin)
+    {
+        std::string qualifier = _join(tokens, returnEnd, nameBegin - 1);
+        symbol.scope = symbol.scope.empty() ? qualifier : symbol.scope + "::" + qualifier;
+        symbol.kind = Symbol::KIND_METHOD;
+    }
+
+    Tokens signature;
+
+    for (std::size_t i = 0; i < returnEnd; ++i)
+    {
+        const std::string& text = tokens[i].text;
+
+        if (text != "virtual" && text != "static" && text != "inline" && text != "explicit" && text != "extern")
+        {
+            signature.push_back(tokens[i]);
+        }
+    }
+
+    signature.insert(signature.end(), tokens.begin() + nameBegin, tokens.begin() + close);
+
+    for (std::size_t i = close; i < tokens.size(); ++i)
+    {
+        if (tokens[i].text == "const" || tokens[i].text == "&" || tokens[i].text == "&&")
+        {
+            signature.push_back(tokens[i]);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    symbol.signature = _join(signature, 0, signature.size());
+    symbols.push_back(symbol);
+
+    return true;
+}
+
+
+void SymbolScanner::_variables(const Tokens& tokens,
+                               const Scopes& scopes,
+                               const std::string& file,
+                               std::vector<Symbol>& symbols)
+{
+    Symbol::Kind kind = (scopes.back().type == Scope::SCOPE_CLASS) ? Symbol::KIND_FIELD : Symbol::KIND_VARIABLE;
+    std::string type;
+    std::size_t begin = 0;
+
+    // int a, b = 2, c[3];
+    while (begin < tokens.size())
+    {
+        std::size_t end = _find(tokens, ",", begin);
+
+        if (end == std::string::npos)
+        {
+            end = tokens.size();
+        }
+
+        std::size_t declaratorEnd = end;
+        std::size_t assignment = _find(tokens, "=", begin);
+        std::size_t bitfield = _find(tokens, ":", begin);
+
+        if (assignment < declaratorEnd)
+        {
+            declaratorEnd = assignment;
+        }
+
+        if (bitfield < declaratorEnd)
+        {
+            declaratorEnd = bitfield;
+        }
+
+        std::size_t name = std::string::npos;
+
+        for (std::size_t i = begin; i < declaratorEnd; i = _findClose(tokens, i))
+        {
+            if (tokens[i].isWord && !std::isdigit(tokens[i].text[0]))
+            {
+                name = i;
+            }
+        }
+
+        if (name == std::string::npos || _isKeyword(tokens[name].text))
+        {
+            return;
+        }
+
+        if (begin == 0)
+        {
+            // A lone word is a macro, not a declaration.
+            if (name == 0)
+            {
+                return;
+            }
+
+            type = _join(tokens, 0, name);
+        }
+
+        Symbol symbol;
+        symbol.name = tokens[name].text;
+        symbol.scope = _getScope(scopes);
+        symbol.signature = type + " " + _join(tokens, name, declaratorEnd);
+        symbol.file = file;
+        symbol.line = tokens[name].line;
+        symbol.kind = kind;
+        symbols.push_back(symbol);
+
+        begin = end + 1;
+    }
+}
+
+
+void SymbolScanner::_typedef(const Tokens& tokens,
+                             const Scopes& scopes,
+                             const std::string& file,
+                             std::vector<Symbol>& symbols)
+{
+    std::size_t name = std::string::npos;
+
+    for (std::size_t i = 1; i + 1 < tokens.size(); ++i)
+    {
+        // typedef void (*name)(int);
+        if (tokens[i].text == "(" && tokens[i + 1].text == "*" && i + 2 < tokens.size() && tokens[i + 2].isWord)
+        {
+            name = i + 2;
+            break;
+        }
+    }
+
+    if (name == std::string::npos)
+    {
+        for (std::size_t i = 1; i < tokens.size(); i = _findClose(tokens, i))
+        {
+            if (tokens[i].isWord)
+            {
+                name = i;
+            }
+        }
+    }
+
+    if (name == std::string::npos)
+    {
+        return;
+    }
+
+    Symbol symbol;
+    symbol.name = tokens[name].text;
+    symbol.scope = _getScope(scopes);
+    symbol.signature = _join(tokens, 0, tokens.size());
+    symbol.file = file;
+    symbol.line = tokens[name].line;
+    symbol.kind = Symbol::KIND_TYPEDEF;
+    symbols.push_back(symbol);
+}
+
+
+SymbolScanner::Tokens SymbolScanner::_stripTemplate(const Tokens& tokens)
+{
+    std::size_t begin = 0;
+
+    while (begin + 1 < tokens.size() && tokens[begin].text == "template" && tokens[begin + 1].text == "<")
+    {
+        begin = _findClose(tokens, begin + 1);
+    }
+
+    return Tokens(tokens.begin() + begin, tokens.end());
+}
+
+
+std::size_t SymbolScanner::_findParameters(const Tokens& tokens)
+{
+    for (std::size_t i = 0; i < tokens.size(); i = _findClose(tokens, i))
+    {
+        if (tokens[i].text == "operator")
+        {
+            // operator() and operator< are part of the name.
+            std::size_t position = i + 1;
+
+            if (position + 1 < tokens.size() && tokens[position].text == "(" && tokens[position + 1].text == ")")
+            {
+                position += 2;
+            }
+
+            while (position < tokens.size() && tokens[position].text != "(")
+            {
+                ++position;
+            }
+
+            return (position < tokens.size()) ? position : std::string::npos;
+        }
+        else if (tokens[i].text == "(")
+        {
+            return i;
+        }
+        else if (tokens[i].text == "=")
+        {
+            return std::string::npos;
+        }
+    }
+
+    return std::string::npos;
+}
+
+
+std::size_t SymbolScanner::_findClose(const Tokens& tokens, std::size_t position)
+{
+    const std::string& open = tokens[position].text;
+    std::string close;
+
+    if (open == "(") close = ")";
+    else if (open == "[") close = "]";
+    else if (open == "<") close = ">";
+    else if (open == "{") close = "}";
+    else return position + 1;
+
+    int depth = 0;
+
+    for (std::size_t i = position; i < tokens.size(); ++i)
+    {
+        const std::string& text = tokens[i].text;
+
+        if (text == open)
+        {
+            ++depth;
+        }
+        else if (text == close && --depth == 0)
+        {
+            return i + 1;
+        }
+        else if (open == "<" && (text == ";" || text == "{"))
+        {
+            // A less than, not a template.
+            return position + 1;
+        }
+    }
+
+    return tokens.size();
+}
+
+
+std::size_t SymbolScanner::_find(const Tokens& tokens,
+                                 const std::string& text,
+                                 std::size_t begin)
+{
+    for (std::size_t i = begin; i < tokens.size(); i = _findClose(tokens, i))
+    {
+        if (tokens[i].text == text)
+        {
+            return i;
+        }
+    }
+
+    return std::string::npos;
+}
+
+
+std::string SymbolScanner::_join(const Tokens& tokens,
+                                 std::size_t begin,
+                                 std::size_t end)
+{
+    std::string result;
+
+    for (std::size_t i = begin; i < end && i < tokens.size(); ++i)
+    {
+        const Token& token = tokens[i];
+
+        if (i > begin)
+        {
+            const Token& last = tokens[i - 1];
+
+            if (last.text == "operator")
+            {
+                // operator== and operator() stay together.
+            }
+            else if ((last.isWord && token.isWord)
+                  || last.text == ","
+                  || last.text == ":"
+                  || token.text == ":"
+                  || (last.text == "=" && token.text != "=" && token.text != "(")
+                  || (token.text == "=" && last.text != "=")
+                  || (token.isWord && (last.text == "*" || last.text == "&" || last.text == ">" || last.text == ")")))
+            {
+                result += " ";
+            }
+        }
+
+        result += token.text;
+    }
+
+    return result;
+}
+
+
+std::string SymbolScanner::_getScope(const Scopes& scopes)
+{
+    std::string scope;
+
+    for (std::size_t i = 0; i < scopes.size(); ++i)
+    {
+        if (!scopes[i].name.empty() && scopes[i].type != Scope::SCOPE_ENUM)
+        {
+            scope += scope.empty() ? scopes[i].name : "::" + scopes[i].name;
+        }
+    }
+
+    return scope;
+}
+
+
+bool SymbolScanner::_isKeyword(const std::string& word)
+{
+    static const char* keywords[] = {
+        "alignas", "alignof", "decltype", "delete", "do", "else", "for",
+        "if", "new", "noexcept", "return", "sizeof", "switch", "throw",
+        "typeid", "while", "__attribute__", "__declspec", "const",
+        "volatile", "void", "int", "float", "double", "char", "bool",
+        "long", "short", "unsigned", "signed", "auto", "public",
+        "private", "protected", "virtual", "static", "inline"
+    };
+
+    for (std::size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); ++i)
+    {
+        if (word == keywords[i])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool SymbolScanner::_isMacroName(const std::string& word)
+{
+    if (word.size() < 2)
+    {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < word.size(); ++i)
+    {
+        if (!std::isupper(static_cast<unsigned char>(word[i]))
+         && !std::isdigit(static_cast<unsigned char>(word[i]))
+         && word[i] != '_')
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool SymbolScanner::_isIdentifier(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+
+} } // namespace of::Sketch
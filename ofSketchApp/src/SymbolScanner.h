@@ -0,0 +1,129 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include "Symbol.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Finds the declarations in C++ headers and sources, without
+///        preprocessing them.
+class SymbolScanner
+{
+public:
+    static void scan(const std::string& source,
+                     const std::string& file,
+                     std::vector<Symbol>& symbols);
+
+private:
+    struct Token
+    {
+        std::string text;
+        std::size_t line;
+        bool isWord;
+    };
+
+    typedef std::vector<Token> Tokens;
+
+    struct Scope
+    {
+        enum Type
+        {
+            SCOPE_NAMESPACE,
+            SCOPE_CLASS,
+            SCOPE_ENUM,
+            SCOPE_BLOCK
+        };
+
+        Type type;
+        std::string name;
+    };
+
+    typedef std::vector<Scope> Scopes;
+
+    static void _tokenize(const std::string& source,
+                          const std::string& file,
+                          Tokens& tokens,
+                          std::vector<Symbol>& symbols);
+
+    static void _openScope(const Tokens& head,
+                           Scopes& scopes,
+                           const std::string& file,
+                           std::vector<Symbol>& symbols);
+
+    static void _declaration(const Tokens& statement,
+                             const Scopes& scopes,
+                             const std::string& file,
+                             std::vector<Symbol>& symbols);
+
+    static bool _function(const Tokens& tokens,
+                          const Scopes& scopes,
+                          const std::string& file,
+                          std::vector<Symbol>& symbols);
+
+    static void _variables(const Tokens& tokens,
+                           const Scopes& scopes,
+                           const std::string& file,
+                           std::vector<Symbol>& symbols);
+
+    static void _typedef(const Tokens& tokens,
+                         const Scopes& scopes,
+                         const std::string& file,
+                         std::vector<Symbol>& symbols);
+
+    static Tokens _stripTemplate(const Tokens& tokens);
+
+    /// \returns npos if there is no parameter list outside of brackets.
+    static std::size_t _findParameters(const Tokens& tokens);
+
+    static std::size_t _findClose(const Tokens& tokens, std::size_t position);
+
+    static std::size_t _find(const Tokens& tokens,
+                             const std::string& text,
+                             std::size_t begin = 0);
+
+    static std::string _join(const Tokens& tokens,
+                             std::size_t begin,
+                             std::size_t end);
+
+    static std::string _getScope(const Scopes& scopes);
+
+    static bool _isKeyword(const std::string& word);
+
+    static bool _isMacroName(const std::string& word);
+
+    static bool _isIdentifier(char c);
+
+};
+
+
+} } // namespace of::Sketch
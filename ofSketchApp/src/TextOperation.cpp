@@ -0,0 +1,385 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "TextOperation.h"
+#include <algorithm>
+
+
+namespace of {
+namespace Sketch {
+
+
+TextOperation::TextOperation(): _baseLength(0), _targetLength(0)
+{
+}
+
+
+TextOperation& TextOperation::retain(std::size_t length)
+{
+    if (length == 0) return *this;
+
+    _baseLength += length;
+    _targetLength += length;
+
+    if (!_components.empty() && _components.back().type == Component::RETAIN)
+    {
+        _components.back().length += length;
+    }
+    else
+    {
+        Component component;
+        component.type = Component::RETAIN;
+        component.length = length;
+        _components.push_back(component);
+    }
+
+    return *this;
+}
+
+
+TextOperation& TextOperation::insert(const std::string& text)
+{
+    if (text.empty()) return *this;
+
+    std::size_t length = utf16Length(text);
+
+    _targetLength += length;
+
+    Component component;
+    component.type = Component::INSERT;
+    component.length = length;
+    component.text = text;
+
+    // Inserts are kept in front of deletes so that equivalent operations
+    // always have the same representation.
+    std::size_t size = _components.size();
+
+    if (size > 0 && _components[size - 1].type == Component::INSERT)
+    {
+        _components[size - 1].text += text;
+        _components[size - 1].length += length;
+    }
+    else if (size > 0 && _components[size - 1].type == Component::REMOVE)
+    {
+        if (size > 1 && _components[size - 2].type == Component::INSERT)
+        {
+            _components[size - 2].text += text;
+            _components[size - 2].length += length;
+        }
+        else
+        {
+            _components.insert(_components.end() - 1, component);
+        }
+    }
+    else
+    {
+        _components.push_back(component);
+    }
+
+    return *this;
+}
+
+
+TextOperation& TextOperation::remove(std::size_t length)
+{
+    if (length == 0) return *this;
+
+    _baseLength += length;
+
+    if (!_components.empty() && _components.back().type == Component::REMOVE)
+    {
+        _components.back().length += length;
+    }
+    else
+    {
+        Component component;
+        component.type = Component::REMOVE;
+        component.length = length;
+        _components.push_back(component);
+    }
+
+    return *this;
+}
+
+
+bool TextOperation::isNoop() const
+{
+    return _components.empty()
+        || (_components.size() == 1 && _components[0].type == Component::RETAIN);
+}
+
+
+std::size_t TextOperation::getBaseLength() const
+{
+    return _baseLength;
+}
+
+
+std::size_t TextOperation::getTargetLength() const
+{
+    return _targetLength;
+}
+
+
+const std::vector<TextOperation::Component>& TextOperation::getComponents() const
+{
+    return _components;
+}
+
+
+bool TextOperation::apply(const std::string& input, std::string& output) const
+{
+    if (utf16Length(input) != _baseLength) return false;
+
+    std::string result;
+    result.reserve(input.size());
+
+    std::size_t offset = 0;
+
+    std::vector<Component>::const_iterator iter = _components.begin();
+
+    while (iter != _components.end())
+    {
+        std::size_t start = offset;
+
+        switch (iter->type)
+        {
+            case Component::RETAIN:
+                if (!_advance(input, offset, iter->length)) return false;
+                result.append(input, start, offset - start);
+                break;
+            case Component::INSERT:
+                result.append(iter->text);
+                break;
+            case Component::REMOVE:
+                if (!_advance(input, offset, iter->length)) return false;
+                break;
+        }
+
+        ++iter;
+    }
+
+    if (offset != input.size()) return false;
+
+    output.swap(result);
+
+    return true;
+}
+
+
+Json::Value TextOperation::toJson() const
+{
+    Json::Value json(Json::arrayValue);
+
+    std::vector<Component>::const_iterator iter = _components.begin();
+
+    while (iter != _components.end())
+    {
+        switch (iter->type)
+        {
+            case Component::RETAIN:
+                json.append(Json::Int64(iter->length));
+                break;
+            case Component::INSERT:
+                json.append(iter->text);
+                break;
+            case Component::REMOVE:
+                json.append(-Json::Int64(iter->length));
+                break;
+        }
+
+        ++iter;
+    }
+
+    return json;
+}
+
+
+bool TextOperation::fromJson(const Json::Value& json, TextOperation& operation)
+{
+    if (!json.isArray()) return false;
+
+    TextOperation result;
+
+    for (Json::ArrayIndex i = 0; i < json.size(); ++i)
+    {
+        const Json::Value& component = json[i];
+
+        if (component.isString())
+        {
+            result.insert(component.asString());
+        }
+        else if (component.isIntegral() && component.asInt64() > 0)
+        {
+            result.retain(component.asInt64());
+        }
+        else if (component.isIntegral() && component.asInt64() < 0)
+        {
+            result.remove(-component.asInt64());
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    operation = result;
+
+    return true;
+}
+
+
+bool TextOperation::transform(const TextOperation& a,
+                              const TextOperation& b,
+                              TextOperation& aPrime,
+                              TextOperation& bPrime)
+{
+    if (a._baseLength != b._baseLength) return false;
+
+    aPrime = TextOperation();
+    bPrime = TextOperation();
+
+    const std::vector<Component>& components1 = a._components;
+    const std::vector<Component>& components2 = b._components;
+
+    std::size_t i1 = 0;
+    std::size_t i2 = 0;
+
+    // The components currently being consumed, with their remaining lengths.
+    bool has1 = i1 < components1.size();
+    bool has2 = i2 < components2.size();
+
+    Component op1 = has1 ? components1[i1++] : Component();
+    Component op2 = has2 ? components2[i2++] : Component();
+
+    while (has1 || has2)
+    {
+        // Inserts go first.  Ties are broken in favor of a.
+        if (has1 && op1.type == Component::INSERT)
+        {
+            aPrime.insert(op1.text);
+            bPrime.retain(op1.length);
+            has1 = i1 < components1.size();
+            if (has1) op1 = components1[i1++];
+            continue;
+        }
+
+        if (has2 && op2.type == Component::INSERT)
+        {
+            aPrime.retain(op2.length);
+            bPrime.insert(op2.text);
+            has2 = i2 < components2.size();
+            if (has2) op2 = components2[i2++];
+            continue;
+        }
+
+        // Both operations must span the same base document.
+        if (!has1 || !has2) return false;
+
+        std::size_t length = std::min(op1.length, op2.length);
+
+        if (op1.type == Component::RETAIN && op2.type == Component::RETAIN)
+        {
+            aPrime.retain(length);
+            bPrime.retain(length);
+        }
+        else if (op1.type == Component::REMOVE && op2.type == Component::RETAIN)
+        {
+            aPrime.remove(length);
+        }
+        else if (op1.type == Component::RETAIN && op2.type == Component::REMOVE)
+        {
+            bPrime.remove(length);
+        }
+        // When both delete the same range there is nothing left to do.
+
+        op1.length -= length;
+        op2.length -= length;
+
+        if (op1.length == 0)
+        {
+            has1 = i1 < components1.size();
+            if (has1) op1 = components1[i1++];
+        }
+
+        if (op2.length == 0)
+        {
+            has2 = i2 < components2.size();
+            if (has2) op2 = components2[i2++];
+        }
+    }
+
+    return true;
+}
+
+
+std::size_t TextOperation::utf16Length(const std::string& text)
+{
+    std::size_t length = 0;
+
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        unsigned char c = text[i];
+
+        // Count lead bytes only.  Four byte sequences are surrogate pairs.
+        if ((c & 0xC0) != 0x80)
+        {
+            length += (c >= 0xF0) ? 2 : 1;
+        }
+    }
+
+    return length;
+}
+
+
+bool TextOperation::_advance(const std::string& text,
+                             std::size_t& offset,
+                             std::size_t length)
+{
+    while (length > 0)
+    {
+        if (offset >= text.size()) return false;
+
+        unsigned char c = text[offset];
+
+        std::size_t units = (c >= 0xF0) ? 2 : 1;
+
+        // A retain or delete may not split a surrogate pair.
+        if (units > length) return false;
+
+        length -= units;
+
+        do
+        {
+            ++offset;
+        }
+        while (offset < text.size() && (static_cast<unsigned char>(text[offset]) & 0xC0) == 0x80);
+    }
+
+    return true;
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,97 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include <json/json.h>
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief A text edit in the ot.js format, measured in UTF-16 code units.
+class TextOperation
+{
+public:
+    struct Component
+    {
+        enum Type
+        {
+            RETAIN,
+            INSERT,
+            REMOVE
+        };
+
+        Type type;
+        std::size_t length;
+        std::string text;
+    };
+
+    TextOperation();
+
+    TextOperation& retain(std::size_t length);
+    TextOperation& insert(const std::string& text);
+    TextOperation& remove(std::size_t length);
+
+    bool isNoop() const;
+
+    std::size_t getBaseLength() const;
+
+    std::size_t getTargetLength() const;
+
+    const std::vector<Component>& getComponents() const;
+
+    bool apply(const std::string& input, std::string& output) const;
+
+    Json::Value toJson() const;
+
+    static bool fromJson(const Json::Value& json, TextOperation& operation);
+
+    /// \brief Make aPrime and bPrime so a + bPrime equals b + aPrime.
+    static bool transform(const TextOperation& a,
+                          const TextOperation& b,
+                          TextOperation& aPrime,
+                          TextOperation& bPrime);
+
+    static std::size_t utf16Length(const std::string& text);
+
+private:
+    std::vector<Component> _components;
+
+    std::size_t _baseLength;
+    std::size_t _targetLength;
+
+    static bool _advance(const std::string& text,
+                         std::size_t& offset,
+                         std::size_t length);
+
+};
+
+
+} } // namespace of::Sketch
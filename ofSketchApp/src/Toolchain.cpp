@@ -0,0 +1,87 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "Toolchain.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+const std::string Toolchain::NATIVE = "native";
+
+
+Toolchain::Toolchain():
+    name(NATIVE),
+    prefix(""),
+    toolchainRoot(""),
+    sysroot(""),
+    platformArch(""),
+    platformVariant(""),
+    ofRoot("")
+{
+}
+
+
+std::string Toolchain::getCompiler(const std::string& compiler) const
+{
+    if (toolchainRoot.empty())
+    {
+        return prefix + compiler;
+    }
+
+    return toolchainRoot + "/bin/" + prefix + compiler;
+}
+
+
+Json::Value Toolchain::toJson() const
+{
+    Json::Value json;
+    json["name"] = name;
+    json["prefix"] = prefix;
+    json["toolchainRoot"] = toolchainRoot;
+    json["sysroot"] = sysroot;
+    json["platformArch"] = platformArch;
+    json["platformVariant"] = platformVariant;
+    json["ofRoot"] = ofRoot;
+    return json;
+}
+
+
+Toolchain Toolchain::fromJson(const std::string& name, const Json::Value& json)
+{
+    Toolchain toolchain;
+    toolchain.name = name;
+    toolchain.prefix = json.get("prefix", toolchain.prefix).asString();
+    toolchain.toolchainRoot = json.get("toolchainRoot", toolchain.toolchainRoot).asString();
+    toolchain.sysroot = json.get("sysroot", toolchain.sysroot).asString();
+    toolchain.platformArch = json.get("platformArch", toolchain.platformArch).asString();
+    toolchain.platformVariant = json.get("platformVariant", toolchain.platformVariant).asString();
+    toolchain.ofRoot = json.get("ofRoot", toolchain.ofRoot).asString();
+    return toolchain;
+}
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,68 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <map>
+#include <string>
+#include <json/json.h>
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief A cross compiler for another platform, e.g. a Raspberry Pi.
+struct Toolchain
+{
+    Toolchain();
+
+    std::string name;
+
+    std::string prefix; // e.g. arm-linux-gnueabihf-, put before gcc and g++
+
+    std::string toolchainRoot; // holds bin/<prefix>gcc, empty to use PATH
+
+    std::string sysroot; // the target's root file system
+
+    std::string platformArch; // e.g. armv6l or armv7l
+
+    std::string platformVariant; // e.g. rpi
+
+    std::string ofRoot; // openFrameworks for the target, empty for the default
+
+    /// \param compiler e.g. "gcc".
+    std::string getCompiler(const std::string& compiler) const;
+
+    Json::Value toJson() const;
+
+    static Toolchain fromJson(const std::string& name, const Json::Value& json);
+
+    static const std::string NATIVE;
+};
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,849 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "TopicRouter.h"
+#include <algorithm>
+#include "Poco/Exception.h"
+#include "Poco/Net/WebSocket.h"
+#include "Poco/ThreadLocal.h"
+#include "ofLog.h"
+#include "MessagePack.h"
+#include "Utils.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+namespace {
+
+/// \brief Writes a message that has already been built.
+class JSONMessage: public WritableValue
+{
+public:
+    JSONMessage(const Json::Value& json): _json(json)
+    {
+    }
+
+    void write(ValueWriter& writer) const
+    {
+        writer.value(_json);
+    }
+
+private:
+    const Json::Value& _json;
+
+};
+
+
+/// \brief Each thread reuses one buffer to encode its frames.
+Poco::ThreadLocal<std::string> frameBuffer;
+
+}
+
+
+const std::string TopicRouter::SETTINGS_TOPIC = "settings";
+const std::string TopicRouter::TASKS_TOPIC = "tasks";
+const std::string TopicRouter::PROJECT_TOPIC_PREFIX = "project/";
+const std::string TopicRouter::TASK_TOPIC_PREFIX = "task/";
+const std::string TopicRouter::SUBSCRIBE_METHOD = "subscribe";
+const std::string TopicRouter::UNSUBSCRIBE_METHOD = "unsubscribe";
+const std::string TopicRouter::SET_ENCODING_METHOD = "set-encoding";
+
+
+TopicRouter::Settings::Settings():
+    maximumQueuedFrames(DEFAULT_MAXIMUM_QUEUED_FRAMES),
+    coalesce(true),
+    dropVerbose(true),
+    disconnect(true)
+{
+}
+
+
+TopicRouter::Settings TopicRouter::Settings::fromJson(const Json::Value& json)
+{
+    Settings settings;
+
+    settings.maximumQueuedFrames = json.get("maximumQueuedFrames", Json::UInt64(settings.maximumQueuedFrames)).asUInt();
+    settings.coalesce = json.get("coalesce", settings.coalesce).asBool();
+    settings.dropVerbose = json.get("dropVerbose", settings.dropVerbose).asBool();
+    settings.disconnect = json.get("disconnect", settings.disconnect).asBool();
+
+    if (settings.maximumQueuedFrames == 0)
+    {
+        settings.maximumQueuedFrames = 1;
+    }
+
+    return settings;
+}
+
+
+TopicRouter::QueuedFrame::QueuedFrame(const SharedFrame& frame_,
+                                      Priority priority_,
+                                      const std::string& key_):
+    frame(frame_),
+    priority(priority_),
+    key(key_)
+{
+}
+
+
+TopicRouter::Outbox::Outbox():
+    encoding(ENCODING_JSON),
+    isClosed(false),
+    sent(0),
+    coalesced(0),
+    dropped(0),
+    stalls(0),
+    peakQueued(0)
+{
+}
+
+
+Json::Value TopicRouter::Outbox::toJson() const
+{
+    Json::Value json;
+    json["address"] = address;
+    json["encoding"] = TopicRouter::toString(encoding);
+    json["queued"] = Json::UInt64(queued.size());
+    json["inFlight"] = Json::UInt64(inFlight.size());
+    json["peakQueued"] = Json::UInt64(peakQueued);
+    json["sent"] = Json::UInt64(sent);
+    json["coalesced"] = Json::UInt64(coalesced);
+    json["dropped"] = Json::UInt64(dropped);
+    json["stalls"] = Json::UInt64(stalls);
+    json["closed"] = isClosed;
+    return json;
+}
+
+
+TopicRouter::TopicRouter()
+{
+}
+
+
+void TopicRouter::setSettings(const Settings& settings)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _settings = settings;
+}
+
+
+TopicRouter::Settings TopicRouter::getSettings() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return _settings;
+}
+
+
+void TopicRouter::addConnection(ofx::HTTP::WebSocketConnection& connection)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _outboxes[&connection].address = connection.getClientAddress().toString();
+}
+
+
+void TopicRouter::removeConnection(ofx::HTTP::WebSocketConnection& connection)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<ofx::HTTP::WebSocketConnection*, std::set<std::string> >::iterator iter = _topics.find(&connection);
+
+    if (iter != _topics.end())
+    {
+        std::set<std::string> topics = iter->second;
+        std::set<std::string>::const_iterator topic = topics.begin();
+
+        for (; topic != topics.end(); ++topic)
+        {
+            _unsubscribe(&connection, *topic);
+        }
+    }
+
+    _topics.erase(&connection);
+    _outboxes.erase(&connection);
+}
+
+
+bool TopicRouter::handleFrame(ofx::HTTP::WebSocketConnection& connection,
+                              const std::string& text)
+{
+    // Most frames are other calls, so only parse the likely ones.
+    if (text.find(SUBSCRIBE_METHOD) == std::string::npos
+     && text.find(SET_ENCODING_METHOD) == std::string::npos)
+    {
+        return false;
+    }
+
+    // Saved projects and the like can be large, so check what the calls
+    // are before parsing the whole frame.
+    if (!_isRouterFrame(text))
+    {
+        return false;
+    }
+
+    Json::Value json;
+    Json::Reader reader;
+
+    if (!reader.parse(text, json))
+    {
+        return false;
+    }
+
+    return handleCalls(connection, json);
+}
+
+
+bool TopicRouter::handleCalls(ofx::HTTP::WebSocketConnection& connection,
+                              const Json::Value& json)
+{
+    if (!json.isArray())
+    {
+        return _handleCall(connection, json);
+    }
+
+    // A batch may hold subscriptions among other calls.
+    bool isSubscription = false;
+
+    for (unsigned int i = 0; i < json.size(); ++i)
+    {
+        isSubscription = _handleCall(connection, json[i]) || isSubscription;
+    }
+
+    return isSubscription;
+}
+
+
+TopicRouter::Encoding TopicRouter::getEncoding(ofx::HTTP::WebSocketConnection& connection) const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<ofx::HTTP::WebSocketConnection*, Outbox>::const_iterator iter = _outboxes.find(&connection);
+
+    return iter != _outboxes.end() ? iter->second.encoding : ENCODING_JSON;
+}
+
+
+void TopicRouter::frameSent(ofx::HTTP::WebSocketConnection& connection,
+                            const ofx::HTTP::WebSocketFrame& frame)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<ofx::HTTP::WebSocketConnection*, Outbox>::iterator iter = _outboxes.find(&connection);
+
+    // Every data frame is sent through an outbox, but the close frame
+    // is sent directly.
+    if (iter != _outboxes.end()
+     && !iter->second.inFlight.empty()
+     && !_isControlFrame(frame))
+    {
+        iter->second.inFlight.pop_front();
+        iter->second.lastProgress.update();
+        ++iter->second.sent;
+        _send(&connection, iter->second);
+    }
+}
+
+
+void TopicRouter::update()
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<ofx::HTTP::WebSocketConnection*, Outbox>::iterator iter = _outboxes.begin();
+
+    for (; iter != _outboxes.end(); ++iter)
+    {
+        _send(iter->first, iter->second);
+    }
+}
+
+
+std::size_t TopicRouter::publish(const std::string& topic,
+                                 const Json::Value& message,
+                                 Priority priority,
+                                 const std::string& key)
+{
+    return publish(std::vector<std::string>(1, topic), message, priority, key);
+}
+
+
+std::size_t TopicRouter::publish(const std::vector<std::string>& topics,
+                                 const Json::Value& message,
+                                 Priority priority,
+                                 const std::string& key)
+{
+    return publish(topics, JSONMessage(message), priority, key);
+}
+
+
+std::size_t TopicRouter::publish(const std::vector<std::string>& topics,
+                                 const WritableValue& message,
+                                 Priority priority,
+                                 const std::string& key)
+{
+    Connections recipients;
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+
+        for (std::size_t i = 0; i < topics.size(); ++i)
+        {
+            std::map<std::string, Connections>::const_iterator iter = _subscribers.find(topics[i]);
+
+            if (iter != _subscribers.end())
+            {
+                recipients.insert(iter->second.begin(), iter->second.end());
+            }
+        }
+    }
+
+    return _deliver(recipients, message, priority, key);
+}
+
+
+std::size_t TopicRouter::broadcast(const Json::Value& message)
+{
+    Connections recipients;
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+
+        std::map<ofx::HTTP::WebSocketConnection*, Outbox>::const_iterator iter = _outboxes.begin();
+
+        for (; iter != _outboxes.end(); ++iter)
+        {
+            recipients.insert(iter->first);
+        }
+    }
+
+    return _deliver(recipients, JSONMessage(message), PRIORITY_REQUIRED, "");
+}
+
+
+bool TopicRouter::send(ofx::HTTP::WebSocketConnection& connection,
+                       const SharedFrame& frame,
+                       Priority priority)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::map<ofx::HTTP::WebSocketConnection*, Outbox>::const_iterator iter = _outboxes.find(&connection);
+
+    if (iter == _outboxes.end() || iter->second.isClosed)
+    {
+        return false;
+    }
+
+    _enqueue(&connection, frame, priority, "");
+    return true;
+}
+
+
+bool TopicRouter::send(ofx::HTTP::WebSocketConnection& connection,
+                       const Json::Value& message,
+                       Priority priority)
+{
+    return send(connection, makeFrame(message, getEncoding(connection)), priority);
+}
+
+
+TopicRouter::SharedFrame TopicRouter::makeFrame(const Json::Value& json,
+                                                Encoding encoding)
+{
+    return makeFrame(JSONMessage(json), encoding);
+}
+
+
+TopicRouter::SharedFrame TopicRouter::makeFrame(const WritableValue& message,
+                                                Encoding encoding)
+{
+    std::string& buffer = *frameBuffer;
+    buffer.clear();
+
+    if (encoding == ENCODING_MESSAGEPACK)
+    {
+        MessagePack::Writer writer(buffer);
+        message.write(writer);
+        return SharedFrame(new ofx::HTTP::WebSocketFrame(buffer, Poco::Net::WebSocket::FRAME_BINARY));
+    }
+
+    JSONWriter writer(buffer);
+    message.write(writer);
+    return SharedFrame(new ofx::HTTP::WebSocketFrame(buffer));
+}
+
+
+bool TopicRouter::getEncoding(const std::string& name, Encoding& encoding)
+{
+    if (name == "json")
+    {
+        encoding = ENCODING_JSON;
+        return true;
+    }
+    else if (name == "msgpack")
+    {
+        encoding = ENCODING_MESSAGEPACK;
+        return true;
+    }
+
+    return false;
+}
+
+
+std::string TopicRouter::toString(Encoding encoding)
+{
+    return encoding == ENCODING_MESSAGEPACK ? "msgpack" : "json";
+}
+
+
+Json::Value TopicRouter::toJson() const
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    Json::Value json;
+    json["connections"] = Json::Value(Json::arrayValue);
+    json["topics"] = Json::Value(Json::objectValue);
+
+    std::map<ofx::HTTP::WebSocketConnection*, Outbox>::const_iterator outbox = _outboxes.begin();
+
+    for (; outbox != _outboxes.end(); ++outbox)
+    {
+        json["connections"].append(outbox->second.toJson());
+    }
+
+    std::map<std::string, Connections>::const_iterator iter = _subscribers.begin();
+
+    for (; iter != _subscribers.end(); ++iter)
+    {
+        json["topics"][iter->first] = Json::UInt64(iter->second.size());
+    }
+
+    json["maximumQueuedFrames"] = Json::UInt64(_settings.maximumQueuedFrames);
+
+    return json;
+}
+
+
+bool TopicRouter::isValidTopic(const std::string& topic)
+{
+    if (topic == SETTINGS_TOPIC || topic == TASKS_TOPIC)
+    {
+        return true;
+    }
+    else if (topic.compare(0, PROJECT_TOPIC_PREFIX.size(), PROJECT_TOPIC_PREFIX) == 0)
+    {
+        return topic.size() > PROJECT_TOPIC_PREFIX.size();
+    }
+    else if (topic.compare(0, TASK_TOPIC_PREFIX.size(), TASK_TOPIC_PREFIX) == 0)
+    {
+        try
+        {
+            Poco::UUID uuid(topic.substr(TASK_TOPIC_PREFIX.size()));
+            return true;
+        }
+        catch (const Poco::SyntaxException& exc)
+        {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+
+std::string TopicRouter::getProjectTopic(const std::string& projectName)
+{
+    return PROJECT_TOPIC_PREFIX + projectName;
+}
+
+
+std::string TopicRouter::getTaskTopic(const Poco::UUID& taskId)
+{
+    return TASK_TOPIC_PREFIX + taskId.toString();
+}
+
+
+bool TopicRouter::_handleCall(ofx::HTTP::WebSocketConnection& connection,
+                              const Json::Value& json)
+{
+    if (!json.isObject())
+    {
+        return false;
+    }
+
+    std::string method = json["method"].asString();
+
+    if (method == SET_ENCODING_METHOD)
+    {
+        Encoding encoding;
+
+        // The set-encoding method answers unknown encodings with an error.
+        if (getEncoding(json["params"]["encoding"].asString(), encoding))
+        {
+            Poco::FastMutex::ScopedLock lock(_mutex);
+
+            std::map<ofx::HTTP::WebSocketConnection*, Outbox>::iterator iter = _outboxes.find(&connection);
+
+            if (iter != _outboxes.end())
+            {
+                iter->second.encoding = encoding;
+            }
+        }
+
+        return false;
+    }
+    else if (method != SUBSCRIBE_METHOD && method != UNSUBSCRIBE_METHOD)
+    {
+        return false;
+    }
+
+    const Json::Value& topics = json["params"]["topics"];
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    for (unsigned int i = 0; i < topics.size(); ++i)
+    {
+        std::string topic = topics[i].asString();
+
+        if (!isValidTopic(topic))
+        {
+            ofLogWarning("TopicRouter::_handleCall") << "Ignoring an invalid topic: " << topic;
+        }
+        else if (method == SUBSCRIBE_METHOD)
+        {
+            _subscribe(&connection, topic);
+        }
+        else
+        {
+            _unsubscribe(&connection, topic);
+        }
+    }
+
+    return true;
+}
+
+
+void TopicRouter::_subscribe(ofx::HTTP::WebSocketConnection* connection,
+                             const std::string& topic)
+{
+    std::set<std::string>& topics = _topics[connection];
+
+    if (topics.size() >= MAXIMUM_TOPICS_PER_CONNECTION && topics.find(topic) == topics.end())
+    {
+        ofLogWarning("TopicRouter::_subscribe") << "Too many subscriptions, ignoring " << topic;
+        return;
+    }
+
+    topics.insert(topic);
+    _subscribers[topic].insert(connection);
+}
+
+
+void TopicRouter::_unsubscribe(ofx::HTTP::WebSocketConnection* connection,
+                               const std::string& topic)
+{
+    std::map<std::string, Connections>::iterator iter = _subscribers.find(topic);
+
+    if (iter != _subscribers.end())
+    {
+        iter->second.erase(connection);
+
+        if (iter->second.empty())
+        {
+            _subscribers.erase(iter);
+        }
+    }
+
+    std::map<ofx::HTTP::WebSocketConnection*, std::set<std::string> >::iterator topics = _topics.find(connection);
+
+    if (topics != _topics.end())
+    {
+        topics->second.erase(topic);
+    }
+}
+
+
+std::size_t TopicRouter::_deliver(const Connections& recipients,
+                                  const WritableValue& message,
+                                  Priority priority,
+                                  const std::string& key)
+{
+    if (recipients.empty())
+    {
+        return 0;
+    }
+
+    // Encode the message outside the lock, once for each encoding the
+    // recipients asked for.
+    bool isNeeded[2] = { false, false };
+
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+
+        Connections::const_iterator iter = recipients.begin();
+
+        for (; iter != recipients.end(); ++iter)
+        {
+            std::map<ofx::HTTP::WebSocketConnection*, Outbox>::const_iterator outbox = _outboxes.find(*iter);
+
+            if (outbox != _outboxes.end())
+            {
+                isNeeded[outbox->second.encoding] = true;
+            }
+        }
+    }
+
+    SharedFrame frames[2];
+
+    for (int i = 0; i < 2; ++i)
+    {
+        if (isNeeded[i])
+        {
+            frames[i] = makeFrame(message, Encoding(i));
+        }
+    }
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    std::size_t count = 0;
+
+    Connections::const_iterator iter = recipients.begin();
+
+    for (; iter != recipients.end(); ++iter)
+    {
+        std::map<ofx::HTTP::WebSocketConnection*, Outbox>::const_iterator outbox = _outboxes.find(*iter);
+
+        // The connection may have closed, or changed its encoding, since.
+        if (outbox == _outboxes.end())
+        {
+            continue;
+        }
+
+        Encoding encoding = outbox->second.encoding;
+
+        if (frames[encoding].isNull())
+        {
+            frames[encoding] = makeFrame(message, encoding);
+        }
+
+        _enqueue(*iter, frames[encoding], priority, key);
+        ++count;
+    }
+
+    return count;
+}
+
+
+void TopicRouter::_enqueue(ofx::HTTP::WebSocketConnection* connection,
+                           const SharedFrame& frame,
+                           Priority priority,
+                           const std::string& key)
+{
+    std::map<ofx::HTTP::WebSocketConnection*, Outbox>::iterator iter = _outboxes.find(connection);
+
+    if (iter == _outboxes.end())
+    {
+        return;
+    }
+
+    Outbox& outbox = iter->second;
+
+    if (outbox.isClosed)
+    {
+        ++outbox.dropped;
+        return;
+    }
+
+    // A queued frame hasn't been handed over yet, so a newer one with the
+    // same key can take its place without reordering anything.
+    if (priority == PRIORITY_LATEST && _settings.coalesce && !key.empty())
+    {
+        std::deque<QueuedFrame>::iterator queued = outbox.queued.begin();
+
+        for (; queued != outbox.queued.end(); ++queued)
+        {
+            if (queued->priority == PRIORITY_LATEST && queued->key == key)
+            {
+                queued->frame = frame;
+                ++outbox.coalesced;
+                return;
+            }
+        }
+    }
+
+    if (outbox.queued.size() >= _settings.maximumQueuedFrames
+     && !_makeRoom(connection, outbox, priority))
+    {
+        return;
+    }
+
+    outbox.queued.push_back(QueuedFrame(frame, priority, key));
+    outbox.peakQueued = std::max(outbox.peakQueued, outbox.queued.size());
+
+    _send(connection, outbox);
+}
+
+
+bool TopicRouter::_makeRoom(ofx::HTTP::WebSocketConnection* connection,
+                            Outbox& outbox,
+                            Priority priority)
+{
+    if (_settings.dropVerbose)
+    {
+        if (priority == PRIORITY_VERBOSE)
+        {
+            ++outbox.dropped;
+            return false;
+        }
+
+        std::deque<QueuedFrame>::iterator queued = outbox.queued.begin();
+
+        for (; queued != outbox.queued.end(); ++queued)
+        {
+            if (queued->priority == PRIORITY_VERBOSE)
+            {
+                outbox.queued.erase(queued);
+                ++outbox.dropped;
+                return true;
+            }
+        }
+    }
+
+    if (_settings.disconnect)
+    {
+        ofLogWarning("TopicRouter::_makeRoom") << "Closing " << outbox.address << ", which is " << outbox.queued.size() << " frames behind.";
+        _close(connection, outbox);
+        return false;
+    }
+
+    outbox.queued.pop_front();
+    ++outbox.dropped;
+    return true;
+}
+
+
+void TopicRouter::_close(ofx::HTTP::WebSocketConnection* connection, Outbox& outbox)
+{
+    outbox.dropped += outbox.queued.size() + 1;
+    outbox.queued.clear();
+    outbox.isClosed = true;
+
+    // The close payload is a big-endian status code and a reason.  The
+    // connection finishes closing when the client answers it.
+    std::string payload;
+    payload += char((SLOW_CONSUMER_CLOSE_CODE >> 8) & 0xFF);
+    payload += char(SLOW_CONSUMER_CLOSE_CODE & 0xFF);
+    payload += "Too far behind.";
+
+    connection->sendFrame(ofx::HTTP::WebSocketFrame(payload,
+                                                    Poco::Net::WebSocket::FRAME_FLAG_FIN | Poco::Net::WebSocket::FRAME_OP_CLOSE));
+}
+
+
+void TopicRouter::_send(ofx::HTTP::WebSocketConnection* connection, Outbox& outbox)
+{
+    // Don't let a missed report hold up the outbox for good.
+    if (outbox.inFlight.size() >= MAXIMUM_FRAMES_IN_FLIGHT
+     && !outbox.queued.empty()
+     && outbox.lastProgress.isElapsed(Poco::Timestamp::TimeDiff(IN_FLIGHT_TIMEOUT) * 1000))
+    {
+        ofLogWarning("TopicRouter::_send") << "No frames sent to " << outbox.address << " in " << IN_FLIGHT_TIMEOUT << " ms, sending more.";
+        outbox.inFlight.clear();
+        ++outbox.stalls;
+    }
+
+    while (!outbox.queued.empty() && outbox.inFlight.size() < MAXIMUM_FRAMES_IN_FLIGHT)
+    {
+        SharedFrame frame = outbox.queued.front().frame;
+        outbox.queued.pop_front();
+
+        if (connection->sendFrame(*frame))
+        {
+            outbox.inFlight.push_back(frame);
+            outbox.lastProgress.update();
+        }
+        else
+        {
+            ++outbox.dropped;
+        }
+    }
+}
+
+
+bool TopicRouter::_isRouterFrame(const std::string& text)
+{
+    JSONReader reader(text);
+    JSONReader::Token token = reader.next();
+    bool isBatch = (token == JSONReader::TOKEN_BEGIN_ARRAY);
+
+    if (isBatch)
+    {
+        token = reader.next();
+    }
+
+    // Look at the method of each call, and skip everything else.
+    while (token == JSONReader::TOKEN_BEGIN_OBJECT)
+    {
+        while ((token = reader.next()) == JSONReader::TOKEN_KEY)
+        {
+            if (!reader.isString("method"))
+            {
+                if (!reader.skipValue())
+                {
+                    return false;
+                }
+            }
+            else if (reader.next() == JSONReader::TOKEN_STRING)
+            {
+                if (reader.isString(SUBSCRIBE_METHOD)
+                 || reader.isString(UNSUBSCRIBE_METHOD)
+                 || reader.isString(SET_ENCODING_METHOD))
+                {
+                    return true;
+                }
+            }
+            else if (!reader.skipValue())
+            {
+                return false;
+            }
+        }
+
+        if (token != JSONReader::TOKEN_END_OBJECT || !isBatch)
+        {
+            return false;
+        }
+
+        token = reader.next();
+    }
+
+    return false;
+}
+
+
+bool TopicRouter::_isControlFrame(const ofx::HTTP::WebSocketFrame& frame)
+{
+    return (frame.getFlags() & Poco::Net::WebSocket::FRAME_OP_BITMASK) >= Poco::Net::WebSocket::FRAME_OP_CLOSE;
+}
+
+} } // namespace of::Sketch
@@ -0,0 +1,261 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <json/json.h>
+#include "Poco/Mutex.h"
+#include "Poco/SharedPtr.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Types.h"
+#include "Poco/UUID.h"
+#include "ofxHTTP.h"
+#include "Utils.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Routes server messages to the websocket connections subscribed
+///        to them, through a bounded outbox per connection.
+class TopicRouter
+{
+public:
+    typedef Poco::SharedPtr<const ofx::HTTP::WebSocketFrame> SharedFrame;
+
+    /// \brief What may be done with a frame when its connection can't
+    ///        keep up.
+    enum Priority
+    {
+        PRIORITY_REQUIRED, // always delivered, in order
+        PRIORITY_LATEST,   // only the newest with the same key, e.g. progress
+        PRIORITY_VERBOSE   // may be dropped, e.g. build output
+    };
+
+    enum Encoding
+    {
+        ENCODING_JSON,
+        ENCODING_MESSAGEPACK
+    };
+
+    struct Settings
+    {
+        Settings();
+
+        std::size_t maximumQueuedFrames; // per connection
+        bool coalesce; // replace queued PRIORITY_LATEST frames
+        bool dropVerbose; // drop PRIORITY_VERBOSE frames when full
+        bool disconnect; // close a full connection, or drop its oldest frame
+
+        static Settings fromJson(const Json::Value& json);
+    };
+
+    TopicRouter();
+
+    void setSettings(const Settings& settings);
+
+    Settings getSettings() const;
+
+    void addConnection(ofx::HTTP::WebSocketConnection& connection);
+    void removeConnection(ofx::HTTP::WebSocketConnection& connection);
+
+    /// \returns true if the frame held a subscription call.
+    bool handleFrame(ofx::HTTP::WebSocketConnection& connection,
+                     const std::string& text);
+
+    bool handleCalls(ofx::HTTP::WebSocketConnection& connection,
+                     const Json::Value& json);
+
+    Encoding getEncoding(ofx::HTTP::WebSocketConnection& connection) const;
+
+    /// \brief Hand the connection more frames once it has sent one.
+    void frameSent(ofx::HTTP::WebSocketConnection& connection,
+                   const ofx::HTTP::WebSocketFrame& frame);
+
+    /// \brief Hand more frames to connections whose frames timed out.
+    void update();
+
+    /// \param key Identifies the frames a PRIORITY_LATEST frame replaces.
+    std::size_t publish(const std::string& topic,
+                        const Json::Value& message,
+                        Priority priority = PRIORITY_REQUIRED,
+                        const std::string& key = "");
+
+    std::size_t publish(const std::vector<std::string>& topics,
+                        const Json::Value& message,
+                        Priority priority = PRIORITY_REQUIRED,
+                        const std::string& key = "");
+
+    std::size_t publish(const std::vector<std::string>& topics,
+                        const WritableValue& message,
+                        Priority priority = PRIORITY_REQUIRED,
+                        const std::string& key = "");
+
+    std::size_t broadcast(const Json::Value& message);
+
+    /// \returns false if the connection is gone or was closed.
+    bool send(ofx::HTTP::WebSocketConnection& connection,
+              const SharedFrame& frame,
+              Priority priority = PRIORITY_REQUIRED);
+
+    bool send(ofx::HTTP::WebSocketConnection& connection,
+              const Json::Value& message,
+              Priority priority = PRIORITY_REQUIRED);
+
+    static SharedFrame makeFrame(const Json::Value& json,
+                                 Encoding encoding = ENCODING_JSON);
+
+    static SharedFrame makeFrame(const WritableValue& message,
+                                 Encoding encoding = ENCODING_JSON);
+
+    /// \param name "json" or "msgpack".
+    static bool getEncoding(const std::string& name, Encoding& encoding);
+
+    static std::string toString(Encoding encoding);
+
+    Json::Value toJson() const;
+
+    static bool isValidTopic(const std::string& topic);
+
+    static std::string getProjectTopic(const std::string& projectName);
+    static std::string getTaskTopic(const Poco::UUID& taskId);
+
+    static const std::string SETTINGS_TOPIC;
+    static const std::string TASKS_TOPIC;
+
+    static const std::string PROJECT_TOPIC_PREFIX;
+    static const std::string TASK_TOPIC_PREFIX;
+
+    static const std::string SUBSCRIBE_METHOD;
+    static const std::string UNSUBSCRIBE_METHOD;
+    static const std::string SET_ENCODING_METHOD;
+
+    enum
+    {
+        MAXIMUM_TOPICS_PER_CONNECTION = 64,
+
+        /// \brief Frames handed to a connection and not yet sent.
+        MAXIMUM_FRAMES_IN_FLIGHT = 2,
+
+        DEFAULT_MAXIMUM_QUEUED_FRAMES = 256,
+
+        /// \brief In ms, after which frames in flight are assumed sent.
+        IN_FLIGHT_TIMEOUT = 10000,
+
+        /// \brief "Try Again Later".
+        SLOW_CONSUMER_CLOSE_CODE = 1013
+    };
+
+private:
+    typedef std::set<ofx::HTTP::WebSocketConnection*> Connections;
+
+    struct QueuedFrame
+    {
+        QueuedFrame(const SharedFrame& frame,
+                    Priority priority,
+                    const std::string& key);
+
+        SharedFrame frame;
+        Priority priority;
+        std::string key;
+    };
+
+    struct Outbox
+    {
+        Outbox();
+
+        std::deque<QueuedFrame> queued;
+        std::deque<SharedFrame> inFlight;
+
+        Poco::Timestamp lastProgress;
+
+        std::string address;
+
+        Encoding encoding;
+
+        bool isClosed; // for falling behind
+
+        Poco::UInt64 sent;
+        Poco::UInt64 coalesced;
+        Poco::UInt64 dropped;
+
+        Poco::UInt64 stalls;
+        std::size_t peakQueued;
+
+        Json::Value toJson() const;
+    };
+
+    Settings _settings;
+
+    std::map<ofx::HTTP::WebSocketConnection*, Outbox> _outboxes;
+
+    std::map<std::string, Connections> _subscribers;
+    std::map<ofx::HTTP::WebSocketConnection*, std::set<std::string> > _topics;
+
+    mutable Poco::FastMutex _mutex;
+
+    bool _handleCall(ofx::HTTP::WebSocketConnection& connection,
+                     const Json::Value& json);
+
+    void _subscribe(ofx::HTTP::WebSocketConnection* connection,
+                    const std::string& topic);
+
+    void _unsubscribe(ofx::HTTP::WebSocketConnection* connection,
+                      const std::string& topic);
+
+    std::size_t _deliver(const Connections& recipients,
+                         const WritableValue& message,
+                         Priority priority,
+                         const std::string& key);
+
+    void _enqueue(ofx::HTTP::WebSocketConnection* connection,
+                  const SharedFrame& frame,
+                  Priority priority,
+                  const std::string& key);
+
+    /// \returns false if the frame should not be queued.
+    bool _makeRoom(ofx::HTTP::WebSocketConnection* connection,
+                   Outbox& outbox,
+                   Priority priority);
+
+    void _close(ofx::HTTP::WebSocketConnection* connection, Outbox& outbox);
+
+    void _send(ofx::HTTP::WebSocketConnection* connection, Outbox& outbox);
+
+    static bool _isRouterFrame(const std::string& text);
+
+    static bool _isControlFrame(const ofx::HTTP::WebSocketFrame& frame);
+
+};
+
+
+} } // namespace of::Sketch
@@ -0,0 +1,384 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "UnityBuild.h"
+#include <algorithm>
+#include "Poco/DirectoryIterator.h"
+#include "Poco/File.h"
+#include "Poco/Path.h"
+#include "Poco/RegularExpression.h"
+#include "ofFileUtils.h"
+#include "ofLog.h"
+#include "ofUtils.h"
+#include "FileTransaction.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+const std::string UnityBuild::FILE_PREFIX = "ofSketchUnity";
+const std::string UnityBuild::CONFIG_MARKER = "# Generated by ofSketch for a unity build.";
+const std::string UnityBuild::FAILED_FILE = ".ofSketchUnityFailed";
+const std::string UnityBuild::RETRY_MESSAGE = "The unity build failed, building addon sources separately.";
+
+
+namespace {
+
+
+struct Unit
+{
+    Poco::File::FileSize size;
+    std::vector<std::string> sources;
+};
+
+
+bool isUnitSource(const std::string& path)
+{
+    std::string extension = Poco::Path(path).getExtension();
+    return extension == "cpp" || extension == "cc" || extension == "cxx";
+}
+
+
+/// \brief Rewriting a file, even with the same contents, changes its mtime
+///        and so makes make rebuild it.
+bool hasContents(const std::string& path, const std::string& contents)
+{
+    return ofFile::doesFileExist(path, false)
+        && ofBufferFromFile(path, true).getText() == contents;
+}
+
+
+}
+
+
+bool UnityBuild::generate(const Project& project,
+                          const std::string& ofRoot,
+                          std::size_t numUnits)
+{
+    std::vector<std::string> addons = project.getAddons();
+
+    if (!project.isUnityBuild() || addons.empty() || numUnits == 0)
+    {
+        _removeConfig(project);
+        _removeUnits(project, 0);
+        return false;
+    }
+
+    // The unity build is set up through config.make, so it can't be used
+    // alongside one that the user wrote.
+    if (_hasUserConfig(project))
+    {
+        ofLogNotice("UnityBuild::generate") << "Skipping the unity build of " << project.getName() << ", it has its own config.make.";
+        _removeUnits(project, 0);
+        return false;
+    }
+
+    ofFile failedFile(project.getPath() + "/" + FAILED_FILE);
+
+    if (failedFile.exists() && ofBufferFromFile(failedFile.path()).getText() == _getSignature(project))
+    {
+        ofLogVerbose("UnityBuild::generate") << "Skipping the unity build of " << project.getName() << ", it failed before with these addons.";
+        _removeConfig(project);
+        _removeUnits(project, 0);
+        return false;
+    }
+
+    std::vector<std::string> sources;
+
+    for (std::size_t i = 0; i < addons.size(); ++i)
+    {
+        std::string addonPath = ofRoot + "/addons/" + addons[i];
+
+        _findSources(addonPath + "/src", sources);
+
+        // Bundled libraries are built from libs/<name>/src.
+        Poco::File libs(addonPath + "/libs");
+
+        if (libs.exists() && libs.isDirectory())
+        {
+            Poco::DirectoryIterator iter(libs);
+            Poco::DirectoryIterator end;
+
+            for (; iter != end; ++iter)
+            {
+                _findSources(iter->path() + "/src", sources);
+            }
+        }
+    }
+
+    std::vector<std::string> unitSources;
+    std::vector<std::string> otherSources;
+
+    for (std::size_t i = 0; i < sources.size(); ++i)
+    {
+        if (isUnitSource(sources[i])) unitSources.push_back(sources[i]);
+        else otherSources.push_back(sources[i]);
+    }
+
+    if (unitSources.empty())
+    {
+        _removeConfig(project);
+        _removeUnits(project, 0);
+        return false;
+    }
+
+    // Fill the smallest unit with the largest remaining source, so that the
+    // units take about as long as each other to compile in parallel.
+    std::vector<std::pair<Poco::File::FileSize, std::string> > sizes;
+
+    for (std::size_t i = 0; i < unitSources.size(); ++i)
+    {
+        sizes.push_back(std::make_pair(Poco::File(unitSources[i]).getSize(), unitSources[i]));
+    }
+
+    std::sort(sizes.rbegin(), sizes.rend());
+
+    std::vector<Unit> units(std::min(numUnits, unitSources.size()));
+
+    for (std::size_t i = 0; i < units.size(); ++i)
+    {
+        units[i].size = 0;
+    }
+
+    for (std::size_t i = 0; i < sizes.size(); ++i)
+    {
+        std::size_t smallest = 0;
+
+        for (std::size_t j = 1; j < units.size(); ++j)
+        {
+            if (units[j].size < units[smallest].size) smallest = j;
+        }
+
+        units[smallest].size += sizes[i].first;
+        units[smallest].sources.push_back(sizes[i].second);
+    }
+
+    FileTransaction transaction;
+
+    for (std::size_t i = 0; i < units.size(); ++i)
+    {
+        std::sort(units[i].sources.begin(), units[i].sources.end());
+
+        std::string unit = "// Generated by ofSketch.  A unity build of addon sources.\n";
+
+        for (std::size_t j = 0; j < units[i].sources.size(); ++j)
+        {
+            unit += "#include \"" + units[i].sources[j] + "\"\n";
+        }
+
+        std::string path = project.getPath() + "/src/" + FILE_PREFIX + ofToString(i) + ".cpp";
+
+        if (!hasContents(path, unit))
+        {
+            transaction.write(path, unit);
+        }
+    }
+
+    std::string config = CONFIG_MARKER + "\n";
+    config += "# Addon C++ sources are compiled through src/" + FILE_PREFIX + "*.cpp.\n";
+    config += "override PROJECT_ADDONS_SOURCE_FILES :=";
+
+    for (std::size_t i = 0; i < otherSources.size(); ++i)
+    {
+        config += " \\\n\t" + otherSources[i];
+    }
+
+    config += "\n";
+
+    if (!hasContents(project.getPath() + "/config.make", config))
+    {
+        transaction.write(project.getPath() + "/config.make", config);
+    }
+
+    if (!transaction.empty() && !transaction.commit())
+    {
+        ofLogError("UnityBuild::generate") << "Unable to write the unity build of " << project.getName();
+        return false;
+    }
+
+    // Fewer units than before, e.g. after an addon was removed.
+    _removeUnits(project, units.size());
+
+    ofLogVerbose("UnityBuild::generate") << "Compiling " << unitSources.size() << " addon sources of " << project.getName() << " as " << units.size() << " units.";
+
+    return true;
+}
+
+
+bool UnityBuild::isGenerated(const Project& project)
+{
+    return ofFile(project.getPath() + "/src/" + FILE_PREFIX + "0.cpp").exists();
+}
+
+
+void UnityBuild::disable(const Project& project)
+{
+    FileTransaction transaction;
+
+    if (!transaction.write(project.getPath() + "/" + FAILED_FILE, _getSignature(project))
+     || !transaction.commit())
+    {
+        ofLogWarning("UnityBuild::disable") << "Unable to record the failed unity build of " << project.getName();
+    }
+
+    _removeConfig(project);
+    _removeUnits(project, 0);
+}
+
+
+UnityBuild::IncludeStack::IncludeStack():
+    isInUnit(false)
+{
+}
+
+
+bool UnityBuild::isUnityError(const std::string& line, IncludeStack& stack)
+{
+    // i.e. In file included from src/ofSketchUnity0.cpp:3:
+    //      or                  from src/ofSketchUnity0.cpp:3,
+    Poco::RegularExpression includeExpression("^(In file included | +)from (.+?):[0-9]+[:,]$");
+
+    // i.e. /path/to/addons/ofxFoo/src/Foo.cpp:12:5: error: redefinition of 'bar'
+    Poco::RegularExpression errorExpression("^(.+?):[0-9]+(:[0-9]+)?: (fatal error|error|warning|note): ");
+
+    std::vector<std::string> vals;
+
+    if (includeExpression.split(line, vals) == 3)
+    {
+        // A new stack replaces the last one.
+        if (line.compare(0, 2, "In") == 0)
+        {
+            stack.isInUnit = false;
+            stack.file.clear();
+        }
+
+        stack.isInUnit = stack.isInUnit || _isUnitPath(vals[2]);
+        return false;
+    }
+    else if (errorExpression.split(line, vals) == 4)
+    {
+        if (stack.isInUnit)
+        {
+            stack.isInUnit = false;
+            stack.file = vals[1];
+        }
+
+        return (vals[3] == "error" || vals[3] == "fatal error")
+            && (_isUnitPath(vals[1]) || vals[1] == stack.file);
+    }
+
+    return false;
+}
+
+
+void UnityBuild::_removeConfig(const Project& project)
+{
+    ofFile config(project.getPath() + "/config.make");
+
+    // Leave a config.make that the user wrote alone.
+    if (config.exists() && ofBufferFromFile(config.path()).getFirstLine() == CONFIG_MARKER)
+    {
+        config.remove();
+    }
+}
+
+
+bool UnityBuild::_hasUserConfig(const Project& project)
+{
+    ofFile config(project.getPath() + "/config.make");
+
+    return config.exists()
+        && ofBufferFromFile(config.path()).getFirstLine() != CONFIG_MARKER;
+}
+
+
+void UnityBuild::_removeUnits(const Project& project, std::size_t first)
+{
+    for (std::size_t i = first; ; ++i)
+    {
+        ofFile unit(project.getPath() + "/src/" + FILE_PREFIX + ofToString(i) + ".cpp");
+
+        if (!unit.exists())
+        {
+            break;
+        }
+
+        unit.remove();
+    }
+}
+
+
+bool UnityBuild::_isUnitPath(const std::string& path)
+{
+    return Poco::Path(path).getFileName().compare(0, FILE_PREFIX.size(), FILE_PREFIX) == 0;
+}
+
+
+void UnityBuild::_findSources(const std::string& path,
+                              std::vector<std::string>& sources)
+{
+    try
+    {
+        Poco::File directory(path);
+
+        if (!directory.exists() || !directory.isDirectory())
+        {
+            return;
+        }
+
+        Poco::DirectoryIterator iter(directory);
+        Poco::DirectoryIterator end;
+
+        for (; iter != end; ++iter)
+        {
+            std::string extension = Poco::Path(iter->path()).getExtension();
+
+            if (iter->isDirectory())
+            {
+                _findSources(iter->path(), sources);
+            }
+            else if (extension == "cpp" || extension == "cc" || extension == "cxx"
+                  || extension == "c" || extension == "m" || extension == "mm"
+                  || extension == "S")
+            {
+                sources.push_back(iter->path());
+            }
+        }
+    }
+    catch (const Poco::Exception& exc)
+    {
+        ofLogError("UnityBuild::_findSources") << exc.displayText();
+    }
+}
+
+
+std::string UnityBuild::_getSignature(const Project& project)
+{
+    return ofJoinString(project.getAddons(), "\n");
+}
+
+
+} } // namespace of::Sketch
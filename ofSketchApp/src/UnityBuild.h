@@ -0,0 +1,93 @@
+// =============================================================================
+//
+// Copyright (c) 2013-2014 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include "Project.h"
+
+
+namespace of {
+namespace Sketch {
+
+
+/// \brief Compiles a project's addon sources as a few large translation
+///        units, so the shared headers are parsed once per unit.
+class UnityBuild
+{
+public:
+    /// \returns true if a unity build was generated.
+    static bool generate(const Project& project,
+                         const std::string& ofRoot,
+                         std::size_t numUnits);
+
+    static bool isGenerated(const Project& project);
+
+    static void disable(const Project& project);
+
+    /// \brief The compiler only prints an include stack when it changes,
+    ///        so it is carried over to the diagnostics that follow it.
+    struct IncludeStack
+    {
+        IncludeStack();
+
+        bool isInUnit; // the stack being read goes through a unit
+        std::string file; // the file a stack through a unit led into
+    };
+
+    /// \returns true for a compiler error located in a unit, or in a
+    ///          source that a unit includes.
+    static bool isUnityError(const std::string& line, IncludeStack& stack);
+
+    static const std::string FILE_PREFIX;
+
+    static const std::string CONFIG_MARKER;
+
+    static const std::string FAILED_FILE;
+
+    static const std::string RETRY_MESSAGE;
+
+private:
+    static void _removeConfig(const Project& project);
+
+    /// \returns true if config.make wasn't written by the unity build.
+    static bool _hasUserConfig(const Project& project);
+
+    /// \brief Remove the units numbered first and up.
+    static void _removeUnits(const Project& project, std::size_t first);
+
+    static bool _isUnitPath(const std::string& path);
+
+    static void _findSources(const std::string& path,
+                             std::vector<std::string>& sources);
+
+    static std::string _getSignature(const Project& project);
+
+};
+
+
+} } // namespace of::Sketch
@@ -25,6 +25,10 @@
 
 
 #include "Utils.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include "Poco/Process.h"
 #include "Poco/PipeStream.h"
 #include "Poco/StreamCopier.h"
@@ -35,6 +39,769 @@ namespace of {
 namespace Sketch {
 
 
+namespace {
+
+/// \brief Read the four hex digits of a \\u escape.
+unsigned long parseHex(const char* digits)
+{
+    unsigned long value = 0;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        char c = digits[i];
+        value = (value << 4) | (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+    }
+
+    return value;
+}
+
+}
+
+
+ValueWriter::~ValueWriter()
+{
+}
+
+
+void ValueWriter::key(const std::string& name)
+{
+    writeKey(name.data(), name.size());
+}
+
+
+void ValueWriter::value(const std::string& value)
+{
+    writeString(value.data(), value.size());
+}
+
+
+void ValueWriter::value(const char* value)
+{
+    writeString(value, std::strlen(value));
+}
+
+
+void ValueWriter::value(int value)
+{
+    writeInt(value);
+}
+
+
+void ValueWriter::value(unsigned int value)
+{
+    writeUInt(value);
+}
+
+
+void ValueWriter::value(Poco::Int64 value)
+{
+    writeInt(value);
+}
+
+
+void ValueWriter::value(Poco::UInt64 value)
+{
+    writeUInt(value);
+}
+
+
+void ValueWriter::value(double value)
+{
+    writeDouble(value);
+}
+
+
+void ValueWriter::value(bool value)
+{
+    writeBool(value);
+}
+
+
+void ValueWriter::value(const Json::Value& json)
+{
+    switch (json.type())
+    {
+        case Json::nullValue:
+            writeNull();
+            break;
+        case Json::booleanValue:
+            writeBool(json.asBool());
+            break;
+        case Json::intValue:
+            writeInt(Poco::Int64(json.asInt64()));
+            break;
+        case Json::uintValue:
+            writeUInt(Poco::UInt64(json.asUInt64()));
+            break;
+        case Json::realValue:
+            writeDouble(json.asDouble());
+            break;
+        case Json::stringValue:
+        {
+            // asString() keeps any NULs in the value, which asCString() would
+            // cut it off at.
+            std::string value = json.asString();
+            writeString(value.data(), value.size());
+            break;
+        }
+        case Json::arrayValue:
+        {
+            beginArray(json.size());
+
+            for (Json::ArrayIndex i = 0; i < json.size(); ++i)
+            {
+                value(json[i]);
+            }
+
+            endArray();
+            break;
+        }
+        case Json::objectValue:
+        {
+            beginObject(json.size());
+
+            Json::Value::const_iterator iter = json.begin();
+
+            for (; iter != json.end(); ++iter)
+            {
+                std::string name = iter.key().asString();
+                writeKey(name.data(), name.size());
+                value(*iter);
+            }
+
+            endObject();
+            break;
+        }
+    }
+}
+
+
+WritableValue::~WritableValue()
+{
+}
+
+
+JSONWriter::JSONWriter(std::string& buffer):
+    _buffer(buffer),
+    _start(buffer.size())
+{
+}
+
+
+void JSONWriter::beginObject(std::size_t size)
+{
+    _separate();
+    _buffer += '{';
+}
+
+
+void JSONWriter::endObject()
+{
+    _buffer += '}';
+}
+
+
+void JSONWriter::beginArray(std::size_t size)
+{
+    _separate();
+    _buffer += '[';
+}
+
+
+void JSONWriter::endArray()
+{
+    _buffer += ']';
+}
+
+
+void JSONWriter::writeKey(const char* name, std::size_t size)
+{
+    _separate();
+    _writeQuoted(name, size);
+    _buffer += ':';
+}
+
+
+void JSONWriter::writeString(const char* value, std::size_t size)
+{
+    _separate();
+    _writeQuoted(value, size);
+}
+
+
+void JSONWriter::writeInt(Poco::Int64 value)
+{
+    if (value >= 0)
+    {
+        writeUInt(Poco::UInt64(value));
+        return;
+    }
+
+    _separate();
+    _buffer += '-';
+
+    // Negate as unsigned, so the most negative value doesn't overflow.
+    char digits[20];
+    char* end = digits + sizeof(digits);
+    char* digit = end;
+    Poco::UInt64 magnitude = Poco::UInt64(0) - Poco::UInt64(value);
+
+    do
+    {
+        *--digit = char('0' + magnitude % 10);
+        magnitude /= 10;
+    }
+    while (magnitude > 0);
+
+    _buffer.append(digit, end);
+}
+
+
+void JSONWriter::writeUInt(Poco::UInt64 value)
+{
+    _separate();
+
+    char digits[20];
+    char* end = digits + sizeof(digits);
+    char* digit = end;
+
+    do
+    {
+        *--digit = char('0' + value % 10);
+        value /= 10;
+    }
+    while (value > 0);
+
+    _buffer.append(digit, end);
+}
+
+
+void JSONWriter::writeDouble(double value)
+{
+    // JSON has no NaN or infinity.
+    if (value != value || value - value != 0)
+    {
+        writeNull();
+        return;
+    }
+
+    _separate();
+
+    char number[32];
+    int size = std::snprintf(number, sizeof(number), "%.17g", value);
+
+    _buffer.append(number, size);
+
+    // Keep it a real number when it is read back.
+    if (std::strpbrk(number, ".eE") == 0)
+    {
+        _buffer += ".0";
+    }
+}
+
+
+void JSONWriter::writeBool(bool value)
+{
+    _separate();
+    _buffer += value ? "true" : "false";
+}
+
+
+void JSONWriter::writeNull()
+{
+    _separate();
+    _buffer += "null";
+}
+
+
+void JSONWriter::_separate()
+{
+    // Whatever was written last tells whether this starts a container,
+    // follows a key, or follows another member or element.
+    if (_buffer.size() > _start)
+    {
+        char last = _buffer[_buffer.size() - 1];
+
+        if (last != '{' && last != '[' && last != ':')
+        {
+            _buffer += ',';
+        }
+    }
+}
+
+
+void JSONWriter::_writeQuoted(const char* value, std::size_t size)
+{
+    static const char HEX[] = "0123456789ABCDEF";
+
+    _buffer += '"';
+
+    // Copy runs of characters that need no escaping in one go.
+    const char* run = value;
+    const char* end = value + size;
+
+    for (const char* c = value; c != end; ++c)
+    {
+        unsigned char ch = static_cast<unsigned char>(*c);
+
+        if (ch >= 0x20 && ch != '"' && ch != '\\')
+        {
+            continue;
+        }
+
+        _buffer.append(run, c);
+        run = c + 1;
+
+        switch (ch)
+        {
+            case '"': _buffer += "\\\""; break;
+            case '\\': _buffer += "\\\\"; break;
+            case '\b': _buffer += "\\b"; break;
+            case '\f': _buffer += "\\f"; break;
+            case '\n': _buffer += "\\n"; break;
+            case '\r': _buffer += "\\r"; break;
+            case '\t': _buffer += "\\t"; break;
+            default:
+                _buffer += "\\u00";
+                _buffer += HEX[ch >> 4];
+                _buffer += HEX[ch & 0x0f];
+                break;
+        }
+    }
+
+    _buffer.append(run, end);
+    _buffer += '"';
+}
+
+
+JSONReader::JSONReader(const std::string& text):
+    _begin(text.c_str()),
+    _position(text.c_str()),
+    _end(text.c_str() + text.size()),
+    _tokenBegin(0),
+    _tokenEnd(0),
+    _hasEscapes(false),
+    _token(TOKEN_END),
+    _expect(EXPECT_VALUE),
+    _depth(0)
+{
+}
+
+
+JSONReader::Token JSONReader::next()
+{
+    while (_token != TOKEN_ERROR)
+    {
+        while (_position != _end
+            && (*_position == ' ' || *_position == '\t' || *_position == '\n' || *_position == '\r'))
+        {
+            ++_position;
+        }
+
+        if (_position == _end)
+        {
+            return _expect == EXPECT_END ? (_token = TOKEN_END) : _error();
+        }
+
+        char c = *_position;
+
+        switch (_expect)
+        {
+            case EXPECT_FIRST_VALUE:
+                if (c == ']')
+                {
+                    ++_position;
+                    --_depth;
+                    _afterValue();
+                    return _token = TOKEN_END_ARRAY;
+                }
+                return _readValue();
+            case EXPECT_VALUE:
+                return _readValue();
+            case EXPECT_FIRST_KEY:
+                if (c == '}')
+                {
+                    ++_position;
+                    --_depth;
+                    _afterValue();
+                    return _token = TOKEN_END_OBJECT;
+                }
+                // Fall through.
+            case EXPECT_KEY:
+                if (c != '"' || !_scanString())
+                {
+                    return _error();
+                }
+                _expect = EXPECT_COLON;
+                return _token = TOKEN_KEY;
+            case EXPECT_COLON:
+                if (c != ':')
+                {
+                    return _error();
+                }
+                ++_position;
+                _expect = EXPECT_VALUE;
+                break;
+            case EXPECT_SEPARATOR:
+                if (c == ',')
+                {
+                    ++_position;
+                    _expect = _isObject[_depth - 1] ? EXPECT_KEY : EXPECT_VALUE;
+                    break;
+                }
+                else if (c == (_isObject[_depth - 1] ? '}' : ']'))
+                {
+                    ++_position;
+                    --_depth;
+                    _afterValue();
+                    return _token = (c == '}' ? TOKEN_END_OBJECT : TOKEN_END_ARRAY);
+                }
+                return _error();
+            case EXPECT_END:
+                return _error();
+        }
+    }
+
+    return TOKEN_ERROR;
+}
+
+
+bool JSONReader::skipValue()
+{
+    if (_token == TOKEN_KEY)
+    {
+        next();
+    }
+
+    if (_token != TOKEN_BEGIN_OBJECT && _token != TOKEN_BEGIN_ARRAY)
+    {
+        return _token != TOKEN_ERROR && _token != TOKEN_END;
+    }
+
+    std::size_t depth = _depth - 1;
+
+    while (next() != TOKEN_ERROR)
+    {
+        if (_depth == depth)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+std::size_t JSONReader::getDepth() const
+{
+    return _depth;
+}
+
+
+bool JSONReader::getString(std::string& value) const
+{
+    if (_token != TOKEN_KEY && _token != TOKEN_STRING)
+    {
+        return false;
+    }
+
+    value.clear();
+
+    if (!_hasEscapes)
+    {
+        value.append(_tokenBegin, _tokenEnd);
+        return true;
+    }
+
+    const char* c = _tokenBegin;
+
+    while (c != _tokenEnd)
+    {
+        const char* run = c;
+
+        while (c != _tokenEnd && *c != '\\')
+        {
+            ++c;
+        }
+
+        value.append(run, c);
+
+        if (c == _tokenEnd)
+        {
+            break;
+        }
+
+        // The escapes were checked when the string was read.
+        ++c;
+
+        switch (*c++)
+        {
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            case 'u':
+            {
+                unsigned long code = parseHex(c);
+                c += 4;
+
+                // Join a surrogate pair.
+                if (code >= 0xd800 && code < 0xdc00
+                 && _tokenEnd - c >= 6 && c[0] == '\\' && c[1] == 'u')
+                {
+                    unsigned long low = parseHex(c + 2);
+
+                    if (low >= 0xdc00 && low < 0xe000)
+                    {
+                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                        c += 6;
+                    }
+                }
+
+                if (code < 0x80)
+                {
+                    value += char(code);
+                }
+                else if (code < 0x800)
+                {
+                    value += char(0xc0 | (code >> 6));
+                    value += char(0x80 | (code & 0x3f));
+                }
+                else if (code < 0x10000)
+                {
+                    value += char(0xe0 | (code >> 12));
+                    value += char(0x80 | ((code >> 6) & 0x3f));
+                    value += char(0x80 | (code & 0x3f));
+                }
+                else
+                {
+                    value += char(0xf0 | (code >> 18));
+                    value += char(0x80 | ((code >> 12) & 0x3f));
+                    value += char(0x80 | ((code >> 6) & 0x3f));
+                    value += char(0x80 | (code & 0x3f));
+                }
+                break;
+            }
+            default:
+                // \" \\ and \/ stand for themselves.
+                value += c[-1];
+                break;
+        }
+    }
+
+    return true;
+}
+
+
+bool JSONReader::isString(const std::string& text) const
+{
+    if (_token != TOKEN_KEY && _token != TOKEN_STRING)
+    {
+        return false;
+    }
+    else if (!_hasEscapes)
+    {
+        return std::size_t(_tokenEnd - _tokenBegin) == text.size()
+            && text.compare(0, text.size(), _tokenBegin, text.size()) == 0;
+    }
+
+    std::string value;
+    return getString(value) && value == text;
+}
+
+
+double JSONReader::getNumber() const
+{
+    // The number is followed by a character that ends it, or by the
+    // text's terminating null.
+    return _token == TOKEN_NUMBER ? std::strtod(_tokenBegin, 0) : 0;
+}
+
+
+JSONReader::Token JSONReader::_error()
+{
+    return _token = TOKEN_ERROR;
+}
+
+
+JSONReader::Token JSONReader::_readValue()
+{
+    char c = *_position;
+
+    if (c == '{' || c == '[')
+    {
+        if (_depth == MAXIMUM_DEPTH)
+        {
+            return _error();
+        }
+
+        _isObject[_depth++] = (c == '{');
+        ++_position;
+        _expect = (c == '{') ? EXPECT_FIRST_KEY : EXPECT_FIRST_VALUE;
+        return _token = (c == '{') ? TOKEN_BEGIN_OBJECT : TOKEN_BEGIN_ARRAY;
+    }
+    else if (c == '"')
+    {
+        if (!_scanString())
+        {
+            return _error();
+        }
+
+        _afterValue();
+        return _token = TOKEN_STRING;
+    }
+    else if (c == '-' || (c >= '0' && c <= '9'))
+    {
+        if (!_scanNumber())
+        {
+            return _error();
+        }
+
+        _afterValue();
+        return _token = TOKEN_NUMBER;
+    }
+
+    static const char* const LITERALS[] = { "true", "false", "null" };
+    static const Token TOKENS[] = { TOKEN_TRUE, TOKEN_FALSE, TOKEN_NULL };
+
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        std::size_t size = std::strlen(LITERALS[i]);
+
+        if (std::size_t(_end - _position) >= size
+         && std::memcmp(_position, LITERALS[i], size) == 0)
+        {
+            _position += size;
+            _afterValue();
+            return _token = TOKENS[i];
+        }
+    }
+
+    return _error();
+}
+
+
+bool JSONReader::_scanString()
+{
+    _tokenBegin = ++_position;
+    _hasEscapes = false;
+
+    while (_position != _end)
+    {
+        unsigned char c = static_cast<unsigned char>(*_position);
+
+        if (c == '"')
+        {
+            _tokenEnd = _position++;
+            return true;
+        }
+        else if (c < 0x20)
+        {
+            return false;
+        }
+        else if (c == '\\')
+        {
+            _hasEscapes = true;
+
+            if (++_position == _end)
+            {
+                return false;
+            }
+            else if (*_position == 'u')
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (++_position == _end || !std::isxdigit(static_cast<unsigned char>(*_position)))
+                    {
+                        return false;
+                    }
+                }
+            }
+            else if (std::strchr("\"\\/bfnrt", *_position) == 0)
+            {
+                return false;
+            }
+        }
+
+        ++_position;
+    }
+
+    return false;
+}
+
+
+bool JSONReader::_scanNumber()
+{
+    _tokenBegin = _position;
+
+    if (*_position == '-')
+    {
+        ++_position;
+    }
+
+    if (_position == _end || !std::isdigit(static_cast<unsigned char>(*_position)))
+    {
+        return false;
+    }
+    else if (*_position == '0')
+    {
+        ++_position;
+    }
+    else
+    {
+        while (_position != _end && std::isdigit(static_cast<unsigned char>(*_position)))
+        {
+            ++_position;
+        }
+    }
+
+    if (_position != _end && *_position == '.')
+    {
+        ++_position;
+
+        if (_position == _end || !std::isdigit(static_cast<unsigned char>(*_position)))
+        {
+            return false;
+        }
+
+        while (_position != _end && std::isdigit(static_cast<unsigned char>(*_position)))
+        {
+            ++_position;
+        }
+    }
+
+    if (_position != _end && (*_position == 'e' || *_position == 'E'))
+    {
+        ++_position;
+
+        if (_position != _end && (*_position == '+' || *_position == '-'))
+        {
+            ++_position;
+        }
+
+        if (_position == _end || !std::isdigit(static_cast<unsigned char>(*_position)))
+        {
+            return false;
+        }
+
+        while (_position != _end && std::isdigit(static_cast<unsigned char>(*_position)))
+        {
+            ++_position;
+        }
+    }
+
+    _tokenEnd = _position;
+    return true;
+}
+
+
+void JSONReader::_afterValue()
+{
+    _expect = (_depth == 0) ? EXPECT_END : EXPECT_SEPARATOR;
+}
+
+
 bool Utils::JSONfromFile(const std::string& path, Json::Value& value)
 {
     try
@@ -95,10 +862,46 @@ Json::Value Utils::toJSONMethod(const std::string& module,
 }
 
 
+void Utils::beginJSONMethod(ValueWriter& writer,
+                            const std::string& module,
+                            const std::string& method)
+{
+    writer.beginObject(4);
+    writer.key("ofSketch");
+    writer.value("1.0");
+    writer.key("module");
+    writer.value(module);
+    writer.key("method");
+    writer.value(method);
+    writer.key("params");
+}
+
+
 std::string Utils::toJSONString(const Json::Value& json)
 {
-    Json::FastWriter writer;
-    return writer.write(json);
+    std::string buffer;
+    toJSONString(json, buffer);
+    return buffer;
+}
+
+
+void Utils::toJSONString(const Json::Value& json, std::string& buffer)
+{
+    JSONWriter writer(buffer);
+    writer.value(json);
+
+    // Json::FastWriter ended its output with a newline, which files
+    // written before still have.
+    buffer += '\n';
+}
+
+
+std::string Utils::toJSONString(const WritableValue& value)
+{
+    std::string buffer;
+    JSONWriter writer(buffer);
+    value.write(writer);
+    return buffer;
 }
 
 
@@ -29,6 +29,7 @@
 
 #include <string>
 #include <json/json.h>
+#include "Poco/Types.h"
 #include "ofConstants.h"
 #include "ofUtils.h"
 
@@ -37,6 +38,191 @@ namespace of {
 namespace Sketch {
 
 
+/// \brief Receives a value one piece at a time, so it can be encoded
+///        without building a Json::Value first.
+class ValueWriter
+{
+public:
+    virtual ~ValueWriter();
+
+    virtual void beginObject(std::size_t size) = 0;
+    virtual void endObject() = 0;
+    virtual void beginArray(std::size_t size) = 0;
+    virtual void endArray() = 0;
+
+    /// \brief Write the name of the next member of an object.
+    virtual void writeKey(const char* name, std::size_t size) = 0;
+
+    virtual void writeString(const char* value, std::size_t size) = 0;
+    virtual void writeInt(Poco::Int64 value) = 0;
+    virtual void writeUInt(Poco::UInt64 value) = 0;
+    virtual void writeDouble(double value) = 0;
+    virtual void writeBool(bool value) = 0;
+    virtual void writeNull() = 0;
+
+    void key(const std::string& name);
+
+    void value(const std::string& value);
+    void value(const char* value);
+    void value(int value);
+    void value(unsigned int value);
+    void value(Poco::Int64 value);
+    void value(Poco::UInt64 value);
+    void value(double value);
+    void value(bool value);
+
+    /// \brief Write a value that has already been built.
+    void value(const Json::Value& value);
+
+};
+
+
+/// \brief A value that writes itself to a ValueWriter.
+class WritableValue
+{
+public:
+    virtual ~WritableValue();
+
+    virtual void write(ValueWriter& writer) const = 0;
+
+};
+
+
+/// \brief Writes JSON text straight into a buffer the caller may reuse.
+class JSONWriter: public ValueWriter
+{
+public:
+    /// \brief Append to a buffer.
+    JSONWriter(std::string& buffer);
+
+    void beginObject(std::size_t size);
+    void endObject();
+    void beginArray(std::size_t size);
+    void endArray();
+    void writeKey(const char* name, std::size_t size);
+    void writeString(const char* value, std::size_t size);
+    void writeInt(Poco::Int64 value);
+    void writeUInt(Poco::UInt64 value);
+    void writeDouble(double value);
+    void writeBool(bool value);
+    void writeNull();
+
+private:
+    /// \brief Separate the next key or value from the one before it.
+    void _separate();
+
+    void _writeQuoted(const char* value, std::size_t size);
+
+    std::string& _buffer;
+
+    /// \brief Where this writer started appending.
+    std::size_t _start;
+
+};
+
+
+/// \brief Reads JSON text one token at a time, without building a
+///        Json::Value.
+class JSONReader
+{
+public:
+    enum Token
+    {
+        TOKEN_BEGIN_OBJECT,
+        TOKEN_END_OBJECT,
+        TOKEN_BEGIN_ARRAY,
+        TOKEN_END_ARRAY,
+
+        /// \brief The name of an object member.
+        TOKEN_KEY,
+
+        TOKEN_STRING,
+        TOKEN_NUMBER,
+        TOKEN_TRUE,
+        TOKEN_FALSE,
+        TOKEN_NULL,
+
+        /// \brief The end of the text, after one complete value.
+        TOKEN_END,
+
+        /// \brief The text isn't valid JSON.  Every later token is an
+        ///        error too.
+        TOKEN_ERROR
+    };
+
+    /// \brief Read a buffer that must outlive the reader.
+    JSONReader(const std::string& text);
+
+    Token next();
+
+    /// \brief Skip the rest of the value whose first token was just read.
+    bool skipValue();
+
+    /// \returns how many objects and arrays enclose the next token.
+    std::size_t getDepth() const;
+
+    /// \brief Unescape the last key or string into a buffer.
+    /// \returns false if the last token wasn't a key or string.
+    bool getString(std::string& value) const;
+
+    /// \returns true if the last key or string equals text.  Doesn't
+    ///          allocate unless the token holds escapes.
+    bool isString(const std::string& text) const;
+
+    /// \returns the last number, or 0.
+    double getNumber() const;
+
+    enum
+    {
+        /// \brief How deeply objects and arrays may be nested.
+        MAXIMUM_DEPTH = 256
+    };
+
+private:
+    /// \brief What is allowed after the last token.
+    enum Expect
+    {
+        EXPECT_VALUE,
+        EXPECT_FIRST_VALUE,
+        EXPECT_KEY,
+        EXPECT_FIRST_KEY,
+        EXPECT_COLON,
+        EXPECT_SEPARATOR,
+        EXPECT_END
+    };
+
+    Token _error();
+
+    /// \brief Read a value starting at the current character.
+    Token _readValue();
+
+    /// \brief Find the end of a string, and whether it holds escapes.
+    bool _scanString();
+
+    bool _scanNumber();
+
+    /// \brief The token after a value, depending on what encloses it.
+    void _afterValue();
+
+    const char* _begin;
+    const char* _position;
+    const char* _end;
+
+    /// \brief The text of the last key, string or number, without quotes.
+    const char* _tokenBegin;
+    const char* _tokenEnd;
+    bool _hasEscapes;
+
+    Token _token;
+    Expect _expect;
+
+    /// \brief Whether each enclosing container is an object.
+    bool _isObject[MAXIMUM_DEPTH];
+    std::size_t _depth;
+
+};
+
+
 class Utils
 {
 public:
@@ -49,9 +235,19 @@ public:
                                     const std::string& method,
                                     const Json::Value& params);
 
+    /// \brief Write toJSONMethod up to the "params" key.
+    static void beginJSONMethod(ValueWriter& writer,
+                                const std::string& module,
+                                const std::string& method);
+
     // This is a utility method for quickly converting a json value to a string.
     static std::string toJSONString(const Json::Value& json);
 
+    /// \brief Write a value as JSON, e.g. into a reused buffer.
+    static void toJSONString(const Json::Value& json, std::string& buffer);
+
+    static std::string toJSONString(const WritableValue& value);
+
     // TODO: HACK while openFrameworks core is updated.
     // - https://github.com/openframeworks/openFrameworks/issues/2162
     // - https://github.com/openframeworks/openFrameworks/pull/3109